@@ -0,0 +1,160 @@
+//
+// Created by Sirui Mu on 2019/12/29.
+//
+
+#include "Infrastructure/Stream.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+namespace jvc {
+
+namespace {
+
+double median(std::vector<double>& samples) {
+  std::sort(samples.begin(), samples.end());
+  auto n = samples.size();
+  if (n % 2) {
+    return samples[n / 2];
+  }
+  return (samples[n / 2 - 1] + samples[n / 2]) / 2;
+}
+
+BenchmarkStatistics computeRates(const std::vector<double>& seconds, double amount) {
+  std::vector<double> rates;
+  rates.reserve(seconds.size());
+  for (auto s : seconds) {
+    rates.push_back(amount / s);
+  }
+  return BenchmarkStatistics::Compute(std::move(rates));
+}
+
+void dumpStatistics(StreamWriter& o, const BenchmarkStatistics& stats) {
+  o << "{ \"median\": " << stats.Median
+    << ", \"min\": " << stats.Min
+    << ", \"max\": " << stats.Max
+    << ", \"relative_mad\": " << stats.RelativeMAD
+    << " }";
+}
+
+} // namespace <anonymous>
+
+BenchmarkStatistics BenchmarkStatistics::Compute(std::vector<double> samples) {
+  assert(!samples.empty() && "samples is empty.");
+
+  BenchmarkStatistics stats { };
+  stats.Median = median(samples);
+  stats.Min = samples.front();
+  stats.Max = samples.back();
+
+  for (auto& s : samples) {
+    s = std::fabs(s - stats.Median);
+  }
+  stats.RelativeMAD = stats.Median == 0 ? 0 : median(samples) / stats.Median;
+
+  return stats;
+}
+
+BenchmarkStatistics BenchmarkResult::GetBytesPerSecond() const {
+  return computeRates(Seconds, static_cast<double>(Bytes) / (1024 * 1024));
+}
+
+BenchmarkStatistics BenchmarkResult::GetItemsPerSecond() const {
+  return computeRates(Seconds, static_cast<double>(Items));
+}
+
+BenchmarkRunner::BenchmarkRunner(BenchmarkOptions options)
+    : _options(std::move(options))
+{ }
+
+void BenchmarkRunner::Add(Benchmark benchmark) {
+  _benchmarks.push_back(std::move(benchmark));
+}
+
+void BenchmarkRunner::RunAll(StreamWriter& progress) {
+  for (const auto& benchmark : _benchmarks) {
+    if (benchmark.Name.find(_options.Filter) == std::string::npos) {
+      continue;
+    }
+
+    auto result = run(benchmark);
+    auto bytesPerSecond = result.GetBytesPerSecond();
+    auto itemsPerSecond = result.GetItemsPerSecond();
+    progress << benchmark.Name << ": "
+             << bytesPerSecond.Median << " MB/s, "
+             << itemsPerSecond.Median << " tokens/s (+/- "
+             << bytesPerSecond.RelativeMAD * 100 << "%)\n";
+
+    _results.push_back(std::move(result));
+  }
+}
+
+void BenchmarkRunner::DumpJson(StreamWriter& o) const {
+  o << "{\n";
+  {
+    auto indentGuard = o.PushIndent();
+    o << "\"repetitions\": " << _options.Repetitions << ",\n";
+    o << "\"benchmarks\": [\n";
+    for (size_t i = 0; i < _results.size(); ++i) {
+      const auto& result = _results[i];
+      auto resultIndentGuard = o.PushIndent();
+      o << "{ \"name\": \"" << result.Name << "\""
+        << ", \"bytes\": " << result.Bytes
+        << ", \"tokens\": " << result.Items
+        << ", \"cold_cache\": " << (result.ColdCache ? "true" : "false")
+        << ", \"mb_per_second\": ";
+      dumpStatistics(o, result.GetBytesPerSecond());
+      o << ", \"tokens_per_second\": ";
+      dumpStatistics(o, result.GetItemsPerSecond());
+      o << " }" << (i + 1 == _results.size() ? "\n" : ",\n");
+    }
+    o << "]\n";
+  }
+  o << "}\n";
+}
+
+BenchmarkResult BenchmarkRunner::run(const Benchmark& benchmark) {
+  BenchmarkResult result { };
+  result.Name = benchmark.Name;
+  result.Bytes = benchmark.Bytes;
+  result.ColdCache = benchmark.ColdCache;
+
+  if (!benchmark.ColdCache) {
+    // Warm up the caches with an untimed run.
+    benchmark.Run();
+  }
+
+  for (auto i = 0; i < _options.Repetitions; ++i) {
+    if (benchmark.ColdCache) {
+      flushCache();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    result.Items = benchmark.Run();
+    auto end = std::chrono::steady_clock::now();
+
+    result.Seconds.push_back(std::chrono::duration<double>(end - start).count());
+  }
+
+  return result;
+}
+
+void BenchmarkRunner::flushCache() {
+  if (_cacheFlushBuffer.empty()) {
+    _cacheFlushBuffer.resize(CacheFlushBytes);
+  }
+
+  // Write and then read back every cache line so that the buffer evicts everything else from the caches.
+  for (size_t i = 0; i < _cacheFlushBuffer.size(); i += 64) {
+    ++_cacheFlushBuffer[i];
+  }
+  volatile char sink = 0;
+  for (size_t i = 0; i < _cacheFlushBuffer.size(); i += 64) {
+    sink = sink + _cacheFlushBuffer[i];
+  }
+}
+
+} // namespace jvc
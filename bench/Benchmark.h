@@ -0,0 +1,157 @@
+//
+// Created by Sirui Mu on 2019/12/29.
+//
+
+#ifndef JVC_BENCHMARK_H
+#define JVC_BENCHMARK_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace jvc {
+
+class StreamWriter;
+
+/**
+ * @brief Options controlling how benchmarks are executed.
+ */
+struct BenchmarkOptions {
+  /**
+   * @brief Number of timed repetitions of each benchmark.
+   */
+  int Repetitions = 10;
+
+  /**
+   * @brief Only benchmarks whose names contain this string are executed.
+   */
+  std::string Filter;
+};
+
+/**
+ * @brief A single benchmark.
+ */
+struct Benchmark {
+  /**
+   * @brief Name of the benchmark.
+   */
+  std::string Name;
+
+  /**
+   * @brief Number of input bytes processed by a single run of the benchmark.
+   */
+  size_t Bytes;
+
+  /**
+   * @brief Should the CPU caches be flushed before each timed run?
+   */
+  bool ColdCache;
+
+  /**
+   * @brief The benchmark body. Returns the number of items (e.g. tokens) processed by a single run.
+   */
+  std::function<size_t()> Run;
+};
+
+/**
+ * @brief Summary of a series of samples.
+ */
+struct BenchmarkStatistics {
+  double Median;
+  double Min;
+  double Max;
+
+  /**
+   * @brief Median absolute deviation of the samples, relative to the median.
+   */
+  double RelativeMAD;
+
+  /**
+   * @brief Summarize the given samples.
+   * @param samples the samples. Must not be empty.
+   * @return summary of the given samples.
+   */
+  static BenchmarkStatistics Compute(std::vector<double> samples);
+};
+
+/**
+ * @brief Result of a single benchmark.
+ */
+struct BenchmarkResult {
+  std::string Name;
+  size_t Bytes;
+  size_t Items;
+  bool ColdCache;
+  std::vector<double> Seconds;
+
+  /**
+   * @brief Get the throughput of the benchmark in MB/s.
+   * @return the throughput of the benchmark in MB/s.
+   */
+  [[nodiscard]]
+  BenchmarkStatistics GetBytesPerSecond() const;
+
+  /**
+   * @brief Get the throughput of the benchmark in items per second.
+   * @return the throughput of the benchmark in items per second.
+   */
+  [[nodiscard]]
+  BenchmarkStatistics GetItemsPerSecond() const;
+};
+
+/**
+ * @brief Execute benchmarks and collect their results.
+ */
+class BenchmarkRunner {
+public:
+  /**
+   * @brief Size of the buffer touched to evict the CPU caches before cold runs, in bytes.
+   */
+  constexpr static const size_t CacheFlushBytes = 64 * 1024 * 1024;
+
+  /**
+   * @brief Initialize a new @see BenchmarkRunner object.
+   * @param options the benchmark options.
+   */
+  explicit BenchmarkRunner(BenchmarkOptions options);
+
+  /**
+   * @brief Register a benchmark.
+   * @param benchmark the benchmark.
+   */
+  void Add(Benchmark benchmark);
+
+  /**
+   * @brief Execute all registered benchmarks that pass the filter.
+   * @param progress writer to which human readable progress is reported.
+   */
+  void RunAll(StreamWriter& progress);
+
+  /**
+   * @brief Get the results of the executed benchmarks.
+   * @return the results of the executed benchmarks.
+   */
+  [[nodiscard]]
+  const std::vector<BenchmarkResult>& results() const { return _results; }
+
+  /**
+   * @brief Write the results of the executed benchmarks as a JSON document.
+   * @param output the output writer.
+   */
+  void DumpJson(StreamWriter& output) const;
+
+private:
+  BenchmarkOptions _options;
+  std::vector<Benchmark> _benchmarks;
+  std::vector<BenchmarkResult> _results;
+  std::vector<char> _cacheFlushBuffer;
+
+  BenchmarkResult run(const Benchmark& benchmark);
+
+  void flushCache();
+};
+
+} // namespace jvc
+
+#endif // JVC_BENCHMARK_H
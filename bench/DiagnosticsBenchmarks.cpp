@@ -0,0 +1,76 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#include "Infrastructure/Stream.h"
+#include "Frontend/CompilerInstance.h"
+#include "DiagnosticsBenchmarks.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jvc {
+
+namespace {
+
+/**
+ * @brief Maximum number of diagnostics messages reported by a single run.
+ */
+constexpr const size_t MaxDiagnosticsPerRun = 100000;
+
+const char* getFormatName(DiagnosticsFormat format) {
+  switch (format) {
+    case DiagnosticsFormat::Text:
+      return "text";
+    case DiagnosticsFormat::JsonLines:
+      return "jsonl";
+    case DiagnosticsFormat::Sarif:
+      return "sarif";
+  }
+  return "unknown";
+}
+
+size_t renderDiagnostics(CompilerInstance& ci, const std::vector<SourceRange>& ranges, DiagnosticsOptions options,
+                         std::string& sink) {
+  sink.clear();
+  DiagnosticsEngine diag { ci, options };
+  diag.SetOutput(OutputStream::FromString(sink));
+  for (const auto& range : ranges) {
+    diag.Emit(Diagnostics { DiagnosticsKind::UnknownOperator, range, "@" });
+  }
+  diag.Finish();
+  return ranges.size();
+}
+
+} // namespace <anonymous>
+
+void RegisterDiagnosticsBenchmarks(BenchmarkRunner& runner, CompilerInstance& ci, int sourceFileId) {
+  auto sourceFileInfo = ci.GetSourceManager().GetSourceFileInfo(sourceFileId);
+  auto ranges = std::make_shared<std::vector<SourceRange>>();
+  auto lines = sourceFileInfo->GetEOFLoc().row();
+  for (uint64_t row = 1; row <= lines && ranges->size() < MaxDiagnosticsPerRun; ++row) {
+    ranges->emplace_back(SourceLocation { sourceFileId, row, 1 }, SourceLocation { sourceFileId, row, 2 });
+  }
+  auto sink = std::make_shared<std::string>();
+
+  for (auto format : { DiagnosticsFormat::Text, DiagnosticsFormat::JsonLines, DiagnosticsFormat::Sarif }) {
+    for (auto queued : { false, true }) {
+      DiagnosticsOptions options { };
+      options.Format = format;
+      options.Queued = queued;
+
+      Benchmark benchmark { };
+      benchmark.Name = std::string { "diagnostics/" } + getFormatName(format) + (queued ? "/queued" : "/immediate");
+      // Measure the size of the rendered output once, so that throughputs of the formats can be compared.
+      renderDiagnostics(ci, *ranges, options, *sink);
+      benchmark.Bytes = sink->size();
+      benchmark.ColdCache = false;
+      benchmark.Run = [&ci, ranges, options, sink] { return renderDiagnostics(ci, *ranges, options, *sink); };
+
+      runner.Add(std::move(benchmark));
+    }
+  }
+}
+
+} // namespace jvc
@@ -0,0 +1,30 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#ifndef JVC_DIAGNOSTICSBENCHMARKS_H
+#define JVC_DIAGNOSTICSBENCHMARKS_H
+
+#include "Benchmark.h"
+
+namespace jvc {
+
+class CompilerInstance;
+
+/**
+ * @brief Register diagnostics rendering benchmarks, reporting a diagnostics message on every line of the given source
+ * code file.
+ *
+ * A benchmark is registered for every combination of output format and queueing mode, so that the overhead of the
+ * machine-readable formats can be compared against the text renderer. Throughput is reported in bytes of rendered
+ * output.
+ *
+ * @param runner the benchmark runner.
+ * @param ci the compiler instance owning the source code file.
+ * @param sourceFileId ID of the source code file.
+ */
+void RegisterDiagnosticsBenchmarks(BenchmarkRunner& runner, CompilerInstance& ci, int sourceFileId);
+
+} // namespace jvc
+
+#endif // JVC_DIAGNOSTICSBENCHMARKS_H
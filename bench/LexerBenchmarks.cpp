@@ -0,0 +1,64 @@
+//
+// Created by Sirui Mu on 2019/12/29.
+//
+
+#include "Frontend/CompilerInstance.h"
+#include "Lex/Lexer.h"
+#include "LexerBenchmarks.h"
+
+#include <vector>
+
+namespace jvc {
+
+namespace {
+
+size_t lexOneByOne(CompilerInstance& ci, int sourceFileId, LexerOptions options) {
+  auto lexer = Lexer::Create(ci, sourceFileId, options);
+  size_t tokens = 0;
+  while (auto token = lexer->ReadNextToken()) {
+    ++tokens;
+  }
+  return tokens;
+}
+
+size_t lexAll(CompilerInstance& ci, int sourceFileId, LexerOptions options) {
+  auto lexer = Lexer::Create(ci, sourceFileId, options);
+  std::vector<std::unique_ptr<Token>> tokens;
+  return lexer->ReadAllTokens(tokens);
+}
+
+} // namespace <anonymous>
+
+void RegisterLexerBenchmarks(BenchmarkRunner& runner, CompilerInstance& ci, int sourceFileId,
+                             const std::string& corpusName) {
+  auto bytes = ci.GetSourceManager().GetSourceFileInfo(sourceFileId)->GetSize();
+
+  for (auto keepComment : { false, true }) {
+    for (auto keepWhitespace : { false, true }) {
+      LexerOptions options { };
+      options.KeepComment = keepComment;
+      options.KeepWhitespace = keepWhitespace;
+
+      for (auto bulk : { false, true }) {
+        for (auto coldCache : { false, true }) {
+          Benchmark benchmark { };
+          benchmark.Name = "lex/" + corpusName + "/comment=" + (keepComment ? "1" : "0")
+              + ",whitespace=" + (keepWhitespace ? "1" : "0")
+              + (bulk ? "/all" : "/next")
+              + (coldCache ? "/cold" : "/warm");
+          benchmark.Bytes = bytes;
+          benchmark.ColdCache = coldCache;
+          if (bulk) {
+            benchmark.Run = [&ci, sourceFileId, options] { return lexAll(ci, sourceFileId, options); };
+          } else {
+            benchmark.Run = [&ci, sourceFileId, options] { return lexOneByOne(ci, sourceFileId, options); };
+          }
+
+          runner.Add(std::move(benchmark));
+        }
+      }
+    }
+  }
+}
+
+} // namespace jvc
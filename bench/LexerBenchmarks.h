@@ -0,0 +1,32 @@
+//
+// Created by Sirui Mu on 2019/12/29.
+//
+
+#ifndef JVC_LEXERBENCHMARKS_H
+#define JVC_LEXERBENCHMARKS_H
+
+#include "Benchmark.h"
+
+#include <string>
+
+namespace jvc {
+
+class CompilerInstance;
+
+/**
+ * @brief Register lexer throughput benchmarks over the given source code file.
+ *
+ * A benchmark is registered for every combination of lexer options, token consumption mode (one token at a time or
+ * all tokens at once) and cache state.
+ *
+ * @param runner the benchmark runner.
+ * @param ci the compiler instance owning the source code file.
+ * @param sourceFileId ID of the source code file.
+ * @param corpusName name of the corpus, included in the benchmark names.
+ */
+void RegisterLexerBenchmarks(BenchmarkRunner& runner, CompilerInstance& ci, int sourceFileId,
+                             const std::string& corpusName);
+
+} // namespace jvc
+
+#endif // JVC_LEXERBENCHMARKS_H
@@ -0,0 +1,92 @@
+//
+// Created by Sirui Mu on 2019/12/29.
+//
+
+#include "Infrastructure/Stream.h"
+#include "Frontend/CompilerInstance.h"
+#include "Benchmark.h"
+#include "CorpusGenerator.h"
+#include "DiagnosticsBenchmarks.h"
+#include "LexerBenchmarks.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct BenchmarkArgs {
+  jvc::BenchmarkOptions Options;
+  jvc::CorpusOptions Corpus;
+  std::string OutputFile;
+};
+
+[[noreturn]] void PrintUsageAndExit(const char* program) {
+  std::cerr << "usage: " << program
+            << " [--repetitions N] [--corpus-lines N] [--corpus-mix NAME] [--corpus-seed N] [--filter SUBSTRING]"
+            << " [--output FILE]" << std::endl
+            << "Benchmark results are written to stdout as JSON unless --output is given." << std::endl;
+  std::exit(1);
+}
+
+BenchmarkArgs ParseCommandLine(int argc, char* argv[]) {
+  BenchmarkArgs args { };
+  args.Corpus.Seed = 2019;
+  args.Corpus.LinesPerFile = 100000;
+
+  for (auto i = 1; i < argc; ++i) {
+    if (i + 1 >= argc) {
+      PrintUsageAndExit(argv[0]);
+    }
+
+    auto value = argv[++i];
+    if (std::strcmp(argv[i - 1], "--repetitions") == 0) {
+      args.Options.Repetitions = std::atoi(value);
+    } else if (std::strcmp(argv[i - 1], "--corpus-lines") == 0) {
+      args.Corpus.LinesPerFile = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(argv[i - 1], "--corpus-mix") == 0) {
+      if (!jvc::ParseCorpusMix(value, args.Corpus.Mix)) {
+        PrintUsageAndExit(argv[0]);
+      }
+    } else if (std::strcmp(argv[i - 1], "--corpus-seed") == 0) {
+      args.Corpus.Seed = std::strtoull(value, nullptr, 10);
+    } else if (std::strcmp(argv[i - 1], "--filter") == 0) {
+      args.Options.Filter = value;
+    } else if (std::strcmp(argv[i - 1], "--output") == 0) {
+      args.OutputFile = value;
+    } else {
+      PrintUsageAndExit(argv[0]);
+    }
+  }
+
+  if (args.Options.Repetitions <= 0) {
+    PrintUsageAndExit(argv[0]);
+  }
+  return args;
+}
+
+} // namespace <anonymous>
+
+int main(int argc, char* argv[]) {
+  auto args = ParseCommandLine(argc, argv);
+
+  jvc::CompilerInstance ci { };
+  auto corpus = jvc::CorpusGenerator { args.Corpus }.GenerateFile(0);
+  auto corpusFileId = ci.GetSourceManager().Load(
+      "<corpus>", jvc::InputStream::FromBuffer(corpus.data(), corpus.size()));
+
+  jvc::BenchmarkRunner runner { args.Options };
+  jvc::RegisterLexerBenchmarks(runner, ci, corpusFileId, jvc::GetCorpusMixName(args.Corpus.Mix));
+  jvc::RegisterDiagnosticsBenchmarks(runner, ci, corpusFileId);
+  runner.RunAll(jvc::errs());
+
+  if (args.OutputFile.empty()) {
+    runner.DumpJson(jvc::outs());
+  } else {
+    jvc::StreamWriter output { jvc::OutputStream::FromFile(args.OutputFile) };
+    runner.DumpJson(output);
+  }
+
+  return 0;
+}
@@ -5,9 +5,11 @@
 #ifndef JVC_COMPILERINSTANCE_H
 #define JVC_COMPILERINSTANCE_H
 
+#include "Infrastructure/StatCache.h"
 #include "Frontend/CompilerOptions.h"
 #include "Frontend/Diagnostics.h"
 #include "Frontend/SourceManager.h"
+#include "Frontend/SourcePathIndex.h"
 
 #include <memory>
 
@@ -25,7 +27,9 @@ public:
   explicit CompilerInstance(CompilerOptions options = CompilerOptions { })
     : _options(std::move(options)),
       _diag(std::make_unique<DiagnosticsEngine>(*this)),
-      _sources(std::make_unique<SourceManager>(*this))
+      _sources(std::make_unique<SourceManager>(*this)),
+      _statCache(std::make_unique<StatCache>()),
+      _sourcePath(std::make_unique<SourcePathIndex>(*this))
   { }
 
   /**
@@ -76,10 +80,33 @@ public:
   [[nodiscard]]
   const SourceManager& GetSourceManager() const { return *_sources; }
 
+  /**
+   * @brief Get the cache of `stat` results shared by the whole compiler session.
+   * @return the stat cache.
+   */
+  [[nodiscard]]
+  StatCache& GetStatCache() { return *_statCache; }
+
+  /**
+   * @brief Get the index of the java source files found under the source path.
+   * @return the source path index.
+   */
+  [[nodiscard]]
+  SourcePathIndex& GetSourcePathIndex() { return *_sourcePath; }
+
+  /**
+   * @brief Get the index of the java source files found under the source path.
+   * @return the source path index.
+   */
+  [[nodiscard]]
+  const SourcePathIndex& GetSourcePathIndex() const { return *_sourcePath; }
+
 private:
   CompilerOptions _options;
   std::unique_ptr<DiagnosticsEngine> _diag;
   std::unique_ptr<SourceManager> _sources;
+  std::unique_ptr<StatCache> _statCache;
+  std::unique_ptr<SourcePathIndex> _sourcePath;
 };
 
 } // namespace jvc
@@ -7,13 +7,65 @@
 
 #include "FrontendAction.h"
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 namespace jvc {
 
+/**
+ * @brief Formats in which the lexer output is dumped.
+ */
+enum class TokenDumpFormat {
+  /**
+   * @brief One human-readable line per token.
+   */
+  Text,
+
+  /**
+   * @brief One JSON object per source code file and per token.
+   */
+  JsonLines,
+
+  /**
+   * @brief Fixed-width token records followed by a string table, per source code file. See @see TokenRecord.
+   */
+  Binary,
+};
+
 struct CompilerOptions {
   bool HasOutputFile;
   std::string OutputFilePath;
+
+  /**
+   * @brief Should the lexer report statistics about the tokens it produces?
+   */
+  bool LexStats;
+
+  /**
+   * @brief The format in which the lexer output is dumped.
+   */
+  TokenDumpFormat DumpFormat;
+
+  /**
+   * @brief The maximum number of threads to use. If 0, the number of hardware threads is used.
+   */
+  size_t Jobs;
+
+  /**
+   * @brief The maximum number of source file content bytes to keep in memory. If 0, the budget is unlimited.
+   */
+  size_t SourceMemoryBudget;
+
+  /**
+   * @brief Root directories of the source path, searched for java source files.
+   */
+  std::vector<std::string> SourcePath;
+
+  /**
+   * @brief Should the memory held by tokens be measured for the memory report?
+   */
+  bool MemReport;
 };
 
 } // namespace jvc
@@ -5,15 +5,24 @@
 #ifndef JVC_DIAGNOSTICS_H
 #define JVC_DIAGNOSTICS_H
 
+#include "Infrastructure/Stream.h"
 #include "Frontend/SourceLocation.h"
 
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 namespace jvc {
 
 class CompilerInstance;
-class StreamWriter;
 
 #define JVC_DIAGNOSTICS_LEVELS(h)   \
   h(Info)                           \
@@ -30,6 +39,86 @@ enum class DiagnosticsLevel {
 #undef EMIT_ENUM_CLASS_VARIANT
 };
 
+/**
+ * @brief The table of diagnostics emitted by JVC. Each entry gives the name, the default level and the format string of
+ * a diagnostics. In format strings, `%0` to `%3` are replaced by the arguments of the diagnostics message and `%%` by
+ * a single `%`.
+ */
+#define JVC_DIAGNOSTICS_LIST(h) \
+  h(UnexpectedEOF, Error, "Unexpected end-of-file.") \
+  h(UnrecognizedToken, Error, "Unrecognized token") \
+  h(UnclosedStringLiteral, Error, "Unclosed string literal.") \
+  h(UnexpectedChar, Error, "Unexpected input character: expected `%0`, but found `%1`") \
+  h(UnknownEscapeSequence, Error, "Unknown escape sequence: `\\%0`") \
+  h(UnknownDelimiter, Error, "Unknown delimiter: `%0`") \
+  h(UnknownOperator, Error, "Unknown operator: `%0`") \
+  h(IntegerLiteralOutOfRange, Error, "Number literal cannot fit into 64-bit integer type.") \
+  h(FloatLiteralOutOfRange, Error, "Number literal cannot fit into double precision floating point type.") \
+  h(NumberLiteralOutOfRange, Error, \
+    "Number literal cannot fit into either 64-bit integer type or double precision floating point type.") \
+  h(IntegerLiteralAsDouble, Warning, \
+    "Number literal is written in integer form but cannot fit in 64-bit integer type. " \
+    "Fallback to interpret it as a double precision floating point value instead.") \
+  h(CannotLoadSourceFile, Fatal, "cannot load source file: %0: %1") \
+  h(SourceLocationOutOfRange, Fatal, "source file is too large: %0: line %1, column %2 cannot be represented") \
+  h(CannotReadSourcePathRoot, Warning, "cannot read source path root: %0: %1") \
+  h(CannotReadSourcePathDirectory, Warning, "cannot read source path directory: %0: %1") \
+  h(CannotReadFileList, Fatal, "cannot read the list of input files: %0: %1") \
+  h(UnsupportedAction, Fatal, "Unsupported action type.") \
+  h(LexStatsNotCompiledIn, Warning, \
+    "--lex-stats has no effect since lexer statistics are not compiled in; " \
+    "reconfigure with -DJVC_ENABLE_LEX_STATS=ON")
+
+/**
+ * @brief Kinds of diagnostics, as listed in @see JVC_DIAGNOSTICS_LIST.
+ */
+enum class DiagnosticsKind {
+#define EMIT_ENUM_CLASS_VARIANT(name, level, format) name,
+  JVC_DIAGNOSTICS_LIST(EMIT_ENUM_CLASS_VARIANT)
+#undef EMIT_ENUM_CLASS_VARIANT
+};
+
+/**
+ * @brief Get the name of the given diagnostics kind.
+ * @param kind the diagnostics kind.
+ * @return the name of the given diagnostics kind.
+ */
+const char* GetDiagnosticsKindName(DiagnosticsKind kind);
+
+/**
+ * @brief Get the level at which diagnostics of the given kind are emitted.
+ * @param kind the diagnostics kind.
+ * @return the default level of the given diagnostics kind.
+ */
+DiagnosticsLevel GetDiagnosticsKindLevel(DiagnosticsKind kind);
+
+/**
+ * @brief Get the format string of the given diagnostics kind.
+ * @param kind the diagnostics kind.
+ * @return the format string of the given diagnostics kind.
+ */
+const char* GetDiagnosticsKindFormat(DiagnosticsKind kind);
+
+/**
+ * @brief Formats in which the diagnostics engine renders diagnostics messages.
+ */
+enum class DiagnosticsFormat {
+  /**
+   * @brief Human-readable text, with source code snippets.
+   */
+  Text,
+
+  /**
+   * @brief One JSON object per line and per diagnostics message, without source code snippets.
+   */
+  JsonLines,
+
+  /**
+   * @brief A single SARIF 2.1.0 log, whose results are streamed as diagnostics messages are rendered.
+   */
+  Sarif,
+};
+
 /**
  * @brief Provide options for the diagnostics engine.
  */
@@ -40,9 +129,32 @@ struct DiagnosticsOptions {
   bool TreatWarningsAsErrors;
 
   /**
-   * @brief Should we exit the compiler session on error diagnostics?
+   * @brief Should we cancel the compiler session on error diagnostics?
    */
   bool ExitOnError;
+
+  /**
+   * @brief Should diagnostics messages be queued and rendered in bulk, sorted by location, when the source code file
+   * they are reported against is flushed? Fatal diagnostics messages are never queued.
+   */
+  bool Queued;
+
+  /**
+   * @brief Maximum number of errors to report. Further errors are counted but neither queued nor rendered. If 0, the
+   * number of errors is unlimited.
+   */
+  size_t ErrorLimit;
+
+  /**
+   * @brief Maximum number of warnings to report. Further warnings are counted but neither queued nor rendered. If 0,
+   * the number of warnings is unlimited.
+   */
+  size_t WarningLimit;
+
+  /**
+   * @brief The format in which diagnostics messages are rendered.
+   */
+  DiagnosticsFormat Format;
 };
 
 /**
@@ -105,6 +217,13 @@ public:
   [[nodiscard]]
   SourceRange range() const { return _range; }
 
+  /**
+   * @brief Get the stable identifier of the diagnostics message, as reported in machine-readable formats.
+   * @return the identifier, or nullptr if the diagnostics message has none.
+   */
+  [[nodiscard]]
+  virtual const char* id() const { return nullptr; }
+
   /**
    * @brief Dump the message of this diagnostics message to the given output.
    * @param output a @see StreamWriter object associated with the output stream.
@@ -150,6 +269,196 @@ private:
   SourceRange _range;
 };
 
+/**
+ * @brief A small typed argument of a diagnostics message, held inline.
+ *
+ * String arguments are not copied: the referenced string must outlive the diagnostics message.
+ */
+class DiagnosticsArgument {
+public:
+  /**
+   * @brief Initialize an empty @see DiagnosticsArgument object.
+   */
+  DiagnosticsArgument()
+    : _kind(Kind::None),
+      _int(0)
+  { }
+
+  DiagnosticsArgument(char ch)  // NOLINT(google-explicit-constructor)
+    : _kind(Kind::Char),
+      _char(ch)
+  { }
+
+  DiagnosticsArgument(int value)  // NOLINT(google-explicit-constructor)
+    : _kind(Kind::Int),
+      _int(value)
+  { }
+
+  DiagnosticsArgument(int64_t value)  // NOLINT(google-explicit-constructor)
+    : _kind(Kind::Int),
+      _int(value)
+  { }
+
+  DiagnosticsArgument(uint64_t value)  // NOLINT(google-explicit-constructor)
+    : _kind(Kind::UInt),
+      _uint(value)
+  { }
+
+  DiagnosticsArgument(const char* s)  // NOLINT(google-explicit-constructor)
+    : DiagnosticsArgument(std::string_view { s })
+  { }
+
+  DiagnosticsArgument(const std::string& s)  // NOLINT(google-explicit-constructor)
+    : DiagnosticsArgument(std::string_view { s })
+  { }
+
+  DiagnosticsArgument(std::string_view s)  // NOLINT(google-explicit-constructor)
+    : _kind(Kind::String),
+      _string { s.data(), s.size() }
+  { }
+
+  /**
+   * @brief Create a @see DiagnosticsArgument object that is formatted as the description of the given error code.
+   * @param errorCode the error code, as found in errno.
+   * @return the created @see DiagnosticsArgument object.
+   */
+  static DiagnosticsArgument ErrorCode(int errorCode) {
+    DiagnosticsArgument arg { errorCode };
+    arg._kind = Kind::ErrorCode;
+    return arg;
+  }
+
+  /**
+   * @brief Determine whether this argument holds a value.
+   * @return whether this argument holds a value.
+   */
+  [[nodiscard]]
+  bool valid() const { return _kind != Kind::None; }
+
+  /**
+   * @brief Dump the value of this argument to the given output.
+   * @param output a @see StreamWriter object associated with the output stream.
+   */
+  void Dump(StreamWriter& output) const;
+
+  /**
+   * @brief Append a compact encoding of this argument to the given buffer. String arguments are copied into the
+   * buffer.
+   * @param buffer the buffer.
+   */
+  void Encode(std::string& buffer) const;
+
+  /**
+   * @brief Decode an argument encoded by @see Encode at the front of the given buffer, and remove it from the buffer.
+   * String arguments refer to the buffer, which must outlive the decoded argument.
+   * @param buffer the buffer.
+   * @return the decoded argument.
+   */
+  static DiagnosticsArgument Decode(std::string_view& buffer);
+
+private:
+  enum class Kind : uint8_t {
+    None,
+    Char,
+    Int,
+    UInt,
+    String,
+    ErrorCode,
+  };
+
+  struct StringArgument {
+    const char* Data;
+    size_t Size;
+  };
+
+  Kind _kind;
+  union {
+    char _char;
+    int64_t _int;
+    uint64_t _uint;
+    StringArgument _string;
+  };
+};
+
+/**
+ * @brief A diagnostics message of a kind listed in @see JVC_DIAGNOSTICS_LIST, carrying its arguments inline.
+ *
+ * Creating and emitting a @see Diagnostics object allocates nothing; the message is only formatted if the diagnostics
+ * engine actually reports it.
+ */
+class Diagnostics : public DiagnosticsMessage {
+public:
+  /**
+   * @brief Maximum number of arguments of a diagnostics message.
+   */
+  constexpr static const size_t MaxArguments = 4;
+
+  /**
+   * @brief Initialize a new @see Diagnostics object not associated with any source location.
+   * @param kind the diagnostics kind.
+   * @param arg0,arg1,arg2,arg3 the arguments. Trailing arguments can be omitted.
+   */
+  explicit Diagnostics(DiagnosticsKind kind,
+                       DiagnosticsArgument arg0 = { }, DiagnosticsArgument arg1 = { },
+                       DiagnosticsArgument arg2 = { }, DiagnosticsArgument arg3 = { })
+    : DiagnosticsMessage(GetDiagnosticsKindLevel(kind)),
+      _kind(kind),
+      _args { arg0, arg1, arg2, arg3 }
+  { }
+
+  /**
+   * @brief Initialize a new @see Diagnostics object.
+   * @param kind the diagnostics kind.
+   * @param loc the source location from which this diagnostics message is triggered.
+   * @param arg0,arg1,arg2,arg3 the arguments. Trailing arguments can be omitted.
+   */
+  explicit Diagnostics(DiagnosticsKind kind, SourceLocation loc,
+                       DiagnosticsArgument arg0 = { }, DiagnosticsArgument arg1 = { },
+                       DiagnosticsArgument arg2 = { }, DiagnosticsArgument arg3 = { })
+    : DiagnosticsMessage(GetDiagnosticsKindLevel(kind), loc),
+      _kind(kind),
+      _args { arg0, arg1, arg2, arg3 }
+  { }
+
+  /**
+   * @brief Initialize a new @see Diagnostics object.
+   * @param kind the diagnostics kind.
+   * @param range the source range from which this diagnostics message is triggered.
+   * @param arg0,arg1,arg2,arg3 the arguments. Trailing arguments can be omitted.
+   */
+  explicit Diagnostics(DiagnosticsKind kind, SourceRange range,
+                       DiagnosticsArgument arg0 = { }, DiagnosticsArgument arg1 = { },
+                       DiagnosticsArgument arg2 = { }, DiagnosticsArgument arg3 = { })
+    : DiagnosticsMessage(GetDiagnosticsKindLevel(kind), range),
+      _kind(kind),
+      _args { arg0, arg1, arg2, arg3 }
+  { }
+
+  /**
+   * @brief Get the kind of the diagnostics message.
+   * @return the kind of the diagnostics message.
+   */
+  [[nodiscard]]
+  DiagnosticsKind kind() const { return _kind; }
+
+  /**
+   * @brief Get the argument at the given index.
+   * @param index the index.
+   * @return the argument at the given index.
+   */
+  [[nodiscard]]
+  const DiagnosticsArgument& GetArgument(size_t index) const { return _args[index]; }
+
+  [[nodiscard]]
+  const char* id() const override { return GetDiagnosticsKindName(_kind); }
+
+  void DumpMessage(StreamWriter& output) const override;
+
+private:
+  DiagnosticsKind _kind;
+  std::array<DiagnosticsArgument, MaxArguments> _args;
+};
+
 /**
  * @brief Diagnostics engine used in JVC.
  */
@@ -161,13 +470,22 @@ public:
    */
   explicit DiagnosticsEngine(CompilerInstance& ci, DiagnosticsOptions options = DiagnosticsOptions { })
     : _ci(ci),
-      _opt(options)
+      _opt(options),
+      _serial(NextSerial.fetch_add(1, std::memory_order_relaxed)),
+      _errors(0),
+      _warnings(0),
+      _cancelled(false),
+      _suppressedReported(0),
+      _sarifResults(0),
+      _sarifOpened(false),
+      _sarifClosed(false)
   { }
 
   DiagnosticsEngine(const DiagnosticsEngine &) = delete;
-  DiagnosticsEngine(DiagnosticsEngine &&) noexcept = default;
+  DiagnosticsEngine(DiagnosticsEngine &&) = delete;
 
   DiagnosticsEngine& operator=(const DiagnosticsEngine &) = delete;
+  DiagnosticsEngine& operator=(DiagnosticsEngine &&) = delete;
 
   /**
    * @brief Destroy a @see DiagnosticsEngine object.
@@ -177,15 +495,80 @@ public:
   /**
    * @brief Emit the given message at the specified diagnostics level.
    *
-   * This function will not return if the specified diagnostics level is Fatal. This function may will not return if
-   * the specified diagnostics level is Error and the diagnostics engine is configured to not return under such
-   * circumstances.
+   * This function can be called from several threads at the same time. If the specified diagnostics level is Fatal, or
+   * if it is Error and the diagnostics engine is configured to stop on errors, the compiler session is cancelled: this
+   * function returns normally and workers are expected to poll @see IsCancelled and wind down.
    *
-   * @param level the diagnostics level.
    * @param message the diagnostics message.
    */
   virtual void Emit(const DiagnosticsMessage& message);
 
+  /**
+   * @brief Determine whether the compiler session has been cancelled by a fatal diagnostics message.
+   * @return whether the compiler session has been cancelled.
+   */
+  [[nodiscard]]
+  bool IsCancelled() const { return _cancelled.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Determine whether diagnostics messages of the specified level would be dropped because the configured limit
+   * has been hit. Callers can use this function to avoid building messages that would be dropped anyway.
+   * @param level the diagnostics level.
+   * @return whether diagnostics messages of the specified level would be dropped.
+   */
+  [[nodiscard]]
+  bool IsSuppressed(DiagnosticsLevel level) const;
+
+  /**
+   * @brief Merge the diagnostics messages queued by all threads against the specified source code file, and render
+   * them sorted by location. Messages reported at the same location are ordered the same way regardless of which
+   * threads reported them.
+   *
+   * This function should be called at phase boundaries, when no thread is reporting diagnostics against the file.
+   *
+   * @param fileId ID of the source code file.
+   */
+  void Flush(int fileId);
+
+  /**
+   * @brief Merge and render all queued diagnostics messages, ordered by source code file ID and then by location,
+   * together with the number of diagnostics messages dropped because of the configured limits.
+   */
+  void Flush();
+
+  /**
+   * @brief Flush all queued diagnostics messages, complete the output document if the output format needs one, and
+   * write buffered output through. This function should be called once no more diagnostics messages are emitted;
+   * calling it again has no effect other than flushing.
+   */
+  void Finish();
+
+  /**
+   * @brief Set the stream diagnostics messages are rendered to. Defaults to the standard error stream.
+   * @param output the output stream.
+   */
+  void SetOutput(std::unique_ptr<OutputStream> output);
+
+  /**
+   * @brief Set diagnostics options.
+   * @param options diagnostics options.
+   */
+  void SetOptions(DiagnosticsOptions options) { _opt = options; }
+
+  /**
+   * @brief Get the number of errors emitted so far, including the dropped ones.
+   * @return the number of errors emitted so far.
+   */
+  [[nodiscard]]
+  size_t GetErrorCount() const { return _errors.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Get the number of warnings emitted so far, including the dropped ones.
+   * @return the number of warnings emitted so far.
+   */
+  [[nodiscard]]
+  size_t GetWarningCount() const { return _warnings.load(std::memory_order_relaxed); }
+
 protected:
   /**
    * @brief Get diagnostics options.
@@ -195,8 +578,177 @@ protected:
   const DiagnosticsOptions& options() const { return _opt; }
 
 private:
+  class SnippetCache;
+
+  /**
+   * @brief A queued diagnostics message. Its arguments are encoded in the argument buffer of the queue, and the message
+   * is only formatted when it is rendered.
+   */
+  struct QueuedDiagnostics {
+    /**
+     * @brief Kind of queued messages that are not @see Diagnostics. Their text is formatted when they are queued and
+     * stored as their only argument, followed by the address of their identifier.
+     */
+    constexpr static const uint16_t LiteralKind = UINT16_MAX;
+
+    // The location, or the start of the range, the message is reported at.
+    SourceLocation Start;
+    // The end of the range the message is reported at; invalid if the message is reported at a single location.
+    SourceLocation End;
+    size_t ArgumentsOffset;
+    // Index of the message among the messages queued against the same file by the same thread.
+    uint32_t Sequence;
+    uint16_t Kind;
+    uint8_t ArgumentCount;
+    DiagnosticsLevel Level;
+  };
+
+  /**
+   * @brief Diagnostics messages queued against a single source code file.
+   */
+  struct DiagnosticsQueue {
+    std::vector<QueuedDiagnostics> Messages;
+    std::string Arguments;
+
+    /**
+     * @brief Get the number of bytes of memory held by this queue.
+     * @return the number of bytes of memory held by this queue.
+     */
+    [[nodiscard]]
+    size_t GetAllocatedSize() const {
+      // Short buffers are stored inline, in the string object itself.
+      auto argumentsSize = Arguments.capacity() > std::string { }.capacity() ? Arguments.capacity() : 0;
+      return Messages.capacity() * sizeof(QueuedDiagnostics) + argumentsSize;
+    }
+  };
+
+  /**
+   * @brief Diagnostics messages queued by a single thread, keyed by source code file ID. Messages without a location
+   * are queued under 0. Only the owning thread queues messages; the mutex is taken by others only when merging.
+   */
+  struct DiagnosticsShard {
+    std::map<int, DiagnosticsQueue> Queues;
+    std::mutex Mutex;
+  };
+
+  static std::atomic<uint64_t> NextSerial;
+
   CompilerInstance& _ci;
   DiagnosticsOptions _opt;
+  // Identify this engine in the per-thread shard caches, which cannot rely on addresses that may be reused.
+  uint64_t _serial;
+  std::atomic<size_t> _errors;
+  std::atomic<size_t> _warnings;
+  std::atomic<bool> _cancelled;
+  std::map<std::thread::id, std::unique_ptr<DiagnosticsShard>> _shards;
+  std::mutex _shardsMutex;
+  size_t _suppressedReported;
+  // The members below are guarded by _outputMutex.
+  std::mutex _outputMutex;
+  std::unique_ptr<StreamWriter> _output;
+  std::string _record;
+  size_t _sarifResults;
+  bool _sarifOpened;
+  bool _sarifClosed;
+
+  /**
+   * @brief Get the stream diagnostics messages are rendered to.
+   * @return the output stream.
+   */
+  StreamWriter& getOutput();
+
+  /**
+   * @brief Get the shard of the calling thread, creating it on first use.
+   * @return the shard of the calling thread.
+   */
+  DiagnosticsShard& getShard();
+
+  /**
+   * @brief Take the messages queued against the given source code file out of all shards, and merge them in a stable
+   * order.
+   * @param fileId ID of the source code file.
+   * @return the merged messages.
+   */
+  DiagnosticsQueue takeQueued(int fileId);
+
+  /**
+   * @brief Queue the given diagnostics message, encoding its arguments into the argument buffer of the given queue.
+   * @param queue the queue.
+   * @param message the diagnostics message.
+   * @param level the diagnostics level, as mapped by the configuration.
+   */
+  static void enqueue(DiagnosticsQueue& queue, const DiagnosticsMessage& message, DiagnosticsLevel level);
+
+  /**
+   * @brief Format the message of the given queued diagnostics message.
+   * @param queue the queue holding the message.
+   * @param message the queued diagnostics message.
+   * @param text output parameter, the formatted message.
+   * @return the identifier of the diagnostics message, or nullptr.
+   */
+  static const char* formatQueued(const DiagnosticsQueue& queue, const QueuedDiagnostics& message, std::string& text);
+
+  /**
+   * @brief Count a diagnostics message of the specified level against the configured limits.
+   * @param level the diagnostics level.
+   * @return whether the message is within the limits and should be reported.
+   */
+  bool countMessage(DiagnosticsLevel level);
+
+  /**
+   * @brief Render the given merged diagnostics messages into the given output.
+   * @param output the output.
+   * @param queue the diagnostics messages.
+   */
+  void render(StreamWriter& output, const DiagnosticsQueue& queue);
+
+  /**
+   * @brief Render a single diagnostics message into the given output, in the configured format.
+   * @param output the output.
+   * @param level the diagnostics level.
+   * @param id identifier of the diagnostics message, or nullptr.
+   * @param location the location.
+   * @param range the range. If valid, it takes precedence over the location.
+   * @param text the formatted message.
+   * @param cache cache of line views of the source code file.
+   */
+  void renderMessage(StreamWriter& output, DiagnosticsLevel level, const char* id, SourceLocation location,
+                     SourceRange range, std::string_view text, SnippetCache& cache);
+
+  /**
+   * @brief Build the JSON object describing a diagnostics message in the configured machine-readable format into
+   * _record.
+   * @param level the diagnostics level.
+   * @param id identifier of the diagnostics message, or nullptr.
+   * @param location the location.
+   * @param range the range. If valid, it takes precedence over the location.
+   * @param text the formatted message.
+   * @param cache cache of line views of the source code file.
+   */
+  void buildRecord(DiagnosticsLevel level, const char* id, SourceLocation location, SourceRange range,
+                   std::string_view text, SnippetCache& cache);
+
+  /**
+   * @brief Render the SARIF log header, including the table of rules, unless it has been rendered already.
+   * @param output the output.
+   */
+  void renderSarifHeader(StreamWriter& output);
+
+  /**
+   * @brief Render the number of diagnostics messages dropped because of the configured limits, if it has grown since
+   * the last time it was rendered.
+   * @param output the output.
+   */
+  void renderSuppressedCount(StreamWriter& output);
+
+  /**
+   * @brief Render the source code snippet and the caret line pointing at the given location or range.
+   * @param output the output.
+   * @param location the location.
+   * @param range the range. If valid, it takes precedence over the location.
+   * @param cache cache of line views of the source code file.
+   */
+  void renderSnippet(StreamWriter& output, SourceLocation location, SourceRange range, SnippetCache& cache) const;
 
   /**
    * @brief Map the given diagnostics level according to the diagnostics engine's configuration.
@@ -206,13 +758,13 @@ private:
   DiagnosticsLevel mapDiagLevel(DiagnosticsLevel level) const;
 
   /**
-   * @brief Determine whether the compiler session should exit on receiving a diagnostics message of the specified
-   * level.
+   * @brief Determine whether the compiler session should be cancelled on receiving a diagnostics message of the
+   * specified level.
    * @param level the diagnostics level.
-   * @return whether the compiler session should exit.
+   * @return whether the compiler session should be cancelled.
    */
   [[nodiscard]]
-  bool shouldExit(DiagnosticsLevel level) const;
+  bool shouldCancel(DiagnosticsLevel level) const;
 };
 
 } // namespace jvc
@@ -0,0 +1,126 @@
+//
+// Created by Sirui Mu on 2020/1/9.
+//
+
+#ifndef JVC_SOURCEFINGERPRINT_H
+#define JVC_SOURCEFINGERPRINT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace jvc {
+
+/**
+ * @brief A top-level block of a source code file: a top-level declaration together with the lines preceding it since
+ * the end of the previous declaration, such as comments and import declarations.
+ */
+struct SourceBlock {
+  /**
+   * @brief The first row of the block, inclusive.
+   */
+  uint64_t FirstRow;
+
+  /**
+   * @brief The last row of the block, exclusive.
+   */
+  uint64_t EndRow;
+
+  /**
+   * @brief Hash of the content of the block.
+   */
+  uint64_t Hash;
+};
+
+/**
+ * @brief A range of lines replaced between two versions of a source code file.
+ */
+struct SourceLineChange {
+  /**
+   * @brief The first replaced row in the old version. If no rows are removed, the rows are inserted before this row.
+   */
+  uint64_t OldFirstRow;
+
+  /**
+   * @brief Number of rows removed from the old version.
+   */
+  uint64_t OldRowCount;
+
+  /**
+   * @brief The first replacing row in the new version. If no rows are inserted, the rows are removed before this row.
+   */
+  uint64_t NewFirstRow;
+
+  /**
+   * @brief Number of rows inserted from the new version.
+   */
+  uint64_t NewRowCount;
+};
+
+/**
+ * @brief Hashes of the lines and of the top-level blocks of a source code file.
+ *
+ * Line hashes are combined into a polynomial rolling hash, so the hash of any range of lines is computed in constant
+ * time and two ranges of lines can be compared without looking at their content.
+ */
+class SourceLineFingerprints {
+public:
+  /**
+   * @brief Compute the fingerprints of the given content.
+   * @param content the content.
+   * @param lineStarts offsets at which the lines of the content start.
+   * @return the fingerprints.
+   */
+  static std::unique_ptr<SourceLineFingerprints> Build(std::string_view content,
+                                                       const std::vector<uint64_t>& lineStarts);
+
+  SourceLineFingerprints(const SourceLineFingerprints &) = delete;
+  SourceLineFingerprints(SourceLineFingerprints &&) = delete;
+
+  SourceLineFingerprints& operator=(const SourceLineFingerprints &) = delete;
+  SourceLineFingerprints& operator=(SourceLineFingerprints &&) = delete;
+
+  /**
+   * @brief Get the number of lines.
+   * @return the number of lines.
+   */
+  [[nodiscard]]
+  size_t lines() const { return _lineHashes.size(); }
+
+  /**
+   * @brief Get the hashes of all lines, including their line terminators. The hash of row i is at index i - 1.
+   * @return the hashes of all lines.
+   */
+  [[nodiscard]]
+  const std::vector<uint64_t>& GetLineHashes() const { return _lineHashes; }
+
+  /**
+   * @brief Get the rolling hash of the given range of lines.
+   * @param firstRow the first row, inclusive.
+   * @param endRow the last row, exclusive.
+   * @return the hash of the range. Ranges out of boundary are clamped.
+   */
+  [[nodiscard]]
+  uint64_t GetRangeHash(uint64_t firstRow, uint64_t endRow) const;
+
+  /**
+   * @brief Get the top-level blocks, which partition the lines of the source code file.
+   * @return the top-level blocks, ordered by position.
+   */
+  [[nodiscard]]
+  const std::vector<SourceBlock>& GetBlocks() const { return _blocks; }
+
+private:
+  std::vector<uint64_t> _lineHashes;
+  // _prefixHashes[i] is the rolling hash of the first i lines.
+  std::vector<uint64_t> _prefixHashes;
+  std::vector<SourceBlock> _blocks;
+
+  SourceLineFingerprints() = default;
+};
+
+} // namespace jvc
+
+#endif // JVC_SOURCEFINGERPRINT_H
@@ -6,6 +6,7 @@
 #define JVC_SOURCELOCATION_H
 
 #include <cassert>
+#include <cstdint>
 
 namespace jvc {
 
@@ -14,6 +15,12 @@ class StreamWriter;
 /**
  * @brief Provide a handle for a location in the source code. This class is designed to be small enough to be copied
  * efficiently.
+ *
+ * Rows and columns are 64-bit, but they are stored as two 32-bit integers, which covers every hand-written source code
+ * file. Locations beyond that, which only occur in huge generated files, refer to a segment of 2^20 rows by 2^20
+ * columns in a process-wide side table, and keep their offsets within the segment. Segments are shared by all the
+ * locations inside them, so the side table grows with the extent of the largest source code file rather than with the
+ * number of locations.
  */
 class SourceLocation {
 public:
@@ -27,16 +34,21 @@ public:
   { }
 
   /**
-   * @brief Initialize a new @class SourceLocation object.
+   * @brief Initialize a new @class SourceLocation object. If the location cannot be represented because the side table
+   * is full, which takes source code files of several TiB, the initialized location is invalid.
    * @param fileId the ID of the source code file.
    * @param row the row number of the specified location.
    * @param col the column number of the specified location.
    */
-  explicit SourceLocation(int fileId, int row, int col)
+  explicit SourceLocation(int fileId, uint64_t row, uint64_t col)
       : _fileId(fileId),
-        _row(row),
-        _col(col)
-  { }
+        _row(static_cast<uint32_t>(row)),
+        _col(static_cast<uint32_t>(col))
+  {
+    if (row >= LargeFlag || col > UINT32_MAX) {
+      encodeLarge(row, col);
+    }
+  }
 
   /**
    * @brief Determine whether the current @class SourceLocation object is valid.
@@ -57,14 +69,14 @@ public:
    * @return the row number of the source location.
    */
   [[nodiscard]]
-  int row() const { return _row; }
+  uint64_t row() const { return _row & LargeFlag ? decodeLargeRow() : _row; }
 
   /**
    * @brief Get the column number of the source location.
    * @return the column number of the source location.
    */
   [[nodiscard]]
-  int col() const { return _col; }
+  uint64_t col() const { return _row & LargeFlag ? decodeLargeCol() : _col; }
 
   /**
    * @brief Dump this @see SourceLocation object to the given output stream.
@@ -77,16 +89,36 @@ public:
 private:
   static constexpr const int InvalidFileId = -1;
 
+  // Bit of _row marking that the location refers to a segment in the side table. The remaining 63 bits of _row and _col
+  // hold the index of the segment and the offsets of the row and the column within it.
+  static constexpr const uint32_t LargeFlag = 1u << 31u;
+
   int _fileId;
-  int _row;
-  int _col;
+  uint32_t _row;
+  uint32_t _col;
+
+  /**
+   * @brief Store the given location through the side table, or invalidate this location if the side table is full.
+   * @param row the row number.
+   * @param col the column number.
+   */
+  void encodeLarge(uint64_t row, uint64_t col);
+
+  [[nodiscard]]
+  uint64_t decodeLargeRow() const;
+
+  [[nodiscard]]
+  uint64_t decodeLargeCol() const;
 };
 
+static_assert(sizeof(SourceLocation) == 12, "SourceLocation should stay small");
+
 inline bool operator==(const SourceLocation& lhs, const SourceLocation& rhs) {
   if (!lhs.valid() && !rhs.valid()) {
     return true;
   }
 
+  // Every location has a single encoding, since segments are never duplicated in the side table.
   return lhs._fileId == rhs._fileId &&
       lhs._row == rhs._row &&
       lhs._col == rhs._col;
@@ -5,19 +5,30 @@
 #ifndef JVC_SOURCEMANAGER_H
 #define JVC_SOURCEMANAGER_H
 
+#include "Infrastructure/ConcurrentTable.h"
+#include "Infrastructure/FileSystem.h"
+#include "Infrastructure/Hash.h"
+#include "Frontend/SourceFingerprint.h"
 #include "Frontend/SourceLocation.h"
 #include "Diagnostics.h"
 
 #include <cstdint>
 #include <cassert>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
-#include <vector>
 #include <unordered_map>
+#include <vector>
 
 namespace jvc {
 
 class InputStream;
+class MemoryBuffer;
+class ResponseFileReader;
+class StreamWriter;
 class CompilerInstance;
 
 /**
@@ -41,6 +52,26 @@ public:
    */
   static SourceFileInfo Load(int fileId, const std::string& path, DiagnosticsEngine& diag);
 
+  /**
+   * @brief Load the specified source code file from the given file system and returns a @see SourceFileInfo object,
+   * without emitting any diagnostics. This function can be called from any thread.
+   * @param fileId the ID of the new source code file.
+   * @param path the path to the source code file.
+   * @param fileSystem the file system.
+   * @param errorCode output parameter, the errno value describing why the file cannot be loaded, or 0 on success.
+   * @return a @see SourceFileInfo object containing information about the loaded source code file. If the file cannot
+   * be loaded, the returned object is empty.
+   */
+  static SourceFileInfo Load(int fileId, const std::string& path, const FileSystem& fileSystem, int& errorCode);
+
+  /**
+   * @brief Emit the fatal diagnostics message reporting that the specified source code file cannot be loaded.
+   * @param path the path to the source code file.
+   * @param errorCode the errno value describing why the file cannot be loaded.
+   * @param diag the diagnostics engine.
+   */
+  static void EmitLoadError(const std::string& path, int errorCode, DiagnosticsEngine& diag);
+
   /**
    * @brief Load the source code in the given input stream and returns a @see SourceFileInfo object.
    * @param fileId the ID of the new source code file.
@@ -50,6 +81,31 @@ public:
    */
   static SourceFileInfo Load(int fileId, const std::string& path, std::unique_ptr<InputStream> inputData);
 
+  /**
+   * @brief Create a @see SourceFileInfo object holding the given source code.
+   * @param fileId the ID of the new source code file.
+   * @param path path to the source code file.
+   * @param content the buffer holding the source code.
+   * @param fingerprint fingerprint of the source code, as computed by @see HashBytes128.
+   * @return a @see SourceFileInfo object containing information about the source code.
+   */
+  static SourceFileInfo Load(int fileId, const std::string& path, std::shared_ptr<const MemoryBuffer> content,
+                             Hash128 fingerprint);
+
+  /**
+   * @brief Create a @see SourceFileInfo object that reads the source code from the given input stream lazily.
+   *
+   * The source code is not read until the stream returned by @see CreateInputStream is consumed, and only a bounded
+   * window of the most recent lines is retained for diagnostics afterwards. Use this for inputs such as pipes whose
+   * size is unknown or too large to be held in memory.
+   *
+   * @param fileId the ID of the new source code file.
+   * @param path path to the source code file.
+   * @param inputData a @see std::unique_ptr to an @see InputStream object containing data of the source code file.
+   * @return a @see SourceFileInfo object containing information about the source code.
+   */
+  static SourceFileInfo LoadStreaming(int fileId, const std::string& path, std::unique_ptr<InputStream> inputData);
+
   SourceFileInfo(const SourceFileInfo &) = delete;
   SourceFileInfo(SourceFileInfo &&) noexcept;
 
@@ -108,19 +164,98 @@ public:
   std::string_view GetViewAtLoc(SourceLocation loc) const;
 
   /**
-   * @brief Get the whole content of the source code file.
+   * @brief Get the whole content of the source code file. For streaming source code files, only the retained window of
+   * the content that has been read so far is returned.
+   *
+   * If the content has been evicted by the source manager, it is reloaded. The returned view is only guaranteed to stay
+   * valid while the content is pinned by holding the buffer returned by @see GetBuffer.
+   *
    * @return the whole content of the source code file.
    */
   [[nodiscard]]
-  const std::string& GetContent() const;
+  std::string_view GetContent() const;
+
+  /**
+   * @brief Get the buffer holding the whole content of the source code file, reloading it if it has been evicted.
+   * Holding the returned buffer pins the content: views returned by this object stay valid until it is released.
+   * @return the buffer. Returns nullptr for streaming source code files, or if evicted content cannot be reloaded.
+   */
+  [[nodiscard]]
+  std::shared_ptr<const MemoryBuffer> GetBuffer() const;
 
   /**
-   * @brief Create a @see InputStream for accessing contents in this source code file.
+   * @brief Determine whether the whole content of this source code file is held in memory.
+   * @return whether the content is resident. Always returns true for streaming source code files.
+   */
+  [[nodiscard]]
+  bool IsResident() const;
+
+  /**
+   * @brief Determine whether this source code file is read in streaming mode.
+   * @return whether this source code file is read in streaming mode.
+   */
+  [[nodiscard]]
+  bool IsStreaming() const;
+
+  /**
+   * @brief Get the hash of the content of this source code file, which is the low half of its fingerprint.
+   * @return the hash of the content. Returns 0 for streaming source code files.
+   */
+  [[nodiscard]]
+  uint64_t GetContentHash() const;
+
+  /**
+   * @brief Get the 128-bit fingerprint of the content of this source code file, computed when the file is loaded.
+   * Two source code files with equal fingerprints can be considered to have the same content.
+   * @return the fingerprint of the content. Returns all zeros for streaming source code files.
+   */
+  [[nodiscard]]
+  Hash128 GetContentFingerprint() const;
+
+  /**
+   * @brief Get the fingerprints of the lines and of the top-level blocks of this source code file. They are computed
+   * the first time they are requested. Streaming source code files have no line fingerprints.
+   * @return the line and block fingerprints.
+   */
+  [[nodiscard]]
+  const SourceLineFingerprints& GetLineFingerprints() const;
+
+  /**
+   * @brief Compute the ranges of lines that changed between two versions of a source code file, by comparing line
+   * fingerprints rather than content.
+   * @param oldFile the old version.
+   * @param newFile the new version.
+   * @return the changed ranges of lines, ordered by position. Returns an empty vector if the two versions have the same
+   * content. If either version is a streaming source code file, the whole file is reported as changed.
+   */
+  static std::vector<SourceLineChange> Diff(const SourceFileInfo& oldFile, const SourceFileInfo& newFile);
+
+  /**
+   * @brief Create a @see InputStream for accessing contents in this source code file. For streaming source code files,
+   * the content can only be accessed once and subsequent calls return nullptr.
    * @return a @see InputStream for accessing contents in this source code file.
    */
   [[nodiscard]]
   std::unique_ptr<InputStream> CreateInputStream() const;
 
+  /**
+   * @brief Get the source location of the byte at the given offset.
+   * @param offset offset of the byte from the start of the source code file.
+   * @return the source location. Returns an invalid @see SourceLocation object if the offset is out of boundary, or,
+   * for streaming source code files, if its line has slid out of the retained window.
+   */
+  [[nodiscard]]
+  SourceLocation GetLocForOffset(size_t offset) const;
+
+  /**
+   * @brief Get the offset of the byte at the given source location.
+   * @param loc the source location.
+   * @param offset output parameter, offset of the byte from the start of the source code file.
+   * @return whether the offset is known. Returns false if the location does not belong to this source code file, is out
+   * of boundary, or, for streaming source code files, if its line has slid out of the retained window.
+   */
+  bool GetOffsetOfLoc(SourceLocation loc, size_t& offset) const;
+
   /**
    * @brief Get the location of the EOF indicator.
    * @return location of the EOF indicator.
@@ -128,7 +263,17 @@ public:
   [[nodiscard]]
   SourceLocation GetEOFLoc() const;
 
+  /**
+   * @brief Get the size of this source code file, in bytes. For streaming source code files, this is the number of
+   * bytes read so far.
+   * @return the size of this source code file.
+   */
+  [[nodiscard]]
+  size_t GetSize() const;
+
 private:
+  friend class SourceManager;
+
   int _id;
   std::string _path;
   std::unique_ptr<SourceFileLineBuffer> _lineBuffer;
@@ -140,10 +285,71 @@ private:
    * @param lineBuffer the line buffer.
    */
   explicit SourceFileInfo(int fileId, std::string path, std::unique_ptr<SourceFileLineBuffer> lineBuffer);
+
+  /**
+   * @brief Set the function used to reload the content of this source code file after it has been evicted.
+   * @param reloader the reloader. It returns nullptr if the content cannot be reloaded.
+   */
+  void setReloader(std::function<std::shared_ptr<const MemoryBuffer>()> reloader) const;
+
+  /**
+   * @brief Determine whether the content of this source code file can ever be evicted.
+   * @return whether a reloader has been set for this source code file.
+   */
+  [[nodiscard]]
+  bool canEvict() const;
+
+  /**
+   * @brief Evict the content of this source code file, unless it is being reloaded concurrently.
+   * @return the number of bytes evicted.
+   */
+  size_t tryEvict() const;
 }; // class SourceFileInfo
 
+/**
+ * @brief Memory used by the content of the source code files held by a @see SourceManager.
+ */
+struct SourceMemoryUsage {
+  /**
+   * @brief Number of content bytes currently held in memory.
+   */
+  size_t ResidentBytes;
+
+  /**
+   * @brief Largest number of content bytes held in memory at once so far.
+   */
+  size_t PeakResidentBytes;
+
+  /**
+   * @brief Total number of content bytes evicted so far.
+   */
+  size_t EvictedBytes;
+
+  /**
+   * @brief Number of evictions.
+   */
+  size_t Evictions;
+
+  /**
+   * @brief Number of times evicted content has been reloaded.
+   */
+  size_t Reloads;
+}; // struct SourceMemoryUsage
+
 /**
  * @brief Manages java source files used in current compiler session.
+ *
+ * Source code files are stored in a dense table indexed by file ID. Files can be loaded from multiple threads
+ * concurrently, and looking up a loaded file never blocks.
+ *
+ * Each file is loaded at most once: files are identified by their @see FileIdentity, so the same file
+ * reached through different paths (symbolic links, `./a/../a`, overlapping globs) maps to a single file ID. Source
+ * code loaded from in-memory streams is identified by its content.
+ *
+ * The memory held by file contents can be bounded by a budget, see @see SetMemoryBudget. Once the budget is exceeded,
+ * the contents of files that have been released through @see ReleaseFile are evicted, least recently released first.
+ * Evicted contents are transparently reloaded from the file system when they are needed again, e.g. to print a
+ * source snippet for a late diagnostics message.
  */
 class SourceManager {
 public:
@@ -154,9 +360,10 @@ public:
   explicit SourceManager(CompilerInstance& ci);
 
   SourceManager(const SourceManager &) = delete;
-  SourceManager(SourceManager &&) noexcept = default;
+  SourceManager(SourceManager &&) = delete;
 
   SourceManager& operator=(const SourceManager &) = delete;
+  SourceManager& operator=(SourceManager &&) = delete;
 
   /**
    * @brief Get the compiler instance.
@@ -165,14 +372,71 @@ public:
   [[nodiscard]]
   CompilerInstance& GetCompilerInstance() const { return _ci; }
 
+  /**
+   * @brief Get the file system source code files are loaded from.
+   * @return the file system.
+   */
+  [[nodiscard]]
+  const FileSystem& GetFileSystem() const { return *_fileSystem; }
+
+  /**
+   * @brief Set the file system source code files are loaded from. By default files are loaded from the disk. This
+   * function must not be called while source code files are being loaded.
+   *
+   * To compile unsaved editor buffers, pass a snapshot of an @see OverlayFileSystem.
+   *
+   * @param fileSystem the file system.
+   */
+  void SetFileSystem(std::shared_ptr<const FileSystem> fileSystem) { _fileSystem = std::move(fileSystem); }
+
+  /**
+   * @brief Get the maximum number of content bytes to keep in memory.
+   * @return the memory budget, in bytes. Returns 0 if the budget is unlimited.
+   */
+  [[nodiscard]]
+  size_t GetMemoryBudget() const;
+
+  /**
+   * @brief Set the maximum number of content bytes to keep in memory. The budget is soft: files that have not been
+   * released, and files whose content is pinned, are never evicted.
+   * @param budget the memory budget, in bytes. 0 means unlimited.
+   */
+  void SetMemoryBudget(size_t budget);
+
+  /**
+   * @brief Notify the source manager that the processing of the specified file has finished, which makes its content
+   * a candidate for eviction. Releasing a file again marks it as the most recently released one. Files loaded from a
+   * stream cannot be reloaded, so releasing them has no effect.
+   * @param fileId ID of the file.
+   */
+  void ReleaseFile(int fileId);
+
+  /**
+   * @brief Get the memory used by the content of the source code files.
+   * @return the memory usage.
+   */
+  [[nodiscard]]
+  SourceMemoryUsage GetMemoryUsage() const;
+
+  /**
+   * @brief Dump a summary of the memory used by the content of the source code files.
+   * @param output the output stream.
+   */
+  void DumpMemoryUsage(StreamWriter& output) const;
+
   /**
    * @brief Get the information about the specified source code file that has been loaded.
    * @param id the ID of the source code file.
    * @return pointer to a @see SourceFileInfo object containing information about the source code file. If the
-   * specified source code file could not be found, returns nullptr.
+   * specified source code file could not be found, or is still being loaded by another thread, returns nullptr.
    */
   [[nodiscard]]
-  const SourceFileInfo* GetSourceFileInfo(int id) const;
+  const SourceFileInfo* GetSourceFileInfo(int id) const {
+    if (id <= 0) {
+      return nullptr;
+    }
+    return _sources.Get(static_cast<size_t>(id) - 1);
+  }
 
   /**
    * @brief Get the information about the source code file referred to by the specified source location.
@@ -217,6 +481,11 @@ public:
    * If the file cannot be loaded, this function will emit a fatal error through the diagnostics engine associated with
    * the compiler instance.
    *
+   * If the path is "-", the source code is streamed from the standard input, see @see LoadStreaming.
+   *
+   * This function can be called from multiple threads concurrently. If the file has already been loaded, possibly
+   * through a different path, the ID of the existing file is returned.
+   *
    * @param path path to the source code file.
    * @return ID of the source code file.
    */
@@ -224,6 +493,10 @@ public:
 
   /**
    * @brief Load the source code contained in the given data stream.
+   *
+   * If source code with the same content has already been loaded from a data stream, the ID of the existing file is
+   * returned and the given name is ignored.
+   *
    * @param name the name of the source code file.
    * @param dataStream an @see InputStream object containing the source code.
    * @return ID of the source code file.
@@ -231,18 +504,126 @@ public:
   int Load(const std::string& name, std::unique_ptr<InputStream> dataStream);
 
   /**
-   * @brief Get the number of loaded source code files.
-   * @return the number of loaded source code files.
+   * @brief Register the source code contained in the given data stream without reading it up front. The source code
+   * is read as it is lexed and only a bounded window of recent lines is kept in memory.
+   * @param name the name of the source code file.
+   * @param dataStream an @see InputStream object containing the source code.
+   * @return ID of the source code file.
+   */
+  int LoadStreaming(const std::string& name, std::unique_ptr<InputStream> dataStream);
+
+  /**
+   * @brief Load all the given source code files, reading them and building their line tables in parallel.
+   *
+   * File IDs are assigned in the order of the given paths, so the result does not depend on the number of jobs or on
+   * thread scheduling. Files that cannot be loaded are reported through the diagnostics engine associated with the
+   * compiler instance after all files have been read, in the order of the given paths.
+   *
+   * @param paths paths to the source code files. "-" streams the standard input, as in @see Load.
+   * @param jobs the maximum number of threads to use. If 0, the number of hardware threads is used.
+   * @return IDs of the source code files, in the order of the given paths. Paths referring to the same file get the
+   * same ID.
+   */
+  std::vector<int> LoadAll(const std::vector<std::string>& paths, size_t jobs);
+
+  /**
+   * @brief Load all the source code files listed by the given reader, as in @see LoadAll. The list is consumed in
+   * batches: loading starts as soon as the first batch has been read, and the paths of a batch are released once the
+   * batch has been loaded, so only the returned file IDs and the paths of the files that failed to load are kept.
+   *
+   * File IDs are assigned in the order of the list. Files that cannot be loaded are reported after all files have been
+   * read, in the order of the list.
+   *
+   * @param paths the reader producing the paths to the source code files.
+   * @param jobs the maximum number of threads to use. If 0, the number of hardware threads is used.
+   * @return IDs of the source code files, in the order of the list.
+   */
+  std::vector<int> LoadAll(ResponseFileReader& paths, size_t jobs);
+
+  /**
+   * @brief Get the number of file IDs handed out. Valid file IDs are 1 through the returned value.
+   * @return the number of file IDs handed out.
    */
   [[nodiscard]]
   size_t size() const { return _sources.size(); }
 
 private:
   CompilerInstance& _ci;
-  std::unordered_map<int, SourceFileInfo> _sources;
+  std::shared_ptr<const FileSystem> _fileSystem;
+  ConcurrentTable<SourceFileInfo> _sources;
+
+  // Guards the identity indexes below. Reserving the file ID of a new file happens under this lock as well, so that
+  // concurrent loads of the same file agree on its ID.
+  std::mutex _identityMutex;
+  std::unordered_map<FileIdentity, int, FileIdentityHash> _filesByIdentity;
+  std::unordered_multimap<uint64_t, int> _filesByContentHash;
+
+  // Guards the memory accounting and the eviction queue below.
+  mutable std::mutex _evictionMutex;
+  size_t _memoryBudget;
+  SourceMemoryUsage _memoryUsage;
+  // Released files, least recently released first.
+  std::list<int> _evictionQueue;
+  std::unordered_map<int, std::list<int>::iterator> _evictionQueuePositions;
 
-  [[nodiscard]]
-  int getNextFileId() const;
+  /**
+   * @brief Get the ID of the file with the given path if it has been loaded, or reserve a new file ID for it.
+   * @param path path to the file.
+   * @param fileId output parameter, the file ID.
+   * @return whether a new file ID has been reserved, i.e. the caller is responsible for loading the file.
+   */
+  bool findOrReserveFile(const std::string& path, int& fileId);
+
+  /**
+   * @brief Load the specified file into its reserved slot.
+   * @param fileId the reserved ID of the file.
+   * @param path path to the file.
+   * @param errorCode output parameter, the errno value describing why the file cannot be loaded, or 0 on success.
+   */
+  void loadFile(int fileId, const std::string& path, int& errorCode);
+
+  /**
+   * @brief Get the identity of the specified file. Files on the disk are queried through the stat cache of the
+   * compiler instance.
+   * @param path path to the file.
+   * @param identity output parameter, the identity of the file.
+   * @return whether the file exists.
+   */
+  bool getFileIdentity(const std::string& path, FileIdentity& identity) const;
+
+  /**
+   * @brief Wait until the specified file, whose ID has been reserved by another thread, is published.
+   * @param fileId ID of the file.
+   * @return the file.
+   */
+  const SourceFileInfo& waitForFile(int fileId) const;
+
+  /**
+   * @brief Reserve the ID of a new source code file.
+   * @return the reserved file ID.
+   */
+  int reserveFileId();
+
+  /**
+   * @brief Publish a loaded source code file into its reserved slot.
+   * @param sourceFileInfo the source code file.
+   */
+  void publish(SourceFileInfo sourceFileInfo);
+
+  /**
+   * @brief Reload the content of the specified file after it has been evicted.
+   * @param fileId ID of the file.
+   * @param path path to the file.
+   * @param fingerprint fingerprint of the content when the file was loaded.
+   * @return the content, or nullptr if the file cannot be read or has changed on the file system.
+   */
+  std::shared_ptr<const MemoryBuffer> reload(int fileId, const std::string& path, Hash128 fingerprint);
+
+  /**
+   * @brief Evict released files until the resident content fits in the memory budget. Must be called with
+   * _evictionMutex held.
+   */
+  void enforceMemoryBudget();
 }; // class SourceManager
 
 } // namespace jvc
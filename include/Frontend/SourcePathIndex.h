@@ -0,0 +1,101 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#ifndef JVC_SOURCEPATHINDEX_H
+#define JVC_SOURCEPATHINDEX_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace jvc {
+
+class CompilerInstance;
+
+/**
+ * @brief Index the java source files found under the source path, by package.
+ *
+ * The source path is a list of root directories, walked in parallel when they are added. Package `a.b` corresponds to
+ * the subdirectory `a/b` of every root. Once the index has been built, resolving a qualified type name to its source
+ * file is a hash lookup that does not touch the file system. Like with `javac -sourcepath`, a type found under more
+ * than one root resolves to the file under the root added first.
+ */
+class SourcePathIndex {
+public:
+  /**
+   * @brief Initialize a new @see SourcePathIndex object.
+   * @param ci the compiler instance.
+   */
+  explicit SourcePathIndex(CompilerInstance& ci);
+
+  SourcePathIndex(const SourcePathIndex &) = delete;
+  SourcePathIndex(SourcePathIndex &&) = delete;
+
+  SourcePathIndex& operator=(const SourcePathIndex &) = delete;
+  SourcePathIndex& operator=(SourcePathIndex &&) = delete;
+
+  /**
+   * @brief Walk the given root directories and add the java source files found to the index. Roots that cannot be
+   * listed are reported as warnings through the diagnostics engine associated with the compiler instance.
+   * @param roots paths to the root directories. Each path may contain several roots separated by ':'.
+   * @param jobs the maximum number of threads to use. If 0, the number of hardware threads is used.
+   */
+  void AddRoots(const std::vector<std::string>& roots, size_t jobs);
+
+  /**
+   * @brief Get the path to the source file declaring the given type.
+   * @param qualifiedName the fully qualified name of the type, e.g. `a.b.C`. Nested types such as `a.b.C.D` resolve to
+   * the source file of their outermost type. A qualified name never resolves to a type in the unnamed package.
+   * @return path to the source file, or nullptr if no source file declares the given type.
+   */
+  [[nodiscard]]
+  const std::string* Resolve(std::string_view qualifiedName) const;
+
+  /**
+   * @brief Get the directories of the given package under all roots.
+   * @param packageName the package name, e.g. `a.b`. The unnamed package is denoted by an empty name.
+   * @return the directories, in the order of the roots, or nullptr if the package contains no source files.
+   */
+  [[nodiscard]]
+  const std::vector<std::string>* GetPackageDirectories(std::string_view packageName) const;
+
+  /**
+   * @brief Get the paths to all source files in the index, in the order of the roots, then of package directories and
+   * file names. Files shadowed by a root added earlier are not included.
+   * @return the paths to all source files in the index.
+   */
+  [[nodiscard]]
+  const std::vector<std::string>& GetFiles() const { return _files; }
+
+  /**
+   * @brief Get the number of packages containing source files.
+   * @return the number of packages.
+   */
+  [[nodiscard]]
+  size_t GetPackageCount() const { return _packages.size(); }
+
+private:
+  struct Package {
+    std::vector<std::string> Directories;
+    // Maps type names to paths of their source files.
+    std::unordered_map<std::string, std::string> Types;
+  };
+
+  CompilerInstance& _ci;
+  std::unordered_map<std::string, Package> _packages;
+  std::vector<std::string> _files;
+
+  /**
+   * @brief Walk the given root directory and add the java source files found to the index.
+   * @param root path to the root directory.
+   * @param jobs the maximum number of threads to use.
+   */
+  void addRoot(const std::string& root, size_t jobs);
+}; // class SourcePathIndex
+
+} // namespace jvc
+
+#endif // JVC_SOURCEPATHINDEX_H
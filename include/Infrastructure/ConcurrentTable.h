@@ -0,0 +1,169 @@
+//
+// Created by Sirui Mu on 2020/1/2.
+//
+
+#ifndef JVC_CONCURRENTTABLE_H
+#define JVC_CONCURRENTTABLE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace jvc {
+
+/**
+ * @brief A dense, append-only table of heap allocated objects indexed by consecutive integers.
+ *
+ * Slots live in segments whose sizes double, so the address of a slot never changes once its segment has been
+ * allocated and the table never needs to be locked or rehashed as it grows. Indexes are reserved atomically, so any
+ * number of threads can append entries at the same time. Lookups only perform two atomic loads and are wait-free.
+ *
+ * @tparam T type of the entries.
+ * @tparam FirstSegmentBits log2 of the number of slots in the first segment.
+ */
+template <typename T, size_t FirstSegmentBits = 10>
+class ConcurrentTable {
+public:
+  /**
+   * @brief Initialize a new, empty @see ConcurrentTable object.
+   */
+  ConcurrentTable()
+      : _size(0),
+        _segments { }
+  { }
+
+  ConcurrentTable(const ConcurrentTable &) = delete;
+  ConcurrentTable(ConcurrentTable &&) = delete;
+
+  ConcurrentTable& operator=(const ConcurrentTable &) = delete;
+  ConcurrentTable& operator=(ConcurrentTable &&) = delete;
+
+  /**
+   * @brief Destroy this @see ConcurrentTable object and all entries in it.
+   */
+  ~ConcurrentTable() {
+    for (size_t segment = 0; segment < MaxSegments; ++segment) {
+      auto slots = _segments[segment].load(std::memory_order_relaxed);
+      if (!slots) {
+        continue;
+      }
+      for (size_t i = 0; i < getSegmentSize(segment); ++i) {
+        delete slots[i].load(std::memory_order_relaxed);
+      }
+      delete[] slots;
+    }
+  }
+
+  /**
+   * @brief Reserve the next index. The slot of the reserved index stays empty until @see Emplace is called on it.
+   * @return the reserved index.
+   */
+  size_t Reserve() {
+    return _size.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Publish an entry into a reserved slot. Each reserved slot can be filled only once.
+   * @param index the index, which must have been returned by @see Reserve.
+   * @param value the entry.
+   * @return pointer to the published entry.
+   */
+  T* Emplace(size_t index, std::unique_ptr<T> value) {
+    assert(index < size() && "index has not been reserved.");
+
+    size_t segment;
+    size_t offset;
+    locate(index, segment, offset);
+
+    auto ptr = value.release();
+    auto& slot = getOrCreateSegment(segment)[offset];
+    assert(!slot.load(std::memory_order_relaxed) && "slot has already been filled.");
+    slot.store(ptr, std::memory_order_release);
+    return ptr;
+  }
+
+  /**
+   * @brief Reserve the next index and publish the given entry into it.
+   * @param value the entry.
+   * @return the index of the entry.
+   */
+  size_t Append(std::unique_ptr<T> value) {
+    auto index = Reserve();
+    Emplace(index, std::move(value));
+    return index;
+  }
+
+  /**
+   * @brief Get the entry at the given index.
+   * @param index the index.
+   * @return pointer to the entry. Returns nullptr if the index has not been reserved or the entry has not been
+   * published yet.
+   */
+  [[nodiscard]]
+  T* Get(size_t index) const {
+    size_t segment;
+    size_t offset;
+    locate(index, segment, offset);
+    if (segment >= MaxSegments) {
+      return nullptr;
+    }
+
+    auto slots = _segments[segment].load(std::memory_order_acquire);
+    if (!slots) {
+      return nullptr;
+    }
+    return slots[offset].load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Get the number of indexes reserved so far.
+   * @return the number of indexes reserved so far.
+   */
+  [[nodiscard]]
+  size_t size() const { return _size.load(std::memory_order_acquire); }
+
+private:
+  constexpr static const size_t MaxSegments = 64 - FirstSegmentBits;
+
+  std::atomic<size_t> _size;
+  std::atomic<std::atomic<T*>*> _segments[MaxSegments];
+
+  constexpr static size_t getSegmentSize(size_t segment) {
+    return static_cast<size_t>(1) << (FirstSegmentBits + segment);
+  }
+
+  static void locate(size_t index, size_t& segment, size_t& offset) {
+    // Segment k holds the indexes [(2^k - 1) * B, (2^(k+1) - 1) * B) where B is the size of the first segment, so the
+    // segment can be read off the position of the most significant bit of index + B.
+    auto biased = static_cast<uint64_t>(index) + (static_cast<uint64_t>(1) << FirstSegmentBits);
+    auto msb = 63 - static_cast<size_t>(__builtin_clzll(biased));
+    segment = msb - FirstSegmentBits;
+    offset = static_cast<size_t>(biased - (static_cast<uint64_t>(1) << msb));
+  }
+
+  std::atomic<T*>* getOrCreateSegment(size_t segment) {
+    auto slots = _segments[segment].load(std::memory_order_acquire);
+    if (slots) {
+      return slots;
+    }
+
+    auto segmentSize = getSegmentSize(segment);
+    auto created = new std::atomic<T*>[segmentSize];
+    for (size_t i = 0; i < segmentSize; ++i) {
+      created[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Another thread may have created the segment in the meantime, in which case we drop ours.
+    if (_segments[segment].compare_exchange_strong(slots, created, std::memory_order_acq_rel)) {
+      return created;
+    }
+    delete[] created;
+    return slots;
+  }
+};
+
+} // namespace jvc
+
+#endif // JVC_CONCURRENTTABLE_H
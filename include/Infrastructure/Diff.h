@@ -0,0 +1,68 @@
+//
+// Created by Sirui Mu on 2020/1/9.
+//
+
+#ifndef JVC_DIFF_H
+#define JVC_DIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jvc {
+
+/**
+ * @brief A range of elements replaced between two sequences.
+ */
+struct DiffHunk {
+  /**
+   * @brief Index of the first replaced element in the old sequence.
+   */
+  size_t OldStart;
+
+  /**
+   * @brief Number of elements removed from the old sequence.
+   */
+  size_t OldLength;
+
+  /**
+   * @brief Index of the first replacing element in the new sequence.
+   */
+  size_t NewStart;
+
+  /**
+   * @brief Number of elements inserted from the new sequence.
+   */
+  size_t NewLength;
+
+  bool operator==(const DiffHunk& rhs) const {
+    return OldStart == rhs.OldStart && OldLength == rhs.OldLength &&
+        NewStart == rhs.NewStart && NewLength == rhs.NewLength;
+  }
+};
+
+/**
+ * @brief Compute a shortest edit script between two sequences of hash values, using the greedy algorithm of Myers.
+ *
+ * Common prefixes and suffixes are stripped first, so the cost is proportional to the size of the changed region
+ * rather than to the length of the sequences. If the two sequences differ in more than @see MaxDiffEdits elements, the
+ * remaining changed region is reported as a single hunk instead.
+ *
+ * @param oldValues pointer to the old sequence.
+ * @param oldSize number of elements in the old sequence.
+ * @param newValues pointer to the new sequence.
+ * @param newSize number of elements in the new sequence.
+ * @return the hunks, ordered by position.
+ */
+std::vector<DiffHunk> DiffSequences(const uint64_t* oldValues, size_t oldSize,
+                                    const uint64_t* newValues, size_t newSize);
+
+/**
+ * @brief Maximum number of insertions and deletions @see DiffSequences searches for before giving up on a minimal
+ * edit script.
+ */
+constexpr const size_t MaxDiffEdits = 1024;
+
+} // namespace jvc
+
+#endif // JVC_DIFF_H
@@ -0,0 +1,67 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#ifndef JVC_DIRECTORYWALKER_H
+#define JVC_DIRECTORYWALKER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jvc {
+
+class StatCache;
+
+/**
+ * @brief Files found in a single directory by @see WalkDirectoryTree.
+ */
+struct DirectoryListing {
+  /**
+   * @brief Path to the directory.
+   */
+  std::string Path;
+
+  /**
+   * @brief Path to the directory relative to the root of the walk, with components separated by '/'. Empty for the
+   * root itself.
+   */
+  std::string RelativePath;
+
+  /**
+   * @brief Names of the files accepted by the filter, sorted.
+   */
+  std::vector<std::string> Files;
+
+  /**
+   * @brief The errno value describing why the directory cannot be listed, or 0 if it has been listed.
+   */
+  int ErrorCode;
+};
+
+/**
+ * @brief Walk the directory tree rooted at the given directory, listing the files accepted by the given filter.
+ *
+ * Subdirectories are listed in parallel. Entries are classified by the type reported along with the directory
+ * listing, so files rejected by the filter never cost a `stat` call; only entries of unknown type, which are queried
+ * with `lstat`, and symbolic links, which are queried through the given @see StatCache, cost one. Symbolic links to
+ * directories are never followed, which rules out cycles.
+ *
+ * @param root path to the root directory.
+ * @param jobs the maximum number of threads to use. If 0, the number of hardware threads is used.
+ * @param filter the filter, called with the name of every file found.
+ * @param statCache the stat cache.
+ * @param errorCode output parameter, the errno value describing why the root directory cannot be listed, or 0 on
+ * success.
+ * @return the directories containing files accepted by the filter, and the subdirectories that cannot be listed along
+ * with their error codes, sorted by relative path.
+ */
+std::vector<DirectoryListing> WalkDirectoryTree(const std::string& root, size_t jobs,
+                                                const std::function<bool(std::string_view)>& filter,
+                                                StatCache& statCache, int& errorCode);
+
+} // namespace jvc
+
+#endif // JVC_DIRECTORYWALKER_H
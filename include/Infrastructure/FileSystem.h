@@ -0,0 +1,174 @@
+//
+// Created by Sirui Mu on 2020/1/5.
+//
+
+#ifndef JVC_FILESYSTEM_H
+#define JVC_FILESYSTEM_H
+
+#include "Infrastructure/MemoryBuffer.h"
+#include "Infrastructure/PieceTable.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace jvc {
+
+class InputStream;
+
+/**
+ * @brief Identity of a file, used to detect the same file reached through different paths.
+ */
+struct FileIdentity {
+  uint64_t Device;
+  uint64_t Inode;
+
+  bool operator==(const FileIdentity& rhs) const {
+    return Device == rhs.Device && Inode == rhs.Inode;
+  }
+};
+
+/**
+ * @brief Hash function of @see FileIdentity values.
+ */
+struct FileIdentityHash {
+  size_t operator()(const FileIdentity& identity) const {
+    return std::hash<uint64_t> { }(identity.Device * 0x9E3779B97F4A7C15ull ^ identity.Inode);
+  }
+};
+
+/**
+ * @brief Abstract class of file systems source code files are read from.
+ */
+class FileSystem {
+public:
+  /**
+   * @brief Get the file system backed by the disk.
+   * @return the file system backed by the disk.
+   */
+  static std::shared_ptr<const FileSystem> GetRealFileSystem();
+
+  /**
+   * @brief Destroy this @see FileSystem object.
+   */
+  virtual ~FileSystem() = default;
+
+  /**
+   * @brief Open the specified file for reading.
+   * @param path path to the file.
+   * @param errorCode output parameter, the errno value describing why the file cannot be opened, or 0 on success.
+   * @return an @see InputStream reading the file, or nullptr if the file cannot be opened.
+   */
+  virtual std::unique_ptr<InputStream> OpenFile(const std::string& path, int& errorCode) const = 0;
+
+  /**
+   * @brief Read the whole content of the specified file. The default implementation reads the stream returned by
+   * @see OpenFile into memory.
+   * @param path path to the file.
+   * @param errorCode output parameter, the errno value describing why the file cannot be read, or 0 on success.
+   * @return a @see MemoryBuffer holding the content of the file, or nullptr if the file cannot be read.
+   */
+  virtual std::shared_ptr<const MemoryBuffer> ReadFile(const std::string& path, int& errorCode) const;
+
+  /**
+   * @brief Get the identity of the specified file.
+   * @param path path to the file.
+   * @param identity output parameter, the identity of the file.
+   * @return whether the file exists.
+   */
+  virtual bool GetFileIdentity(const std::string& path, FileIdentity& identity) const = 0;
+
+protected:
+  /**
+   * @brief Initialize a new @see FileSystem object.
+   */
+  FileSystem() = default;
+};
+
+/**
+ * @brief A file system in which in-memory files shadow the files of an underlying file system.
+ *
+ * In-memory files are typically the unsaved buffers of an editor. Edits to them are applied as deltas through
+ * @see PieceTable, so editing a large file does not copy it. All member functions can be called from multiple threads.
+ *
+ * A compilation should not read from an @see OverlayFileSystem that is still being edited; it should read from a
+ * snapshot taken by @see Snapshot instead, which keeps a consistent view of every in-memory file while new edits
+ * arrive.
+ */
+class OverlayFileSystem : public FileSystem {
+public:
+  /**
+   * @brief Initialize a new @see OverlayFileSystem object.
+   * @param base the underlying file system.
+   */
+  explicit OverlayFileSystem(std::shared_ptr<const FileSystem> base);
+
+  /**
+   * @brief Create or replace the in-memory file at the given path.
+   * @param path path to the file.
+   * @param content content of the file.
+   */
+  void SetFile(const std::string& path, std::string content);
+
+  /**
+   * @brief Replace a range of the in-memory file at the given path with the given text.
+   * @param path path to the file.
+   * @param offset offset of the range.
+   * @param length length of the range.
+   * @param text the text to insert in place of the range.
+   * @return whether the in-memory file exists.
+   */
+  bool EditFile(const std::string& path, size_t offset, size_t length, std::string_view text);
+
+  /**
+   * @brief Remove the in-memory file at the given path, so that the file in the underlying file system becomes visible
+   * again.
+   * @param path path to the file.
+   * @return whether the in-memory file existed.
+   */
+  bool RemoveFile(const std::string& path);
+
+  /**
+   * @brief Determine whether an in-memory file exists at the given path.
+   * @param path path to the file.
+   * @return whether an in-memory file exists at the given path.
+   */
+  [[nodiscard]]
+  bool HasFile(const std::string& path) const;
+
+  /**
+   * @brief Take an immutable snapshot of this file system. The cost is proportional to the number of in-memory files,
+   * not to their sizes.
+   * @return the snapshot.
+   */
+  [[nodiscard]]
+  std::shared_ptr<const FileSystem> Snapshot() const;
+
+  std::unique_ptr<InputStream> OpenFile(const std::string& path, int& errorCode) const override;
+
+  bool GetFileIdentity(const std::string& path, FileIdentity& identity) const override;
+
+private:
+  /**
+   * @brief An in-memory file. The inode number is assigned when the file is created and kept across edits.
+   */
+  struct OverlayFile {
+    PieceTable Content;
+    uint64_t Inode;
+  };
+
+  using FileMap = std::unordered_map<std::string, OverlayFile>;
+
+  class OverlayFileSystemSnapshot;
+
+  std::shared_ptr<const FileSystem> _base;
+  mutable std::mutex _mutex;
+  FileMap _files;
+};
+
+} // namespace jvc
+
+#endif // JVC_FILESYSTEM_H
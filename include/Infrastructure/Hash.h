@@ -0,0 +1,78 @@
+//
+// Created by Sirui Mu on 2020/1/3.
+//
+
+#ifndef JVC_HASH_H
+#define JVC_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace jvc {
+
+/**
+ * @brief Compute the 64-bit xxHash (XXH64) of the given buffer.
+ *
+ * XXH64 processes 32 bytes per iteration with four independent accumulators, which keeps hashing of whole source code
+ * files well below the cost of reading them.
+ *
+ * @param data pointer to the buffer.
+ * @param size size of the buffer, in bytes.
+ * @param seed the seed.
+ * @return the hash value.
+ */
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * @brief Compute the 64-bit xxHash (XXH64) of the given string.
+ * @param s the string.
+ * @param seed the seed.
+ * @return the hash value.
+ */
+inline uint64_t HashBytes(std::string_view s, uint64_t seed = 0) {
+  return HashBytes(s.data(), s.size(), seed);
+}
+
+/**
+ * @brief A 128-bit hash value.
+ */
+struct Hash128 {
+  uint64_t Low;
+  uint64_t High;
+
+  bool operator==(const Hash128& rhs) const {
+    return Low == rhs.Low && High == rhs.High;
+  }
+
+  bool operator!=(const Hash128& rhs) const {
+    return !(*this == rhs);
+  }
+};
+
+/**
+ * @brief Compute the 128-bit MurmurHash3 (x64 variant) of the given buffer.
+ *
+ * 128-bit hashes are wide enough to be used as content fingerprints: two different files are practically never given
+ * the same fingerprint, so equal fingerprints can stand in for a byte-by-byte comparison.
+ *
+ * @param data pointer to the buffer.
+ * @param size size of the buffer, in bytes.
+ * @param seed the seed.
+ * @return the hash value.
+ */
+Hash128 HashBytes128(const void* data, size_t size, uint32_t seed = 0);
+
+/**
+ * @brief Compute the 128-bit MurmurHash3 (x64 variant) of the given string.
+ * @param s the string.
+ * @param seed the seed.
+ * @return the hash value.
+ */
+inline Hash128 HashBytes128(std::string_view s, uint32_t seed = 0) {
+  return HashBytes128(s.data(), s.size(), seed);
+}
+
+} // namespace jvc
+
+#endif // JVC_HASH_H
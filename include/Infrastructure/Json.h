@@ -0,0 +1,51 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#ifndef JVC_JSON_H
+#define JVC_JSON_H
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace jvc {
+
+/**
+ * @brief Append the given string to the output as a quoted JSON string.
+ *
+ * Quotes, backslashes and control characters are escaped; all other bytes, including UTF-8 sequences, are copied
+ * verbatim in runs.
+ *
+ * @param output the output.
+ * @param s the string.
+ */
+void AppendJsonString(std::string& output, std::string_view s);
+
+/**
+ * @brief Append the given number to the output as a JSON number.
+ * @param output the output.
+ * @param value the number.
+ */
+inline void AppendJsonNumber(std::string& output, uint64_t value) {
+  char buffer[20];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  output.append(buffer, result.ptr - buffer);
+}
+
+/**
+ * @brief Append a comma and a member with the given name and number to the output, inside a JSON object that already
+ * has at least one member.
+ * @param output the output.
+ * @param name name of the member. It is not escaped.
+ * @param value the number.
+ */
+inline void AppendJsonField(std::string& output, std::string_view name, uint64_t value) {
+  output.append(",\"").append(name).append("\":");
+  AppendJsonNumber(output, value);
+}
+
+} // namespace jvc
+
+#endif // JVC_JSON_H
@@ -0,0 +1,116 @@
+//
+// Created by Sirui Mu on 2020/1/6.
+//
+
+#ifndef JVC_MEMORYBUFFER_H
+#define JVC_MEMORYBUFFER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace jvc {
+
+class InputStream;
+
+/**
+ * @brief An immutable, contiguous block of memory holding the content of a file.
+ *
+ * Buffers are shared through @see std::shared_ptr; holding a reference to a buffer keeps its content alive, which is
+ * how readers pin content that may otherwise be evicted.
+ */
+class MemoryBuffer {
+public:
+  /**
+   * @brief Files at least this large are memory mapped rather than read by @see FromFile.
+   */
+  constexpr static const size_t MemoryMapThreshold = 64 * 1024;
+
+  /**
+   * @brief Create a @see MemoryBuffer holding the given string.
+   * @param content the string.
+   * @return the created @see MemoryBuffer.
+   */
+  static std::shared_ptr<const MemoryBuffer> FromString(std::string content);
+
+  /**
+   * @brief Create a @see MemoryBuffer holding the content of the given file. Large files are memory mapped.
+   * @param path path to the file.
+   * @param errorCode output parameter, the errno value describing why the file cannot be read, or 0 on success.
+   * @return the created @see MemoryBuffer, or nullptr if the file cannot be read.
+   */
+  static std::shared_ptr<const MemoryBuffer> FromFile(const std::string& path, int& errorCode);
+
+  /**
+   * @brief Create an @see InputStream reading the given buffer. The stream keeps the buffer alive.
+   * @param buffer the buffer.
+   * @return the created @see InputStream.
+   */
+  static std::unique_ptr<InputStream> CreateInputStream(std::shared_ptr<const MemoryBuffer> buffer);
+
+  MemoryBuffer(const MemoryBuffer &) = delete;
+  MemoryBuffer(MemoryBuffer &&) = delete;
+
+  MemoryBuffer& operator=(const MemoryBuffer &) = delete;
+  MemoryBuffer& operator=(MemoryBuffer &&) = delete;
+
+  /**
+   * @brief Destroy this @see MemoryBuffer object, freeing or unmapping its content.
+   */
+  virtual ~MemoryBuffer() = default;
+
+  /**
+   * @brief Get a pointer to the content.
+   * @return pointer to the content.
+   */
+  [[nodiscard]]
+  const char* data() const { return _data; }
+
+  /**
+   * @brief Get the size of the content, in bytes.
+   * @return the size of the content.
+   */
+  [[nodiscard]]
+  size_t size() const { return _size; }
+
+  /**
+   * @brief Get a @see std::string_view referring to the content.
+   * @return the @see std::string_view.
+   */
+  [[nodiscard]]
+  std::string_view GetView() const { return std::string_view { _data, _size }; }
+
+  /**
+   * @brief Determine whether the content is memory mapped from a file.
+   * @return whether the content is memory mapped from a file.
+   */
+  [[nodiscard]]
+  virtual bool IsMemoryMapped() const { return false; }
+
+  /**
+   * @brief Get the number of bytes of memory held by this buffer, which may be larger than the size of the content.
+   * @return the number of bytes of memory held by this buffer.
+   */
+  [[nodiscard]]
+  virtual size_t GetAllocatedSize() const { return _size; }
+
+protected:
+  /**
+   * @brief Initialize a new @see MemoryBuffer object.
+   * @param data pointer to the content.
+   * @param size size of the content, in bytes.
+   */
+  explicit MemoryBuffer(const char* data, size_t size)
+    : _data(data),
+      _size(size)
+  { }
+
+private:
+  const char* _data;
+  size_t _size;
+};
+
+} // namespace jvc
+
+#endif // JVC_MEMORYBUFFER_H
@@ -0,0 +1,178 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#ifndef JVC_MEMORYUSAGE_H
+#define JVC_MEMORYUSAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jvc {
+
+class StreamWriter;
+
+/**
+ * @brief A named amount of memory held by a subsystem, registered in a process-wide registry and reported by
+ * `--mem-report` with its current and peak values. Define gauges with @see JVC_MEMORY_GAUGE at namespace scope.
+ */
+class alignas(64) MemoryGauge {
+public:
+  /**
+   * @brief Initialize a new @see MemoryGauge object and register it.
+   * @param name name of the gauge. It must have static storage duration.
+   * @param description description of the gauge. It must have static storage duration.
+   */
+  explicit MemoryGauge(const char* name, const char* description);
+
+  MemoryGauge(const MemoryGauge &) = delete;
+  MemoryGauge(MemoryGauge &&) = delete;
+
+  MemoryGauge& operator=(const MemoryGauge &) = delete;
+  MemoryGauge& operator=(MemoryGauge &&) = delete;
+
+  [[nodiscard]]
+  const char* name() const { return _name; }
+
+  [[nodiscard]]
+  const char* description() const { return _description; }
+
+  [[nodiscard]]
+  uint64_t current() const { return _current.load(std::memory_order_relaxed); }
+
+  [[nodiscard]]
+  uint64_t peak() const { return _peak.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Record that the given number of bytes are now held.
+   * @param bytes the number of bytes.
+   */
+  void Add(uint64_t bytes);
+
+  /**
+   * @brief Record that the given number of bytes, previously added, have been released.
+   * @param bytes the number of bytes.
+   */
+  void Subtract(uint64_t bytes) { _current.fetch_sub(bytes, std::memory_order_relaxed); }
+
+  /**
+   * @brief Get all registered gauges, sorted by name.
+   * @return all registered gauges.
+   */
+  static std::vector<const MemoryGauge *> GetAll();
+
+private:
+  const char* _name;
+  const char* _description;
+  std::atomic<uint64_t> _current;
+  std::atomic<uint64_t> _peak;
+};
+
+#define JVC_MEMORY_SUBSYSTEM_LIST(h) \
+    h(SourceManager) \
+    h(Lexer) \
+    h(TokenDumper) \
+    h(Diagnostics) \
+    h(Other)
+
+/**
+ * @brief Subsystems heap allocations are attributed to when allocation tracking is compiled in.
+ */
+enum class MemorySubsystem {
+#define DEF_VARIANT(v) v,
+  JVC_MEMORY_SUBSYSTEM_LIST(DEF_VARIANT)
+#undef DEF_VARIANT
+};
+
+/**
+ * @brief Report the memory used by the process.
+ *
+ * Heap allocations are only counted when the global operator new is replaced, which happens when the project is
+ * configured with `JVC_ENABLE_ALLOCATION_TRACKING` or `JVC_ENABLE_LEX_STATS`. Allocations are only attributed to
+ * subsystems with `JVC_ENABLE_ALLOCATION_TRACKING`, in which case the `JVC_ALLOCATION_TRACKING` macro is defined.
+ */
+class MemoryUsage {
+public:
+  /**
+   * @brief Determine whether heap allocations are attributed to subsystems.
+   * @return whether heap allocations are attributed to subsystems.
+   */
+  static bool IsAllocationTrackingEnabled();
+
+  /**
+   * @brief Get the number of heap allocations made by the calling thread so far. This is always 0 if the global
+   * operator new is not replaced.
+   * @return the number of heap allocations made by the calling thread so far.
+   */
+  static uint64_t GetThreadAllocationCount();
+
+  /**
+   * @brief Attribute the heap allocations of the calling thread to the given subsystem.
+   * @param subsystem the subsystem.
+   * @return the subsystem allocations were attributed to before.
+   */
+  static MemorySubsystem EnterSubsystem(MemorySubsystem subsystem);
+
+  /**
+   * @brief Attribute the heap allocations of the calling thread to the given subsystem again.
+   * @param outer the subsystem returned by the matching call to @see EnterSubsystem.
+   */
+  static void LeaveSubsystem(MemorySubsystem outer);
+
+  /**
+   * @brief Print the peak resident set size, the page faults, all registered gauges and, if compiled in, the heap
+   * allocations per subsystem.
+   * @param output the output.
+   */
+  static void Report(StreamWriter& output);
+};
+
+/**
+ * @brief RAII scope attributing the heap allocations of the calling thread to a subsystem. Compiles to nothing
+ * without `JVC_ALLOCATION_TRACKING`.
+ */
+class AllocationScope {
+public:
+  /**
+   * @brief Attribute the heap allocations of the calling thread to the given subsystem.
+   * @param subsystem the subsystem.
+   */
+  explicit AllocationScope(MemorySubsystem subsystem)
+#ifdef JVC_ALLOCATION_TRACKING
+    : _outer(MemoryUsage::EnterSubsystem(subsystem))
+#endif
+  {
+    static_cast<void>(subsystem);
+  }
+
+  AllocationScope(const AllocationScope &) = delete;
+  AllocationScope(AllocationScope &&) = delete;
+
+  AllocationScope& operator=(const AllocationScope &) = delete;
+  AllocationScope& operator=(AllocationScope &&) = delete;
+
+  /**
+   * @brief Attribute the heap allocations of the calling thread to the enclosing subsystem again.
+   */
+  ~AllocationScope() {
+#ifdef JVC_ALLOCATION_TRACKING
+    MemoryUsage::LeaveSubsystem(_outer);
+#endif
+  }
+
+#ifdef JVC_ALLOCATION_TRACKING
+private:
+  MemorySubsystem _outer;
+#endif
+};
+
+} // namespace jvc
+
+/**
+ * @brief Define a @see MemoryGauge with internal linkage. Use at namespace scope.
+ */
+#define JVC_MEMORY_GAUGE(name, description) static ::jvc::MemoryGauge name { #name, description }
+
+#endif // JVC_MEMORYUSAGE_H
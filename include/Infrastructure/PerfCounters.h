@@ -0,0 +1,158 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#ifndef JVC_PERFCOUNTERS_H
+#define JVC_PERFCOUNTERS_H
+
+#include <cstdint>
+
+namespace jvc {
+
+class StreamWriter;
+
+#define JVC_PERF_PHASE_LIST(h) \
+    h(Load) \
+    h(Lex) \
+    h(Dump) \
+    h(Diagnostics) \
+    h(Other)
+
+/**
+ * @brief Compilation phases measured by @see PerfCounters. Other covers everything outside the remaining phases.
+ */
+enum class PerfPhase {
+#define DEF_VARIANT(v) v,
+  JVC_PERF_PHASE_LIST(DEF_VARIANT)
+#undef DEF_VARIANT
+};
+
+#define JVC_PERF_COUNTER_LIST(h) \
+    h(Cycles) \
+    h(Instructions) \
+    h(BranchMisses) \
+    h(L1DMisses) \
+    h(LLCMisses) \
+    h(PageFaults) \
+    h(TaskClock)
+
+/**
+ * @brief Counters collected by @see PerfCounters. TaskClock is the CPU time, in nanoseconds. PageFaults always come
+ * from getrusage.
+ */
+enum class PerfCounter {
+#define DEF_VARIANT(v) v,
+  JVC_PERF_COUNTER_LIST(DEF_VARIANT)
+#undef DEF_VARIANT
+};
+
+/**
+ * @brief Source of the counters collected by @see PerfCounters.
+ */
+enum class PerfCounterSource {
+  /**
+   * @brief Hardware and software events of perf_event_open. Hardware events the machine does not support are missing.
+   */
+  Hardware,
+
+  /**
+   * @brief Only software events of perf_event_open, when hardware events are restricted or not virtualized.
+   */
+  Software,
+
+  /**
+   * @brief getrusage, when perf_event_open is not available at all.
+   */
+  ResourceUsage,
+};
+
+/**
+ * @brief Collect performance counters per thread and attribute them to the compilation phase the thread is in.
+ *
+ * Every thread opens its own counters the first time it enters a phase. Phases nest; time spent in a nested phase is
+ * only attributed to the nested phase. When the collector is not initialized, @see PerfCounterScope costs a single
+ * branch.
+ */
+class PerfCounters {
+public:
+  /**
+   * @brief Start collecting counters. This function should be called once, before any other thread is started.
+   */
+  static void Initialize();
+
+  /**
+   * @brief Stop collecting counters and discard the counters collected so far. No thread should be in a phase while
+   * this function is called.
+   */
+  static void Shutdown();
+
+  /**
+   * @brief Determine whether counters are being collected.
+   * @return whether counters are being collected.
+   */
+  static bool IsEnabled() { return Enabled; }
+
+  /**
+   * @brief Attribute the counters of the calling thread to the given phase, until the matching call to @see End.
+   * @param phase the phase.
+   */
+  static void Begin(PerfPhase phase);
+
+  /**
+   * @brief Return the calling thread to the phase it was in before the matching call to @see Begin.
+   */
+  static void End();
+
+  /**
+   * @brief Print the counters collected so far per phase, with the instructions per cycle and the costs per byte and
+   * per token. Threads other than the calling one should have exited.
+   * @param output the output.
+   * @param bytes number of bytes processed.
+   * @param tokens number of tokens produced.
+   */
+  static void Report(StreamWriter& output, uint64_t bytes, uint64_t tokens);
+
+private:
+  // Only written by Initialize and Shutdown, while no counter is being collected.
+  static bool Enabled;
+};
+
+/**
+ * @brief RAII scope attributing the counters of the calling thread to a phase.
+ */
+class PerfCounterScope {
+public:
+  /**
+   * @brief Enter the given phase if performance counters are being collected.
+   * @param phase the phase.
+   */
+  explicit PerfCounterScope(PerfPhase phase)
+    : _active(PerfCounters::IsEnabled())
+  {
+    if (_active) {
+      PerfCounters::Begin(phase);
+    }
+  }
+
+  PerfCounterScope(const PerfCounterScope &) = delete;
+  PerfCounterScope(PerfCounterScope &&) = delete;
+
+  PerfCounterScope& operator=(const PerfCounterScope &) = delete;
+  PerfCounterScope& operator=(PerfCounterScope &&) = delete;
+
+  /**
+   * @brief Leave the phase.
+   */
+  ~PerfCounterScope() {
+    if (_active) {
+      PerfCounters::End();
+    }
+  }
+
+private:
+  bool _active;
+};
+
+} // namespace jvc
+
+#endif // JVC_PERFCOUNTERS_H
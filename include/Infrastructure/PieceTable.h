@@ -0,0 +1,133 @@
+//
+// Created by Sirui Mu on 2020/1/5.
+//
+
+#ifndef JVC_PIECETABLE_H
+#define JVC_PIECETABLE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jvc {
+
+class InputStream;
+
+/**
+ * @brief A text buffer that applies edits as deltas over immutable storage.
+ *
+ * The content is described by a sequence of pieces, each referring to a range of either the original content or of an
+ * append-only buffer holding inserted text. Edits only rewrite the piece sequence, so the original content is never
+ * copied, and consecutive insertions (e.g. typing) extend a single piece.
+ *
+ * Copying a @see PieceTable takes a snapshot: the copy shares all storage with the original and is not affected by any
+ * edits made to the original afterwards, and vice versa. Snapshots can be read from other threads while the original
+ * is being edited.
+ */
+class PieceTable {
+public:
+  /**
+   * @brief Initialize a new, empty @see PieceTable object.
+   */
+  PieceTable();
+
+  /**
+   * @brief Initialize a new @see PieceTable object with the given original content.
+   * @param content the original content.
+   */
+  explicit PieceTable(std::string content);
+
+  /**
+   * @brief Take a snapshot of the given @see PieceTable object.
+   * @param other the @see PieceTable object.
+   */
+  PieceTable(const PieceTable& other);
+  PieceTable(PieceTable &&) noexcept = default;
+
+  PieceTable& operator=(const PieceTable& other);
+  PieceTable& operator=(PieceTable &&) noexcept = default;
+
+  /**
+   * @brief Get the size of the content, in bytes.
+   * @return the size of the content.
+   */
+  [[nodiscard]]
+  size_t size() const { return _size; }
+
+  /**
+   * @brief Get the number of pieces the content is made up of.
+   * @return the number of pieces.
+   */
+  [[nodiscard]]
+  size_t GetPieceCount() const { return _pieces->size(); }
+
+  /**
+   * @brief Replace a range of the content with the given text.
+   * @param offset offset of the range.
+   * @param length length of the range. The range is clipped to the end of the content.
+   * @param text the text to insert in place of the range.
+   */
+  void Replace(size_t offset, size_t length, std::string_view text);
+
+  /**
+   * @brief Insert the given text at the given offset.
+   * @param offset the offset. Offsets past the end of the content append to it.
+   * @param text the text.
+   */
+  void Insert(size_t offset, std::string_view text) { Replace(offset, 0, text); }
+
+  /**
+   * @brief Erase a range of the content.
+   * @param offset offset of the range.
+   * @param length length of the range. The range is clipped to the end of the content.
+   */
+  void Erase(size_t offset, size_t length) { Replace(offset, length, std::string_view { }); }
+
+  /**
+   * @brief Get the whole content as a contiguous string.
+   * @return the content.
+   */
+  [[nodiscard]]
+  std::string ToString() const;
+
+  /**
+   * @brief Create an @see InputStream reading the current content. The stream holds a snapshot of the content and is
+   * not affected by later edits.
+   * @return the created @see InputStream.
+   */
+  [[nodiscard]]
+  std::unique_ptr<InputStream> CreateInputStream() const;
+
+private:
+  struct Piece {
+    // Keeps the storage referred to by Data alive.
+    std::shared_ptr<const void> Owner;
+    const char* Data;
+    size_t Length;
+  };
+
+  // Size of the chunks the append-only buffer is made up of.
+  constexpr static const size_t AddChunkSize = 64 * 1024;
+
+  std::shared_ptr<const std::vector<Piece>> _pieces;
+  size_t _size;
+
+  // The chunk inserted text is appended to. Snapshots never append to the chunk of the table they were taken from.
+  std::shared_ptr<char[]> _addChunk;
+  size_t _addChunkUsed;
+
+  class PieceTableInputStream;
+
+  /**
+   * @brief Copy the given text into storage owned by this table.
+   * @param text the text.
+   * @return a piece referring to the copied text.
+   */
+  Piece store(std::string_view text);
+};
+
+} // namespace jvc
+
+#endif // JVC_PIECETABLE_H
@@ -0,0 +1,93 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#ifndef JVC_RESPONSEFILE_H
+#define JVC_RESPONSEFILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace jvc {
+
+class InputStream;
+
+/**
+ * @brief Syntax of a list of arguments read by @see ResponseFileReader.
+ */
+enum class ResponseFileSyntax {
+  /**
+   * @brief Arguments are separated by whitespaces, as in the `@argfiles` of javac. Single or double quotes group
+   * characters including whitespaces into one argument, and a backslash escapes the character following it.
+   */
+  Arguments,
+
+  /**
+   * @brief Every non-empty line is one argument, taken verbatim except for the line terminator. This is the syntax of
+   * the output of `find`.
+   */
+  Lines,
+};
+
+/**
+ * @brief Read a list of arguments, typically paths, from a stream.
+ *
+ * The stream is read in blocks as arguments are requested, so a consumer can start processing the first arguments of a
+ * list whose tail has not even been written yet, and the list is never held in memory as a whole.
+ */
+class ResponseFileReader {
+public:
+  /**
+   * @brief Initialize a new @see ResponseFileReader object.
+   * @param input the stream to read the arguments from.
+   * @param syntax syntax of the list.
+   */
+  explicit ResponseFileReader(std::unique_ptr<InputStream> input,
+                              ResponseFileSyntax syntax = ResponseFileSyntax::Arguments);
+
+  ResponseFileReader(const ResponseFileReader &) = delete;
+  ResponseFileReader(ResponseFileReader &&) noexcept;
+
+  ResponseFileReader& operator=(const ResponseFileReader &) = delete;
+  ResponseFileReader& operator=(ResponseFileReader &&) noexcept;
+
+  /**
+   * @brief Destroy this @see ResponseFileReader object.
+   */
+  ~ResponseFileReader();
+
+  /**
+   * @brief Read the next argument.
+   * @param argument output parameter, the argument.
+   * @return whether an argument has been read. Returns false at the end of the stream.
+   */
+  bool ReadNext(std::string& argument);
+
+  /**
+   * @brief Read up to the given number of arguments.
+   * @param arguments output parameter, the arguments read. Its previous content is discarded.
+   * @param maxCount the maximum number of arguments to read.
+   * @return the number of arguments read. Returns 0 at the end of the stream.
+   */
+  size_t ReadBatch(std::vector<std::string>& arguments, size_t maxCount);
+
+private:
+  std::unique_ptr<InputStream> _input;
+  ResponseFileSyntax _syntax;
+  std::unique_ptr<char[]> _buffer;
+  size_t _bufferSize;
+  size_t _readPtr;
+
+  /**
+   * @brief Get the next character in the stream without consuming it, refilling the buffer if necessary.
+   * @param ch output parameter, the character.
+   * @return whether a character is available.
+   */
+  bool peekChar(char& ch);
+};
+
+} // namespace jvc
+
+#endif // JVC_RESPONSEFILE_H
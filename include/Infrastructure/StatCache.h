@@ -0,0 +1,114 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#ifndef JVC_STATCACHE_H
+#define JVC_STATCACHE_H
+
+#include "Infrastructure/FileSystem.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace jvc {
+
+/**
+ * @brief Result of a `stat` call.
+ */
+struct FileStatus {
+  /**
+   * @brief The errno value describing why the path cannot be queried, or 0 if the path exists.
+   */
+  int ErrorCode;
+
+  /**
+   * @brief Is the path a directory?
+   */
+  bool IsDirectory;
+
+  /**
+   * @brief Is the path a regular file?
+   */
+  bool IsRegularFile;
+
+  /**
+   * @brief Size of the file, in bytes.
+   */
+  uint64_t Size;
+
+  /**
+   * @brief Identity of the file.
+   */
+  FileIdentity Identity;
+
+  /**
+   * @brief Determine whether the path exists.
+   * @return whether the path exists.
+   */
+  [[nodiscard]]
+  bool exists() const { return ErrorCode == 0; }
+};
+
+/**
+ * @brief Cache the results of `stat` calls for the duration of a compiler run.
+ *
+ * The file system is assumed not to change during a run, so every path is queried at most once. The cache is split
+ * into shards with separate locks so that threads walking different directories rarely contend with each other. All
+ * member functions can be called from multiple threads.
+ */
+class StatCache {
+public:
+  /**
+   * @brief Number of shards the cache is split into.
+   */
+  constexpr static const size_t ShardCount = 16;
+
+  StatCache();
+
+  StatCache(const StatCache &) = delete;
+  StatCache(StatCache &&) = delete;
+
+  StatCache& operator=(const StatCache &) = delete;
+  StatCache& operator=(StatCache &&) = delete;
+
+  /**
+   * @brief Get the status of the given path, following symbolic links. Only the first query of each path reaches the
+   * file system.
+   * @param path the path.
+   * @return the status of the path.
+   */
+  FileStatus Stat(const std::string& path);
+
+  /**
+   * @brief Get the number of queries answered from the cache.
+   * @return the number of queries answered from the cache.
+   */
+  [[nodiscard]]
+  size_t GetHits() const { return _hits.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Get the number of queries that reached the file system.
+   * @return the number of queries that reached the file system.
+   */
+  [[nodiscard]]
+  size_t GetMisses() const { return _misses.load(std::memory_order_relaxed); }
+
+private:
+  struct Shard {
+    std::mutex Mutex;
+    std::unordered_map<std::string, FileStatus> Entries;
+  };
+
+  std::array<Shard, ShardCount> _shards;
+  std::atomic<size_t> _hits;
+  std::atomic<size_t> _misses;
+};
+
+} // namespace jvc
+
+#endif // JVC_STATCACHE_H
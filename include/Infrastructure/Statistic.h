@@ -0,0 +1,102 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#ifndef JVC_STATISTIC_H
+#define JVC_STATISTIC_H
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace jvc {
+
+class StreamWriter;
+
+/**
+ * @brief A named counter registered in a process-wide registry, reported by `--stats` and `--stats-json`.
+ *
+ * Counters are updated with relaxed atomic operations and are always compiled in. Code that would update a counter
+ * once per byte or per token should accumulate locally and add the total once. Define counters with
+ * @see JVC_STATISTIC at namespace scope.
+ */
+class alignas(64) Statistic {
+public:
+  /**
+   * @brief Initialize a new @see Statistic object and register it.
+   * @param name name of the counter. It must have static storage duration.
+   * @param description description of the counter. It must have static storage duration.
+   */
+  explicit Statistic(const char* name, const char* description);
+
+  Statistic(const Statistic &) = delete;
+  Statistic(Statistic &&) = delete;
+
+  Statistic& operator=(const Statistic &) = delete;
+  Statistic& operator=(Statistic &&) = delete;
+
+  [[nodiscard]]
+  const char* name() const { return _name; }
+
+  [[nodiscard]]
+  const char* description() const { return _description; }
+
+  [[nodiscard]]
+  uint64_t value() const { return _value.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Add the given amount to the counter.
+   * @param amount the amount.
+   */
+  void Add(uint64_t amount) { _value.fetch_add(amount, std::memory_order_relaxed); }
+
+  Statistic& operator++() {
+    Add(1);
+    return *this;
+  }
+
+  Statistic& operator+=(uint64_t amount) {
+    Add(amount);
+    return *this;
+  }
+
+  /**
+   * @brief Get all registered counters, sorted by name.
+   * @return all registered counters.
+   */
+  static std::vector<const Statistic *> GetAll();
+
+  /**
+   * @brief Find the registered counter with the given name.
+   * @param name name of the counter.
+   * @return the counter. Returns nullptr if no counter has the given name.
+   */
+  static const Statistic* Find(std::string_view name);
+
+  /**
+   * @brief Print all registered counters as a human-readable table.
+   * @param output the output.
+   */
+  static void Print(StreamWriter& output);
+
+  /**
+   * @brief Print all registered counters as a single-line JSON object mapping names to values.
+   * @param output the output.
+   */
+  static void PrintJson(StreamWriter& output);
+
+private:
+  const char* _name;
+  const char* _description;
+  std::atomic<uint64_t> _value;
+};
+
+} // namespace jvc
+
+/**
+ * @brief Define a @see Statistic counter with internal linkage. Use at namespace scope.
+ */
+#define JVC_STATISTIC(name, description) static ::jvc::Statistic name { #name, description }
+
+#endif // JVC_STATISTIC_H
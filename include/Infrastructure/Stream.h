@@ -33,6 +33,14 @@ public:
    */
   static std::unique_ptr<InputStream> FromBuffer(const void* buffer, size_t bufferSize);
 
+  /**
+   * @brief Create an @see InputStream that reads contents from the given file.
+   * @param filename the name of the input file.
+   * @return a @see std::unique_ptr to the created @see InputStream object. This function returns nullptr if the file
+   * cannot be opened, in which case errno describes the error.
+   */
+  static std::unique_ptr<InputStream> FromFile(const std::string& filename);
+
   /**
    * @brief Destroy a @see InputStream object.
    */
@@ -60,6 +68,14 @@ protected:
   explicit InputStream() = default;
 };
 
+/**
+ * @brief A buffer written by @see OutputStream::WriteVectored.
+ */
+struct OutputBuffer {
+  const void* Data;
+  size_t Size;
+};
+
 /**
  * @brief Abstract class for output streams.
  */
@@ -73,13 +89,45 @@ public:
   static std::unique_ptr<OutputStream> FromSTL(std::ostream& inner);
 
   /**
-   * @brief Create an @see OutputStream wrapper that writes contents to the given file.
+   * @brief Create an @see OutputStream wrapper that writes contents to the given file. The file is written through a
+   * buffer of @see DefaultBufferCapacity bytes.
    * @param filename the name of the output file.
    * @return a @see std::unique_ptr to the created @see OutputStream object. This function returns nullptr if any errors
    * occured.
    */
   static std::unique_ptr<OutputStream> FromFile(const std::string& filename);
 
+  /**
+   * @brief Create an unbuffered @see OutputStream that writes contents to the given file descriptor. Vectored writes
+   * are forwarded to the operating system as a single call.
+   * @param fd the file descriptor.
+   * @param owned should the file descriptor be closed when the stream is destroyed?
+   * @return a @see std::unique_ptr to the created @see OutputStream object.
+   */
+  static std::unique_ptr<OutputStream> FromFileDescriptor(int fd, bool owned);
+
+  /**
+   * @brief Create an @see OutputStream that appends contents to the given string.
+   * @param buffer the string. It must outlive the returned @see OutputStream object.
+   * @return a @see std::unique_ptr to the created @see OutputStream object.
+   */
+  static std::unique_ptr<OutputStream> FromString(std::string& buffer);
+
+  /**
+   * @brief Default capacity of the buffer of an @see OutputStream created by @see CreateBuffered, in bytes.
+   */
+  constexpr static const size_t DefaultBufferCapacity = 64 * 1024;
+
+  /**
+   * @brief Create an @see OutputStream that collects small writes in a buffer and forwards them to the given stream in
+   * large blocks. The buffer is flushed when it is full, when @see Flush is called and when the stream is destroyed.
+   * @param inner the underlying stream.
+   * @param capacity capacity of the buffer, in bytes.
+   * @return a @see std::unique_ptr to the created @see OutputStream object.
+   */
+  static std::unique_ptr<OutputStream> CreateBuffered(std::unique_ptr<OutputStream> inner,
+                                                      size_t capacity = DefaultBufferCapacity);
+
   /**
    * @brief Destroy a @see OutputStream object.
    */
@@ -99,6 +147,20 @@ public:
    */
   virtual size_t Write(const void* buffer, size_t bufferSize) = 0;
 
+  /**
+   * @brief Write the given buffers into the output stream, in order. Streams backed by a file descriptor write all
+   * buffers with a single system call where possible, which saves gathering them into a contiguous buffer first.
+   * @param buffers the buffers.
+   * @param count number of buffers.
+   * @return number of bytes actually written into the output stream.
+   */
+  virtual size_t WriteVectored(const OutputBuffer* buffers, size_t count);
+
+  /**
+   * @brief Write any buffered data through to the underlying device.
+   */
+  virtual void Flush() { }
+
 protected:
   /**
    * @brief Initialize a new @see OutputStream object.
@@ -196,9 +258,22 @@ public:
   explicit StreamWriter(std::unique_ptr<OutputStream> inner)
     : _inner(std::move(inner)),
       _indent(0),
-      _atLineStart(false)
+      _atLineStart(false),
+      _writes(0),
+      _bytes(0)
   { }
 
+  StreamWriter(const StreamWriter &) = delete;
+  StreamWriter(StreamWriter &&) = delete;
+
+  StreamWriter& operator=(const StreamWriter &) = delete;
+  StreamWriter& operator=(StreamWriter &&) = delete;
+
+  /**
+   * @brief Destroy this @see StreamWriter object, adding its writes to the global statistics.
+   */
+  ~StreamWriter();
+
   /**
    * @brief Apply a single level of indent and returns a RAII wrapper that automatically frees the indent when it is
    * destroyed.
@@ -239,6 +314,11 @@ public:
    */
   void Write(std::string_view s);
 
+  /**
+   * @brief Write any buffered data in the underlying stream through to the underlying device.
+   */
+  void Flush();
+
   /**
    * @brief Write the given C-style string into the underlying stream followed by a new line character.
    * @param s the C-style string to be written.
@@ -270,9 +350,14 @@ private:
   std::unique_ptr<OutputStream> _inner;
   int _indent;
   bool _atLineStart;
+  // Writes not yet added to the global statistics. Counted locally since writers are called once per token.
+  uint64_t _writes;
+  uint64_t _bytes;
 
   void popIndent();
 
+  void publishStatistics();
+
   void writeIndentOnNecessary();
 };
 
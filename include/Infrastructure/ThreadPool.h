@@ -0,0 +1,91 @@
+//
+// Created by Sirui Mu on 2020/1/3.
+//
+
+#ifndef JVC_THREADPOOL_H
+#define JVC_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jvc {
+
+/**
+ * @brief A fixed-size pool of worker threads executing submitted tasks in FIFO order.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Initialize a new @see ThreadPool object.
+   * @param threads the number of worker threads. If 0, the number of hardware threads is used.
+   */
+  explicit ThreadPool(size_t threads);
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+
+  ThreadPool& operator=(const ThreadPool &) = delete;
+  ThreadPool& operator=(ThreadPool &&) = delete;
+
+  /**
+   * @brief Wait for all submitted tasks to finish and destroy this @see ThreadPool object.
+   */
+  ~ThreadPool();
+
+  /**
+   * @brief Get the number of hardware threads available, or 1 if it cannot be determined.
+   * @return the number of hardware threads available.
+   */
+  static size_t GetDefaultConcurrency();
+
+  /**
+   * @brief Get the number of worker threads.
+   * @return the number of worker threads.
+   */
+  [[nodiscard]]
+  size_t size() const { return _workers.size(); }
+
+  /**
+   * @brief Submit a task to the pool.
+   * @param task the task.
+   */
+  void Submit(std::function<void()> task);
+
+  /**
+   * @brief Block until all tasks submitted so far have finished.
+   */
+  void Wait();
+
+private:
+  std::vector<std::thread> _workers;
+  std::deque<std::function<void()>> _tasks;
+  std::mutex _mutex;
+  std::condition_variable _taskAvailable;
+  std::condition_variable _idle;
+  // Number of tasks that are queued or running.
+  size_t _pending;
+  bool _stopping;
+
+  void runWorker();
+};
+
+/**
+ * @brief Call the given function on every index in [0, count) using up to the given number of threads.
+ *
+ * Indexes are handed out dynamically so that uneven work items are balanced across threads. When jobs is 1 the
+ * function is called on the calling thread, in index order.
+ *
+ * @param jobs the maximum number of threads to use. If 0, the number of hardware threads is used.
+ * @param count the number of indexes.
+ * @param body the function to call on each index.
+ */
+void ParallelFor(size_t jobs, size_t count, const std::function<void(size_t)>& body);
+
+} // namespace jvc
+
+#endif // JVC_THREADPOOL_H
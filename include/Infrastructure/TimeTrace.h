@@ -0,0 +1,119 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#ifndef JVC_TIMETRACE_H
+#define JVC_TIMETRACE_H
+
+#include <chrono>
+#include <string_view>
+
+namespace jvc {
+
+class OutputStream;
+
+/**
+ * @brief Collect nested, per-thread scopes of wall-clock time, and write them in the Chrome Trace Event format.
+ *
+ * Every thread records events into its own buffer, so recording an event takes no lock. When the profiler is not
+ * initialized, @see TimeTraceScope costs a single branch.
+ */
+class TimeTraceProfiler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * @brief Start collecting events. This function should be called once, before any other thread is started.
+   */
+  static void Initialize();
+
+  /**
+   * @brief Stop collecting events and discard the events collected so far. No thread should be recording events while
+   * this function is called.
+   */
+  static void Shutdown();
+
+  /**
+   * @brief Determine whether events are being collected.
+   * @return whether events are being collected.
+   */
+  static bool IsEnabled() { return Enabled; }
+
+  /**
+   * @brief Get the time at which the process started, or, more precisely, at which this library was loaded.
+   * @return the time at which the process started.
+   */
+  static Clock::time_point GetProcessStartTime();
+
+  /**
+   * @brief Open a scope on the calling thread. Scopes must be closed in the reverse order they are opened.
+   * @param name name of the scope. It must have static storage duration.
+   * @param detail details of the scope, e.g. the path of the processed source code file.
+   */
+  static void Begin(const char* name, std::string_view detail);
+
+  /**
+   * @brief Close the innermost open scope on the calling thread.
+   */
+  static void End();
+
+  /**
+   * @brief Record a complete event on the calling thread, for time spans measured before the profiler was initialized.
+   * @param name name of the event. It must have static storage duration.
+   * @param start the start time.
+   * @param end the end time.
+   */
+  static void AddEvent(const char* name, Clock::time_point start, Clock::time_point end);
+
+  /**
+   * @brief Write all events collected so far as a Chrome Trace Event JSON document, one lane per thread. No thread
+   * should be recording events while this function is called.
+   * @param output the output.
+   */
+  static void Write(OutputStream& output);
+
+private:
+  // Only written by Initialize and Shutdown, while no event is being recorded.
+  static bool Enabled;
+};
+
+/**
+ * @brief RAII scope of the time trace profiler.
+ */
+class TimeTraceScope {
+public:
+  /**
+   * @brief Open a scope if the time trace profiler is collecting events.
+   * @param name name of the scope. It must have static storage duration.
+   * @param detail details of the scope.
+   */
+  explicit TimeTraceScope(const char* name, std::string_view detail = { })
+    : _active(TimeTraceProfiler::IsEnabled())
+  {
+    if (_active) {
+      TimeTraceProfiler::Begin(name, detail);
+    }
+  }
+
+  TimeTraceScope(const TimeTraceScope &) = delete;
+  TimeTraceScope(TimeTraceScope &&) = delete;
+
+  TimeTraceScope& operator=(const TimeTraceScope &) = delete;
+  TimeTraceScope& operator=(TimeTraceScope &&) = delete;
+
+  /**
+   * @brief Close the scope.
+   */
+  ~TimeTraceScope() {
+    if (_active) {
+      TimeTraceProfiler::End();
+    }
+  }
+
+private:
+  bool _active;
+};
+
+} // namespace jvc
+
+#endif // JVC_TIMETRACE_H
@@ -0,0 +1,90 @@
+//
+// Created by Sirui Mu on 2019/12/28.
+//
+
+#ifndef JVC_UNICODE_H
+#define JVC_UNICODE_H
+
+#include <cstddef>
+#include <string>
+
+namespace jvc {
+
+/**
+ * @brief The code point used to replace malformed UTF-8 sequences.
+ */
+constexpr const char32_t ReplacementCharacter = 0xFFFD;
+
+/**
+ * @brief Determine whether the given byte is an ASCII character.
+ * @param ch the byte.
+ * @return whether the given byte is an ASCII character.
+ */
+inline bool IsASCII(char ch) {
+  return (static_cast<unsigned char>(ch) & 0x80u) == 0;
+}
+
+/**
+ * @brief Determine whether all bytes in the given buffer are ASCII characters.
+ *
+ * The buffer is scanned a machine word at a time so that this function can be used as a cheap block-wide check before
+ * taking any slower, Unicode-aware path.
+ *
+ * @param data pointer to the buffer.
+ * @param size size of the buffer, in bytes.
+ * @return whether all bytes in the given buffer are ASCII characters.
+ */
+bool IsASCII(const char* data, size_t size);
+
+/**
+ * @brief Determine whether the given byte is a UTF-8 continuation byte, i.e. a byte of the form 10xxxxxx.
+ * @param ch the byte.
+ * @return whether the given byte is a UTF-8 continuation byte.
+ */
+inline bool IsUTF8ContinuationByte(char ch) {
+  return (static_cast<unsigned char>(ch) & 0xC0u) == 0x80u;
+}
+
+/**
+ * @brief Get the length of the UTF-8 sequence started by the given leading byte.
+ * @param leader the leading byte.
+ * @return length of the UTF-8 sequence, in bytes. Returns 0 if the given byte cannot start a UTF-8 sequence.
+ */
+size_t GetUTF8SequenceLength(char leader);
+
+/**
+ * @brief Decode a single code point from the given UTF-8 buffer.
+ * @param data pointer to the buffer.
+ * @param size size of the buffer, in bytes.
+ * @param cp output parameter, the decoded code point. Malformed sequences decode to @see ReplacementCharacter.
+ * @return number of bytes consumed. This function returns 0 only if the buffer is empty.
+ */
+size_t DecodeUTF8(const char* data, size_t size, char32_t& cp);
+
+/**
+ * @brief Append the UTF-8 encoding of the given code point to the given string.
+ * @param cp the code point.
+ * @param output the output string.
+ * @return number of bytes appended.
+ */
+size_t EncodeUTF8(char32_t cp, std::string& output);
+
+/**
+ * @brief Determine whether the given code point can start a java identifier, as defined by
+ * `Character.isJavaIdentifierStart`.
+ * @param cp the code point.
+ * @return whether the given code point can start a java identifier.
+ */
+bool IsJavaIdentifierStart(char32_t cp);
+
+/**
+ * @brief Determine whether the given code point can be part of a java identifier, as defined by
+ * `Character.isJavaIdentifierPart`.
+ * @param cp the code point.
+ * @return whether the given code point can be part of a java identifier.
+ */
+bool IsJavaIdentifierPart(char32_t cp);
+
+} // namespace jvc
+
+#endif // JVC_UNICODE_H
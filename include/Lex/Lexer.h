@@ -9,12 +9,15 @@
 #include "Lex/Token.h"
 #include "Lex/SourceLocationBuilder.h"
 
+#include <array>
 #include <memory>
 #include <optional>
+#include <vector>
 
 namespace jvc {
 
 class CompilerInstance;
+class LexerStatistics;
 
 /**
  * @brief Provide options for lexers.
@@ -29,6 +32,12 @@ struct LexerOptions {
    * @brief Should lexer keep whitespace tokens in its output stream?
    */
   bool KeepWhitespace;
+
+  /**
+   * @brief Should lexer collect statistics about the tokens it produces? This option has no effect unless lexer
+   * statistics are compiled in, see @see LexerStatistics.
+   */
+  bool CollectStatistics;
 };
 
 /**
@@ -43,7 +52,8 @@ public:
    * @param ci the compiler instance
    * @param sourceFileId ID of the source code file.
    * @param options lexer options.
-   * @return a @see std::unique_ptr to the created @see Lexer object.
+   * @return a @see std::unique_ptr to the created @see Lexer object. Returns nullptr if the source code file has not
+   * been loaded, or if it is a streaming source code file whose content has already been handed to another lexer.
    */
   static std::unique_ptr<Lexer> Create(CompilerInstance& ci, int sourceFileId, LexerOptions options = LexerOptions { });
 
@@ -85,6 +95,17 @@ public:
    */
   std::unique_ptr<Token> ReadNextToken();
 
+  /**
+   * @brief Consume all remaining tokens and append them to the given vector.
+   *
+   * This is equivalent to calling @see ReadNextToken until EOS is hit, but avoids re-checking the peek buffer for every
+   * token.
+   *
+   * @param tokens the vector to which the tokens are appended.
+   * @return the number of tokens appended.
+   */
+  size_t ReadAllTokens(std::vector<std::unique_ptr<Token>>& tokens);
+
   /**
    * @brief Get the source code location to which the underlying stream's read pointer refers.
    *
@@ -97,6 +118,13 @@ public:
   [[nodiscard]]
   SourceLocation GetNextLocation() const { return _locBuilder.GetSourceLocation(); }
 
+  /**
+   * @brief Get the statistics collected by this lexer.
+   * @return the statistics collected by this lexer. Returns nullptr if statistics are not collected.
+   */
+  [[nodiscard]]
+  const LexerStatistics* GetStatistics() const;
+
 private:
   /**
    * @brief Initialize a new @see Lexer object.
@@ -113,6 +141,15 @@ private:
   SourceLocationBuilder _locBuilder;
   std::unique_ptr<LexerStreamReader> _reader;
   std::unique_ptr<Token> _peekBuffer;
+#define COUNT_VARIANT(v) + 1
+  constexpr static const size_t TokenKindCount = 0 JVC_TOKEN_KIND_LIST(COUNT_VARIANT);
+#undef COUNT_VARIANT
+
+  // Tokens lexed so far, by kind; added to the global statistics when the lexer is destroyed.
+  std::array<uint64_t, TokenKindCount> _tokenCounts;
+#ifdef JVC_LEX_STATS
+  std::unique_ptr<LexerStatistics> _stats;
+#endif
 
   /**
    * @brief Peek next character from the underlying @see LexerStreamReader object. This function will not update the
@@ -177,15 +214,21 @@ private:
   bool shouldKeepCurrentToken() const;
 
   /**
-   * @brief Peek the next lexical token into the internal peek buffer. This function does most of the job of the lexer.
+   * @brief Peek the next lexical token into the internal peek buffer, recording statistics about it if requested.
    */
   void peek();
 
+  /**
+   * @brief Lex the next lexical token into the internal peek buffer. This function does most of the job of the lexer.
+   */
+  void lexNextToken();
+
   // The following functions are used by peek during lex to transfer lexer control flow into concrete lexical token
   // types.
 
   void lexKeywordOrIdentifier(SourceLocation startLoc);
   void lexIdentifier(SourceLocation startLoc);
+  bool lexUnicodeIdentifierPart(std::string& name);
   void lexStringLiteral(SourceLocation startLoc);
   void lexCharLiteral(SourceLocation startLoc);
   void lexStringLiteralCharacter(std::string& literal, std::string& content);
@@ -0,0 +1,214 @@
+//
+// Created by Sirui Mu on 2019/12/31.
+//
+
+#ifndef JVC_LEXERSTATISTICS_H
+#define JVC_LEXERSTATISTICS_H
+
+#include "Frontend/SourceLocation.h"
+#include "Lex/Token.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jvc {
+
+class StreamWriter;
+
+#define JVC_LEXER_ROUTINE_LIST(h) \
+    h(Whitespace) \
+    h(KeywordOrIdentifier) \
+    h(Identifier) \
+    h(StringLiteral) \
+    h(CharLiteral) \
+    h(NumberLiteralOrOperator) \
+    h(NumberLiteral) \
+    h(Delimiter) \
+    h(Operator) \
+    h(DivideOperatorOrComment) \
+    h(BlockComment) \
+    h(LineComment)
+
+/**
+ * @brief Routines of the lexer whose execution time is measured by @see LexerStatistics.
+ */
+enum class LexerRoutine {
+#define DEF_VARIANT(v) v,
+  JVC_LEXER_ROUTINE_LIST(DEF_VARIANT)
+#undef DEF_VARIANT
+};
+
+/**
+ * @brief Statistics about the tokens produced by a lexer and the time it spends in each of its routines.
+ *
+ * Lexers only collect statistics when the project is configured with `JVC_ENABLE_LEX_STATS`, in which case the
+ * `JVC_LEX_STATS` macro is defined. Otherwise all hooks in the lexer compile out and @see IsEnabled returns false.
+ */
+class LexerStatistics {
+public:
+  /**
+   * @brief Number of longest tokens and comments retained.
+   */
+  constexpr static const size_t LongestTokensCount = 10;
+
+  /**
+   * @brief Describe one of the longest tokens seen.
+   */
+  struct LongToken {
+    size_t Bytes;
+    TokenKind Kind;
+    SourceLocation Location;
+    std::string Preview;
+  };
+
+  /**
+   * @brief Determine whether lexer statistics have been compiled in.
+   * @return whether lexer statistics have been compiled in.
+   */
+  static bool IsEnabled();
+
+  /**
+   * @brief Get the number of heap allocations made by the current thread so far. This is always 0 if lexer statistics
+   * have not been compiled in.
+   * @return the number of heap allocations made by the current thread so far.
+   */
+  static uint64_t GetAllocationCount();
+
+  /**
+   * @brief Read the timestamp counter used to measure routines. This is the CPU cycle counter where available and a
+   * nanosecond clock otherwise; see @see GetTimestampUnit.
+   * @return current value of the timestamp counter.
+   */
+  static uint64_t ReadTimestamp();
+
+  /**
+   * @brief Get the name of the unit of @see ReadTimestamp.
+   * @return the name of the unit of @see ReadTimestamp.
+   */
+  static const char* GetTimestampUnit();
+
+  /**
+   * @brief Initialize a new @see LexerStatistics object.
+   */
+  LexerStatistics();
+
+  /**
+   * @brief Record a token produced by the lexer.
+   * @param token the token.
+   * @param bytes number of source bytes the token occupies.
+   * @param allocations number of heap allocations made while lexing the token.
+   * @param ticks time spent lexing the token, in units of @see ReadTimestamp.
+   */
+  void RecordToken(const Token& token, size_t bytes, uint64_t allocations, uint64_t ticks);
+
+  /**
+   * @brief Record a single execution of a lexer routine.
+   * @param routine the routine.
+   * @param ticks execution time of the routine, in units of @see ReadTimestamp.
+   */
+  void RecordRoutine(LexerRoutine routine, uint64_t ticks) {
+    auto& entry = _routines[static_cast<int>(routine)];
+    ++entry.Calls;
+    entry.Ticks += ticks;
+  }
+
+  /**
+   * @brief Merge the given statistics into this object.
+   * @param other the statistics to merge.
+   */
+  void Merge(const LexerStatistics& other);
+
+  /**
+   * @brief Get the number of tokens recorded.
+   * @return the number of tokens recorded.
+   */
+  [[nodiscard]]
+  uint64_t tokens() const { return _tokens; }
+
+  /**
+   * @brief Get the number of source bytes covered by the recorded tokens.
+   * @return the number of source bytes covered by the recorded tokens.
+   */
+  [[nodiscard]]
+  uint64_t bytes() const { return _bytes; }
+
+  /**
+   * @brief Get the number of recorded tokens of the given kind.
+   * @param kind the token kind.
+   * @return the number of recorded tokens of the given kind.
+   */
+  [[nodiscard]]
+  uint64_t GetTokenCount(TokenKind kind) const { return _tokenKinds[static_cast<int>(kind)]; }
+
+  /**
+   * @brief Get the longest non-comment tokens recorded, longest first.
+   * @return the longest non-comment tokens recorded.
+   */
+  [[nodiscard]]
+  const std::vector<LongToken>& longestTokens() const { return _longestTokens; }
+
+  /**
+   * @brief Get the longest comments recorded, longest first.
+   * @return the longest comments recorded.
+   */
+  [[nodiscard]]
+  const std::vector<LongToken>& longestComments() const { return _longestComments; }
+
+  /**
+   * @brief Write a human readable report of the statistics.
+   * @param o the output writer.
+   */
+  void Dump(StreamWriter& o) const;
+
+private:
+  struct RoutineEntry {
+    uint64_t Calls;
+    uint64_t Ticks;
+  };
+
+  uint64_t _tokens;
+  uint64_t _bytes;
+  uint64_t _allocations;
+  uint64_t _ticks;
+  std::vector<uint64_t> _tokenKinds;
+  std::vector<uint64_t> _keywords;
+  std::vector<uint64_t> _literals;
+  std::vector<uint64_t> _delimiters;
+  std::vector<uint64_t> _operators;
+  std::vector<RoutineEntry> _routines;
+  std::vector<LongToken> _longestTokens;
+  std::vector<LongToken> _longestComments;
+};
+
+/**
+ * @brief RAII timer that records the execution time of a lexer routine into a @see LexerStatistics object, if any.
+ */
+class LexerRoutineTimer {
+public:
+  explicit LexerRoutineTimer(LexerStatistics* stats, LexerRoutine routine)
+      : _stats(stats),
+        _routine(routine),
+        _start(stats ? LexerStatistics::ReadTimestamp() : 0)
+  { }
+
+  LexerRoutineTimer(const LexerRoutineTimer &) = delete;
+  LexerRoutineTimer& operator=(const LexerRoutineTimer &) = delete;
+
+  ~LexerRoutineTimer() {
+    if (_stats) {
+      _stats->RecordRoutine(_routine, LexerStatistics::ReadTimestamp() - _start);
+    }
+  }
+
+private:
+  LexerStatistics* _stats;
+  LexerRoutine _routine;
+  uint64_t _start;
+};
+
+} // namespace jvc
+
+#endif // JVC_LEXERSTATISTICS_H
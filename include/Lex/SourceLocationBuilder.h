@@ -7,6 +7,8 @@
 
 #include "Frontend/SourceLocation.h"
 
+#include <cstdint>
+
 namespace jvc {
 
 /**
@@ -21,7 +23,8 @@ public:
   explicit SourceLocationBuilder(int fileId)
     : _fileId(fileId),
       _row(1),
-      _col(1)
+      _col(1),
+      _afterCR(false)
   { }
 
   /**
@@ -36,14 +39,14 @@ public:
    * @return the row number.
    */
   [[nodiscard]]
-  int row() const { return _row; }
+  uint64_t row() const { return _row; }
 
   /**
    * @brief Get the column number.
    * @return the column number.
    */
   [[nodiscard]]
-  int col() const { return _col; }
+  uint64_t col() const { return _col; }
 
   /**
    * @brief Build a new @see SourceLocation value based on current state of this object.
@@ -62,18 +65,39 @@ public:
    * @param ch the input character.
    */
   void UpdateState(char ch) {
+    UpdateState(ch, 1);
+  }
+
+  /**
+   * @brief Update counters inside this @see SourceLocationBuilder object to match the next state transferred to by
+   * the given character.
+   * @param ch the input character.
+   * @param width number of bytes the character occupies in the source code file. Characters produced by unicode
+   * escapes are wider than one byte.
+   */
+  void UpdateState(char ch, int width) {
+    // Lines are terminated by LF, CR LF or a lone CR (JLS §3.4).
     if (ch == '\n') {
+      if (!_afterCR) {
+        ++_row;
+        _col = 1;
+      }
+      _afterCR = false;
+    } else if (ch == '\r') {
       ++_row;
       _col = 1;
+      _afterCR = true;
     } else {
-      ++_col;
+      _col += width;
+      _afterCR = false;
     }
   }
 
 private:
   int _fileId;
-  int _row;
-  int _col;
+  uint64_t _row;
+  uint64_t _col;
+  bool _afterCR;
 };
 
 } // namespace jvc
@@ -33,6 +33,13 @@ enum class TokenKind {
 #undef DEF_VARIANT
 };
 
+/**
+ * @brief Get the name of the given token kind.
+ * @param kind the token kind.
+ * @return the name of the given token kind.
+ */
+const char* GetTokenKindName(TokenKind kind);
+
 /**
  * @brief A lexical token generated by the lexer.
  *
@@ -157,6 +164,13 @@ enum class KeywordKind {
 #undef DEF_VARIANT
 };
 
+/**
+ * @brief Get the name of the given keyword kind.
+ * @param kind the keyword kind.
+ * @return the name of the given keyword kind.
+ */
+const char* GetKeywordName(KeywordKind kind);
+
 /**
  * @brief Determine whether the given keyword is a type specifier.
  *
@@ -266,6 +280,13 @@ enum class LiteralKind {
 #undef DEF_VARIANT
 };
 
+/**
+ * @brief Get the name of the given literal kind.
+ * @param kind the literal kind.
+ * @return the name of the given literal kind.
+ */
+const char* GetLiteralKindName(LiteralKind kind);
+
 /**
  * @brief Specialize a token that represents a string literal or a number literal.
  */
@@ -470,10 +491,10 @@ public:
   /**
    * @brief Initialize a new @see CharacterLiteralToken object.
    * @param source the source of this token.
-   * @param ch the character represented by this token.
+   * @param ch the code point of the character represented by this token.
    * @param range the source code range of this token.
    */
-  explicit CharacterLiteralToken(std::string source, char ch, SourceRange range)
+  explicit CharacterLiteralToken(std::string source, char32_t ch, SourceRange range)
     : LiteralToken { LiteralKind::Character, range },
       _source(std::move(source)),
       _ch(ch)
@@ -487,17 +508,17 @@ public:
   const std::string& source() const { return _source; }
 
   /**
-   * @brief Get the character value represented by this token.
-   * @return the character value represented by this token.
+   * @brief Get the code point of the character represented by this token.
+   * @return the code point of the character represented by this token.
    */
   [[nodiscard]]
-  char value() const { return _ch; }
+  char32_t value() const { return _ch; }
 
   void Dump(StreamWriter& o) const override;
 
 private:
   std::string _source;
-  char _ch;
+  char32_t _ch;
 };
 
 #define JVC_DELIMITER_LIST(h) \
@@ -521,6 +542,13 @@ enum class DelimiterKind {
 #undef DEF_VARIANT
 };
 
+/**
+ * @brief Get the name of the given delimiter kind.
+ * @param kind the delimiter kind.
+ * @return the name of the given delimiter kind.
+ */
+const char* GetDelimiterName(DelimiterKind kind);
+
 /**
  * @brief Specialize a token that represents a delimiter.
  */
@@ -602,6 +630,13 @@ enum class OperatorKind {
 #undef DEF_VARIANT
 };
 
+/**
+ * @brief Get the name of the given operator kind.
+ * @param kind the operator kind.
+ * @return the name of the given operator kind.
+ */
+const char* GetOperatorName(OperatorKind kind);
+
 /**
  * @brief Specialize a token that represents an operator.
  */
@@ -699,6 +734,13 @@ public:
   void Dump(StreamWriter& o) const override;
 };
 
+/**
+ * @brief Get the number of bytes the given token holds, including the strings it owns.
+ * @param token the token.
+ * @return the number of bytes the given token holds.
+ */
+size_t GetTokenMemoryUsage(const Token& token);
+
 } // namespace jvc
 
 #endif // JVC_TOKEN_H
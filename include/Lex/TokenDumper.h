@@ -0,0 +1,181 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#ifndef JVC_TOKENDUMPER_H
+#define JVC_TOKENDUMPER_H
+
+#include "Frontend/CompilerOptions.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace jvc {
+
+class OutputStream;
+class SourceFileInfo;
+class StreamWriter;
+class Token;
+
+/**
+ * @brief Header at the start of a binary token dump.
+ */
+struct TokenDumpHeader {
+  /**
+   * @brief The expected value of @see Magic.
+   */
+  constexpr static const char ExpectedMagic[8] = { 'J', 'V', 'C', 'T', 'O', 'K', 'S', '\0' };
+
+  /**
+   * @brief The current value of @see Version. Version 2 widened @see TokenRecord::Length to 64 bits.
+   */
+  constexpr static const uint32_t CurrentVersion = 2;
+
+  char Magic[8];
+  uint32_t Version;
+
+  /**
+   * @brief Size of a @see TokenRecord, in bytes.
+   */
+  uint32_t RecordSize;
+};
+
+/**
+ * @brief Header of the section of a binary token dump holding the tokens of a single source code file.
+ *
+ * The header is followed by RecordCount @see TokenRecord values, by StringCount + 1 64-bit offsets delimiting the
+ * strings in the string table, and by the StringBytes bytes of the string table padded to a multiple of 8 bytes. All
+ * values are in the byte order of the machine that wrote the dump.
+ */
+struct TokenDumpSectionHeader {
+  uint32_t FileId;
+
+  /**
+   * @brief Index of the path of the source code file in the string table.
+   */
+  uint32_t PathIndex;
+
+  uint64_t RecordCount;
+  uint64_t StringCount;
+  uint64_t StringBytes;
+};
+
+/**
+ * @brief A token in a binary token dump.
+ */
+struct TokenRecord {
+  /**
+   * @brief Value of @see Payload for tokens without a string payload.
+   */
+  constexpr static const uint32_t NoPayload = UINT32_MAX;
+
+  /**
+   * @brief Value of @see Offset for tokens whose offset is unknown.
+   */
+  constexpr static const uint64_t UnknownOffset = UINT64_MAX;
+
+  /**
+   * @brief Number literal flag: the value is an integer.
+   */
+  constexpr static const uint16_t IntegerFlag = 1u;
+
+  /**
+   * @brief @see TokenKind of the token.
+   */
+  uint8_t Kind;
+
+  /**
+   * @brief Keyword, literal, delimiter, operator or comment kind of the token, depending on @see Kind.
+   */
+  uint8_t SubKind;
+
+  /**
+   * @brief Number literals: @see IntegerFlag, the @see NumberLiteralPrefix shifted left by 1 and the
+   * @see NumberLiteralSuffix shifted left by 3.
+   */
+  uint16_t Flags;
+
+  uint32_t FileId;
+
+  /**
+   * @brief Offset of the first byte of the token in the source code file.
+   */
+  uint64_t Offset;
+
+  /**
+   * @brief Length of the token in the source code file, in bytes. A single comment or literal can be longer than 4 GiB.
+   */
+  uint64_t Length;
+
+  /**
+   * @brief Index of the name of an identifier, or the content of a string literal or a comment, in the string table.
+   */
+  uint32_t Payload;
+
+  /**
+   * @brief Always 0.
+   */
+  uint32_t Reserved;
+
+  /**
+   * @brief Number literals: bits of the int64_t or double value. Character literals: the code point.
+   */
+  uint64_t Value;
+};
+
+static_assert(sizeof(TokenRecord) == 40, "TokenRecord is expected to be 40 bytes wide.");
+
+/**
+ * @brief Dump the tokens of a single source code file in one of the @see TokenDumpFormat formats.
+ */
+class TokenDumper {
+public:
+  /**
+   * @brief Create a @see TokenDumper object.
+   * @param format the dump format.
+   * @param sourceFile the source code file whose tokens are dumped.
+   * @param output the output.
+   * @return the created @see TokenDumper object.
+   */
+  static std::unique_ptr<TokenDumper> Create(TokenDumpFormat format, const SourceFileInfo& sourceFile,
+                                             StreamWriter& output);
+
+  /**
+   * @brief Write the header preceding the dumps of all source code files, if the given format has one.
+   * @param format the dump format.
+   * @param output the output.
+   */
+  static void WriteHeader(TokenDumpFormat format, OutputStream& output);
+
+  /**
+   * @brief Destroy a @see TokenDumper object.
+   */
+  virtual ~TokenDumper() = default;
+
+  TokenDumper(const TokenDumper &) = delete;
+  TokenDumper(TokenDumper &&) = delete;
+
+  TokenDumper& operator=(const TokenDumper &) = delete;
+  TokenDumper& operator=(TokenDumper &&) = delete;
+
+  /**
+   * @brief Dump the given token.
+   * @param token the token.
+   */
+  virtual void Dump(const Token& token) = 0;
+
+  /**
+   * @brief Complete the dump of the source code file. Formats that buffer the dump write it out here.
+   */
+  virtual void Finish() = 0;
+
+protected:
+  /**
+   * @brief Initialize a new @see TokenDumper object.
+   */
+  explicit TokenDumper() = default;
+};
+
+} // namespace jvc
+
+#endif // JVC_TOKENDUMPER_H
@@ -0,0 +1,64 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#include "CommandLine.h"
+
+#include <string_view>
+
+namespace jvc {
+
+std::vector<std::string> ExtractInputFileLists(int argc, char* argv[], std::vector<std::string>& fileLists) {
+  // Options taking a value, either as the next argument or attached with '='. The value of a single-letter option can
+  // also be attached directly, as in `-j4`.
+  constexpr const std::string_view ValueOptions[] = {
+      "-o", "--output", "-j", "--jobs", "--dump-format", "--source-memory-budget", "--diagnostics-format",
+      "--sourcepath", "--src-root", "--files-from", "-ferror-limit", "-fwarning-limit", "-ftime-trace" };
+
+  std::vector<std::string> remaining;
+  auto isValue = false;
+  for (auto i = 0; i < argc; ++i) {
+    std::string_view arg { argv[i] };
+    if (isValue) {
+      remaining.emplace_back(arg);
+      isValue = false;
+      continue;
+    }
+    if (i > 0 && arg.size() > 1 && arg.front() == '@') {
+      fileLists.emplace_back(arg.substr(1));
+      continue;
+    }
+
+    auto matched = false;
+    for (auto option : ValueOptions) {
+      if (arg.substr(0, option.size()) != option) {
+        continue;
+      }
+      auto isShort = option.size() == 2;
+      auto hasEquals = arg.size() > option.size() && arg[option.size()] == '=';
+      if (arg.size() > option.size() && !hasEquals && !isShort) {
+        continue;
+      }
+      auto name = std::string { option };
+      if (name.size() > 2 && name[1] != '-') {
+        name.insert(0, 1, '-');
+      }
+      remaining.push_back(name);
+      if (hasEquals) {
+        remaining.emplace_back(arg.substr(option.size() + 1));
+      } else if (arg.size() > option.size()) {
+        remaining.emplace_back(arg.substr(option.size()));
+      } else {
+        isValue = true;
+      }
+      matched = true;
+      break;
+    }
+    if (!matched) {
+      remaining.emplace_back(arg);
+    }
+  }
+  return remaining;
+}
+
+} // namespace jvc
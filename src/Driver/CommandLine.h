@@ -0,0 +1,31 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#ifndef JVC_COMMANDLINE_H
+#define JVC_COMMANDLINE_H
+
+#include <string>
+#include <vector>
+
+namespace jvc {
+
+/**
+ * @brief Take the `@file` input file lists out of the command line, and split `--files-from=file`, `-ferror-limit=n`
+ * and `-j4` like arguments into two arguments, which is the only form TCLAP understands. The `-f` options are spelled
+ * with a single dash as in other compilers, and are given a second one for TCLAP.
+ *
+ * Unlike the `@argfiles` of javac, an input file list only lists input files and is not expanded into arguments: it can
+ * list hundreds of thousands of paths, which are streamed into the source manager instead. Only arguments in argument
+ * position are input file lists; `-o @out` writes to a file named `@out`.
+ *
+ * @param argc number of arguments.
+ * @param argv the arguments.
+ * @param fileLists output parameter, paths to the input file lists.
+ * @return the remaining arguments.
+ */
+std::vector<std::string> ExtractInputFileLists(int argc, char* argv[], std::vector<std::string>& fileLists);
+
+} // namespace jvc
+
+#endif // JVC_COMMANDLINE_H
@@ -2,12 +2,22 @@
 // Created by Sirui Mu on 2019/12/23.
 //
 
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/PerfCounters.h"
+#include "Infrastructure/ResponseFile.h"
+#include "Infrastructure/Statistic.h"
+#include "Infrastructure/Stream.h"
+#include "Infrastructure/TimeTrace.h"
 #include "Frontend/CompilerOptions.h"
 #include "Frontend/CompilerInstance.h"
 #include "Frontend/FrontendAction.h"
+#include "CommandLine.h"
 
+#include <cerrno>
 #include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <utility>
 #include <vector>
 
 #include "tclap/CmdLine.h"
@@ -16,12 +26,66 @@ namespace {
 
 struct CommandLineArgs {
   bool LexOnly;
+  bool LexStats;
+  jvc::TokenDumpFormat DumpFormat;
+  size_t Jobs;
+  size_t SourceMemoryBudget;
+  bool BatchDiagnostics;
+  size_t ErrorLimit;
+  size_t WarningLimit;
+  jvc::DiagnosticsFormat DiagnosticsFormat;
+  bool PerfCounters;
+  bool Stats;
+  bool StatsJson;
+  bool MemReport;
+  // Path to the Chrome Trace Event file; empty if tracing is off.
+  std::string TimeTraceFile;
   bool HasOutputFile;
   std::string OutputFile;
+  std::vector<std::string> SourcePath;
   std::vector<std::string> InputFiles;
+  // Lists of input files, read after the input files given on the command line.
+  std::vector<std::pair<std::string, jvc::ResponseFileSyntax>> InputFileLists;
 };
 
+/**
+ * @brief Parse a size in bytes, optionally followed by a K, M or G suffix.
+ * @param text the text to parse.
+ * @param size output parameter, the parsed size.
+ * @return whether the text is a valid size.
+ */
+bool ParseByteSize(const std::string& text, size_t& size) {
+  size_t end;
+  unsigned long long value;
+  try {
+    value = std::stoull(text, &end);
+  } catch (std::exception &) {
+    return false;
+  }
+
+  auto suffix = text.substr(end);
+  if (suffix.empty()) {
+    size = value;
+  } else if (suffix == "K" || suffix == "k") {
+    size = value << 10u;
+  } else if (suffix == "M" || suffix == "m") {
+    size = value << 20u;
+  } else if (suffix == "G" || suffix == "g") {
+    size = value << 30u;
+  } else {
+    return false;
+  }
+  return true;
+}
+
 CommandLineArgs ParseCommandLine(int argc, char* argv[]) {
+  std::vector<std::string> fileLists;
+  auto remaining = jvc::ExtractInputFileLists(argc, argv, fileLists);
+  std::vector<char*> remainingArgv;
+  for (auto& arg : remaining) {
+    remainingArgv.push_back(arg.data());
+  }
+
   try {
     TCLAP::CmdLine cmd { "Minimal Java Compiler by Sirui Mu", ' ', "0.1" };
 
@@ -31,20 +95,146 @@ CommandLineArgs ParseCommandLine(int argc, char* argv[]) {
     TCLAP::SwitchArg lexOnlySwitch {
       "", "lex-only", "Execute lexer only.", cmd, false };
 
+    TCLAP::SwitchArg lexStatsSwitch {
+      "", "lex-stats", "Report lexer statistics. Requires a build with JVC_ENABLE_LEX_STATS.", cmd, false };
+
+    TCLAP::ValueArg<std::string> dumpFormat {
+      "", "dump-format",
+      "Format of the lexer output: text (human-readable), jsonl (one JSON object per line) or binary (fixed-width "
+      "token records followed by a string table, per file). Defaults to text.",
+      false, "text", "text|jsonl|binary", cmd };
+
+    TCLAP::ValueArg<size_t> jobs {
+      "j", "jobs", "Number of threads to use. Defaults to the number of hardware threads.", false, 0, "number", cmd };
+
+    TCLAP::ValueArg<std::string> sourceMemoryBudget {
+      "", "source-memory-budget",
+      "Maximum amount of source file content to keep in memory, e.g. 512M. Contents of files that have been processed "
+      "are evicted beyond this budget and reloaded on demand. Defaults to unlimited.",
+      false, "", "size", cmd };
+
+    TCLAP::SwitchArg batchDiagnostics {
+      "", "batch-diagnostics",
+      "Queue diagnostics and report them in bulk after each file is processed, sorted by location.", cmd, false };
+
+    TCLAP::ValueArg<size_t> errorLimit {
+      "", "ferror-limit", "Stop reporting errors after the given number of errors; 0 means no limit.",
+      false, 0, "number", cmd };
+
+    TCLAP::ValueArg<size_t> warningLimit {
+      "", "fwarning-limit", "Stop reporting warnings after the given number of warnings; 0 means no limit.",
+      false, 0, "number", cmd };
+
+    TCLAP::ValueArg<std::string> diagnosticsFormat {
+      "", "diagnostics-format",
+      "Format of the diagnostics: text (human-readable, with source snippets), jsonl (one JSON object per line) or "
+      "sarif (a SARIF 2.1.0 log). Defaults to text.",
+      false, "text", "text|jsonl|sarif", cmd };
+
+    TCLAP::SwitchArg perfCounters {
+      "", "perf-counters",
+      "Print cycles, instructions, branch and cache misses, page faults and CPU time per phase (load, lex, dump, "
+      "diagnostics) to the standard error at exit. Falls back to software counters where hardware ones are restricted.",
+      cmd, false };
+
+    TCLAP::SwitchArg stats {
+      "", "stats", "Print all statistics counters to the standard error at exit.", cmd, false };
+
+    TCLAP::SwitchArg statsJson {
+      "", "stats-json", "Print all statistics counters to the standard error at exit, as a single-line JSON object.",
+      cmd, false };
+
+    TCLAP::SwitchArg memReport {
+      "", "mem-report",
+      "Print the peak resident set size, the page faults and the bytes held by source files, line tables, tokens, "
+      "diagnostics and stream buffers to the standard error at exit.",
+      cmd, false };
+
+    TCLAP::ValueArg<std::string> timeTrace {
+      "", "ftime-trace",
+      "Write a Chrome Trace Event file of the time spent loading, lexing, dumping and reporting diagnostics, with one "
+      "lane per thread. Open it in chrome://tracing or Perfetto.",
+      false, "", "file", cmd };
+
+    TCLAP::MultiArg<std::string> sourcePath {
+      "", "sourcepath",
+      "Directories to search for java source files, separated by ':'. Input files default to all source files found.",
+      false, "path", cmd };
+
+    TCLAP::MultiArg<std::string> sourceRoot {
+      "", "src-root", "Same as --sourcepath.", false, "path", cmd };
+
+    TCLAP::MultiArg<std::string> filesFrom {
+      "", "files-from",
+      "Read the paths to input files from the given file, one per line; '-' reads them from the standard input. "
+      "Input files can also be listed in @file arguments, separated by whitespaces as in the @argfiles of javac; "
+      "unlike those, the file only lists input files, and options in it are not recognized.",
+      false, "file", cmd };
+
     TCLAP::UnlabeledMultiArg<std::string> inputFiles {
-      "input", "Input files", true, "string", cmd, true };
+      "input", "Input files", false, "string", cmd, true };
 
-    cmd.parse(argc, argv);
+    cmd.parse(static_cast<int>(remainingArgv.size()), remainingArgv.data());
 
     CommandLineArgs args { };
     args.LexOnly = lexOnlySwitch.getValue();
+    args.LexStats = lexStatsSwitch.getValue();
+    if (dumpFormat.getValue() == "jsonl") {
+      args.DumpFormat = jvc::TokenDumpFormat::JsonLines;
+    } else if (dumpFormat.getValue() == "binary") {
+      args.DumpFormat = jvc::TokenDumpFormat::Binary;
+    } else if (dumpFormat.getValue() == "text") {
+      args.DumpFormat = jvc::TokenDumpFormat::Text;
+    } else {
+      std::cerr << "fatal error: invalid format \"" << dumpFormat.getValue() << "\" for arg --dump-format" << std::endl;
+      std::exit(1);
+    }
+    args.Jobs = jobs.getValue();
+    if (sourceMemoryBudget.isSet() && !ParseByteSize(sourceMemoryBudget.getValue(), args.SourceMemoryBudget)) {
+      std::cerr << "fatal error: invalid size \"" << sourceMemoryBudget.getValue()
+                << "\" for arg --source-memory-budget" << std::endl;
+      std::exit(1);
+    }
+    args.BatchDiagnostics = batchDiagnostics.getValue();
+    args.ErrorLimit = errorLimit.getValue();
+    args.WarningLimit = warningLimit.getValue();
+    if (diagnosticsFormat.getValue() == "jsonl") {
+      args.DiagnosticsFormat = jvc::DiagnosticsFormat::JsonLines;
+    } else if (diagnosticsFormat.getValue() == "sarif") {
+      args.DiagnosticsFormat = jvc::DiagnosticsFormat::Sarif;
+    } else if (diagnosticsFormat.getValue() == "text") {
+      args.DiagnosticsFormat = jvc::DiagnosticsFormat::Text;
+    } else {
+      std::cerr << "fatal error: invalid format \"" << diagnosticsFormat.getValue()
+                << "\" for arg --diagnostics-format" << std::endl;
+      std::exit(1);
+    }
+    args.PerfCounters = perfCounters.getValue();
+    args.Stats = stats.getValue();
+    args.StatsJson = statsJson.getValue();
+    args.MemReport = memReport.getValue();
+    args.TimeTraceFile = timeTrace.getValue();
     args.HasOutputFile = outputFile.isSet();
     if (args.HasOutputFile) {
       args.OutputFile = outputFile.getValue();
     }
+    args.SourcePath = sourcePath.getValue();
+    for (const auto& root : sourceRoot) {
+      args.SourcePath.push_back(root);
+    }
     for (const auto& inFile : inputFiles) {
       args.InputFiles.push_back(inFile);
     }
+    for (const auto& fileList : fileLists) {
+      args.InputFileLists.emplace_back(fileList, jvc::ResponseFileSyntax::Arguments);
+    }
+    for (const auto& fileList : filesFrom) {
+      args.InputFileLists.emplace_back(fileList, jvc::ResponseFileSyntax::Lines);
+    }
+    if (args.InputFiles.empty() && args.InputFileLists.empty() && args.SourcePath.empty()) {
+      std::cerr << "fatal error: no input files" << std::endl;
+      std::exit(1);
+    }
 
     return args;
   } catch (TCLAP::ArgException& e) {
@@ -61,25 +251,129 @@ jvc::FrontendActionKind GetFrontendActionKind(const CommandLineArgs& args) {
   return jvc::FrontendActionKind::EmitLLVM;
 }
 
-} // namespace <anonymous>
-
-int main(int argc, char* argv[]) {
-  auto args = ParseCommandLine(argc, argv);
+/**
+ * @brief Run the compiler.
+ * @param args the command line arguments.
+ * @return the exit code.
+ */
+int Compile(CommandLineArgs& args) {
+  jvc::TimeTraceScope traceScope { "Compile" };
 
   jvc::CompilerOptions compilerOptions { };
+  compilerOptions.LexStats = args.LexStats;
+  compilerOptions.DumpFormat = args.DumpFormat;
+  compilerOptions.Jobs = args.Jobs;
+  compilerOptions.SourceMemoryBudget = args.SourceMemoryBudget;
+  compilerOptions.SourcePath = args.SourcePath;
+  compilerOptions.MemReport = args.MemReport;
   compilerOptions.HasOutputFile = args.HasOutputFile;
   if (args.HasOutputFile) {
     compilerOptions.OutputFilePath = std::move(args.OutputFile);
   }
 
   auto compiler = std::make_unique<jvc::CompilerInstance>(std::move(compilerOptions));
-  for (const auto& inputFile : args.InputFiles) {
-    compiler->GetSourceManager().Load(inputFile);
+
+  jvc::DiagnosticsOptions diagOptions { };
+  diagOptions.Queued = args.BatchDiagnostics;
+  diagOptions.ErrorLimit = args.ErrorLimit;
+  diagOptions.WarningLimit = args.WarningLimit;
+  diagOptions.Format = args.DiagnosticsFormat;
+  compiler->GetDiagnosticsEngine().SetOptions(diagOptions);
+  if (args.DiagnosticsFormat != jvc::DiagnosticsFormat::Text) {
+    // Machine-readable diagnostics come in large numbers and without snippets; write them in blocks.
+    compiler->GetDiagnosticsEngine().SetOutput(
+        jvc::OutputStream::CreateBuffered(jvc::OutputStream::FromSTL(std::cerr)));
+  }
+
+  compiler->GetSourceManager().SetMemoryBudget(args.SourceMemoryBudget);
+  compiler->GetSourcePathIndex().AddRoots(args.SourcePath, args.Jobs);
+  if (args.InputFiles.empty() && args.InputFileLists.empty()) {
+    args.InputFiles = compiler->GetSourcePathIndex().GetFiles();
+  }
+  compiler->GetSourceManager().LoadAll(args.InputFiles, args.Jobs);
+  for (const auto& [path, syntax] : args.InputFileLists) {
+    errno = 0;
+    auto stream = path == "-" ? jvc::InputStream::FromSTL(std::cin) : jvc::InputStream::FromFile(path);
+    if (!stream) {
+      compiler->GetDiagnosticsEngine().Emit(jvc::Diagnostics {
+          jvc::DiagnosticsKind::CannotReadFileList, path, jvc::DiagnosticsArgument::ErrorCode(errno ? errno : ENOENT) });
+      compiler->GetDiagnosticsEngine().Finish();
+      return 1;
+    }
+
+    jvc::ResponseFileReader reader { std::move(stream), syntax };
+    compiler->GetSourceManager().LoadAll(reader, args.Jobs);
+  }
+  if (compiler->GetDiagnosticsEngine().IsCancelled()) {
+    compiler->GetDiagnosticsEngine().Finish();
+    return 1;
   }
 
   auto frontendActionKind = GetFrontendActionKind(args);
   auto frontendAction = jvc::FrontendAction::CreateAction(frontendActionKind, compiler->GetDiagnosticsEngine());
+  if (!frontendAction) {
+    compiler->GetDiagnosticsEngine().Finish();
+    return 1;
+  }
   frontendAction->ExecuteAction(*compiler);
+  compiler->GetDiagnosticsEngine().Finish();
+
+  if (args.SourceMemoryBudget) {
+    compiler->GetSourceManager().DumpMemoryUsage(jvc::errs());
+  }
+
+  if (args.MemReport) {
+    auto usage = compiler->GetSourceManager().GetMemoryUsage();
+    jvc::errs() << "source content: " << compiler->GetSourceManager().size() << " files, "
+                << usage.ResidentBytes << " bytes resident, peak " << usage.PeakResidentBytes << " bytes\n";
+    jvc::MemoryUsage::Report(jvc::errs());
+  }
+
+  return compiler->GetDiagnosticsEngine().IsCancelled() ? 1 : 0;
+}
 
-  return 0;
+} // namespace <anonymous>
+
+int main(int argc, char* argv[]) {
+  auto parseStart = jvc::TimeTraceProfiler::Clock::now();
+  auto args = ParseCommandLine(argc, argv);
+  if (!args.TimeTraceFile.empty()) {
+    jvc::TimeTraceProfiler::Initialize();
+    jvc::TimeTraceProfiler::AddEvent("Startup", jvc::TimeTraceProfiler::GetProcessStartTime(), parseStart);
+    jvc::TimeTraceProfiler::AddEvent("ParseCommandLine", parseStart, jvc::TimeTraceProfiler::Clock::now());
+  }
+
+  if (args.PerfCounters) {
+    jvc::PerfCounters::Initialize();
+  }
+
+  auto exitCode = Compile(args);
+
+  if (args.PerfCounters) {
+    // Costs are given per byte and per token lexed; files that are only loaded are not counted.
+    auto bytes = jvc::Statistic::Find("LexerReaderBytes");
+    auto tokens = jvc::Statistic::Find("LexerTokens");
+    jvc::PerfCounters::Report(jvc::errs(), bytes ? bytes->value() : 0, tokens ? tokens->value() : 0);
+  }
+
+  if (args.Stats || args.StatsJson) {
+    // Writers add their writes to the statistics when flushed.
+    jvc::outs().Flush();
+    if (args.Stats) {
+      jvc::Statistic::Print(jvc::errs());
+    }
+    if (args.StatsJson) {
+      jvc::Statistic::PrintJson(jvc::errs());
+    }
+  }
+
+  if (!args.TimeTraceFile.empty()) {
+    auto output = jvc::OutputStream::FromFile(args.TimeTraceFile);
+    if (!output) {
+      std::cerr << "fatal error: cannot write time trace to \"" << args.TimeTraceFile << "\"" << std::endl;
+      return 1;
+    }
+    jvc::TimeTraceProfiler::Write(*output);
+  }
+  return exitCode;
 }
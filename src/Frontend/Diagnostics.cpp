@@ -2,14 +2,42 @@
 // Created by Sirui Mu on 2019/12/19.
 //
 
+#include "Infrastructure/Json.h"
+#include "Infrastructure/MemoryBuffer.h"
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/PerfCounters.h"
+#include "Infrastructure/Statistic.h"
 #include "Infrastructure/Stream.h"
+#include "Infrastructure/TimeTrace.h"
 #include "Frontend/Diagnostics.h"
 #include "Frontend/CompilerInstance.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <set>
+
 namespace jvc {
 
 namespace {
 
+JVC_STATISTIC(DiagnosticsEmitted, "Number of diagnostics messages emitted, including suppressed ones");
+JVC_STATISTIC(DiagnosticsSuppressed, "Number of diagnostics messages suppressed by -ferror-limit and -fwarning-limit");
+JVC_MEMORY_GAUGE(DiagnosticsQueueBytes, "Bytes of diagnostics messages queued until their source file is done");
+
+template <typename T>
+void appendRaw(std::string& buffer, T value) {
+  buffer.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T>
+T readRaw(std::string_view& buffer) {
+  T value;
+  std::memcpy(&value, buffer.data(), sizeof(value));
+  buffer.remove_prefix(sizeof(value));
+  return value;
+}
+
 class LiteralDiagnosticsMessage : public DiagnosticsMessage {
 public:
   explicit LiteralDiagnosticsMessage(DiagnosticsLevel level, std::string message)
@@ -53,6 +81,124 @@ DiagnosticsMessage::CreateLiteral(DiagnosticsLevel level, SourceRange range, std
 
 namespace {
 
+struct DiagnosticsKindInfo {
+  const char* Name;
+  DiagnosticsLevel Level;
+  const char* Format;
+};
+
+constexpr const DiagnosticsKindInfo DiagnosticsKindTable[] = {
+#define EMIT_KIND_INFO(name, level, format) { #name, DiagnosticsLevel::level, format },
+  JVC_DIAGNOSTICS_LIST(EMIT_KIND_INFO)
+#undef EMIT_KIND_INFO
+};
+
+} // namespace <anonymous>
+
+const char* GetDiagnosticsKindName(DiagnosticsKind kind) {
+  return DiagnosticsKindTable[static_cast<int>(kind)].Name;
+}
+
+DiagnosticsLevel GetDiagnosticsKindLevel(DiagnosticsKind kind) {
+  return DiagnosticsKindTable[static_cast<int>(kind)].Level;
+}
+
+const char* GetDiagnosticsKindFormat(DiagnosticsKind kind) {
+  return DiagnosticsKindTable[static_cast<int>(kind)].Format;
+}
+
+void DiagnosticsArgument::Dump(StreamWriter& output) const {
+  switch (_kind) {
+    case Kind::None:
+      break;
+    case Kind::Char:
+      output << _char;
+      break;
+    case Kind::Int:
+      output << std::to_string(_int);
+      break;
+    case Kind::UInt:
+      output << std::to_string(_uint);
+      break;
+    case Kind::String:
+      output << std::string_view { _string.Data, _string.Size };
+      break;
+    case Kind::ErrorCode:
+      output << std::strerror(static_cast<int>(_int));
+      break;
+  }
+}
+
+void DiagnosticsArgument::Encode(std::string& buffer) const {
+  buffer.push_back(static_cast<char>(_kind));
+  switch (_kind) {
+    case Kind::None:
+      break;
+    case Kind::Char:
+      buffer.push_back(_char);
+      break;
+    case Kind::Int:
+    case Kind::ErrorCode:
+      appendRaw(buffer, _int);
+      break;
+    case Kind::UInt:
+      appendRaw(buffer, _uint);
+      break;
+    case Kind::String:
+      appendRaw(buffer, _string.Size);
+      buffer.append(_string.Data, _string.Size);
+      break;
+  }
+}
+
+DiagnosticsArgument DiagnosticsArgument::Decode(std::string_view& buffer) {
+  DiagnosticsArgument arg { };
+  arg._kind = static_cast<Kind>(buffer.front());
+  buffer.remove_prefix(1);
+  switch (arg._kind) {
+    case Kind::None:
+      break;
+    case Kind::Char:
+      arg._char = buffer.front();
+      buffer.remove_prefix(1);
+      break;
+    case Kind::Int:
+    case Kind::ErrorCode:
+      arg._int = readRaw<int64_t>(buffer);
+      break;
+    case Kind::UInt:
+      arg._uint = readRaw<uint64_t>(buffer);
+      break;
+    case Kind::String:
+      arg._string.Size = readRaw<size_t>(buffer);
+      arg._string.Data = buffer.data();
+      buffer.remove_prefix(arg._string.Size);
+      break;
+  }
+  return arg;
+}
+
+void Diagnostics::DumpMessage(StreamWriter& output) const {
+  std::string_view format { GetDiagnosticsKindFormat(_kind) };
+  while (!format.empty()) {
+    auto placeholder = format.find('%');
+    output << format.substr(0, placeholder);
+    if (placeholder == std::string_view::npos || placeholder + 1 == format.size()) {
+      break;
+    }
+
+    auto spec = format[placeholder + 1];
+    if (spec >= '0' && spec < static_cast<char>('0' + MaxArguments)) {
+      _args[spec - '0'].Dump(output);
+    } else {
+      output << spec;
+    }
+    format.remove_prefix(placeholder + 2);
+  }
+}
+
+namespace {
+
 const char* getDiagLevelName(DiagnosticsLevel level) {
   switch (level) {
     case DiagnosticsLevel::Info:
@@ -68,69 +214,544 @@ const char* getDiagLevelName(DiagnosticsLevel level) {
   }
 }
 
+const char* getSarifLevelName(DiagnosticsLevel level) {
+  switch (level) {
+    case DiagnosticsLevel::Info:
+      return "note";
+    case DiagnosticsLevel::Warning:
+      return "warning";
+    default:
+      return "error";
+  }
+}
+
 } // namespace <anonymous>
 
+/**
+ * @brief Cache the line views of the source code file diagnostics messages are being rendered against, so that a run
+ * of messages reported against the same lines looks them up only once.
+ */
+class DiagnosticsEngine::SnippetCache {
+public:
+  explicit SnippetCache(const SourceManager& sources)
+    : _sources(sources),
+      _file(nullptr),
+      _viewKey { }
+  { }
+
+  [[nodiscard]]
+  const SourceFileInfo* GetFile(int fileId) {
+    if (!_file || _file->id() != fileId) {
+      _file = _sources.GetSourceFileInfo(fileId);
+      // Pin the content so that it cannot be evicted while the snippets are printed.
+      _pin = _file ? _file->GetBuffer() : nullptr;
+      _viewKey = { };
+      _view = { };
+    }
+    return _file;
+  }
+
+  [[nodiscard]]
+  std::string_view GetViewInRange(SourceRange range) {
+    ViewKey key { range.start().row(), range.end().row(), true };
+    if (!(key == _viewKey)) {
+      _viewKey = key;
+      _view = _file->GetViewInRange(range);
+    }
+    return _view;
+  }
+
+  [[nodiscard]]
+  std::string_view GetViewAtLoc(SourceLocation loc) {
+    ViewKey key { loc.row(), loc.row(), false };
+    if (!(key == _viewKey)) {
+      _viewKey = key;
+      _view = _file->GetViewAtLoc(loc);
+    }
+    return _view;
+  }
+
+  /**
+   * @brief Build a caret line pointing at the given columns on a single line.
+   * @param startCol the first column, inclusive.
+   * @param endCol the last column, exclusive.
+   * @return the caret line. It is valid until the next call to this function.
+   */
+  [[nodiscard]]
+  std::string_view GetCaret(uint64_t startCol, uint64_t endCol) {
+    auto padding = startCol > 1 ? startCol - 1 : 0;
+    auto tildes = endCol > startCol + 1 ? endCol - startCol - 1 : 0;
+    _caret.assign(padding, ' ');
+    _caret.push_back('^');
+    _caret.append(tildes, '~');
+    return _caret;
+  }
+
+private:
+  struct ViewKey {
+    uint64_t StartRow;
+    uint64_t EndRow;
+    bool IsRange;
+
+    bool operator==(const ViewKey& rhs) const {
+      return StartRow == rhs.StartRow && EndRow == rhs.EndRow && IsRange == rhs.IsRange;
+    }
+  };
+
+  const SourceManager& _sources;
+  const SourceFileInfo* _file;
+  std::shared_ptr<const MemoryBuffer> _pin;
+  ViewKey _viewKey;
+  std::string_view _view;
+  std::string _caret;
+};
+
+std::atomic<uint64_t> DiagnosticsEngine::NextSerial { 1 };
+
 void DiagnosticsEngine::Emit(const DiagnosticsMessage& message) {
+  AllocationScope allocationScope { MemorySubsystem::Diagnostics };
   auto level = mapDiagLevel(message.level());
-  auto& o = errs();
+  ++DiagnosticsEmitted;
+  if (!countMessage(level)) {
+    ++DiagnosticsSuppressed;
+    return;
+  }
+
+  if (_opt.Queued && !shouldCancel(level)) {
+    auto fileId = 0;
+    if (message.range().valid()) {
+      fileId = message.range().fileId();
+    } else if (message.location().valid()) {
+      fileId = message.location().fileId();
+    }
 
-  o << "jvc: " << getDiagLevelName(level) << ": ";
-  message.DumpMessage(o);
-  o << '\n';
+    auto& shard = getShard();
+    std::lock_guard<std::mutex> lock { shard.Mutex };
+    auto& queue = shard.Queues[fileId];
+    auto allocatedSize = queue.GetAllocatedSize();
+    enqueue(queue, message, level);
+    // Account for the memory actually held, which grows in steps as the buffers are reallocated.
+    DiagnosticsQueueBytes.Add(queue.GetAllocatedSize() - allocatedSize);
+    return;
+  }
 
-  if (message.range().valid()) {
-    auto sourceFileInfo = _ci.GetSourceManager().GetSourceFileInfo(message.range());
-    if (sourceFileInfo) {
-      auto indGuard1 = o.PushIndent();
+  if (_opt.Queued) {
+    // Messages queued so far precede this one.
+    Flush();
+  }
+
+  {
+    std::string text;
+    {
+      StreamWriter textWriter { OutputStream::FromString(text) };
+      message.DumpMessage(textWriter);
+    }
+
+    std::lock_guard<std::mutex> lock { _outputMutex };
+    TimeTraceScope traceScope { "RenderDiagnostics" };
+    PerfCounterScope perfScope { PerfPhase::Diagnostics };
+    SnippetCache cache { _ci.GetSourceManager() };
+    renderMessage(getOutput(), level, message.id(), message.location(), message.range(), text, cache);
+  }
+
+  if (shouldCancel(level)) {
+    _cancelled.store(true, std::memory_order_relaxed);
+  }
+}
 
-      o << "In file " << sourceFileInfo->path() << ':';
-      message.range().Dump(o);
-      o << ":\n";
+bool DiagnosticsEngine::IsSuppressed(DiagnosticsLevel level) const {
+  switch (mapDiagLevel(level)) {
+    case DiagnosticsLevel::Warning:
+      return _opt.WarningLimit && GetWarningCount() >= _opt.WarningLimit;
+    case DiagnosticsLevel::Error:
+      return _opt.ErrorLimit && GetErrorCount() >= _opt.ErrorLimit;
+    default:
+      return false;
+  }
+}
 
-      auto indGuard2 = o.PushIndent();
-      auto sourceView = sourceFileInfo->GetViewInRange(message.range());
-      o << sourceView;
-      if (sourceView.back() != '\n') {
-        o << '\n';
+void DiagnosticsEngine::Flush(int fileId) {
+  auto queue = takeQueued(fileId);
+  if (queue.Messages.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock { _outputMutex };
+  std::string buffer;
+  {
+    StreamWriter writer { OutputStream::FromString(buffer) };
+    render(writer, queue);
+  }
+  getOutput() << buffer;
+}
+
+void DiagnosticsEngine::Flush() {
+  std::set<int> fileIds;
+  {
+    std::lock_guard<std::mutex> shardsLock { _shardsMutex };
+    for (const auto& [threadId, shard] : _shards) {
+      std::lock_guard<std::mutex> lock { shard->Mutex };
+      for (const auto& [fileId, queue] : shard->Queues) {
+        fileIds.insert(fileId);
       }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock { _outputMutex };
+  std::string buffer;
+  {
+    StreamWriter writer { OutputStream::FromString(buffer) };
+    for (auto fileId : fileIds) {
+      render(writer, takeQueued(fileId));
+    }
+    renderSuppressedCount(writer);
+  }
+  if (!buffer.empty()) {
+    getOutput() << buffer;
+  }
+}
+
+void DiagnosticsEngine::Finish() {
+  Flush();
+
+  std::lock_guard<std::mutex> lock { _outputMutex };
+  auto& output = getOutput();
+  if (_opt.Format == DiagnosticsFormat::Sarif && !_sarifClosed) {
+    renderSarifHeader(output);
+    output << "\n]}]}\n";
+    _sarifClosed = true;
+  }
+  output.Flush();
+}
+
+void DiagnosticsEngine::SetOutput(std::unique_ptr<OutputStream> output) {
+  std::lock_guard<std::mutex> lock { _outputMutex };
+  _output = std::make_unique<StreamWriter>(std::move(output));
+}
+
+StreamWriter& DiagnosticsEngine::getOutput() {
+  return _output ? *_output : errs();
+}
+
+DiagnosticsEngine::DiagnosticsShard& DiagnosticsEngine::getShard() {
+  struct ShardCache {
+    uint64_t EngineSerial;
+    DiagnosticsShard* Shard;
+  };
+  thread_local ShardCache cache { 0, nullptr };
+
+  if (cache.EngineSerial != _serial) {
+    std::lock_guard<std::mutex> lock { _shardsMutex };
+    auto& shard = _shards[std::this_thread::get_id()];
+    if (!shard) {
+      shard = std::make_unique<DiagnosticsShard>();
+    }
+    cache = ShardCache { _serial, shard.get() };
+  }
+  return *cache.Shard;
+}
+
+DiagnosticsEngine::DiagnosticsQueue DiagnosticsEngine::takeQueued(int fileId) {
+  DiagnosticsQueue merged;
+  {
+    std::lock_guard<std::mutex> shardsLock { _shardsMutex };
+    for (auto& [threadId, shard] : _shards) {
+      std::lock_guard<std::mutex> lock { shard->Mutex };
+      auto it = shard->Queues.find(fileId);
+      if (it == shard->Queues.end()) {
+        continue;
+      }
+
+      auto argumentsBase = merged.Arguments.size();
+      merged.Arguments.append(it->second.Arguments);
+      for (auto message : it->second.Messages) {
+        message.ArgumentsOffset += argumentsBase;
+        merged.Messages.push_back(message);
+      }
+      DiagnosticsQueueBytes.Subtract(it->second.GetAllocatedSize());
+      shard->Queues.erase(it);
+    }
+  }
 
-      if (message.range().start().row() == message.range().end().row()) {
-        for (auto i = 1; i < message.range().start().col(); ++i) {
-          o << ' ';
+  // Shards are visited in no particular order, so ties are broken by the content of the messages. Messages reported
+  // by the same thread keep their relative order.
+  std::string_view arguments { merged.Arguments };
+  auto getArguments = [&arguments](const QueuedDiagnostics& message) {
+    auto encoded = arguments.substr(message.ArgumentsOffset);
+    auto rest = encoded;
+    for (size_t i = 0; i < message.ArgumentCount; ++i) {
+      DiagnosticsArgument::Decode(rest);
+    }
+    return encoded.substr(0, encoded.size() - rest.size());
+  };
+  std::sort(merged.Messages.begin(), merged.Messages.end(),
+      [&getArguments](const QueuedDiagnostics& lhs, const QueuedDiagnostics& rhs) {
+        const auto& lhsStart = lhs.Start;
+        const auto& rhsStart = rhs.Start;
+        if (lhsStart.row() != rhsStart.row()) {
+          return lhsStart.row() < rhsStart.row();
+        }
+        if (lhsStart.col() != rhsStart.col()) {
+          return lhsStart.col() < rhsStart.col();
+        }
+        if (lhs.Sequence != rhs.Sequence) {
+          return lhs.Sequence < rhs.Sequence;
         }
-        o << '^';
-        for (auto i = message.range().start().col() + 1; i < message.range().end().col(); ++i) {
-          o << '~';
+        if (lhs.Level != rhs.Level) {
+          return lhs.Level < rhs.Level;
         }
+        if (lhs.Kind != rhs.Kind) {
+          return lhs.Kind < rhs.Kind;
+        }
+        return getArguments(lhs) < getArguments(rhs);
+      });
+  return merged;
+}
+
+void DiagnosticsEngine::enqueue(DiagnosticsQueue& queue, const DiagnosticsMessage& message, DiagnosticsLevel level) {
+  auto argumentsOffset = queue.Arguments.size();
+  uint16_t kind;
+  size_t argumentCount = 0;
+  if (auto diag = dynamic_cast<const Diagnostics *>(&message)) {
+    // Only the arguments are copied; the message is formatted if and when it is rendered.
+    kind = static_cast<uint16_t>(diag->kind());
+    for (size_t i = 0; i < Diagnostics::MaxArguments; ++i) {
+      if (diag->GetArgument(i).valid()) {
+        argumentCount = i + 1;
       }
     }
-  } else if (message.location().valid()) {
-    auto sourceFileInfo = _ci.GetSourceManager().GetSourceFileInfo(message.location());
-    if (sourceFileInfo) {
-      auto indGuard1 = o.PushIndent();
+    for (size_t i = 0; i < argumentCount; ++i) {
+      diag->GetArgument(i).Encode(queue.Arguments);
+    }
+  } else {
+    std::string text;
+    {
+      StreamWriter textWriter { OutputStream::FromString(text) };
+      message.DumpMessage(textWriter);
+    }
+    kind = QueuedDiagnostics::LiteralKind;
+    argumentCount = 1;
+    DiagnosticsArgument { text }.Encode(queue.Arguments);
+    appendRaw(queue.Arguments, message.id());
+  }
 
-      o << "In file " << sourceFileInfo->path() << ':';
-      message.location().Dump(o);
-      o << ":\n";
+  auto range = message.range();
+  queue.Messages.push_back(QueuedDiagnostics {
+      range.valid() ? range.start() : message.location(), range.valid() ? range.end() : SourceLocation { },
+      argumentsOffset, static_cast<uint32_t>(queue.Messages.size()), kind, static_cast<uint8_t>(argumentCount),
+      level });
+}
 
-      auto indGuard2 = o.PushIndent();
-      auto sourceView = sourceFileInfo->GetViewAtLoc(message.location());
-      o << sourceView;
-      if (sourceView.back() != '\n') {
-        o << '\n';
-      }
+const char* DiagnosticsEngine::formatQueued(const DiagnosticsQueue& queue, const QueuedDiagnostics& message,
+                                            std::string& text) {
+  std::string_view arguments { queue.Arguments };
+  arguments.remove_prefix(message.ArgumentsOffset);
+  std::array<DiagnosticsArgument, Diagnostics::MaxArguments> args;
+  for (size_t i = 0; i < message.ArgumentCount; ++i) {
+    args[i] = DiagnosticsArgument::Decode(arguments);
+  }
 
-      for (auto i = 1; i < message.range().start().col(); ++i) {
-        o << ' ';
-      }
-      o << '^';
+  text.clear();
+  StreamWriter textWriter { OutputStream::FromString(text) };
+  if (message.Kind == QueuedDiagnostics::LiteralKind) {
+    args[0].Dump(textWriter);
+    return readRaw<const char *>(arguments);
+  }
+
+  auto kind = static_cast<DiagnosticsKind>(message.Kind);
+  Diagnostics { kind, args[0], args[1], args[2], args[3] }.DumpMessage(textWriter);
+  return GetDiagnosticsKindName(kind);
+}
+
+bool DiagnosticsEngine::countMessage(DiagnosticsLevel level) {
+  switch (level) {
+    case DiagnosticsLevel::Warning:
+      return _warnings.fetch_add(1, std::memory_order_relaxed) < _opt.WarningLimit || !_opt.WarningLimit;
+    case DiagnosticsLevel::Error:
+      return _errors.fetch_add(1, std::memory_order_relaxed) < _opt.ErrorLimit || !_opt.ErrorLimit;
+    default:
+      return true;
+  }
+}
+
+void DiagnosticsEngine::render(StreamWriter& output, const DiagnosticsQueue& queue) {
+  TimeTraceScope traceScope { "RenderDiagnostics" };
+  PerfCounterScope perfScope { PerfPhase::Diagnostics };
+  AllocationScope allocationScope { MemorySubsystem::Diagnostics };
+  SnippetCache cache { _ci.GetSourceManager() };
+  std::string text;
+  for (const auto& message : queue.Messages) {
+    auto id = formatQueued(queue, message, text);
+    auto reportedAtRange = message.End.valid();
+    renderMessage(output, message.Level, id, reportedAtRange ? SourceLocation { } : message.Start,
+                  reportedAtRange ? SourceRange { message.Start, message.End } : SourceRange { }, text, cache);
+  }
+}
+
+void DiagnosticsEngine::renderMessage(StreamWriter& output, DiagnosticsLevel level, const char* id,
+                                      SourceLocation location, SourceRange range, std::string_view text,
+                                      SnippetCache& cache) {
+  switch (_opt.Format) {
+    case DiagnosticsFormat::Text:
+      output << "jvc: " << getDiagLevelName(level) << ": " << text << '\n';
+      renderSnippet(output, location, range, cache);
+      output << '\n';
+      break;
+    case DiagnosticsFormat::JsonLines:
+      buildRecord(level, id, location, range, text, cache);
+      _record.push_back('\n');
+      output << _record;
+      break;
+    case DiagnosticsFormat::Sarif:
+      renderSarifHeader(output);
+      buildRecord(level, id, location, range, text, cache);
+      output << (_sarifResults++ ? ",\n" : "\n") << _record;
+      break;
+  }
+}
+
+void DiagnosticsEngine::buildRecord(DiagnosticsLevel level, const char* id, SourceLocation location,
+                                    SourceRange range, std::string_view text, SnippetCache& cache) {
+  auto start = range.valid() ? range.start() : location;
+  auto end = range.valid() ? range.end() : SourceLocation { location.fileId(), location.row(), location.col() + 1 };
+  auto sourceFileInfo = start.valid() ? cache.GetFile(start.fileId()) : nullptr;
+  size_t startOffset = 0;
+  size_t endOffset = 0;
+  auto hasOffsets = sourceFileInfo && sourceFileInfo->GetOffsetOfLoc(start, startOffset);
+  if (hasOffsets && end.row() == start.row() && end.col() >= start.col()) {
+    endOffset = startOffset + (end.col() - start.col());
+  } else if (hasOffsets) {
+    hasOffsets = sourceFileInfo->GetOffsetOfLoc(end, endOffset);
+  }
+
+  _record.clear();
+  if (_opt.Format == DiagnosticsFormat::JsonLines) {
+    _record.append("{\"level\":\"").append(getDiagLevelName(level)).push_back('"');
+    if (id) {
+      _record.append(",\"id\":\"").append(id).push_back('"');
+    }
+    if (sourceFileInfo) {
+      _record.append(",\"file\":");
+      AppendJsonString(_record, sourceFileInfo->path());
+    }
+    if (hasOffsets) {
+      AppendJsonField(_record, "offset", startOffset);
+      AppendJsonField(_record, "endOffset", endOffset);
+    }
+    if (start.valid()) {
+      AppendJsonField(_record, "line", start.row());
+      AppendJsonField(_record, "column", start.col());
+      AppendJsonField(_record, "endLine", end.row());
+      AppendJsonField(_record, "endColumn", end.col());
+    }
+    _record.append(",\"message\":");
+    AppendJsonString(_record, text);
+    _record.push_back('}');
+    return;
+  }
+
+  _record.push_back('{');
+  if (id) {
+    _record.append("\"ruleId\":\"").append(id).append("\",");
+  }
+  _record.append("\"level\":\"").append(getSarifLevelName(level)).append("\",\"message\":{\"text\":");
+  AppendJsonString(_record, text);
+  _record.push_back('}');
+  if (sourceFileInfo) {
+    _record.append(",\"locations\":[{\"physicalLocation\":{\"artifactLocation\":{\"uri\":");
+    AppendJsonString(_record, sourceFileInfo->path());
+    _record.append("},\"region\":{\"startLine\":");
+    AppendJsonNumber(_record, start.row());
+    AppendJsonField(_record, "startColumn", start.col());
+    AppendJsonField(_record, "endLine", end.row());
+    AppendJsonField(_record, "endColumn", end.col());
+    if (hasOffsets) {
+      AppendJsonField(_record, "byteOffset", startOffset);
+      AppendJsonField(_record, "byteLength", endOffset - startOffset);
     }
+    _record.append("}}}]");
+  }
+  _record.push_back('}');
+}
+
+void DiagnosticsEngine::renderSarifHeader(StreamWriter& output) {
+  if (_sarifOpened) {
+    return;
+  }
+  _sarifOpened = true;
+
+  std::string header { "{\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",\"version\":\"2.1.0\","
+                       "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"jvc\",\"rules\":[" };
+  auto first = true;
+  for (const auto& info : DiagnosticsKindTable) {
+    header.append(first ? "\n" : ",\n");
+    first = false;
+    header.append("{\"id\":\"").append(info.Name).append("\",\"shortDescription\":{\"text\":");
+    AppendJsonString(header, info.Format);
+    header.append("},\"defaultConfiguration\":{\"level\":\"").append(getSarifLevelName(info.Level)).append("\"}}");
+  }
+  header.append("\n]}},\"results\":[");
+  output << header;
+}
+
+void DiagnosticsEngine::renderSuppressedCount(StreamWriter& output) {
+  auto errors = GetErrorCount();
+  auto warnings = GetWarningCount();
+  auto suppressedErrors = _opt.ErrorLimit && errors > _opt.ErrorLimit ? errors - _opt.ErrorLimit : 0;
+  auto suppressedWarnings = _opt.WarningLimit && warnings > _opt.WarningLimit ? warnings - _opt.WarningLimit : 0;
+
+  std::lock_guard<std::mutex> lock { _shardsMutex };
+  if (suppressedErrors + suppressedWarnings <= _suppressedReported) {
+    return;
+  }
+  _suppressedReported = suppressedErrors + suppressedWarnings;
+
+  std::string text;
+  {
+    StreamWriter textWriter { OutputStream::FromString(text) };
+    textWriter << suppressedErrors << " error(s) and " << suppressedWarnings << " warning(s) were not reported; "
+               << "raise -ferror-limit or -fwarning-limit to see them.";
+  }
+  SnippetCache cache { _ci.GetSourceManager() };
+  renderMessage(output, DiagnosticsLevel::Info, nullptr, SourceLocation { }, SourceRange { }, text, cache);
+}
+
+void DiagnosticsEngine::renderSnippet(StreamWriter& output, SourceLocation location, SourceRange range,
+                                      SnippetCache& cache) const {
+  auto start = range.valid() ? range.start() : location;
+  if (!start.valid()) {
+    return;
+  }
+  auto sourceFileInfo = cache.GetFile(start.fileId());
+  if (!sourceFileInfo) {
+    return;
   }
 
-  o << '\n';
+  auto indGuard1 = output.PushIndent();
+
+  output << "In file " << sourceFileInfo->path() << ':';
+  if (range.valid()) {
+    range.Dump(output);
+  } else {
+    location.Dump(output);
+  }
+  output << ":\n";
+
+  auto indGuard2 = output.PushIndent();
+  auto sourceView = range.valid() ? cache.GetViewInRange(range) : cache.GetViewAtLoc(location);
+  // The source code may be no longer available, e.g. it has slid out of the window of a streaming source file.
+  if (sourceView.empty()) {
+    return;
+  }
+  output << sourceView;
+  if (sourceView.back() != '\n') {
+    output << '\n';
+  }
 
-  if (shouldExit(level)) {
-    std::exit(1);
+  if (!range.valid()) {
+    output << cache.GetCaret(location.col(), location.col() + 1);
+  } else if (range.start().row() == range.end().row()) {
+    output << cache.GetCaret(range.start().col(), range.end().col());
   }
 }
 
@@ -142,7 +763,7 @@ DiagnosticsLevel DiagnosticsEngine::mapDiagLevel(DiagnosticsLevel level) const {
   }
 }
 
-bool DiagnosticsEngine::shouldExit(DiagnosticsLevel level) const {
+bool DiagnosticsEngine::shouldCancel(DiagnosticsLevel level) const {
   return level == DiagnosticsLevel::Fatal ||
       (level == DiagnosticsLevel::Error && _opt.ExitOnError);
 }
@@ -15,8 +15,7 @@ std::unique_ptr<FrontendAction> FrontendAction::CreateAction(FrontendActionKind
     case FrontendActionKind::LexOnly:
       return std::make_unique<LexOnlyFrontendAction>();
     default: {
-      auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Fatal, "Unsupported action type.");
-      diag.Emit(*diagMsg);
+      diag.Emit(Diagnostics { DiagnosticsKind::UnsupportedAction });
       return std::unique_ptr<FrontendAction> { };
     }
   }
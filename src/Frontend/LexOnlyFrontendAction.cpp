@@ -2,14 +2,147 @@
 // Created by Sirui Mu on 2019/12/23.
 //
 
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/PerfCounters.h"
 #include "Infrastructure/Stream.h"
+#include "Infrastructure/ThreadPool.h"
+#include "Infrastructure/TimeTrace.h"
 #include "Frontend/FrontendAction.h"
 #include "Frontend/CompilerInstance.h"
 #include "Lex/Lexer.h"
+#include "Lex/LexerStatistics.h"
+#include "Lex/TokenDumper.h"
 #include "BuiltinFrontendActions.h"
 
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
 namespace jvc {
 
+namespace {
+
+/**
+ * @brief Number of tokens lexed before they are dumped when lexing and dumping are profiled, so that the profilers can
+ * tell the two phases apart without a pair of events per token.
+ */
+constexpr const size_t TokenBatchSize = 4096;
+
+/**
+ * @brief Number of files per job that may be lexed ahead of the first file whose dump has not been committed. Dumps of
+ * files lexed ahead are buffered, and their sources cannot be released, until every file before them is committed.
+ */
+constexpr const size_t LookaheadFilesPerJob = 2;
+
+JVC_MEMORY_GAUGE(TokenBytes, "Bytes held by lexed tokens waiting to be dumped; only measured with --mem-report");
+JVC_MEMORY_GAUGE(PendingDumpBytes, "Bytes of token dumps of files lexed ahead, waiting to be written in order");
+
+/**
+ * @brief Lex all tokens of the given lexer and dump them in batches of @see TokenBatchSize tokens, alternating between
+ * the lexing and the dumping phase once per batch.
+ * @param lexer the lexer.
+ * @param dumper the token dumper.
+ * @param measureTokens whether to measure the memory held by the lexed tokens.
+ */
+void dumpTokenBatches(Lexer& lexer, TokenDumper& dumper, bool measureTokens) {
+  std::vector<std::unique_ptr<Token>> batch;
+  batch.reserve(TokenBatchSize);
+  auto eos = false;
+  while (!eos) {
+    size_t batchBytes = 0;
+    {
+      TimeTraceScope lexScope { "Lex" };
+      PerfCounterScope lexPerfScope { PerfPhase::Lex };
+      AllocationScope allocationScope { MemorySubsystem::Lexer };
+      while (batch.size() < TokenBatchSize) {
+        auto token = lexer.ReadNextToken();
+        if (!token) {
+          eos = true;
+          break;
+        }
+        if (measureTokens) {
+          batchBytes += GetTokenMemoryUsage(*token);
+        }
+        batch.push_back(std::move(token));
+      }
+    }
+    TokenBytes.Add(batchBytes);
+
+    TimeTraceScope dumpScope { "DumpTokens" };
+    PerfCounterScope dumpPerfScope { PerfPhase::Dump };
+    AllocationScope allocationScope { MemorySubsystem::TokenDumper };
+    for (const auto& token : batch) {
+      dumper.Dump(*token);
+    }
+    batch.clear();
+    TokenBytes.Subtract(batchBytes);
+    if (eos) {
+      dumper.Finish();
+    }
+  }
+}
+
+/**
+ * @brief Lex the given source code file and dump its tokens to the given output. The lexer pins the content of the
+ * source code file; it is destroyed before this function returns, so that the content can be evicted afterwards.
+ * @param ci the compiler instance.
+ * @param fileId ID of the source code file.
+ * @param options the lexer options.
+ * @param o the output.
+ * @param stats statistics collected by the lexer are merged into this object.
+ */
+void dumpTokens(CompilerInstance& ci, int fileId, const LexerOptions& options, StreamWriter& o,
+                LexerStatistics& stats) {
+  auto sourceFile = ci.GetSourceManager().GetSourceFileInfo(fileId);
+  TimeTraceScope traceScope { "Lexer", sourceFile->path() };
+  auto lexer = Lexer::Create(ci, fileId, options);
+
+  auto dumper = TokenDumper::Create(ci.options().DumpFormat, *sourceFile, o);
+  auto measureTokens = ci.options().MemReport;
+  if (TimeTraceProfiler::IsEnabled() || PerfCounters::IsEnabled()) {
+    dumpTokenBatches(*lexer, *dumper, measureTokens);
+  } else {
+    while (true) {
+      std::unique_ptr<Token> token;
+      {
+        AllocationScope allocationScope { MemorySubsystem::Lexer };
+        token = lexer->ReadNextToken();
+      }
+      if (!token) {
+        break;
+      }
+      size_t tokenBytes = 0;
+      if (measureTokens) {
+        tokenBytes = GetTokenMemoryUsage(*token);
+        TokenBytes.Add(tokenBytes);
+      }
+      AllocationScope allocationScope { MemorySubsystem::TokenDumper };
+      dumper->Dump(*token);
+      TokenBytes.Subtract(tokenBytes);
+    }
+    AllocationScope allocationScope { MemorySubsystem::TokenDumper };
+    dumper->Finish();
+  }
+
+  if (auto lexerStats = lexer->GetStatistics()) {
+    stats.Merge(*lexerStats);
+  }
+}
+
+/**
+ * @brief A source code file being lexed by a worker, whose dump is committed to the output in file ID order.
+ */
+struct LexedFile {
+  std::string Output;
+  bool Done = false;
+};
+
+} // namespace <anonymous>
+
 void LexOnlyFrontendAction::ExecuteAction(CompilerInstance& ci) {
   std::unique_ptr<StreamWriter> writer;
   StreamWriter* o;
@@ -17,22 +150,82 @@ void LexOnlyFrontendAction::ExecuteAction(CompilerInstance& ci) {
     auto outputFileStream = OutputStream::FromFile(ci.options().OutputFilePath);
     writer = std::make_unique<StreamWriter>(std::move(outputFileStream));
     o = writer.get();
+  } else if (ci.options().DumpFormat == TokenDumpFormat::Binary) {
+    // Write binary dumps to the standard output directly, so that sections go out with a single vectored write.
+    writer = std::make_unique<StreamWriter>(OutputStream::FromFileDescriptor(STDOUT_FILENO, false));
+    o = writer.get();
   } else {
     o = &outs();
   }
+  TokenDumper::WriteHeader(ci.options().DumpFormat, o->stream());
 
-  for (size_t i = 1; i <= ci.GetSourceManager().size(); ++i) {
-    auto lexer = Lexer::Create(ci, i);
+  if (ci.options().LexStats && !LexerStatistics::IsEnabled()) {
+    ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::LexStatsNotCompiledIn });
+  }
+
+  LexerOptions lexerOptions { };
+  lexerOptions.CollectStatistics = ci.options().LexStats;
+  LexerStatistics stats { };
 
-    auto sourceFile = ci.GetSourceManager().GetSourceFileInfo(i);
-    *o << "Tokenization of source file: " << sourceFile->path() << "\n";
+  auto& diag = ci.GetDiagnosticsEngine();
+  auto& sources = ci.GetSourceManager();
+  auto files = sources.size();
+  auto jobs = ci.options().Jobs ? ci.options().Jobs : ThreadPool::GetDefaultConcurrency();
 
-    auto indentGuard = o->PushIndent();
-    while (auto token = lexer->ReadNextToken()) {
-      token->Dump(*o);
-      *o << '\n';
+  if (jobs <= 1 || files <= 1) {
+    for (size_t i = 1; i <= files && !diag.IsCancelled(); ++i) {
+      dumpTokens(ci, i, lexerOptions, *o, stats);
+      diag.Flush(i);
+      sources.ReleaseFile(i);
     }
-    *o << '\n';
+  } else {
+    // Dumps are buffered and committed in file ID order, which keeps the output identical to the sequential run. Files
+    // are handed out in ID order and a worker waits while its file is too far ahead of the next one to commit, which
+    // bounds both the buffered dumps and the sources that cannot be released yet. The file at nextCommit never waits,
+    // so the run always makes progress.
+    auto lookahead = jobs * LookaheadFilesPerJob;
+    std::vector<LexedFile> lexed(files + 1);
+    size_t nextCommit = 1;
+    std::mutex commitMutex;
+    std::condition_variable committed;
+
+    ParallelFor(jobs, files, [&](size_t index) {
+      auto fileId = index + 1;
+      {
+        std::unique_lock<std::mutex> lock { commitMutex };
+        committed.wait(lock, [&]() { return fileId < nextCommit + lookahead || diag.IsCancelled(); });
+      }
+      if (diag.IsCancelled()) {
+        // The file that cancelled the run may not be committed, so wake up the workers waiting behind it.
+        committed.notify_all();
+        return;
+      }
+
+      LexerStatistics fileStats { };
+      {
+        StreamWriter fileWriter { OutputStream::FromString(lexed[fileId].Output) };
+        dumpTokens(ci, fileId, lexerOptions, fileWriter, fileStats);
+      }
+
+      std::lock_guard<std::mutex> lock { commitMutex };
+      committed.notify_all();
+      stats.Merge(fileStats);
+      lexed[fileId].Done = true;
+      PendingDumpBytes.Add(lexed[fileId].Output.capacity());
+      // A file cancelled before it was lexed is never done, so nothing past it is committed, as in the sequential run.
+      for (; nextCommit <= files && lexed[nextCommit].Done; ++nextCommit) {
+        auto& output = lexed[nextCommit].Output;
+        o->stream().Write(output.data(), output.size());
+        PendingDumpBytes.Subtract(output.capacity());
+        std::string { }.swap(output);
+        diag.Flush(nextCommit);
+        sources.ReleaseFile(nextCommit);
+      }
+    });
+  }
+
+  if (ci.options().LexStats && LexerStatistics::IsEnabled()) {
+    stats.Dump(errs());
   }
 }
 
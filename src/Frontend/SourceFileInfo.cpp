@@ -2,14 +2,15 @@
 // Created by Sirui Mu on 2019/12/19.
 //
 
+#include "Infrastructure/FileSystem.h"
+#include "Infrastructure/Diff.h"
+#include "Infrastructure/Hash.h"
+#include "Infrastructure/MemoryBuffer.h"
 #include "Infrastructure/Stream.h"
 #include "Frontend/SourceManager.h"
 #include "Frontend/Diagnostics.h"
 #include "SourceFileLineBuffer.h"
 
-#include <cerrno>
-#include <cstring>
-#include <fstream>
 #include <sstream>
 
 namespace jvc {
@@ -43,52 +44,126 @@ std::string_view SourceFileInfo::GetViewAtLoc(SourceLocation loc) const {
   return _lineBuffer->GetLineView(loc.row());
 }
 
-const std::string& SourceFileInfo::GetContent() const {
+std::string_view SourceFileInfo::GetContent() const {
   return _lineBuffer->content();
 }
 
+std::shared_ptr<const MemoryBuffer> SourceFileInfo::GetBuffer() const {
+  return _lineBuffer->GetBuffer();
+}
+
+bool SourceFileInfo::IsResident() const {
+  return _lineBuffer->IsResident();
+}
+
+size_t SourceFileInfo::GetSize() const {
+  return _lineBuffer->length();
+}
+
+void SourceFileInfo::setReloader(std::function<std::shared_ptr<const MemoryBuffer>()> reloader) const {
+  _lineBuffer->SetReloader(std::move(reloader));
+}
+
+bool SourceFileInfo::canEvict() const {
+  return _lineBuffer->CanEvict();
+}
+
+size_t SourceFileInfo::tryEvict() const {
+  return _lineBuffer->TryEvict();
+}
+
 SourceLocation SourceFileInfo::GetEOFLoc() const {
-  auto lines = static_cast<int>(_lineBuffer->lines());
-  auto lastLineWidth = static_cast<int>(_lineBuffer->GetLineWidth(lines));
+  auto lines = _lineBuffer->lines();
+  auto lastLineWidth = _lineBuffer->GetLineWidth(lines);
   return SourceLocation { _id, lines, lastLineWidth + 1 };
 }
 
-std::unique_ptr<InputStream> SourceFileInfo::CreateInputStream() const {
-  const auto& view = _lineBuffer->content();
-  return InputStream::FromBuffer(view.data(), view.size());
+SourceLocation SourceFileInfo::GetLocForOffset(size_t offset) const {
+  auto row = _lineBuffer->GetRowOfOffset(offset);
+  if (!row) {
+    return SourceLocation { };
+  }
+  auto col = offset - _lineBuffer->GetLineStart(row) + 1;
+  return SourceLocation { _id, row, col };
+}
+
+bool SourceFileInfo::GetOffsetOfLoc(SourceLocation loc, size_t& offset) const {
+  if (loc.fileId() != _id || loc.row() < 1 || loc.row() > _lineBuffer->lines() || loc.col() < 1) {
+    return false;
+  }
+  // The line table reports 0 for dropped lines; only the first line really starts there.
+  auto lineStart = _lineBuffer->GetLineStart(loc.row());
+  if (!lineStart && loc.row() != 1) {
+    return false;
+  }
+  offset = lineStart + loc.col() - 1;
+  return true;
+}
+
+bool SourceFileInfo::IsStreaming() const {
+  return _lineBuffer->streaming();
+}
+
+uint64_t SourceFileInfo::GetContentHash() const {
+  return _lineBuffer->contentHash();
 }
 
-namespace {
+Hash128 SourceFileInfo::GetContentFingerprint() const {
+  return _lineBuffer->fingerprint();
+}
 
-class LoadFileFailedDiagnosticsMessage : public DiagnosticsMessage {
-public:
-  explicit LoadFileFailedDiagnosticsMessage(const std::string& path, int errorCode)
-      : DiagnosticsMessage(DiagnosticsLevel::Fatal),
-        _path(path),
-        _errorCode(errorCode)
-  { }
+const SourceLineFingerprints& SourceFileInfo::GetLineFingerprints() const {
+  return _lineBuffer->GetLineFingerprints();
+}
 
-  void DumpMessage(StreamWriter &output) const override {
-    output << "cannot load source file: "
-           << _path << ": "
-           << std::strerror(_errorCode);
+std::vector<SourceLineChange> SourceFileInfo::Diff(const SourceFileInfo& oldFile, const SourceFileInfo& newFile) {
+  if (oldFile.IsStreaming() || newFile.IsStreaming()) {
+    return { SourceLineChange { 1, oldFile._lineBuffer->lines(), 1, newFile._lineBuffer->lines() } };
+  }
+  if (oldFile.GetContentFingerprint() == newFile.GetContentFingerprint()) {
+    return { };
   }
 
-private:
-  const std::string& _path;
-  int _errorCode;
-};
+  const auto& oldLines = oldFile.GetLineFingerprints().GetLineHashes();
+  const auto& newLines = newFile.GetLineFingerprints().GetLineHashes();
+  auto hunks = DiffSequences(oldLines.data(), oldLines.size(), newLines.data(), newLines.size());
 
-} // namespace <anonymous>
+  std::vector<SourceLineChange> changes;
+  changes.reserve(hunks.size());
+  for (const auto& hunk : hunks) {
+    changes.push_back(SourceLineChange {
+        hunk.OldStart + 1, hunk.OldLength, hunk.NewStart + 1, hunk.NewLength });
+  }
+  return changes;
+}
+
+std::unique_ptr<InputStream> SourceFileInfo::CreateInputStream() const {
+  return _lineBuffer->CreateInputStream();
+}
 
 SourceFileInfo SourceFileInfo::Load(int fileId, const std::string& path, DiagnosticsEngine& diag) {
-  std::ifstream fs { path };
-  if (fs.fail()) {
-    int errorCode = errno;
-    diag.Emit(LoadFileFailedDiagnosticsMessage { path, errorCode });
+  int errorCode;
+  auto sourceFileInfo = Load(fileId, path, *FileSystem::GetRealFileSystem(), errorCode);
+  if (errorCode) {
+    EmitLoadError(path, errorCode, diag);
   }
 
-  return Load(fileId, path, InputStream::FromSTL(fs));
+  return sourceFileInfo;
+}
+
+SourceFileInfo SourceFileInfo::Load(int fileId, const std::string& path, const FileSystem& fileSystem,
+                                    int& errorCode) {
+  auto buffer = fileSystem.ReadFile(path, errorCode);
+  if (!buffer) {
+    buffer = MemoryBuffer::FromString(std::string { });
+  }
+
+  auto fingerprint = HashBytes128(buffer->GetView());
+  return Load(fileId, path, std::move(buffer), fingerprint);
+}
+
+void SourceFileInfo::EmitLoadError(const std::string& path, int errorCode, DiagnosticsEngine& diag) {
+  diag.Emit(Diagnostics { DiagnosticsKind::CannotLoadSourceFile, path, DiagnosticsArgument::ErrorCode(errorCode) });
 }
 
 SourceFileInfo SourceFileInfo::Load(int fileId, const std::string& path, std::unique_ptr<InputStream> inputData) {
@@ -96,4 +171,16 @@ SourceFileInfo SourceFileInfo::Load(int fileId, const std::string& path, std::un
   return SourceFileInfo { fileId, path, std::move(lineBuffer) };
 }
 
+SourceFileInfo SourceFileInfo::Load(int fileId, const std::string& path, std::shared_ptr<const MemoryBuffer> content,
+                                    Hash128 fingerprint) {
+  auto lineBuffer = std::make_unique<SourceFileLineBuffer>(std::move(content), fingerprint);
+  return SourceFileInfo { fileId, path, std::move(lineBuffer) };
+}
+
+SourceFileInfo SourceFileInfo::LoadStreaming(int fileId, const std::string& path,
+                                             std::unique_ptr<InputStream> inputData) {
+  auto lineBuffer = SourceFileLineBuffer::LoadStreaming(std::move(inputData));
+  return SourceFileInfo { fileId, path, std::move(lineBuffer) };
+}
+
 }
@@ -3,65 +3,278 @@
 //
 
 #include "Infrastructure/Stream.h"
+#include "Infrastructure/Hash.h"
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/TimeTrace.h"
 #include "SourceFileLineBuffer.h"
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
 namespace jvc {
 
+JVC_MEMORY_GAUGE(SourceLineTableBytes, "Bytes held by the line tables of source files");
+
+namespace {
+
+/**
+ * @brief An @see InputStream that feeds everything read from the underlying stream into a streaming line buffer.
+ */
+template <typename LineBuffer>
+class LineBufferFeedingInputStream : public InputStream {
+public:
+  explicit LineBufferFeedingInputStream(std::unique_ptr<InputStream> inner, LineBuffer& lineBuffer)
+      : _inner(std::move(inner)),
+        _lineBuffer(lineBuffer)
+  { }
+
+  size_t Read(void *buffer, size_t bufferSize) override {
+    auto read = _inner->Read(buffer, bufferSize);
+    _lineBuffer.Append(reinterpret_cast<const char *>(buffer), read);
+    return read;
+  }
+
+private:
+  std::unique_ptr<InputStream> _inner;
+  LineBuffer& _lineBuffer;
+};
+
+} // namespace <anonymous>
+
 std::unique_ptr<SourceFileInfo::SourceFileLineBuffer>
     SourceFileInfo::SourceFileLineBuffer::Load(std::unique_ptr<InputStream> inputData) {
   assert(inputData && "inputData is nullptr.");
 
   StreamReader reader { std::move(inputData) };
-  auto content = reader.ReadToEnd();
+  auto buffer = MemoryBuffer::FromString(reader.ReadToEnd());
+
+  auto fingerprint = HashBytes128(buffer->GetView());
+  return std::make_unique<SourceFileInfo::SourceFileLineBuffer>(std::move(buffer), fingerprint);
+}
 
-  std::vector<size_t> lineStarts;
-  lineStarts.push_back(0);
-  for (size_t i = 0; i < content.size(); ++i) {
-    if (content[i] == '\n') {
-      lineStarts.push_back(i + 1);
+std::unique_ptr<SourceFileInfo::SourceFileLineBuffer>
+    SourceFileInfo::SourceFileLineBuffer::LoadStreaming(std::unique_ptr<InputStream> inputData) {
+  assert(inputData && "inputData is nullptr.");
+
+  auto lineBuffer = std::make_unique<SourceFileInfo::SourceFileLineBuffer>(nullptr);
+  lineBuffer->_streaming = true;
+  lineBuffer->_streamingInput = std::move(inputData);
+  lineBuffer->_lineTable = std::make_unique<SourceFileLineTable>();
+  return lineBuffer;
+}
+
+SourceFileInfo::SourceFileLineBuffer::~SourceFileLineBuffer() {
+  SourceLineTableBytes.Subtract(_lineTableBytes);
+}
+
+const SourceFileLineTable& SourceFileInfo::SourceFileLineBuffer::getLineTable() const {
+  if (!_streaming) {
+    std::call_once(_lineTableBuilt, [this]() {
+      TimeTraceScope traceScope { "BuildLineTable" };
+      AllocationScope allocationScope { MemorySubsystem::SourceManager };
+      auto buffer = GetBuffer();
+      _lineTable = buffer
+          ? SourceFileLineTable::Build(buffer->data(), buffer->size())
+          : std::make_unique<SourceFileLineTable>();
+      _lineTableBytes = _lineTable->GetMemoryUsage();
+      SourceLineTableBytes.Add(_lineTableBytes);
+    });
+  }
+  return *_lineTable;
+}
+
+const SourceLineFingerprints& SourceFileInfo::SourceFileLineBuffer::GetLineFingerprints() const {
+  std::call_once(_lineFingerprintsBuilt, [this]() {
+    auto buffer = _streaming ? nullptr : GetBuffer();
+    if (!buffer) {
+      _lineFingerprints = SourceLineFingerprints::Build(std::string_view(), { });
+      return;
+    }
+
+    const auto& lineTable = getLineTable();
+    std::vector<uint64_t> lineStarts;
+    lineStarts.reserve(lineTable.size());
+    for (size_t i = 0; i < lineTable.size(); ++i) {
+      lineStarts.push_back(lineTable.GetLineStart(i));
     }
+    _lineFingerprints = SourceLineFingerprints::Build(buffer->GetView(), lineStarts);
+  });
+  return *_lineFingerprints;
+}
+
+std::string_view SourceFileInfo::SourceFileLineBuffer::content() const {
+  if (_streaming) {
+    return _content;
   }
 
-  return std::make_unique<SourceFileInfo::SourceFileLineBuffer>(std::move(content), std::move(lineStarts));
+  auto buffer = GetBuffer();
+  return buffer ? buffer->GetView() : std::string_view { };
+}
+
+std::shared_ptr<const MemoryBuffer> SourceFileInfo::SourceFileLineBuffer::GetBuffer() const {
+  if (_streaming) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock { _bufferMutex };
+  if (!_buffer && _reloader) {
+    _buffer = _reloader();
+  }
+  return _buffer;
+}
+
+bool SourceFileInfo::SourceFileLineBuffer::IsResident() const {
+  if (_streaming) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock { _bufferMutex };
+  return _buffer != nullptr;
+}
+
+size_t SourceFileInfo::SourceFileLineBuffer::TryEvict() {
+  if (_streaming || !_reloader) {
+    return 0;
+  }
+
+  // The content may be being reloaded by a thread that is about to account for it, in which case leave it alone.
+  std::unique_lock<std::mutex> lock { _bufferMutex, std::try_to_lock };
+  if (!lock.owns_lock() || !_buffer) {
+    return 0;
+  }
+  // Dropping a pinned buffer would free nothing, and the next reload would hold the content twice.
+  if (_buffer.use_count() > 1) {
+    return 0;
+  }
+
+  auto size = _buffer->size();
+  _buffer.reset();
+  return size;
 }
 
 size_t SourceFileInfo::SourceFileLineBuffer::GetLineWidth(size_t lineNumber) const {
-  if (lineNumber == lines()) {
-    return length() - _lineStarts.back();
+  if (lineNumber < _firstRow || lineNumber > lines()) {
+    return 0;
   }
 
-  --lineNumber;
-  return _lineStarts[lineNumber + 1] - _lineStarts[lineNumber];
+  const auto& lineTable = getLineTable();
+  auto index = lineNumber - _firstRow;
+  auto end = index + 1 == lineTable.size() ? length() : lineTable.GetLineStart(index + 1);
+  return end - lineTable.GetLineStart(index);
 }
 
-std::string_view SourceFileInfo::SourceFileLineBuffer::GetViewInRange(int startRow, int endRow) const {
-  --startRow;
-  --endRow;
+size_t SourceFileInfo::SourceFileLineBuffer::GetLineStart(size_t lineNumber) const {
+  if (lineNumber < _firstRow || lineNumber > lines()) {
+    return 0;
+  }
+  return getLineTable().GetLineStart(lineNumber - _firstRow);
+}
+
+size_t SourceFileInfo::SourceFileLineBuffer::GetRowOfOffset(size_t offset) const {
+  const auto& lineTable = getLineTable();
+  if (offset < lineTable.GetLineStart(0) || offset > length()) {
+    return 0;
+  }
+  return _firstRow + lineTable.FindLine(offset);
+}
 
-  if (startRow < 0 || startRow >= lines()) {
+std::string_view SourceFileInfo::SourceFileLineBuffer::GetViewInRange(uint64_t startRow, uint64_t endRow) const {
+  // Rows that have slid out of the retained window of a streaming line buffer are treated as out of boundary.
+  if (startRow < _firstRow || startRow > lines()) {
     return std::string_view { };
   }
-  if (endRow < 0 || endRow > lines()) {
+  if (endRow <= startRow || endRow > lines() + 1) {
     return std::string_view { };
   }
-  if (endRow <= startRow) {
+
+  const auto& lineTable = getLineTable();
+  auto startIndex = static_cast<size_t>(startRow - _firstRow);
+  auto endIndex = static_cast<size_t>(endRow - _firstRow);
+
+  auto startLineStart = lineTable.GetLineStart(startIndex);
+  if (startLineStart < _baseOffset) {
+    // The head of the line has been dropped since the line is longer than the retained window.
     return std::string_view { };
   }
 
-  auto startOffset = _lineStarts[startRow];
-  auto v = static_cast<std::string_view>(_content);
+  auto startOffset = startLineStart - _baseOffset;
+  auto v = content();
+  if (v.size() < startOffset) {
+    // The content has been evicted and cannot be reloaded.
+    return std::string_view { };
+  }
   v.remove_prefix(startOffset);
 
-  if (endRow == lines()) {
+  if (endIndex == lineTable.size()) {
     return v;
   }
 
-  auto endOffset = _lineStarts[endRow];
+  auto endOffset = lineTable.GetLineStart(endIndex) - _baseOffset;
   v = v.substr(0, endOffset - startOffset);
   return v;
 }
 
+std::unique_ptr<InputStream> SourceFileInfo::SourceFileLineBuffer::CreateInputStream() {
+  if (!_streaming) {
+    auto buffer = GetBuffer();
+    if (!buffer) {
+      return nullptr;
+    }
+    return MemoryBuffer::CreateInputStream(std::move(buffer));
+  }
+
+  if (!_streamingInput) {
+    return nullptr;
+  }
+  return std::make_unique<LineBufferFeedingInputStream<SourceFileLineBuffer>>(std::move(_streamingInput), *this);
+}
+
+void SourceFileInfo::SourceFileLineBuffer::Append(const char *data, size_t size) {
+  assert(_streaming && "Append called on a non-streaming line buffer.");
+
+  if (!size) {
+    // The underlying stream has hit EOS.
+    _lineTable->Finish(_length);
+    return;
+  }
+
+  _lineTable->Scan(data, size, _length);
+  _content.append(data, size);
+  _length += size;
+
+  trimStreamingWindow();
+}
+
+void SourceFileInfo::SourceFileLineBuffer::trimStreamingWindow() {
+  // Drop lines in batches so that the cost of moving the retained window is amortized over the lines read.
+  auto& lineTable = *_lineTable;
+  auto completeLines = lineTable.size() - 1;
+  size_t dropLines = 0;
+  if (completeLines >= 2 * StreamingRetainedLines) {
+    dropLines = completeLines - StreamingRetainedLines;
+  }
+  if (_content.size() >= 2 * StreamingRetainedBytes) {
+    // Keep dropping complete lines until the retained bytes fit in the budget.
+    auto keepFrom = _length - StreamingRetainedBytes;
+    auto firstKept = std::min(lineTable.FindLine(keepFrom), completeLines ? completeLines - 1 : 0);
+    dropLines = std::max(dropLines, firstKept);
+  }
+
+  if (dropLines) {
+    lineTable.DropFront(dropLines);
+    _firstRow += dropLines;
+  }
+
+  auto newBase = std::max(_baseOffset, static_cast<size_t>(lineTable.GetLineStart(0)));
+  if (_length - newBase >= 2 * StreamingRetainedBytes) {
+    // The last line alone exceeds the budget; only keep its tail.
+    newBase = _length - StreamingRetainedBytes;
+  }
+  if (newBase != _baseOffset) {
+    _content.erase(0, newBase - _baseOffset);
+    _baseOffset = newBase;
+  }
+}
+
 } // namespace jvc
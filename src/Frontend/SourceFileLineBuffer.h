@@ -5,46 +5,233 @@
 #ifndef JVC_SOURCEFILELINEBUFFER_H
 #define JVC_SOURCEFILELINEBUFFER_H
 
+#include "Infrastructure/Hash.h"
+#include "Infrastructure/MemoryBuffer.h"
+#include "Frontend/SourceFingerprint.h"
 #include "Frontend/SourceManager.h"
+#include "SourceFileLineTable.h"
 
+#include <functional>
 #include <memory>
+#include <mutex>
 
 namespace jvc {
 
 class InputStream;
 
+/**
+ * @brief Hold the content and the line table of a source code file.
+ *
+ * A line buffer either holds the whole file, or, for files loaded in streaming mode, a sliding window over the most
+ * recent lines read from the underlying stream. Line starts are kept as absolute offsets into the file in both cases.
+ *
+ * The line table of a whole file is only built the first time a line is queried, since most files never have a
+ * diagnostics message reported against them. Streaming line buffers maintain their line table as data is appended.
+ *
+ * The content of a whole file can be evicted to save memory and is transparently reloaded by a reloader the next time
+ * it is needed. The line table survives eviction.
+ */
 class SourceFileInfo::SourceFileLineBuffer {
 public:
+  /**
+   * @brief Maximum number of complete lines retained by a streaming line buffer.
+   */
+  constexpr static const size_t StreamingRetainedLines = 64;
+
+  /**
+   * @brief Maximum number of bytes retained by a streaming line buffer.
+   */
+  constexpr static const size_t StreamingRetainedBytes = 1024 * 1024;
+
   static std::unique_ptr<SourceFileLineBuffer> Load(std::unique_ptr<InputStream> input);
 
-  explicit SourceFileLineBuffer(std::string content, std::vector<size_t> lineStarts)
-      : _content(std::move(content)),
-        _lineStarts(std::move(lineStarts))
+  /**
+   * @brief Create a streaming line buffer that is fed as the given input stream is consumed.
+   * @param input the input stream.
+   * @return the created line buffer.
+   */
+  static std::unique_ptr<SourceFileLineBuffer> LoadStreaming(std::unique_ptr<InputStream> input);
+
+  /**
+   * @brief Initialize a new @see SourceFileLineBuffer object holding the whole content of a file.
+   * @param buffer the content. Pass nullptr to create an empty streaming line buffer.
+   * @param fingerprint fingerprint of the content, as computed by @see HashBytes128.
+   */
+  explicit SourceFileLineBuffer(std::shared_ptr<const MemoryBuffer> buffer, Hash128 fingerprint = Hash128 { })
+      : _buffer(std::move(buffer)),
+        _baseOffset(0),
+        _firstRow(1),
+        _length(_buffer ? _buffer->size() : 0),
+        _fingerprint(fingerprint),
+        _streamingInput(nullptr)
   { }
 
+  SourceFileLineBuffer(const SourceFileLineBuffer &) = delete;
+  SourceFileLineBuffer(SourceFileLineBuffer &&) = delete;
+
+  SourceFileLineBuffer& operator=(const SourceFileLineBuffer &) = delete;
+  SourceFileLineBuffer& operator=(SourceFileLineBuffer &&) = delete;
+
+  ~SourceFileLineBuffer();
+
   [[nodiscard]]
-  size_t lines() const { return _lineStarts.size(); }
+  size_t lines() const { return _firstRow - 1 + getLineTable().size(); }
 
   [[nodiscard]]
   size_t GetLineWidth(size_t lineNumber) const;
 
+  /**
+   * @brief Get the offset at which the given line starts.
+   * @param lineNumber the line number.
+   * @return offset of the line start. Returns 0 if the line is out of boundary or has been dropped.
+   */
+  [[nodiscard]]
+  size_t GetLineStart(size_t lineNumber) const;
+
+  /**
+   * @brief Get the number of the line containing the given offset.
+   * @param offset the offset.
+   * @return the line number. Returns 0 if the offset is out of boundary or its line has been dropped.
+   */
+  [[nodiscard]]
+  size_t GetRowOfOffset(size_t offset) const;
+
+  /**
+   * @brief Get the content of the given range of lines.
+   * @param startRow the first row, inclusive.
+   * @param endRow the last row, exclusive.
+   * @return the content. Returns an empty view if the range is out of boundary or no longer retained.
+   */
   [[nodiscard]]
-  std::string_view GetViewInRange(int startRow, int endRow) const;
+  std::string_view GetViewInRange(uint64_t startRow, uint64_t endRow) const;
 
   [[nodiscard]]
-  std::string_view GetLineView(int row) const {
+  std::string_view GetLineView(uint64_t row) const {
     return GetViewInRange(row, row + 1);
   }
 
+  /**
+   * @brief Get the retained content. For non-streaming line buffers this is the whole file, reloaded if it has been
+   * evicted; the returned view is only valid until the content is evicted again, see @see GetBuffer.
+   * @return the retained content. Returns an empty view if evicted content cannot be reloaded.
+   */
+  [[nodiscard]]
+  std::string_view content() const;
+
+  /**
+   * @brief Get the buffer holding the whole content of a non-streaming line buffer, reloading it if it has been
+   * evicted. Holding the returned buffer keeps the content alive even if it is evicted in the meantime.
+   * @return the buffer. Returns nullptr for streaming line buffers, or if evicted content cannot be reloaded.
+   */
+  [[nodiscard]]
+  std::shared_ptr<const MemoryBuffer> GetBuffer() const;
+
+  /**
+   * @brief Set the function used to reload the content after it has been evicted. Content can only be evicted if a
+   * reloader has been set.
+   * @param reloader the reloader. It returns nullptr if the content cannot be reloaded.
+   */
+  void SetReloader(std::function<std::shared_ptr<const MemoryBuffer>()> reloader) { _reloader = std::move(reloader); }
+
+  /**
+   * @brief Determine whether the content of this line buffer can ever be evicted.
+   * @return whether this line buffer is not streaming and a reloader has been set.
+   */
+  [[nodiscard]]
+  bool CanEvict() const { return !_streaming && _reloader; }
+
+  /**
+   * @brief Evict the content of this line buffer, unless the content is pinned or being reloaded concurrently.
+   * @return the number of bytes evicted. Returns 0 if nothing has been evicted.
+   */
+  size_t TryEvict();
+
+  /**
+   * @brief Determine whether the whole content is held in memory.
+   * @return whether the content is resident. Always returns true for streaming line buffers.
+   */
   [[nodiscard]]
-  const std::string& content() const { return _content; }
+  bool IsResident() const;
 
+  /**
+   * @brief Get the number of bytes in the file that have been seen so far.
+   * @return the number of bytes in the file that have been seen so far.
+   */
   [[nodiscard]]
-  size_t length() const { return content().size(); }
+  size_t length() const { return _length; }
+
+  /**
+   * @brief Determine whether this line buffer is a sliding window over a stream.
+   * @return whether this line buffer is a sliding window over a stream.
+   */
+  [[nodiscard]]
+  bool streaming() const { return _streaming; }
+
+  /**
+   * @brief Get the hash of the whole content, which is the low half of its fingerprint, or 0 for streaming line
+   * buffers.
+   * @return the hash of the whole content.
+   */
+  [[nodiscard]]
+  uint64_t contentHash() const { return _fingerprint.Low; }
+
+  /**
+   * @brief Get the 128-bit fingerprint of the whole content, or all zeros for streaming line buffers.
+   * @return the fingerprint of the whole content.
+   */
+  [[nodiscard]]
+  Hash128 fingerprint() const { return _fingerprint; }
+
+  /**
+   * @brief Get the line and block fingerprints of the whole content. They are computed the first time they are
+   * requested; streaming line buffers have no line fingerprints.
+   * @return the line and block fingerprints.
+   */
+  [[nodiscard]]
+  const SourceLineFingerprints& GetLineFingerprints() const;
+
+  /**
+   * @brief Create an @see InputStream for the content of the file. For streaming line buffers, the returned stream
+   * reads from the underlying stream and feeds this line buffer as it goes; it can only be created once.
+   * @return the created @see InputStream, or nullptr if the underlying stream has already been handed out.
+   */
+  std::unique_ptr<InputStream> CreateInputStream();
+
+  /**
+   * @brief Append data read from the underlying stream of a streaming line buffer, dropping the lines that fall out
+   * of the retained window.
+   * @param data pointer to the data.
+   * @param size size of the data, in bytes.
+   */
+  void Append(const char* data, size_t size);
 
 private:
+  // The whole content of a non-streaming line buffer; nullptr if evicted.
+  mutable std::shared_ptr<const MemoryBuffer> _buffer;
+  mutable std::mutex _bufferMutex;
+  std::function<std::shared_ptr<const MemoryBuffer>()> _reloader;
+  // The retained window of a streaming line buffer.
   std::string _content;
-  std::vector<size_t> _lineStarts;
+  // Absolute offsets of the retained lines. Built on demand for non-streaming line buffers.
+  mutable std::unique_ptr<SourceFileLineTable> _lineTable;
+  mutable std::once_flag _lineTableBuilt;
+  // Bytes of the line table of a non-streaming line buffer counted in the memory report.
+  mutable size_t _lineTableBytes = 0;
+  // Absolute offset of the first byte in _content.
+  size_t _baseOffset;
+  // Row number of the first retained line.
+  size_t _firstRow;
+  size_t _length;
+  Hash128 _fingerprint;
+  mutable std::unique_ptr<SourceLineFingerprints> _lineFingerprints;
+  mutable std::once_flag _lineFingerprintsBuilt;
+  bool _streaming = false;
+  std::unique_ptr<InputStream> _streamingInput;
+
+  [[nodiscard]]
+  const SourceFileLineTable& getLineTable() const;
+
+  void trimStreamingWindow();
 };
 
 } // namespace jvc
@@ -0,0 +1,178 @@
+//
+// Created by Sirui Mu on 2020/1/4.
+//
+
+#include "SourceFileLineTable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace jvc {
+
+namespace {
+
+/**
+ * @brief Call the given function with the offset of every line started within the given buffer. A CR at the end of
+ * the buffer is considered a lone CR.
+ */
+template <typename Callback>
+void scanLineTerminators(const char* data, size_t size, Callback onLineStart) {
+  auto handle = [data, size, &onLineStart](size_t pos) {
+    if (data[pos] == '\r' && pos + 1 < size && data[pos + 1] == '\n') {
+      // The line ends at the LF of the CR LF pair.
+      return;
+    }
+    onLineStart(pos + 1);
+  };
+
+  size_t i = 0;
+#ifdef __SSE2__
+  // Most blocks of 16 bytes contain no line terminator at all, and are skipped with a couple of instructions.
+  auto lf = _mm_set1_epi8('\n');
+  auto cr = _mm_set1_epi8('\r');
+  for (; i + 16 <= size; i += 16) {
+    auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    auto terminators = _mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(terminators));
+    while (mask) {
+      handle(i + static_cast<size_t>(__builtin_ctz(mask)));
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for (; i < size; ++i) {
+    if (data[i] == '\n' || data[i] == '\r') {
+      handle(i);
+    }
+  }
+}
+
+} // namespace <anonymous>
+
+SourceFileLineTable::SourceFileLineTable()
+    : _offsets { 0 },
+      _checkpoints { Checkpoint { 0, 0 } },
+      _pendingCR(false),
+      _lastHit(0)
+{ }
+
+std::unique_ptr<SourceFileLineTable> SourceFileLineTable::Build(const char *data, size_t size) {
+  auto table = std::make_unique<SourceFileLineTable>();
+  table->Scan(data, size, 0);
+  table->Finish(size);
+  return table;
+}
+
+void SourceFileLineTable::Scan(const char *data, size_t size, uint64_t offset) {
+  if (!size) {
+    return;
+  }
+
+  if (_pendingCR) {
+    _pendingCR = false;
+    if (data[0] != '\n') {
+      push(offset);
+    }
+  }
+
+  if (data[size - 1] == '\r') {
+    _pendingCR = true;
+    --size;
+  }
+
+  scanLineTerminators(data, size, [this, offset](size_t lineStart) {
+    push(offset + lineStart);
+  });
+}
+
+void SourceFileLineTable::Finish(uint64_t length) {
+  if (_pendingCR) {
+    _pendingCR = false;
+    push(length);
+  }
+}
+
+void SourceFileLineTable::DropFront(size_t count) {
+  count = std::min(count, _offsets.size() - 1);
+  if (!count) {
+    return;
+  }
+
+  _offsets.erase(_offsets.begin(), _offsets.begin() + count);
+  for (auto& checkpoint : _checkpoints) {
+    checkpoint.FirstLine = checkpoint.FirstLine > count ? checkpoint.FirstLine - count : 0;
+  }
+  // Checkpoints whose lines have all been dropped are superseded by the next one.
+  auto firstLive = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), 0,
+      [](size_t line, const Checkpoint& checkpoint) { return line < checkpoint.FirstLine; }) - 1;
+  _checkpoints.erase(_checkpoints.begin(), firstLive);
+
+  _lastHit.store(0, std::memory_order_relaxed);
+}
+
+uint64_t SourceFileLineTable::GetLineStart(size_t index) const {
+  assert(index < _offsets.size() && "line index is out of range.");
+  return _checkpoints[getCheckpointOfLine(index)].BaseOffset + _offsets[index];
+}
+
+size_t SourceFileLineTable::FindLine(uint64_t offset) const {
+  auto hit = _lastHit.load(std::memory_order_relaxed);
+  if (hit < _offsets.size()) {
+    if (lineContains(hit, offset)) {
+      return hit;
+    }
+    if (hit + 1 < _offsets.size() && lineContains(hit + 1, offset)) {
+      _lastHit.store(hit + 1, std::memory_order_relaxed);
+      return hit + 1;
+    }
+  }
+
+  // Locate the checkpoint first, then the line within the range of lines relative to that checkpoint.
+  auto checkpoint = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), offset,
+      [](uint64_t value, const Checkpoint& cp) { return value < cp.BaseOffset; });
+  if (checkpoint != _checkpoints.begin()) {
+    --checkpoint;
+  }
+
+  auto first = _offsets.begin() + checkpoint->FirstLine;
+  auto last = checkpoint + 1 == _checkpoints.end() ? _offsets.end() : _offsets.begin() + (checkpoint + 1)->FirstLine;
+  auto relative = offset >= checkpoint->BaseOffset ? offset - checkpoint->BaseOffset : 0;
+  auto key = static_cast<uint32_t>(std::min<uint64_t>(relative, std::numeric_limits<uint32_t>::max()));
+
+  auto line = static_cast<size_t>(std::upper_bound(first, last, key) - _offsets.begin());
+  line = line ? line - 1 : 0;
+  _lastHit.store(line, std::memory_order_relaxed);
+  return line;
+}
+
+void SourceFileLineTable::push(uint64_t lineStart) {
+  auto& checkpoint = _checkpoints.back();
+  if (lineStart - checkpoint.BaseOffset > std::numeric_limits<uint32_t>::max()) {
+    _checkpoints.push_back(Checkpoint { _offsets.size(), lineStart });
+  }
+  _offsets.push_back(static_cast<uint32_t>(lineStart - _checkpoints.back().BaseOffset));
+}
+
+size_t SourceFileLineTable::getCheckpointOfLine(size_t index) const {
+  if (_checkpoints.size() == 1) {
+    return 0;
+  }
+  auto checkpoint = std::upper_bound(_checkpoints.begin(), _checkpoints.end(), index,
+      [](size_t line, const Checkpoint& cp) { return line < cp.FirstLine; });
+  return static_cast<size_t>(checkpoint - _checkpoints.begin()) - 1;
+}
+
+bool SourceFileLineTable::lineContains(size_t index, uint64_t offset) const {
+  if (offset < GetLineStart(index)) {
+    return index == 0;
+  }
+  return index + 1 == _offsets.size() || offset < GetLineStart(index + 1);
+}
+
+} // namespace jvc
@@ -0,0 +1,126 @@
+//
+// Created by Sirui Mu on 2020/1/4.
+//
+
+#ifndef JVC_SOURCEFILELINETABLE_H
+#define JVC_SOURCEFILELINETABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace jvc {
+
+/**
+ * @brief Map between line indexes and the offsets at which the lines start.
+ *
+ * Line starts are stored as 32-bit offsets relative to sparse checkpoints; a new checkpoint is only inserted when the
+ * file grows past 4GiB from the previous one, so for all practical source code files the table costs 4 bytes per line.
+ * Lines are terminated by LF, CR LF or a lone CR, as in JLS §3.4.
+ */
+class SourceFileLineTable {
+public:
+  /**
+   * @brief Initialize a new @see SourceFileLineTable object containing a single line starting at offset 0.
+   */
+  SourceFileLineTable();
+
+  SourceFileLineTable(const SourceFileLineTable &) = delete;
+  SourceFileLineTable(SourceFileLineTable &&) = delete;
+
+  SourceFileLineTable& operator=(const SourceFileLineTable &) = delete;
+  SourceFileLineTable& operator=(SourceFileLineTable &&) = delete;
+
+  /**
+   * @brief Build the line table of the given content.
+   * @param data pointer to the content.
+   * @param size size of the content, in bytes.
+   * @return the line table.
+   */
+  static std::unique_ptr<SourceFileLineTable> Build(const char* data, size_t size);
+
+  /**
+   * @brief Record the lines started within the given chunk of content. Chunks must be scanned in order.
+   *
+   * A CR at the end of the chunk is held back until the next chunk shows whether it is followed by an LF.
+   *
+   * @param data pointer to the chunk.
+   * @param size size of the chunk, in bytes.
+   * @param offset offset of the chunk from the start of the content.
+   */
+  void Scan(const char* data, size_t size, uint64_t offset);
+
+  /**
+   * @brief Record the line started by a CR held back at the end of the content, if any.
+   * @param length length of the content, in bytes.
+   */
+  void Finish(uint64_t length);
+
+  /**
+   * @brief Remove the given number of lines from the front of this table.
+   * @param count the number of lines to remove. At least one line is always retained.
+   */
+  void DropFront(size_t count);
+
+  /**
+   * @brief Get the number of lines.
+   * @return the number of lines.
+   */
+  [[nodiscard]]
+  size_t size() const { return _offsets.size(); }
+
+  /**
+   * @brief Get the number of bytes allocated by this table.
+   * @return the number of bytes allocated by this table.
+   */
+  [[nodiscard]]
+  size_t GetMemoryUsage() const {
+    return _offsets.capacity() * sizeof(uint32_t) + _checkpoints.capacity() * sizeof(Checkpoint);
+  }
+
+  /**
+   * @brief Get the offset at which the given line starts.
+   * @param index index of the line.
+   * @return offset of the line start.
+   */
+  [[nodiscard]]
+  uint64_t GetLineStart(size_t index) const;
+
+  /**
+   * @brief Find the line containing the given offset.
+   *
+   * The result of the last lookup is cached, so that lookups of increasing offsets within the same or the next line
+   * take constant time; other lookups use binary search.
+   *
+   * @param offset the offset. Offsets before the first line map to the first line.
+   * @return index of the line.
+   */
+  [[nodiscard]]
+  size_t FindLine(uint64_t offset) const;
+
+private:
+  struct Checkpoint {
+    // Index of the first line relative to this checkpoint.
+    size_t FirstLine;
+    uint64_t BaseOffset;
+  };
+
+  std::vector<uint32_t> _offsets;
+  std::vector<Checkpoint> _checkpoints;
+  bool _pendingCR;
+  mutable std::atomic<size_t> _lastHit;
+
+  void push(uint64_t lineStart);
+
+  [[nodiscard]]
+  size_t getCheckpointOfLine(size_t index) const;
+
+  [[nodiscard]]
+  bool lineContains(size_t index, uint64_t offset) const;
+};
+
+} // namespace jvc
+
+#endif // JVC_SOURCEFILELINETABLE_H
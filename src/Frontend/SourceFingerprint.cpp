@@ -0,0 +1,130 @@
+//
+// Created by Sirui Mu on 2020/1/9.
+//
+
+#include "Infrastructure/Hash.h"
+#include "Frontend/SourceFingerprint.h"
+
+#include <algorithm>
+
+namespace jvc {
+
+namespace {
+
+constexpr const uint64_t RollingBase = 0x100000001B3ull;
+
+uint64_t power(uint64_t base, uint64_t exponent) {
+  uint64_t result = 1;
+  while (exponent) {
+    if (exponent & 1u) {
+      result *= base;
+    }
+    base *= base;
+    exponent >>= 1u;
+  }
+  return result;
+}
+
+/**
+ * @brief Find the rows at which top-level declarations end, i.e. the rows containing a `}` that closes a brace opened
+ * at the top level. Braces within comments and string or character literals are ignored.
+ */
+std::vector<uint64_t> findBlockEnds(std::string_view content, const std::vector<uint64_t>& lineStarts) {
+  enum class State { Code, LineComment, BlockComment, String, Character };
+
+  std::vector<uint64_t> blockEnds;
+  auto state = State::Code;
+  size_t depth = 0;
+  size_t line = 0;
+  for (size_t i = 0; i < content.size(); ++i) {
+    while (line + 1 < lineStarts.size() && lineStarts[line + 1] <= i) {
+      ++line;
+      if (state == State::LineComment) {
+        state = State::Code;
+      }
+    }
+
+    auto ch = content[i];
+    auto next = i + 1 < content.size() ? content[i + 1] : '\0';
+    switch (state) {
+      case State::Code:
+        if (ch == '/' && next == '/') {
+          state = State::LineComment;
+          ++i;
+        } else if (ch == '/' && next == '*') {
+          state = State::BlockComment;
+          ++i;
+        } else if (ch == '"') {
+          state = State::String;
+        } else if (ch == '\'') {
+          state = State::Character;
+        } else if (ch == '{') {
+          ++depth;
+        } else if (ch == '}' && depth > 0 && --depth == 0) {
+          blockEnds.push_back(line + 2);
+        }
+        break;
+      case State::LineComment:
+        break;
+      case State::BlockComment:
+        if (ch == '*' && next == '/') {
+          state = State::Code;
+          ++i;
+        }
+        break;
+      case State::String:
+      case State::Character:
+        if (ch == '\\') {
+          ++i;
+        } else if ((state == State::String && ch == '"') || (state == State::Character && ch == '\'')) {
+          state = State::Code;
+        }
+        break;
+    }
+  }
+  return blockEnds;
+}
+
+} // namespace <anonymous>
+
+std::unique_ptr<SourceLineFingerprints> SourceLineFingerprints::Build(std::string_view content,
+                                                                      const std::vector<uint64_t>& lineStarts) {
+  std::unique_ptr<SourceLineFingerprints> fingerprints { new SourceLineFingerprints() };
+
+  auto& lineHashes = fingerprints->_lineHashes;
+  auto& prefixHashes = fingerprints->_prefixHashes;
+  lineHashes.reserve(lineStarts.size());
+  prefixHashes.reserve(lineStarts.size() + 1);
+  prefixHashes.push_back(0);
+  for (size_t i = 0; i < lineStarts.size(); ++i) {
+    auto end = i + 1 < lineStarts.size() ? lineStarts[i + 1] : content.size();
+    auto hash = HashBytes(content.substr(lineStarts[i], end - lineStarts[i]));
+    lineHashes.push_back(hash);
+    prefixHashes.push_back(prefixHashes.back() * RollingBase + hash);
+  }
+
+  uint64_t firstRow = 1;
+  for (auto endRow : findBlockEnds(content, lineStarts)) {
+    if (endRow > firstRow) {
+      fingerprints->_blocks.push_back(SourceBlock { firstRow, endRow, fingerprints->GetRangeHash(firstRow, endRow) });
+      firstRow = endRow;
+    }
+  }
+  auto endRow = static_cast<uint64_t>(lineStarts.size()) + 1;
+  if (endRow > firstRow) {
+    fingerprints->_blocks.push_back(SourceBlock { firstRow, endRow, fingerprints->GetRangeHash(firstRow, endRow) });
+  }
+
+  return fingerprints;
+}
+
+uint64_t SourceLineFingerprints::GetRangeHash(uint64_t firstRow, uint64_t endRow) const {
+  auto first = std::min<uint64_t>(std::max<uint64_t>(firstRow, 1) - 1, lines());
+  auto end = std::min<uint64_t>(std::max<uint64_t>(endRow, 1) - 1, lines());
+  if (end <= first) {
+    return 0;
+  }
+  return _prefixHashes[end] - _prefixHashes[first] * power(RollingBase, end - first);
+}
+
+} // namespace jvc
@@ -2,18 +2,131 @@
 // Created by Sirui Mu on 2019/12/23.
 //
 
-#include "Frontend/SourceLocation.h"
+#include "Infrastructure/ConcurrentTable.h"
 #include "Infrastructure/Stream.h"
+#include "Frontend/SourceLocation.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 namespace jvc {
 
+namespace {
+
+// Number of bits of the row and column offsets within a segment.
+constexpr const unsigned SegmentOffsetBits = 20;
+
+// Number of bits of the index of a segment, which fills the 63 bits left next to the flag.
+constexpr const unsigned SegmentIndexBits = 63 - 2 * SegmentOffsetBits;
+
+constexpr const uint64_t SegmentOffsetMask = (1ull << SegmentOffsetBits) - 1;
+
+struct LocationSegment {
+  uint64_t RowBase;
+  uint64_t ColBase;
+};
+
+/**
+ * @brief The side table holding the segments of the locations that do not fit in a @see SourceLocation handle. Each
+ * segment is stored once, so the table stays small: lexing a 4 GiB line adds a few thousand segments.
+ */
+class LocationSegmentTable {
+public:
+  /**
+   * @brief Get the index of the given segment, adding it to the table if needed.
+   * @param rowBase the first row of the segment.
+   * @param colBase the first column of the segment.
+   * @param index output parameter, the index of the segment.
+   * @return whether the segment is in the table. Returns false if the table is full.
+   */
+  bool Find(uint64_t rowBase, uint64_t colBase, uint64_t& index) {
+    std::lock_guard<std::mutex> lock { _mutex };
+    auto i = _indexes.find({ rowBase, colBase });
+    if (i != _indexes.end()) {
+      index = i->second;
+      return true;
+    }
+    if (_indexes.size() >> SegmentIndexBits) {
+      return false;
+    }
+
+    index = _segments.Append(std::make_unique<LocationSegment>(LocationSegment { rowBase, colBase }));
+    _indexes.emplace(std::make_pair(rowBase, colBase), index);
+    return true;
+  }
+
+  /**
+   * @brief Get the segment at the given index. This function never blocks.
+   * @param index the index.
+   * @return the segment.
+   */
+  [[nodiscard]]
+  const LocationSegment& Get(uint64_t index) const {
+    return *_segments.Get(index);
+  }
+
+private:
+  ConcurrentTable<LocationSegment> _segments;
+  std::map<std::pair<uint64_t, uint64_t>, uint64_t> _indexes;
+  std::mutex _mutex;
+};
+
+LocationSegmentTable& getSegments() {
+  static LocationSegmentTable segments;
+  return segments;
+}
+
+} // namespace <anonymous>
+
+void SourceLocation::encodeLarge(uint64_t row, uint64_t col) {
+  // Consecutive locations almost always fall into the same segment, which is looked up without taking the lock.
+  struct SegmentCache {
+    uint64_t RowBase;
+    uint64_t ColBase;
+    uint64_t Index;
+  };
+  thread_local SegmentCache cache { 0, 0, UINT64_MAX };
+
+  auto rowBase = row & ~SegmentOffsetMask;
+  auto colBase = col & ~SegmentOffsetMask;
+  if (cache.Index == UINT64_MAX || cache.RowBase != rowBase || cache.ColBase != colBase) {
+    uint64_t index;
+    if (!getSegments().Find(rowBase, colBase, index)) {
+      _fileId = InvalidFileId;
+      _row = 0;
+      _col = 0;
+      return;
+    }
+    cache = SegmentCache { rowBase, colBase, index };
+  }
+
+  auto payload = (cache.Index << (2 * SegmentOffsetBits)) |
+      ((row & SegmentOffsetMask) << SegmentOffsetBits) |
+      (col & SegmentOffsetMask);
+  _row = LargeFlag | static_cast<uint32_t>(payload >> 32u);
+  _col = static_cast<uint32_t>(payload);
+}
+
+uint64_t SourceLocation::decodeLargeRow() const {
+  auto payload = (static_cast<uint64_t>(_row & ~LargeFlag) << 32u) | _col;
+  return getSegments().Get(payload >> (2 * SegmentOffsetBits)).RowBase +
+      ((payload >> SegmentOffsetBits) & SegmentOffsetMask);
+}
+
+uint64_t SourceLocation::decodeLargeCol() const {
+  auto payload = (static_cast<uint64_t>(_row & ~LargeFlag) << 32u) | _col;
+  return getSegments().Get(payload >> (2 * SegmentOffsetBits)).ColBase + (payload & SegmentOffsetMask);
+}
+
 void SourceLocation::Dump(StreamWriter &output) const {
   if (!valid()) {
     output << "<invalid loc>";
     return;
   }
 
-  output << _row << ':' << _col;
+  output << row() << ':' << col();
 }
 
 void SourceRange::Dump(StreamWriter &output) const {
@@ -2,24 +2,39 @@
 // Created by Sirui Mu on 2019/12/18.
 //
 
+#include "Infrastructure/Hash.h"
+#include "Infrastructure/MemoryBuffer.h"
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/PerfCounters.h"
+#include "Infrastructure/ResponseFile.h"
+#include "Infrastructure/Statistic.h"
 #include "Infrastructure/Stream.h"
+#include "Infrastructure/ThreadPool.h"
+#include "Infrastructure/TimeTrace.h"
 #include "Frontend/CompilerInstance.h"
 #include "Frontend/SourceManager.h"
 #include "Frontend/Diagnostics.h"
 #include "SourceFileLineBuffer.h"
 
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
 namespace jvc {
 
-const SourceFileInfo* SourceManager::GetSourceFileInfo(int id) const {
-  auto i = _sources.find(id);
-  if (i == _sources.end()) {
-    return nullptr;
-  }
-  return &i->second;
-}
+namespace {
+
+JVC_STATISTIC(SourceFilesLoaded, "Number of source files loaded, excluding streamed ones");
+JVC_STATISTIC(SourceBytesLoaded, "Number of bytes of source files loaded, excluding streamed ones");
+JVC_STATISTIC(SourceBytesReloaded, "Number of bytes of evicted source files reloaded");
+
+} // namespace <anonymous>
 
 SourceManager::SourceManager(CompilerInstance &ci)
-    : _ci(ci)
+    : _ci(ci),
+      _fileSystem(FileSystem::GetRealFileSystem()),
+      _memoryBudget(0),
+      _memoryUsage { }
 { }
 
 SourceLocation SourceManager::GetLocForEndOfFile(int fileId) const {
@@ -32,25 +47,318 @@ SourceLocation SourceManager::GetLocForEndOfFile(int fileId) const {
 }
 
 int SourceManager::Load(const std::string &path) {
-  auto fileId = getNextFileId();
+  if (path == "-") {
+    return LoadStreaming("<stdin>", InputStream::FromSTL(std::cin));
+  }
 
-  auto sourceFileInfo = SourceFileInfo::Load(fileId, path, _ci.GetDiagnosticsEngine());
-  _sources.emplace(fileId, std::move(sourceFileInfo));
+  int fileId;
+  if (!findOrReserveFile(path, fileId)) {
+    waitForFile(fileId);
+    return fileId;
+  }
 
+  int errorCode;
+  loadFile(fileId, path, errorCode);
+  if (errorCode) {
+    SourceFileInfo::EmitLoadError(path, errorCode, _ci.GetDiagnosticsEngine());
+  }
   return fileId;
 }
 
 int SourceManager::Load(const std::string &name, std::unique_ptr<InputStream> dataStream) {
-  auto fileId = getNextFileId();
+  TimeTraceScope traceScope { "Load", name };
+  PerfCounterScope perfScope { PerfPhase::Load };
+  AllocationScope allocationScope { MemorySubsystem::SourceManager };
+  StreamReader reader { std::move(dataStream) };
+  auto content = MemoryBuffer::FromString(reader.ReadToEnd());
+  auto fingerprint = HashBytes128(content->GetView());
+  auto contentHash = fingerprint.Low;
 
-  auto sourceFileInfo = SourceFileInfo::Load(fileId, name, std::move(dataStream));
-  _sources.emplace(fileId, std::move(sourceFileInfo));
+  int fileId;
+  {
+    std::lock_guard<std::mutex> lock { _identityMutex };
+    auto candidates = _filesByContentHash.equal_range(contentHash);
+    for (auto i = candidates.first; i != candidates.second; ++i) {
+      // Hold the content of the candidate while comparing, so that it cannot be evicted under the comparison.
+      auto candidate = waitForFile(i->second).GetBuffer();
+      if (candidate && candidate->GetView() == content->GetView()) {
+        return i->second;
+      }
+    }
+
+    fileId = reserveFileId();
+    _filesByContentHash.emplace(contentHash, fileId);
+  }
 
+  ++SourceFilesLoaded;
+  SourceBytesLoaded += content->size();
+  publish(SourceFileInfo::Load(fileId, name, std::move(content), fingerprint));
   return fileId;
 }
 
-int SourceManager::getNextFileId() const {
-  return static_cast<int>(_sources.size()) + 1;
+int SourceManager::LoadStreaming(const std::string &name, std::unique_ptr<InputStream> dataStream) {
+  auto fileId = reserveFileId();
+  publish(SourceFileInfo::LoadStreaming(fileId, name, std::move(dataStream)));
+  return fileId;
+}
+
+std::vector<int> SourceManager::LoadAll(const std::vector<std::string> &paths, size_t jobs) {
+  // Reserve all file IDs up front so that they follow the order of the paths.
+  std::vector<int> fileIds;
+  fileIds.reserve(paths.size());
+  std::vector<size_t> pending;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (paths[i] == "-") {
+      // Streaming source code files are read lazily; registering them here is cheap.
+      fileIds.push_back(Load(paths[i]));
+      continue;
+    }
+
+    int fileId;
+    if (findOrReserveFile(paths[i], fileId)) {
+      pending.push_back(i);
+    }
+    fileIds.push_back(fileId);
+  }
+
+  std::vector<int> errorCodes(paths.size(), 0);
+  ParallelFor(jobs, pending.size(), [this, &paths, &pending, &fileIds, &errorCodes](size_t job) {
+    auto i = pending[job];
+    loadFile(fileIds[i], paths[i], errorCodes[i]);
+  });
+
+  // Files reserved by other threads calling Load concurrently may still be loading.
+  for (auto fileId : fileIds) {
+    waitForFile(fileId);
+  }
+
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (errorCodes[i]) {
+      SourceFileInfo::EmitLoadError(paths[i], errorCodes[i], _ci.GetDiagnosticsEngine());
+    }
+  }
+
+  return fileIds;
+}
+
+std::vector<int> SourceManager::LoadAll(ResponseFileReader &paths, size_t jobs) {
+  struct PendingLoad {
+    std::string Path;
+    int FileId;
+    int ErrorCode;
+  };
+
+  // Paths are read in batches. Each batch is handed to the thread pool as soon as its file IDs have been reserved, so
+  // files are loaded while the rest of the list is still being read. A batch owns its paths and drops them once
+  // loaded; only the failed loads are kept to be reported.
+  constexpr const size_t BatchSize = 256;
+
+  std::vector<int> fileIds;
+  std::mutex failedMutex;
+  std::vector<PendingLoad> failed;
+  {
+    ThreadPool pool { jobs };
+    std::vector<std::string> batch;
+    while (paths.ReadBatch(batch, BatchSize)) {
+      std::vector<PendingLoad> loads;
+      for (auto& path : batch) {
+        if (path == "-") {
+          fileIds.push_back(Load(path));
+          continue;
+        }
+
+        int fileId;
+        if (findOrReserveFile(path, fileId)) {
+          loads.push_back(PendingLoad { std::move(path), fileId, 0 });
+        }
+        fileIds.push_back(fileId);
+      }
+
+      if (!loads.empty()) {
+        pool.Submit([this, &failedMutex, &failed, loads = std::move(loads)]() mutable {
+          for (auto& load : loads) {
+            loadFile(load.FileId, load.Path, load.ErrorCode);
+            if (load.ErrorCode) {
+              std::lock_guard<std::mutex> lock { failedMutex };
+              failed.push_back(std::move(load));
+            }
+          }
+        });
+      }
+    }
+  }
+
+  for (auto fileId : fileIds) {
+    waitForFile(fileId);
+  }
+
+  // File IDs are reserved in the order of the list.
+  std::sort(failed.begin(), failed.end(), [](const PendingLoad& lhs, const PendingLoad& rhs) {
+    return lhs.FileId < rhs.FileId;
+  });
+  for (const auto& load : failed) {
+    SourceFileInfo::EmitLoadError(load.Path, load.ErrorCode, _ci.GetDiagnosticsEngine());
+  }
+
+  return fileIds;
+}
+
+void SourceManager::loadFile(int fileId, const std::string &path, int &errorCode) {
+  TimeTraceScope traceScope { "Load", path };
+  PerfCounterScope perfScope { PerfPhase::Load };
+  AllocationScope allocationScope { MemorySubsystem::SourceManager };
+  auto sourceFileInfo = SourceFileInfo::Load(fileId, path, *_fileSystem, errorCode);
+  if (!errorCode) {
+    ++SourceFilesLoaded;
+    SourceBytesLoaded += sourceFileInfo.GetSize();
+    auto fingerprint = sourceFileInfo.GetContentFingerprint();
+    sourceFileInfo.setReloader([this, fileId, path, fingerprint]() { return reload(fileId, path, fingerprint); });
+  }
+  publish(std::move(sourceFileInfo));
+}
+
+bool SourceManager::findOrReserveFile(const std::string &path, int &fileId) {
+  FileIdentity identity { };
+  if (!getFileIdentity(path, identity)) {
+    // The file cannot be loaded; let the loader report the error.
+    fileId = reserveFileId();
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock { _identityMutex };
+  auto i = _filesByIdentity.find(identity);
+  if (i != _filesByIdentity.end()) {
+    fileId = i->second;
+    return false;
+  }
+
+  fileId = reserveFileId();
+  _filesByIdentity.emplace(identity, fileId);
+  return true;
+}
+
+bool SourceManager::getFileIdentity(const std::string &path, FileIdentity &identity) const {
+  if (_fileSystem != FileSystem::GetRealFileSystem()) {
+    return _fileSystem->GetFileIdentity(path, identity);
+  }
+
+  // Files on the disk have most likely been stat'ed already while walking the source path.
+  auto status = _ci.GetStatCache().Stat(path);
+  identity = status.Identity;
+  return status.exists();
+}
+
+const SourceFileInfo& SourceManager::waitForFile(int fileId) const {
+  auto sourceFileInfo = GetSourceFileInfo(fileId);
+  while (!sourceFileInfo) {
+    std::this_thread::yield();
+    sourceFileInfo = GetSourceFileInfo(fileId);
+  }
+  return *sourceFileInfo;
+}
+
+int SourceManager::reserveFileId() {
+  return static_cast<int>(_sources.Reserve()) + 1;
+}
+
+void SourceManager::publish(SourceFileInfo sourceFileInfo) {
+  auto index = static_cast<size_t>(sourceFileInfo.id()) - 1;
+  auto size = sourceFileInfo.IsStreaming() ? 0 : sourceFileInfo.GetSize();
+  _sources.Emplace(index, std::make_unique<SourceFileInfo>(std::move(sourceFileInfo)));
+
+  std::lock_guard<std::mutex> lock { _evictionMutex };
+  _memoryUsage.ResidentBytes += size;
+  _memoryUsage.PeakResidentBytes = std::max(_memoryUsage.PeakResidentBytes, _memoryUsage.ResidentBytes);
+  enforceMemoryBudget();
+}
+
+size_t SourceManager::GetMemoryBudget() const {
+  std::lock_guard<std::mutex> lock { _evictionMutex };
+  return _memoryBudget;
+}
+
+void SourceManager::SetMemoryBudget(size_t budget) {
+  std::lock_guard<std::mutex> lock { _evictionMutex };
+  _memoryBudget = budget;
+  enforceMemoryBudget();
+}
+
+void SourceManager::ReleaseFile(int fileId) {
+  auto sourceFileInfo = GetSourceFileInfo(fileId);
+  if (!sourceFileInfo || !sourceFileInfo->canEvict()) {
+    // Files loaded from a stream cannot be reloaded, so they never enter the eviction queue.
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock { _evictionMutex };
+  auto i = _evictionQueuePositions.find(fileId);
+  if (i != _evictionQueuePositions.end()) {
+    _evictionQueue.splice(_evictionQueue.end(), _evictionQueue, i->second);
+  } else {
+    _evictionQueuePositions.emplace(fileId, _evictionQueue.insert(_evictionQueue.end(), fileId));
+  }
+  enforceMemoryBudget();
+}
+
+SourceMemoryUsage SourceManager::GetMemoryUsage() const {
+  std::lock_guard<std::mutex> lock { _evictionMutex };
+  return _memoryUsage;
+}
+
+void SourceManager::DumpMemoryUsage(StreamWriter &output) const {
+  auto usage = GetMemoryUsage();
+  output << "source memory: "
+         << usage.ResidentBytes << " bytes resident, "
+         << usage.EvictedBytes << " bytes evicted in "
+         << usage.Evictions << " evictions, "
+         << usage.Reloads << " reloads\n";
+}
+
+std::shared_ptr<const MemoryBuffer> SourceManager::reload(int fileId, const std::string &path, Hash128 fingerprint) {
+  AllocationScope allocationScope { MemorySubsystem::SourceManager };
+  int errorCode;
+  auto buffer = _fileSystem->ReadFile(path, errorCode);
+  if (!buffer || HashBytes128(buffer->GetView()) != fingerprint) {
+    // The file has been removed or modified since it was loaded; locations into it would no longer make sense.
+    return nullptr;
+  }
+
+  SourceBytesReloaded += buffer->size();
+  std::lock_guard<std::mutex> lock { _evictionMutex };
+  _memoryUsage.ResidentBytes += buffer->size();
+  _memoryUsage.PeakResidentBytes = std::max(_memoryUsage.PeakResidentBytes, _memoryUsage.ResidentBytes);
+  ++_memoryUsage.Reloads;
+  // Only released files are ever evicted. The content is needed again, so queue it as the most recently released one;
+  // the caller is still reloading the file, so the budget is enforced the next time a file is released.
+  auto i = _evictionQueuePositions.find(fileId);
+  if (i != _evictionQueuePositions.end()) {
+    _evictionQueue.splice(_evictionQueue.end(), _evictionQueue, i->second);
+  } else {
+    _evictionQueuePositions.emplace(fileId, _evictionQueue.insert(_evictionQueue.end(), fileId));
+  }
+  return buffer;
+}
+
+void SourceManager::enforceMemoryBudget() {
+  if (!_memoryBudget) {
+    return;
+  }
+
+  for (auto i = _evictionQueue.begin(); i != _evictionQueue.end() && _memoryUsage.ResidentBytes > _memoryBudget; ) {
+    auto fileId = *i;
+    auto evicted = GetSourceFileInfo(fileId)->tryEvict();
+    if (!evicted) {
+      // Either not resident or being reloaded right now.
+      ++i;
+      continue;
+    }
+
+    _memoryUsage.ResidentBytes -= evicted;
+    _memoryUsage.EvictedBytes += evicted;
+    ++_memoryUsage.Evictions;
+    i = _evictionQueue.erase(i);
+    _evictionQueuePositions.erase(fileId);
+  }
 }
 
 } // namespace jvc
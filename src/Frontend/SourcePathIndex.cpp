@@ -0,0 +1,109 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#include "Infrastructure/DirectoryWalker.h"
+#include "Frontend/CompilerInstance.h"
+#include "Frontend/SourcePathIndex.h"
+
+#include <algorithm>
+
+namespace jvc {
+
+namespace {
+
+constexpr const std::string_view JavaFileExtension = ".java";
+
+bool isJavaFile(std::string_view name) {
+  return name.size() > JavaFileExtension.size() &&
+      name.substr(name.size() - JavaFileExtension.size()) == JavaFileExtension;
+}
+
+} // namespace <anonymous>
+
+SourcePathIndex::SourcePathIndex(CompilerInstance &ci)
+    : _ci(ci)
+{ }
+
+void SourcePathIndex::AddRoots(const std::vector<std::string> &roots, size_t jobs) {
+  for (const auto& path : roots) {
+    std::string_view rest { path };
+    while (!rest.empty()) {
+      auto separator = std::min(rest.find(':'), rest.size());
+      auto root = rest.substr(0, separator);
+      if (!root.empty()) {
+        addRoot(std::string { root }, jobs);
+      }
+      rest.remove_prefix(std::min(separator + 1, rest.size()));
+    }
+  }
+}
+
+void SourcePathIndex::addRoot(const std::string &root, size_t jobs) {
+  int errorCode;
+  auto listings = WalkDirectoryTree(root, jobs, isJavaFile, _ci.GetStatCache(), errorCode);
+  if (errorCode) {
+    _ci.GetDiagnosticsEngine().Emit(Diagnostics {
+        DiagnosticsKind::CannotReadSourcePathRoot, root, DiagnosticsArgument::ErrorCode(errorCode) });
+    return;
+  }
+
+  for (auto& listing : listings) {
+    if (listing.ErrorCode) {
+      _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::CannotReadSourcePathDirectory, listing.Path,
+                                                    DiagnosticsArgument::ErrorCode(listing.ErrorCode) });
+      continue;
+    }
+
+    auto packageName = listing.RelativePath;
+    std::replace(packageName.begin(), packageName.end(), '/', '.');
+
+    auto& package = _packages[packageName];
+    package.Directories.push_back(listing.Path);
+    for (const auto& fileName : listing.Files) {
+      auto typeName = fileName.substr(0, fileName.size() - JavaFileExtension.size());
+      auto path = listing.Path + '/' + fileName;
+      if (package.Types.emplace(std::move(typeName), path).second) {
+        _files.push_back(std::move(path));
+      }
+    }
+  }
+}
+
+const std::string* SourcePathIndex::Resolve(std::string_view qualifiedName) const {
+  // Try the longest package name first: `a.b.C.D` is either type `D` in package `a.b.C`, or a type nested in `C`.
+  auto typeEnd = qualifiedName.size();
+  while (true) {
+    auto name = qualifiedName.substr(0, typeEnd);
+    auto dot = name.rfind('.');
+    if (dot == std::string_view::npos && typeEnd != qualifiedName.size()) {
+      // A qualified name never refers to a type in the unnamed package.
+      return nullptr;
+    }
+    auto packageName = dot == std::string_view::npos ? std::string_view { } : name.substr(0, dot);
+    auto typeName = dot == std::string_view::npos ? name : name.substr(dot + 1);
+
+    auto package = _packages.find(std::string { packageName });
+    if (package != _packages.end()) {
+      auto type = package->second.Types.find(std::string { typeName });
+      if (type != package->second.Types.end()) {
+        return &type->second;
+      }
+    }
+
+    if (dot == std::string_view::npos) {
+      return nullptr;
+    }
+    typeEnd = dot;
+  }
+}
+
+const std::vector<std::string>* SourcePathIndex::GetPackageDirectories(std::string_view packageName) const {
+  auto package = _packages.find(std::string { packageName });
+  if (package == _packages.end()) {
+    return nullptr;
+  }
+  return &package->second.Directories;
+}
+
+} // namespace jvc
@@ -0,0 +1,122 @@
+//
+// Created by Sirui Mu on 2020/1/9.
+//
+
+#include "Infrastructure/Diff.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace jvc {
+
+namespace {
+
+struct DiffEdit {
+  bool IsInsertion;
+  size_t OldPosition;
+  size_t NewPosition;
+};
+
+/**
+ * @brief Find a shortest edit script between the given sequences, which must not share a common prefix or suffix.
+ * @return whether an edit script with at most @see MaxDiffEdits edits has been found.
+ */
+bool findEditScript(const uint64_t* a, size_t n, const uint64_t* b, size_t m, std::vector<DiffEdit>& edits) {
+  auto maxEdits = static_cast<ptrdiff_t>(std::min(n + m, MaxDiffEdits));
+  auto offset = maxEdits + 1;
+  std::vector<ptrdiff_t> v(2 * maxEdits + 3, 0);
+
+  // trace[d] holds v[k] for k in [-d - 1, d + 1] as it was before step d, at index k + d + 1.
+  std::vector<std::vector<ptrdiff_t>> trace;
+  auto sn = static_cast<ptrdiff_t>(n);
+  auto sm = static_cast<ptrdiff_t>(m);
+
+  for (ptrdiff_t d = 0; d <= maxEdits; ++d) {
+    trace.emplace_back(v.begin() + offset - d - 1, v.begin() + offset + d + 2);
+
+    for (auto k = -d; k <= d; k += 2) {
+      ptrdiff_t x;
+      if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+        x = v[offset + k + 1];
+      } else {
+        x = v[offset + k - 1] + 1;
+      }
+      auto y = x - k;
+      while (x < sn && y < sm && a[x] == b[y]) {
+        ++x;
+        ++y;
+      }
+      v[offset + k] = x;
+
+      if (x >= sn && y >= sm) {
+        // Walk the trace backwards to recover the edits.
+        for (auto step = d; step > 0; --step) {
+          const auto& prev = trace[step];
+          auto at = [&prev, step](ptrdiff_t index) { return prev[index + step + 1]; };
+          auto kk = x - y;
+          auto prevK = (kk == -step || (kk != step && at(kk - 1) < at(kk + 1))) ? kk + 1 : kk - 1;
+          auto prevX = at(prevK);
+          auto prevY = prevX - prevK;
+          while (x > prevX && y > prevY) {
+            --x;
+            --y;
+          }
+          edits.push_back(DiffEdit {
+            x == prevX, static_cast<size_t>(prevX), static_cast<size_t>(prevY)
+          });
+          x = prevX;
+          y = prevY;
+        }
+        std::reverse(edits.begin(), edits.end());
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+} // namespace <anonymous>
+
+std::vector<DiffHunk> DiffSequences(const uint64_t* oldValues, size_t oldSize,
+                                    const uint64_t* newValues, size_t newSize) {
+  size_t prefix = 0;
+  while (prefix < oldSize && prefix < newSize && oldValues[prefix] == newValues[prefix]) {
+    ++prefix;
+  }
+  size_t suffix = 0;
+  while (suffix < oldSize - prefix && suffix < newSize - prefix &&
+         oldValues[oldSize - suffix - 1] == newValues[newSize - suffix - 1]) {
+    ++suffix;
+  }
+
+  auto n = oldSize - prefix - suffix;
+  auto m = newSize - prefix - suffix;
+  if (n == 0 && m == 0) {
+    return { };
+  }
+
+  std::vector<DiffEdit> edits;
+  if (n == 0 || m == 0 || !findEditScript(oldValues + prefix, n, newValues + prefix, m, edits)) {
+    return { DiffHunk { prefix, n, prefix, m } };
+  }
+
+  std::vector<DiffHunk> hunks;
+  for (const auto& edit : edits) {
+    auto oldPosition = edit.OldPosition + prefix;
+    auto newPosition = edit.NewPosition + prefix;
+    if (hunks.empty() ||
+        hunks.back().OldStart + hunks.back().OldLength != oldPosition ||
+        hunks.back().NewStart + hunks.back().NewLength != newPosition) {
+      hunks.push_back(DiffHunk { oldPosition, 0, newPosition, 0 });
+    }
+    if (edit.IsInsertion) {
+      ++hunks.back().NewLength;
+    } else {
+      ++hunks.back().OldLength;
+    }
+  }
+  return hunks;
+}
+
+} // namespace jvc
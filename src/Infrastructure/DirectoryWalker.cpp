@@ -0,0 +1,116 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#include "Infrastructure/DirectoryWalker.h"
+#include "Infrastructure/StatCache.h"
+#include "Infrastructure/ThreadPool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <mutex>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace jvc {
+
+namespace {
+
+class DirectoryTreeWalker {
+public:
+  explicit DirectoryTreeWalker(size_t jobs, const std::function<bool(std::string_view)>& filter, StatCache& statCache)
+      : _pool(jobs),
+        _filter(filter),
+        _statCache(statCache)
+  { }
+
+  std::vector<DirectoryListing> Walk(const std::string& root, int& errorCode) {
+    errorCode = listDirectory(root, std::string { });
+    _pool.Wait();
+
+    std::sort(_listings.begin(), _listings.end(), [](const DirectoryListing& lhs, const DirectoryListing& rhs) {
+      return lhs.RelativePath < rhs.RelativePath;
+    });
+    return std::move(_listings);
+  }
+
+private:
+  ThreadPool _pool;
+  const std::function<bool(std::string_view)>& _filter;
+  StatCache& _statCache;
+
+  std::mutex _listingsMutex;
+  std::vector<DirectoryListing> _listings;
+
+  void submit(std::string path, std::string relativePath) {
+    _pool.Submit([this, path = std::move(path), relativePath = std::move(relativePath)]() {
+      auto errorCode = listDirectory(path, relativePath);
+      if (errorCode) {
+        std::lock_guard<std::mutex> lock { _listingsMutex };
+        _listings.push_back(DirectoryListing { path, relativePath, { }, errorCode });
+      }
+    });
+  }
+
+  int listDirectory(const std::string& path, const std::string& relativePath) {
+    errno = 0;
+    auto dir = opendir(path.c_str());
+    if (!dir) {
+      return errno ? errno : ENOENT;
+    }
+
+    DirectoryListing listing { path, relativePath, { }, 0 };
+    while (auto entry = readdir(dir)) {
+      std::string_view name { entry->d_name };
+      if (name == "." || name == "..") {
+        continue;
+      }
+
+      auto type = entry->d_type;
+      if (type == DT_UNKNOWN) {
+        // The file system does not report entry types along with the listing. Do not follow symbolic links here, so
+        // that they are handled the same way as on file systems that report them.
+        struct stat st { };
+        if (lstat((path + '/' + entry->d_name).c_str(), &st) == 0) {
+          type = S_ISLNK(st.st_mode) ? DT_LNK
+              : S_ISDIR(st.st_mode) ? DT_DIR
+              : S_ISREG(st.st_mode) ? DT_REG
+              : DT_UNKNOWN;
+        }
+      }
+
+      if (type == DT_DIR) {
+        auto separator = relativePath.empty() ? "" : "/";
+        submit(path + '/' + entry->d_name, relativePath + separator + entry->d_name);
+        continue;
+      }
+      if ((type != DT_REG && type != DT_LNK) || !_filter(name)) {
+        continue;
+      }
+      if (type == DT_LNK && !_statCache.Stat(path + '/' + entry->d_name).IsRegularFile) {
+        continue;
+      }
+      listing.Files.emplace_back(name);
+    }
+    closedir(dir);
+
+    if (!listing.Files.empty()) {
+      std::sort(listing.Files.begin(), listing.Files.end());
+      std::lock_guard<std::mutex> lock { _listingsMutex };
+      _listings.push_back(std::move(listing));
+    }
+    return 0;
+  }
+};
+
+} // namespace <anonymous>
+
+std::vector<DirectoryListing> WalkDirectoryTree(const std::string& root, size_t jobs,
+                                                const std::function<bool(std::string_view)>& filter,
+                                                StatCache& statCache, int& errorCode) {
+  DirectoryTreeWalker walker { jobs, filter, statCache };
+  return walker.Walk(root, errorCode);
+}
+
+} // namespace jvc
@@ -0,0 +1,199 @@
+//
+// Created by Sirui Mu on 2020/1/5.
+//
+
+#include "Infrastructure/FileSystem.h"
+#include "Infrastructure/Stream.h"
+
+#include <atomic>
+#include <cerrno>
+#include <limits>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace jvc {
+
+namespace {
+
+class RealFileSystem : public FileSystem {
+public:
+  std::unique_ptr<InputStream> OpenFile(const std::string &path, int &errorCode) const override {
+    errno = 0;
+    errorCode = 0;
+    auto stream = InputStream::FromFile(path);
+    if (!stream) {
+      errorCode = errno ? errno : ENOENT;
+    }
+    return stream;
+  }
+
+  std::shared_ptr<const MemoryBuffer> ReadFile(const std::string &path, int &errorCode) const override {
+    return MemoryBuffer::FromFile(path, errorCode);
+  }
+
+  bool GetFileIdentity(const std::string &path, FileIdentity &identity) const override {
+    struct stat st { };
+    if (stat(path.c_str(), &st) != 0) {
+      return false;
+    }
+    identity.Device = static_cast<uint64_t>(st.st_dev);
+    identity.Inode = static_cast<uint64_t>(st.st_ino);
+    return true;
+  }
+};
+
+/**
+ * @brief Normalize the given path lexically, removing `.` components and resolving `..` components against the
+ * preceding component.
+ */
+std::string normalizePath(const std::string& path) {
+  auto absolute = !path.empty() && path.front() == '/';
+  std::vector<std::string_view> components;
+
+  std::string_view rest { path };
+  while (!rest.empty()) {
+    auto separator = rest.find('/');
+    auto component = rest.substr(0, separator);
+    rest = separator == std::string_view::npos ? std::string_view { } : rest.substr(separator + 1);
+
+    if (component.empty() || component == ".") {
+      continue;
+    }
+    if (component == ".." && !components.empty() && components.back() != "..") {
+      components.pop_back();
+      continue;
+    }
+    if (component == ".." && absolute) {
+      continue;
+    }
+    components.push_back(component);
+  }
+
+  std::string normalized = absolute ? "/" : "";
+  for (size_t i = 0; i < components.size(); ++i) {
+    if (i) {
+      normalized.push_back('/');
+    }
+    normalized.append(components[i]);
+  }
+  return normalized.empty() ? "." : normalized;
+}
+
+// In-memory files are identified by inode numbers handed out in creation order, on a device number no real device uses.
+constexpr const uint64_t OverlayDevice = std::numeric_limits<uint64_t>::max();
+
+std::atomic<uint64_t> nextOverlayInode { 1 };
+
+template <typename FileMap>
+std::unique_ptr<InputStream> openFile(const FileMap& files, const FileSystem& base, const std::string& path,
+                                      int& errorCode) {
+  auto i = files.find(normalizePath(path));
+  if (i == files.end()) {
+    return base.OpenFile(path, errorCode);
+  }
+  errorCode = 0;
+  return i->second.Content.CreateInputStream();
+}
+
+template <typename FileMap>
+bool getFileIdentity(const FileMap& files, const FileSystem& base, const std::string& path, FileIdentity& identity) {
+  auto i = files.find(normalizePath(path));
+  if (i == files.end()) {
+    return base.GetFileIdentity(path, identity);
+  }
+  identity.Device = OverlayDevice;
+  identity.Inode = i->second.Inode;
+  return true;
+}
+
+} // namespace <anonymous>
+
+std::shared_ptr<const MemoryBuffer> FileSystem::ReadFile(const std::string &path, int &errorCode) const {
+  auto stream = OpenFile(path, errorCode);
+  if (!stream) {
+    return nullptr;
+  }
+
+  StreamReader reader { std::move(stream) };
+  return MemoryBuffer::FromString(reader.ReadToEnd());
+}
+
+std::shared_ptr<const FileSystem> FileSystem::GetRealFileSystem() {
+  static auto realFileSystem = std::make_shared<const RealFileSystem>();
+  return realFileSystem;
+}
+
+class OverlayFileSystem::OverlayFileSystemSnapshot : public FileSystem {
+public:
+  explicit OverlayFileSystemSnapshot(std::shared_ptr<const FileSystem> base, FileMap files)
+    : _base(std::move(base)),
+      _files(std::move(files))
+  { }
+
+  std::unique_ptr<InputStream> OpenFile(const std::string &path, int &errorCode) const override {
+    return openFile(_files, *_base, path, errorCode);
+  }
+
+  bool GetFileIdentity(const std::string &path, FileIdentity &identity) const override {
+    return getFileIdentity(_files, *_base, path, identity);
+  }
+
+private:
+  std::shared_ptr<const FileSystem> _base;
+  const FileMap _files;
+};
+
+OverlayFileSystem::OverlayFileSystem(std::shared_ptr<const FileSystem> base)
+    : _base(std::move(base))
+{ }
+
+void OverlayFileSystem::SetFile(const std::string &path, std::string content) {
+  std::lock_guard<std::mutex> lock { _mutex };
+  auto normalized = normalizePath(path);
+  auto i = _files.find(normalized);
+  if (i != _files.end()) {
+    // Replacing the content of a file keeps its identity, as overwriting a file on the disk does.
+    i->second.Content = PieceTable { std::move(content) };
+    return;
+  }
+  _files.emplace(std::move(normalized), OverlayFile { PieceTable { std::move(content) }, nextOverlayInode++ });
+}
+
+bool OverlayFileSystem::EditFile(const std::string &path, size_t offset, size_t length, std::string_view text) {
+  std::lock_guard<std::mutex> lock { _mutex };
+  auto i = _files.find(normalizePath(path));
+  if (i == _files.end()) {
+    return false;
+  }
+  i->second.Content.Replace(offset, length, text);
+  return true;
+}
+
+bool OverlayFileSystem::RemoveFile(const std::string &path) {
+  std::lock_guard<std::mutex> lock { _mutex };
+  return _files.erase(normalizePath(path)) != 0;
+}
+
+bool OverlayFileSystem::HasFile(const std::string &path) const {
+  std::lock_guard<std::mutex> lock { _mutex };
+  return _files.find(normalizePath(path)) != _files.end();
+}
+
+std::shared_ptr<const FileSystem> OverlayFileSystem::Snapshot() const {
+  std::lock_guard<std::mutex> lock { _mutex };
+  // Copying the file map copies each piece table, which only shares its storage.
+  return std::make_shared<const OverlayFileSystemSnapshot>(_base, _files);
+}
+
+std::unique_ptr<InputStream> OverlayFileSystem::OpenFile(const std::string &path, int &errorCode) const {
+  std::lock_guard<std::mutex> lock { _mutex };
+  return openFile(_files, *_base, path, errorCode);
+}
+
+bool OverlayFileSystem::GetFileIdentity(const std::string &path, FileIdentity &identity) const {
+  std::lock_guard<std::mutex> lock { _mutex };
+  return getFileIdentity(_files, *_base, path, identity);
+}
+
+} // namespace jvc
@@ -0,0 +1,171 @@
+//
+// Created by Sirui Mu on 2020/1/3.
+//
+
+#include "Infrastructure/Hash.h"
+
+#include <cstring>
+
+namespace jvc {
+
+namespace {
+
+constexpr const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+constexpr const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr const uint64_t Prime3 = 0x165667B19E3779F9ull;
+constexpr const uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr const uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t rotateLeft(uint64_t x, unsigned r) {
+  return (x << r) | (x >> (64u - r));
+}
+
+inline uint64_t read64(const unsigned char* p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline uint64_t mixRound(uint64_t acc, uint64_t input) {
+  acc += input * Prime2;
+  acc = rotateLeft(acc, 31);
+  return acc * Prime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t value) {
+  acc ^= mixRound(0, value);
+  return acc * Prime1 + Prime4;
+}
+
+constexpr const uint64_t MurmurC1 = 0x87C37B91114253D5ull;
+constexpr const uint64_t MurmurC2 = 0x4CF5AD432745937Full;
+
+inline uint64_t finalMix(uint64_t k) {
+  k ^= k >> 33u;
+  k *= 0xFF51AFD7ED558CCDull;
+  k ^= k >> 33u;
+  k *= 0xC4CEB9FE1A85EC53ull;
+  k ^= k >> 33u;
+  return k;
+}
+
+} // namespace <anonymous>
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed) {
+  auto p = static_cast<const unsigned char *>(data);
+  auto end = p + size;
+  uint64_t h;
+
+  if (size >= 32) {
+    auto v1 = seed + Prime1 + Prime2;
+    auto v2 = seed + Prime2;
+    auto v3 = seed;
+    auto v4 = seed - Prime1;
+    for (; p + 32 <= end; p += 32) {
+      v1 = mixRound(v1, read64(p));
+      v2 = mixRound(v2, read64(p + 8));
+      v3 = mixRound(v3, read64(p + 16));
+      v4 = mixRound(v4, read64(p + 24));
+    }
+
+    h = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+    h = mergeRound(h, v1);
+    h = mergeRound(h, v2);
+    h = mergeRound(h, v3);
+    h = mergeRound(h, v4);
+  } else {
+    h = seed + Prime5;
+  }
+
+  h += static_cast<uint64_t>(size);
+
+  for (; p + 8 <= end; p += 8) {
+    h ^= mixRound(0, read64(p));
+    h = rotateLeft(h, 27) * Prime1 + Prime4;
+  }
+  if (p + 4 <= end) {
+    h ^= static_cast<uint64_t>(read32(p)) * Prime1;
+    h = rotateLeft(h, 23) * Prime2 + Prime3;
+    p += 4;
+  }
+  for (; p < end; ++p) {
+    h ^= static_cast<uint64_t>(*p) * Prime5;
+    h = rotateLeft(h, 11) * Prime1;
+  }
+
+  h ^= h >> 33u;
+  h *= Prime2;
+  h ^= h >> 29u;
+  h *= Prime3;
+  h ^= h >> 32u;
+  return h;
+}
+
+Hash128 HashBytes128(const void* data, size_t size, uint32_t seed) {
+  auto p = static_cast<const unsigned char *>(data);
+  auto blocks = size / 16;
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+
+  for (size_t i = 0; i < blocks; ++i, p += 16) {
+    auto k1 = read64(p);
+    auto k2 = read64(p + 8);
+
+    k1 *= MurmurC1;
+    k1 = rotateLeft(k1, 31);
+    k1 *= MurmurC2;
+    h1 ^= k1;
+    h1 = rotateLeft(h1, 27);
+    h1 += h2;
+    h1 = h1 * 5 + 0x52DCE729;
+
+    k2 *= MurmurC2;
+    k2 = rotateLeft(k2, 33);
+    k2 *= MurmurC1;
+    h2 ^= k2;
+    h2 = rotateLeft(h2, 31);
+    h2 += h1;
+    h2 = h2 * 5 + 0x38495AB5;
+  }
+
+  // Tail: the remaining 0 to 15 bytes, read as two little-endian words.
+  uint64_t k1 = 0;
+  uint64_t k2 = 0;
+  auto tail = size & 15u;
+  for (auto i = tail; i > 8; --i) {
+    k2 |= static_cast<uint64_t>(p[i - 1]) << ((i - 9) * 8);
+  }
+  for (auto i = tail < 8 ? tail : 8; i > 0; --i) {
+    k1 |= static_cast<uint64_t>(p[i - 1]) << ((i - 1) * 8);
+  }
+  if (tail > 8) {
+    k2 *= MurmurC2;
+    k2 = rotateLeft(k2, 33);
+    k2 *= MurmurC1;
+    h2 ^= k2;
+  }
+  if (tail > 0) {
+    k1 *= MurmurC1;
+    k1 = rotateLeft(k1, 31);
+    k1 *= MurmurC2;
+    h1 ^= k1;
+  }
+
+  h1 ^= static_cast<uint64_t>(size);
+  h2 ^= static_cast<uint64_t>(size);
+  h1 += h2;
+  h2 += h1;
+  h1 = finalMix(h1);
+  h2 = finalMix(h2);
+  h1 += h2;
+  h2 += h1;
+  return Hash128 { h1, h2 };
+}
+
+} // namespace jvc
@@ -0,0 +1,59 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#include "Infrastructure/Json.h"
+
+namespace jvc {
+
+namespace {
+
+bool needsEscape(char ch) {
+  return ch == '"' || ch == '\\' || static_cast<unsigned char>(ch) < 0x20u;
+}
+
+} // namespace <anonymous>
+
+void AppendJsonString(std::string& output, std::string_view s) {
+  constexpr const char HexDigits[] = "0123456789abcdef";
+
+  output.push_back('"');
+  size_t runStart = 0;
+  for (size_t i = 0; i < s.size(); ++i) {
+    auto ch = s[i];
+    if (!needsEscape(ch)) {
+      continue;
+    }
+
+    output.append(s.data() + runStart, i - runStart);
+    runStart = i + 1;
+    switch (ch) {
+      case '"':
+        output.append("\\\"");
+        break;
+      case '\\':
+        output.append("\\\\");
+        break;
+      case '\n':
+        output.append("\\n");
+        break;
+      case '\r':
+        output.append("\\r");
+        break;
+      case '\t':
+        output.append("\\t");
+        break;
+      default: {
+        auto byte = static_cast<unsigned char>(ch);
+        output.append("\\u00");
+        output.push_back(HexDigits[byte >> 4u]);
+        output.push_back(HexDigits[byte & 0xFu]);
+        break;
+      }
+    }
+  }
+  output.append(s.data() + runStart, s.size() - runStart);
+  output.push_back('"');
+}
+
+} // namespace jvc
@@ -0,0 +1,144 @@
+//
+// Created by Sirui Mu on 2020/1/6.
+//
+
+#include "Infrastructure/MemoryBuffer.h"
+#include "Infrastructure/Stream.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jvc {
+
+namespace {
+
+class StringMemoryBuffer : public MemoryBuffer {
+public:
+  explicit StringMemoryBuffer(std::unique_ptr<std::string> content)
+    : MemoryBuffer(content->data(), content->size()),
+      _content(std::move(content))
+  { }
+
+  [[nodiscard]]
+  size_t GetAllocatedSize() const override { return _content->capacity(); }
+
+private:
+  std::unique_ptr<std::string> _content;
+};
+
+class MappedMemoryBuffer : public MemoryBuffer {
+public:
+  explicit MappedMemoryBuffer(void* address, size_t size)
+    : MemoryBuffer(static_cast<const char *>(address), size),
+      _address(address)
+  { }
+
+  ~MappedMemoryBuffer() override {
+    munmap(_address, size());
+  }
+
+  [[nodiscard]]
+  bool IsMemoryMapped() const override { return true; }
+
+private:
+  void* _address;
+};
+
+class MemoryBufferInputStream : public InputStream {
+public:
+  explicit MemoryBufferInputStream(std::shared_ptr<const MemoryBuffer> buffer)
+    : _buffer(std::move(buffer)),
+      _readPtr(0)
+  { }
+
+  size_t Read(void *buffer, size_t bufferSize) override {
+    auto copySize = std::min(bufferSize, _buffer->size() - _readPtr);
+    std::memcpy(buffer, _buffer->data() + _readPtr, copySize);
+    _readPtr += copySize;
+    return copySize;
+  }
+
+private:
+  std::shared_ptr<const MemoryBuffer> _buffer;
+  size_t _readPtr;
+};
+
+} // namespace <anonymous>
+
+std::shared_ptr<const MemoryBuffer> MemoryBuffer::FromString(std::string content) {
+  // The string is kept on the heap so that moving it into the buffer cannot invalidate the pointer to its content,
+  // which small string optimization would otherwise do.
+  return std::make_shared<StringMemoryBuffer>(std::make_unique<std::string>(std::move(content)));
+}
+
+std::shared_ptr<const MemoryBuffer> MemoryBuffer::FromFile(const std::string &path, int &errorCode) {
+  errorCode = 0;
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    errorCode = errno;
+    return nullptr;
+  }
+
+  struct stat st { };
+  if (fstat(fd, &st) != 0) {
+    errorCode = errno;
+    close(fd);
+    return nullptr;
+  }
+
+  auto size = static_cast<size_t>(st.st_size);
+  if (S_ISREG(st.st_mode) && size >= MemoryMapThreshold) {
+    auto address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      close(fd);
+      return std::make_shared<MappedMemoryBuffer>(address, size);
+    }
+  }
+
+  // Small files, and files that cannot be mapped, are read into memory.
+  std::string content;
+  content.resize(S_ISREG(st.st_mode) ? size : 0);
+  size_t read = 0;
+  char overflow[4096];
+  while (true) {
+    // Once the content is full, read into a small buffer so that the content only grows if there is data left, e.g.
+    // when the file is not a regular file or has grown since it was inspected.
+    auto full = read == content.size();
+    auto result = full
+        ? ::read(fd, overflow, sizeof(overflow))
+        : ::read(fd, &content[read], content.size() - read);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      errorCode = errno;
+      close(fd);
+      return nullptr;
+    }
+    if (result == 0) {
+      break;
+    }
+    if (full) {
+      content.append(overflow, static_cast<size_t>(result));
+    }
+    read += static_cast<size_t>(result);
+  }
+  close(fd);
+
+  content.resize(read);
+  // Content that has grown while being read holds spare capacity, which would not be accounted for anywhere.
+  content.shrink_to_fit();
+  return FromString(std::move(content));
+}
+
+std::unique_ptr<InputStream> MemoryBuffer::CreateInputStream(std::shared_ptr<const MemoryBuffer> buffer) {
+  return std::make_unique<MemoryBufferInputStream>(std::move(buffer));
+}
+
+} // namespace jvc
@@ -0,0 +1,308 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/Stream.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+
+#include <sys/resource.h>
+
+#ifdef JVC_ALLOCATION_TRACKING
+#include <malloc.h>
+#endif
+
+namespace jvc {
+
+namespace {
+
+struct MemoryGaugeRegistry {
+  std::mutex Mutex;
+  std::vector<const MemoryGauge *> Gauges;
+};
+
+MemoryGaugeRegistry& getRegistry() {
+  // Gauges register themselves during static initialization, in no particular order across translation units.
+  static MemoryGaugeRegistry registry;
+  return registry;
+}
+
+// The state below is touched by the replaced operator new, which can run before any dynamic initializer; everything is
+// constant-initialized.
+
+#ifdef JVC_ALLOCATION_HOOKS
+thread_local uint64_t threadAllocationCount = 0;
+#endif
+
+#ifdef JVC_ALLOCATION_TRACKING
+#define COUNT_VARIANT(v) + 1
+constexpr const size_t SubsystemCount = 0 JVC_MEMORY_SUBSYSTEM_LIST(COUNT_VARIANT);
+#undef COUNT_VARIANT
+
+const char* const SubsystemNames[SubsystemCount] = {
+#define DEF_SUBSYSTEM_NAME(v) #v,
+  JVC_MEMORY_SUBSYSTEM_LIST(DEF_SUBSYSTEM_NAME)
+#undef DEF_SUBSYSTEM_NAME
+};
+
+thread_local MemorySubsystem currentSubsystem = MemorySubsystem::Other;
+
+struct alignas(64) SubsystemAllocations {
+  std::atomic<uint64_t> Count;
+  std::atomic<uint64_t> Bytes;
+};
+
+std::array<SubsystemAllocations, SubsystemCount> subsystemAllocations;
+std::atomic<int64_t> liveHeapBytes;
+std::atomic<int64_t> peakLiveHeapBytes;
+
+// Bytes are measured with malloc_usable_size, so that unsized operator delete can subtract what was added.
+void recordAllocation(void* ptr) {
+  ++threadAllocationCount;
+  auto bytes = malloc_usable_size(ptr);
+  auto& allocations = subsystemAllocations[static_cast<size_t>(currentSubsystem)];
+  allocations.Count.fetch_add(1, std::memory_order_relaxed);
+  allocations.Bytes.fetch_add(bytes, std::memory_order_relaxed);
+
+  auto live = liveHeapBytes.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) +
+      static_cast<int64_t>(bytes);
+  auto peak = peakLiveHeapBytes.load(std::memory_order_relaxed);
+  while (live > peak && !peakLiveHeapBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+}
+
+void recordDeallocation(void* ptr) {
+  if (ptr) {
+    liveHeapBytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+  }
+}
+#elif defined(JVC_ALLOCATION_HOOKS)
+void recordAllocation(void *) {
+  ++threadAllocationCount;
+}
+
+void recordDeallocation(void *) { }
+#endif
+
+} // namespace <anonymous>
+
+MemoryGauge::MemoryGauge(const char* name, const char* description)
+  : _name(name),
+    _description(description),
+    _current(0),
+    _peak(0)
+{
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock { registry.Mutex };
+  registry.Gauges.push_back(this);
+}
+
+void MemoryGauge::Add(uint64_t bytes) {
+  auto current = _current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  auto peak = _peak.load(std::memory_order_relaxed);
+  while (current > peak && !_peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) { }
+}
+
+std::vector<const MemoryGauge *> MemoryGauge::GetAll() {
+  std::vector<const MemoryGauge *> gauges;
+  {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock { registry.Mutex };
+    gauges = registry.Gauges;
+  }
+  std::sort(gauges.begin(), gauges.end(), [](const MemoryGauge* lhs, const MemoryGauge* rhs) {
+    return std::strcmp(lhs->name(), rhs->name()) < 0;
+  });
+  return gauges;
+}
+
+bool MemoryUsage::IsAllocationTrackingEnabled() {
+#ifdef JVC_ALLOCATION_TRACKING
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t MemoryUsage::GetThreadAllocationCount() {
+#ifdef JVC_ALLOCATION_HOOKS
+  return threadAllocationCount;
+#else
+  return 0;
+#endif
+}
+
+MemorySubsystem MemoryUsage::EnterSubsystem(MemorySubsystem subsystem) {
+#ifdef JVC_ALLOCATION_TRACKING
+  auto outer = currentSubsystem;
+  currentSubsystem = subsystem;
+  return outer;
+#else
+  return subsystem;
+#endif
+}
+
+void MemoryUsage::LeaveSubsystem(MemorySubsystem outer) {
+#ifdef JVC_ALLOCATION_TRACKING
+  currentSubsystem = outer;
+#else
+  static_cast<void>(outer);
+#endif
+}
+
+void MemoryUsage::Report(StreamWriter& output) {
+  std::string text { "Memory report:\n" };
+  char line[256];
+
+  rusage usage { };
+  if (!getrusage(RUSAGE_SELF, &usage)) {
+    // ru_maxrss is in kilobytes on Linux.
+    std::snprintf(line, sizeof(line), "  peak RSS: %ld KiB\n  page faults: %ld minor, %ld major\n",
+                  usage.ru_maxrss, usage.ru_minflt, usage.ru_majflt);
+    text.append(line);
+  }
+
+  auto gauges = MemoryGauge::GetAll();
+  size_t nameWidth = 0;
+  for (auto gauge : gauges) {
+    nameWidth = std::max(nameWidth, std::strlen(gauge->name()));
+  }
+  std::snprintf(line, sizeof(line), "  %-*s  %14s  %14s\n", static_cast<int>(nameWidth), "held bytes", "current",
+                "peak");
+  text.append(line);
+  for (auto gauge : gauges) {
+    std::snprintf(line, sizeof(line), "  %-*s  %14llu  %14llu  %s\n", static_cast<int>(nameWidth), gauge->name(),
+                  static_cast<unsigned long long>(gauge->current()), static_cast<unsigned long long>(gauge->peak()),
+                  gauge->description());
+    text.append(line);
+  }
+
+#ifdef JVC_ALLOCATION_TRACKING
+  std::snprintf(line, sizeof(line), "  %-*s  %14s  %14s\n", static_cast<int>(nameWidth), "heap allocations", "count",
+                "bytes");
+  text.append(line);
+  for (size_t i = 0; i < SubsystemCount; ++i) {
+    std::snprintf(line, sizeof(line), "  %-*s  %14llu  %14llu\n", static_cast<int>(nameWidth), SubsystemNames[i],
+                  static_cast<unsigned long long>(subsystemAllocations[i].Count.load(std::memory_order_relaxed)),
+                  static_cast<unsigned long long>(subsystemAllocations[i].Bytes.load(std::memory_order_relaxed)));
+    text.append(line);
+  }
+  std::snprintf(line, sizeof(line), "  live heap: %lld bytes, peak %lld bytes\n",
+                static_cast<long long>(liveHeapBytes.load(std::memory_order_relaxed)),
+                static_cast<long long>(peakLiveHeapBytes.load(std::memory_order_relaxed)));
+  text.append(line);
+#else
+  text.append("  heap allocations per subsystem: not compiled in; configure with "
+              "-DJVC_ENABLE_ALLOCATION_TRACKING=ON\n");
+#endif
+
+  output << text;
+}
+
+} // namespace jvc
+
+#ifdef JVC_ALLOCATION_HOOKS
+
+// Count heap allocations for the lexer statistics and the memory report. The replaced operators are only compiled in
+// when lexer statistics or allocation tracking are enabled.
+
+namespace {
+
+/**
+ * @brief Allocate memory from malloc and record the allocation.
+ * @param size number of bytes to allocate.
+ * @param alignment alignment of the allocation. 0 means the alignment malloc guarantees.
+ * @return the allocated memory. Returns nullptr if the allocation fails.
+ */
+void* allocate(std::size_t size, std::size_t alignment) noexcept {
+  void* ptr = nullptr;
+  if (!size) {
+    size = 1;
+  }
+  if (!alignment) {
+    ptr = std::malloc(size);
+  } else if (posix_memalign(&ptr, std::max(alignment, sizeof(void *)), size)) {
+    ptr = nullptr;
+  }
+  if (ptr) {
+    jvc::recordAllocation(ptr);
+  }
+  return ptr;
+}
+
+/**
+ * @brief Allocate memory as the throwing operator new does: calls the new handler while the allocation fails, and
+ * throws @see std::bad_alloc once no new handler is installed.
+ */
+void* allocateOrThrow(std::size_t size, std::size_t alignment) {
+  while (true) {
+    if (auto ptr = allocate(size, alignment)) {
+      return ptr;
+    }
+    auto handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc { };
+    }
+    handler();
+  }
+}
+
+/**
+ * @brief Allocate memory as the non-throwing operator new does, which calls the new handler like the throwing one.
+ */
+void* allocateOrNull(std::size_t size, std::size_t alignment) noexcept {
+  try {
+    return allocateOrThrow(size, alignment);
+  } catch (std::bad_alloc &) {
+    return nullptr;
+  }
+}
+
+} // namespace <anonymous>
+
+// Array and non-throwing deletes, and array news, forward to the operators below by default.
+
+void* operator new(std::size_t size) {
+  return allocateOrThrow(size, 0);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return allocateOrNull(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return allocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  return allocateOrNull(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept {
+  jvc::recordDeallocation(ptr);
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  jvc::recordDeallocation(ptr);
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+  jvc::recordDeallocation(ptr);
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+  jvc::recordDeallocation(ptr);
+  std::free(ptr);
+}
+
+#endif // JVC_ALLOCATION_HOOKS
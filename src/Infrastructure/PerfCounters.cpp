@@ -0,0 +1,333 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#include "Infrastructure/PerfCounters.h"
+#include "Infrastructure/Stream.h"
+
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+namespace jvc {
+
+namespace {
+
+#define COUNT_VARIANT(v) + 1
+constexpr const size_t PhaseCount = 0 JVC_PERF_PHASE_LIST(COUNT_VARIANT);
+constexpr const size_t CounterCount = 0 JVC_PERF_COUNTER_LIST(COUNT_VARIANT);
+#undef COUNT_VARIANT
+
+const char* const PhaseNames[PhaseCount] = {
+#define DEF_PHASE_NAME(v) #v,
+  JVC_PERF_PHASE_LIST(DEF_PHASE_NAME)
+#undef DEF_PHASE_NAME
+};
+
+const char* const CounterNames[CounterCount] = {
+    "cycles", "instructions", "branch misses", "L1D read misses", "LLC misses", "page faults", "CPU time (ns)"
+};
+
+using CounterValues = std::array<uint64_t, CounterCount>;
+
+// Counters accumulated per phase by all threads.
+std::array<std::array<std::atomic<uint64_t>, CounterCount>, PhaseCount> phaseTotals;
+// Counters the main thread managed to open; decided by Initialize.
+std::array<bool, CounterCount> availableCounters;
+PerfCounterSource counterSource = PerfCounterSource::ResourceUsage;
+
+#ifdef __linux__
+struct PerfEventConfig {
+  PerfCounter Counter;
+  uint32_t Type;
+  uint64_t Config;
+};
+
+constexpr const PerfEventConfig PerfEvents[] = {
+    { PerfCounter::Cycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PerfCounter::Instructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PerfCounter::BranchMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PerfCounter::L1DMisses, PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8u) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16u) },
+    { PerfCounter::LLCMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PerfCounter::TaskClock, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+};
+
+int openPerfEvent(const PerfEventConfig& event, int groupFd) {
+  perf_event_attr attr { };
+  attr.size = sizeof(attr);
+  attr.type = event.Type;
+  attr.config = event.Config;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  // Counting user space only is allowed with the default perf_event_paranoid setting.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+#endif
+
+/**
+ * @brief Counters of a single thread and the phase it is in.
+ */
+class ThreadCounters {
+public:
+  /**
+   * @brief Open the counters of the calling thread.
+   * @param probe whether to try every counter, rather than only those available on the main thread.
+   */
+  explicit ThreadCounters(bool probe)
+    : _groupFd(-1),
+      _phase(PerfPhase::Other)
+  {
+#ifdef __linux__
+    for (const auto& event : PerfEvents) {
+      if (!probe && !availableCounters[static_cast<size_t>(event.Counter)]) {
+        continue;
+      }
+      auto fd = openPerfEvent(event, _groupFd);
+      if (fd < 0) {
+        continue;
+      }
+      if (_groupFd < 0) {
+        _groupFd = fd;
+      }
+      _events.emplace_back(event.Counter, fd);
+    }
+#endif
+    _last = read();
+  }
+
+  ThreadCounters(const ThreadCounters &) = delete;
+  ThreadCounters(ThreadCounters &&) = delete;
+
+  ThreadCounters& operator=(const ThreadCounters &) = delete;
+  ThreadCounters& operator=(ThreadCounters &&) = delete;
+
+  ~ThreadCounters() {
+    Attribute();
+    for (const auto& event : _events) {
+      close(event.second);
+    }
+  }
+
+  [[nodiscard]]
+  const std::vector<std::pair<PerfCounter, int>>& events() const { return _events; }
+
+  void Begin(PerfPhase phase) {
+    Attribute();
+    _outerPhases.push_back(_phase);
+    _phase = phase;
+  }
+
+  void End() {
+    Attribute();
+    if (!_outerPhases.empty()) {
+      _phase = _outerPhases.back();
+      _outerPhases.pop_back();
+    }
+  }
+
+  /**
+   * @brief Add the counters accumulated since the last call to the totals of the current phase.
+   */
+  void Attribute() {
+    auto now = read();
+    auto& totals = phaseTotals[static_cast<size_t>(_phase)];
+    for (size_t i = 0; i < CounterCount; ++i) {
+      if (now[i] > _last[i]) {
+        totals[i].fetch_add(now[i] - _last[i], std::memory_order_relaxed);
+      }
+    }
+    _last = now;
+  }
+
+private:
+  // Leader of the group of perf events, read all at once; -1 if no event could be opened.
+  int _groupFd;
+  std::vector<std::pair<PerfCounter, int>> _events;
+  PerfPhase _phase;
+  std::vector<PerfPhase> _outerPhases;
+  CounterValues _last;
+
+  [[nodiscard]]
+  CounterValues read() const {
+    CounterValues values { };
+    readResourceUsage(values, _groupFd < 0);
+    if (_groupFd < 0) {
+      return values;
+    }
+
+    // Layout of PERF_FORMAT_GROUP: the number of events, the time enabled and running, then one value per event.
+    uint64_t buffer[3 + CounterCount];
+    if (::read(_groupFd, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) {
+      return _last;
+    }
+    auto enabled = buffer[1];
+    auto running = buffer[2];
+    for (size_t i = 0; i < buffer[0] && i < _events.size(); ++i) {
+      auto value = buffer[3 + i];
+      if (running && running < enabled) {
+        // The events have been multiplexed with others; extrapolate to the time enabled.
+        value = static_cast<uint64_t>(static_cast<double>(value) * enabled / running);
+      }
+      values[static_cast<size_t>(_events[i].first)] = value;
+    }
+    return values;
+  }
+
+  /**
+   * @brief Read the page faults, and the CPU time if requested, from getrusage. Page faults are always taken from
+   * here: the page fault event only counts faults taken in user mode unless kernel profiling is allowed, which misses
+   * the faults on buffers filled by read.
+   */
+  static void readResourceUsage(CounterValues& values, bool cpuTime) {
+    rusage usage { };
+#ifdef RUSAGE_THREAD
+    auto who = RUSAGE_THREAD;
+#else
+    auto who = RUSAGE_SELF;
+#endif
+    if (getrusage(who, &usage)) {
+      return;
+    }
+    auto toNanoseconds = [](const timeval& time) {
+      return static_cast<uint64_t>(time.tv_sec) * 1000000000u + static_cast<uint64_t>(time.tv_usec) * 1000u;
+    };
+    values[static_cast<size_t>(PerfCounter::PageFaults)] =
+        static_cast<uint64_t>(usage.ru_minflt) + static_cast<uint64_t>(usage.ru_majflt);
+    if (cpuTime) {
+      values[static_cast<size_t>(PerfCounter::TaskClock)] = toNanoseconds(usage.ru_utime) + toNanoseconds(usage.ru_stime);
+    }
+  }
+};
+
+ThreadCounters& getThreadCounters(bool probe = false) {
+  thread_local ThreadCounters counters { probe };
+  return counters;
+}
+
+void appendFormatted(std::string& output, const char* format, double value) {
+  char buffer[32];
+  auto length = std::snprintf(buffer, sizeof(buffer), format, value);
+  output.append(buffer, length);
+}
+
+void appendPhase(std::string& output, const char* name, const CounterValues& values, uint64_t bytes,
+                 uint64_t tokens) {
+  output.append("  ").append(name).append(":\n");
+  for (size_t i = 0; i < CounterCount; ++i) {
+    if (!availableCounters[i]) {
+      continue;
+    }
+    output.append("    ").append(CounterNames[i]);
+    output.append(20 - std::string_view { CounterNames[i] }.size(), ' ');
+    appendFormatted(output, "%16.0f", static_cast<double>(values[i]));
+    if (bytes) {
+      appendFormatted(output, "  %12.3f/byte", static_cast<double>(values[i]) / bytes);
+    }
+    if (tokens) {
+      appendFormatted(output, "  %12.3f/token", static_cast<double>(values[i]) / tokens);
+    }
+    output.push_back('\n');
+  }
+
+  auto cycles = values[static_cast<size_t>(PerfCounter::Cycles)];
+  if (availableCounters[static_cast<size_t>(PerfCounter::Instructions)] && cycles) {
+    output.append("    IPC                 ");
+    appendFormatted(output, "%16.2f", static_cast<double>(values[static_cast<size_t>(PerfCounter::Instructions)]) /
+        cycles);
+    output.push_back('\n');
+  }
+}
+
+} // namespace <anonymous>
+
+bool PerfCounters::Enabled = false;
+
+void PerfCounters::Initialize() {
+  availableCounters.fill(false);
+  availableCounters[static_cast<size_t>(PerfCounter::PageFaults)] = true;
+  const auto& events = getThreadCounters(true).events();
+  if (events.empty()) {
+    counterSource = PerfCounterSource::ResourceUsage;
+    availableCounters[static_cast<size_t>(PerfCounter::TaskClock)] = true;
+  } else {
+    counterSource = PerfCounterSource::Software;
+    for (const auto& event : events) {
+      availableCounters[static_cast<size_t>(event.first)] = true;
+      if (event.first != PerfCounter::TaskClock) {
+        counterSource = PerfCounterSource::Hardware;
+      }
+    }
+  }
+  Enabled = true;
+}
+
+void PerfCounters::Shutdown() {
+  Enabled = false;
+  // Catch up with the counters of the calling thread, so that they are not attributed again once it is re-enabled.
+  getThreadCounters().Attribute();
+  for (auto& totals : phaseTotals) {
+    for (auto& total : totals) {
+      total.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void PerfCounters::Begin(PerfPhase phase) {
+  getThreadCounters().Begin(phase);
+}
+
+void PerfCounters::End() {
+  getThreadCounters().End();
+}
+
+void PerfCounters::Report(StreamWriter& output, uint64_t bytes, uint64_t tokens) {
+  getThreadCounters().Attribute();
+
+  std::string text { "Performance counters" };
+  switch (counterSource) {
+    case PerfCounterSource::Hardware:
+      text.append(" (perf_event_open):\n");
+      break;
+    case PerfCounterSource::Software:
+      text.append(" (perf_event_open, software events only; hardware events are restricted or not supported):\n");
+      break;
+    case PerfCounterSource::ResourceUsage:
+      text.append(" (getrusage; perf_event_open is not available):\n");
+      break;
+  }
+  text.append("  ").append(std::to_string(bytes)).append(" bytes, ").append(std::to_string(tokens))
+      .append(" tokens\n");
+
+  CounterValues total { };
+  for (size_t phase = 0; phase < PhaseCount; ++phase) {
+    CounterValues values { };
+    auto empty = true;
+    for (size_t i = 0; i < CounterCount; ++i) {
+      values[i] = phaseTotals[phase][i].load(std::memory_order_relaxed);
+      total[i] += values[i];
+      empty = empty && !values[i];
+    }
+    if (!empty) {
+      appendPhase(text, PhaseNames[phase], values, bytes, tokens);
+    }
+  }
+  appendPhase(text, "Total", total, bytes, tokens);
+
+  output << text;
+}
+
+} // namespace jvc
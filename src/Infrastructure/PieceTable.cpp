@@ -0,0 +1,166 @@
+//
+// Created by Sirui Mu on 2020/1/5.
+//
+
+#include "Infrastructure/PieceTable.h"
+#include "Infrastructure/Stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace jvc {
+
+class PieceTable::PieceTableInputStream : public InputStream {
+public:
+  explicit PieceTableInputStream(std::shared_ptr<const std::vector<Piece>> pieces)
+    : _pieces(std::move(pieces)),
+      _piece(0),
+      _offset(0)
+  { }
+
+  size_t Read(void *buffer, size_t bufferSize) override {
+    auto output = static_cast<char *>(buffer);
+    size_t read = 0;
+    while (read < bufferSize && _piece < _pieces->size()) {
+      const auto& piece = (*_pieces)[_piece];
+      auto copySize = std::min(bufferSize - read, piece.Length - _offset);
+      std::memcpy(output + read, piece.Data + _offset, copySize);
+      read += copySize;
+      _offset += copySize;
+      if (_offset == piece.Length) {
+        ++_piece;
+        _offset = 0;
+      }
+    }
+    return read;
+  }
+
+private:
+  std::shared_ptr<const std::vector<Piece>> _pieces;
+  size_t _piece;
+  size_t _offset;
+};
+
+PieceTable::PieceTable()
+    : _pieces(std::make_shared<const std::vector<Piece>>()),
+      _size(0),
+      _addChunk(nullptr),
+      _addChunkUsed(0)
+{ }
+
+PieceTable::PieceTable(std::string content)
+    : PieceTable()
+{
+  if (content.empty()) {
+    return;
+  }
+
+  auto original = std::make_shared<const std::string>(std::move(content));
+  auto data = original->data();
+  _size = original->size();
+  _pieces = std::make_shared<const std::vector<Piece>>(std::vector<Piece> { Piece { std::move(original), data, _size } });
+}
+
+PieceTable::PieceTable(const PieceTable &other)
+    : _pieces(other._pieces),
+      _size(other._size),
+      _addChunk(nullptr),
+      _addChunkUsed(0)
+{ }
+
+PieceTable& PieceTable::operator=(const PieceTable &other) {
+  if (this != &other) {
+    _pieces = other._pieces;
+    _size = other._size;
+    _addChunk = nullptr;
+    _addChunkUsed = 0;
+  }
+  return *this;
+}
+
+void PieceTable::Replace(size_t offset, size_t length, std::string_view text) {
+  offset = std::min(offset, _size);
+  length = std::min(length, _size - offset);
+  if (!length && text.empty()) {
+    return;
+  }
+
+  const auto& oldPieces = *_pieces;
+  std::vector<Piece> pieces;
+  pieces.reserve(oldPieces.size() + 2);
+
+  // Keep the content before the range.
+  size_t i = 0;
+  size_t pieceStart = 0;
+  for (; i < oldPieces.size() && pieceStart + oldPieces[i].Length <= offset; ++i) {
+    pieces.push_back(oldPieces[i]);
+    pieceStart += oldPieces[i].Length;
+  }
+  if (i < oldPieces.size() && pieceStart < offset) {
+    auto head = oldPieces[i];
+    head.Length = offset - pieceStart;
+    pieces.push_back(std::move(head));
+  }
+
+  if (!text.empty()) {
+    auto inserted = store(text);
+    // Typing appends to the add buffer right after the previous insertion; extend its piece instead of adding one.
+    if (!pieces.empty() && pieces.back().Owner == inserted.Owner &&
+        pieces.back().Data + pieces.back().Length == inserted.Data) {
+      pieces.back().Length += inserted.Length;
+    } else {
+      pieces.push_back(std::move(inserted));
+    }
+  }
+
+  // Keep the content after the range.
+  auto end = offset + length;
+  for (; i < oldPieces.size(); ++i) {
+    auto pieceEnd = pieceStart + oldPieces[i].Length;
+    if (pieceEnd > end) {
+      auto tail = oldPieces[i];
+      auto skip = end > pieceStart ? end - pieceStart : 0;
+      tail.Data += skip;
+      tail.Length -= skip;
+      pieces.push_back(std::move(tail));
+    }
+    pieceStart = pieceEnd;
+  }
+
+  _size = _size - length + text.size();
+  _pieces = std::make_shared<const std::vector<Piece>>(std::move(pieces));
+}
+
+std::string PieceTable::ToString() const {
+  std::string content;
+  content.reserve(_size);
+  for (const auto& piece : *_pieces) {
+    content.append(piece.Data, piece.Length);
+  }
+  return content;
+}
+
+std::unique_ptr<InputStream> PieceTable::CreateInputStream() const {
+  return std::make_unique<PieceTableInputStream>(_pieces);
+}
+
+PieceTable::Piece PieceTable::store(std::string_view text) {
+  if (text.size() > AddChunkSize / 4) {
+    // Large insertions, e.g. pasted blocks, get their own storage.
+    auto owned = std::make_shared<const std::string>(text);
+    auto data = owned->data();
+    return Piece { std::move(owned), data, text.size() };
+  }
+
+  if (!_addChunk || _addChunkUsed + text.size() > AddChunkSize) {
+    _addChunk = std::shared_ptr<char[]>(new char[AddChunkSize]);
+    _addChunkUsed = 0;
+  }
+
+  auto data = _addChunk.get() + _addChunkUsed;
+  std::memcpy(data, text.data(), text.size());
+  _addChunkUsed += text.size();
+  return Piece { _addChunk, data, text.size() };
+}
+
+} // namespace jvc
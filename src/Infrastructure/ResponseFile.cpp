@@ -0,0 +1,114 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#include "Infrastructure/ResponseFile.h"
+#include "Infrastructure/Stream.h"
+
+namespace jvc {
+
+namespace {
+
+constexpr const size_t BufferCapacity = 64 * 1024;
+
+bool isWhitespace(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+}
+
+} // namespace <anonymous>
+
+ResponseFileReader::ResponseFileReader(std::unique_ptr<InputStream> input, ResponseFileSyntax syntax)
+    : _input(std::move(input)),
+      _syntax(syntax),
+      _buffer(std::make_unique<char[]>(BufferCapacity)),
+      _bufferSize(0),
+      _readPtr(0)
+{ }
+
+ResponseFileReader::ResponseFileReader(ResponseFileReader &&) noexcept = default;
+
+ResponseFileReader& ResponseFileReader::operator=(ResponseFileReader &&) noexcept = default;
+
+ResponseFileReader::~ResponseFileReader() = default;
+
+bool ResponseFileReader::peekChar(char &ch) {
+  if (_readPtr == _bufferSize) {
+    _bufferSize = _input->Read(_buffer.get(), BufferCapacity);
+    _readPtr = 0;
+    if (_bufferSize == 0) {
+      return false;
+    }
+  }
+
+  ch = _buffer[_readPtr];
+  return true;
+}
+
+bool ResponseFileReader::ReadNext(std::string &argument) {
+  argument.clear();
+  char ch;
+
+  if (_syntax == ResponseFileSyntax::Lines) {
+    while (true) {
+      auto hasChar = peekChar(ch);
+      if (hasChar) {
+        ++_readPtr;
+      }
+      if (!hasChar || ch == '\n') {
+        if (!argument.empty() && argument.back() == '\r') {
+          argument.pop_back();
+        }
+        if (!argument.empty()) {
+          return true;
+        }
+        if (!hasChar) {
+          return false;
+        }
+        continue;
+      }
+      argument.push_back(ch);
+    }
+  }
+
+  // Skip the whitespaces in front of the argument.
+  while (peekChar(ch) && isWhitespace(ch)) {
+    ++_readPtr;
+  }
+  if (!peekChar(ch)) {
+    return false;
+  }
+
+  char quote = 0;
+  while (peekChar(ch)) {
+    if (!quote && isWhitespace(ch)) {
+      break;
+    }
+    ++_readPtr;
+
+    if (ch == '\\') {
+      if (peekChar(ch)) {
+        ++_readPtr;
+        argument.push_back(ch);
+      }
+    } else if (quote && ch == quote) {
+      quote = 0;
+    } else if (!quote && (ch == '"' || ch == '\'')) {
+      quote = ch;
+    } else {
+      argument.push_back(ch);
+    }
+  }
+  return true;
+}
+
+size_t ResponseFileReader::ReadBatch(std::vector<std::string> &arguments, size_t maxCount) {
+  arguments.resize(maxCount);
+  size_t count = 0;
+  while (count < maxCount && ReadNext(arguments[count])) {
+    ++count;
+  }
+  arguments.resize(count);
+  return count;
+}
+
+} // namespace jvc
@@ -0,0 +1,48 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#include "Infrastructure/Hash.h"
+#include "Infrastructure/StatCache.h"
+
+#include <cerrno>
+
+#include <sys/stat.h>
+
+namespace jvc {
+
+StatCache::StatCache()
+    : _hits(0),
+      _misses(0)
+{ }
+
+FileStatus StatCache::Stat(const std::string &path) {
+  auto& shard = _shards[HashBytes(path) % ShardCount];
+  {
+    std::lock_guard<std::mutex> lock { shard.Mutex };
+    auto i = shard.Entries.find(path);
+    if (i != shard.Entries.end()) {
+      _hits.fetch_add(1, std::memory_order_relaxed);
+      return i->second;
+    }
+  }
+
+  // Query the file system without holding the lock. Racing queries of the same path produce the same result.
+  _misses.fetch_add(1, std::memory_order_relaxed);
+  FileStatus status { };
+  struct stat st { };
+  if (stat(path.c_str(), &st) != 0) {
+    status.ErrorCode = errno ? errno : ENOENT;
+  } else {
+    status.IsDirectory = S_ISDIR(st.st_mode);
+    status.IsRegularFile = S_ISREG(st.st_mode);
+    status.Size = static_cast<uint64_t>(st.st_size);
+    status.Identity.Device = static_cast<uint64_t>(st.st_dev);
+    status.Identity.Inode = static_cast<uint64_t>(st.st_ino);
+  }
+
+  std::lock_guard<std::mutex> lock { shard.Mutex };
+  return shard.Entries.emplace(path, status).first->second;
+}
+
+} // namespace jvc
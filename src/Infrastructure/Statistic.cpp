@@ -0,0 +1,100 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#include "Infrastructure/Json.h"
+#include "Infrastructure/Statistic.h"
+#include "Infrastructure/Stream.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace jvc {
+
+namespace {
+
+struct StatisticRegistry {
+  std::mutex Mutex;
+  std::vector<const Statistic *> Statistics;
+};
+
+StatisticRegistry& getRegistry() {
+  // Counters register themselves during static initialization, in no particular order across translation units.
+  static StatisticRegistry registry;
+  return registry;
+}
+
+} // namespace <anonymous>
+
+Statistic::Statistic(const char* name, const char* description)
+  : _name(name),
+    _description(description),
+    _value(0)
+{
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock { registry.Mutex };
+  registry.Statistics.push_back(this);
+}
+
+std::vector<const Statistic *> Statistic::GetAll() {
+  std::vector<const Statistic *> statistics;
+  {
+    auto& registry = getRegistry();
+    std::lock_guard<std::mutex> lock { registry.Mutex };
+    statistics = registry.Statistics;
+  }
+  std::sort(statistics.begin(), statistics.end(), [](const Statistic* lhs, const Statistic* rhs) {
+    return std::strcmp(lhs->name(), rhs->name()) < 0;
+  });
+  return statistics;
+}
+
+const Statistic* Statistic::Find(std::string_view name) {
+  auto& registry = getRegistry();
+  std::lock_guard<std::mutex> lock { registry.Mutex };
+  for (auto statistic : registry.Statistics) {
+    if (statistic->name() == name) {
+      return statistic;
+    }
+  }
+  return nullptr;
+}
+
+void Statistic::Print(StreamWriter& output) {
+  auto statistics = GetAll();
+  size_t nameWidth = 0;
+  for (auto statistic : statistics) {
+    nameWidth = std::max(nameWidth, std::strlen(statistic->name()));
+  }
+
+  std::string text { "Statistics:\n" };
+  for (auto statistic : statistics) {
+    char value[32];
+    auto length = std::snprintf(value, sizeof(value), "%14llu  ",
+                                static_cast<unsigned long long>(statistic->value()));
+    text.append(value, length).append(statistic->name());
+    text.append(nameWidth - std::strlen(statistic->name()) + 2, ' ').append(statistic->description()).push_back('\n');
+  }
+  output << text;
+}
+
+void Statistic::PrintJson(StreamWriter& output) {
+  std::string json { "{\"stats\":{" };
+  auto first = true;
+  for (auto statistic : GetAll()) {
+    if (!first) {
+      json.push_back(',');
+    }
+    first = false;
+    AppendJsonString(json, statistic->name());
+    json.push_back(':');
+    json.append(std::to_string(statistic->value()));
+  }
+  json.append("}}\n");
+  output << json;
+}
+
+} // namespace jvc
@@ -2,16 +2,25 @@
 // Created by Sirui Mu on 2019/12/19.
 //
 
+#include "Infrastructure/MemoryUsage.h"
 #include "Infrastructure/Stream.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
 #include <type_traits>
 
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
 namespace jvc {
 
 namespace {
 
+JVC_MEMORY_GAUGE(StreamBufferBytes, "Bytes held by the buffers of buffered output streams");
+
 class STLInputStreamWrapper : public InputStream {
 public:
   explicit STLInputStreamWrapper(std::istream& inner)
@@ -48,6 +57,26 @@ private:
   size_t _readPtr;
 };
 
+template <typename Inner>
+class STLOwnedInputStream : public InputStream {
+  static_assert(std::is_base_of_v<std::istream, Inner>, "Inner does not derive from std::istream.");
+
+public:
+  explicit STLOwnedInputStream(Inner inner)
+    : _inner(std::move(inner)),
+      _wrapper(_inner)
+  { }
+
+  size_t Read(void *buffer, size_t bufferSize) override {
+    return _wrapper.Read(buffer, bufferSize);
+  }
+
+private:
+  // _inner must be declared before _wrapper since _wrapper refers to it.
+  Inner _inner;
+  STLInputStreamWrapper _wrapper;
+};
+
 class STLOutputStreamWrapper : public OutputStream {
 public:
   explicit STLOutputStreamWrapper(std::ostream& inner)
@@ -60,31 +89,188 @@ public:
     return bufferSize;
   }
 
+  void Flush() override {
+    _inner.flush();
+  }
+
 private:
   std::ostream& _inner;
 };
 
-template <typename Inner>
-class STLOwnedOutputStream : public OutputStream {
-  static_assert(std::is_base_of_v<std::ostream, Inner>, "Inner does not derive from std::ostream.");
+class StringOutputStream : public OutputStream {
+public:
+  explicit StringOutputStream(std::string& buffer)
+    : _buffer(buffer)
+  { }
+
+  size_t Write(const void *buffer, size_t bufferSize) override {
+    _buffer.append(reinterpret_cast<const char *>(buffer), bufferSize);
+    return bufferSize;
+  }
+
+private:
+  std::string& _buffer;
+};
+
+class BufferedOutputStream : public OutputStream {
+public:
+  explicit BufferedOutputStream(std::unique_ptr<OutputStream> inner, size_t capacity)
+    : _inner(std::move(inner)),
+      _buffer(std::make_unique<char[]>(capacity)),
+      _capacity(capacity),
+      _size(0)
+  {
+    StreamBufferBytes.Add(capacity);
+  }
+
+  ~BufferedOutputStream() override {
+    flushBuffer();
+    StreamBufferBytes.Subtract(_capacity);
+  }
+
+  size_t Write(const void *buffer, size_t bufferSize) override {
+    if (_size + bufferSize > _capacity) {
+      flushBuffer();
+      if (bufferSize >= _capacity) {
+        // Large writes bypass the buffer.
+        return _inner->Write(buffer, bufferSize);
+      }
+    }
+    memcpy(_buffer.get() + _size, buffer, bufferSize);
+    _size += bufferSize;
+    return bufferSize;
+  }
+
+  size_t WriteVectored(const OutputBuffer* buffers, size_t count) override {
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+      total += buffers[i].Size;
+    }
+    if (_size + total <= _capacity) {
+      for (size_t i = 0; i < count; ++i) {
+        Write(buffers[i].Data, buffers[i].Size);
+      }
+      return total;
+    }
 
+    flushBuffer();
+    return _inner->WriteVectored(buffers, count);
+  }
+
+  void Flush() override {
+    flushBuffer();
+    _inner->Flush();
+  }
+
+private:
+  std::unique_ptr<OutputStream> _inner;
+  std::unique_ptr<char[]> _buffer;
+  size_t _capacity;
+  size_t _size;
+
+  void flushBuffer() {
+    if (_size) {
+      _inner->Write(_buffer.get(), _size);
+      _size = 0;
+    }
+  }
+};
+
+class FileDescriptorOutputStream : public OutputStream {
 public:
-  explicit STLOwnedOutputStream(Inner inner)
-    : _wrapper(inner),
-      _inner(std::move(inner))
+  explicit FileDescriptorOutputStream(int fd, bool owned)
+    : _fd(fd),
+      _owned(owned)
   { }
 
+  ~FileDescriptorOutputStream() override {
+    if (_owned) {
+      close(_fd);
+    }
+  }
+
   size_t Write(const void *buffer, size_t bufferSize) override {
-    return _wrapper.Write(buffer, bufferSize);
+    OutputBuffer buffers[] = { { buffer, bufferSize } };
+    return WriteVectored(buffers, 1);
+  }
+
+  size_t WriteVectored(const OutputBuffer* buffers, size_t count) override {
+    constexpr const size_t MaxBuffersPerCall = 64;
+
+    size_t written = 0;
+    while (count) {
+      iovec vectors[MaxBuffersPerCall];
+      auto batch = std::min(count, MaxBuffersPerCall);
+      size_t batchSize = 0;
+      for (size_t i = 0; i < batch; ++i) {
+        vectors[i].iov_base = const_cast<void *>(buffers[i].Data);
+        vectors[i].iov_len = buffers[i].Size;
+        batchSize += buffers[i].Size;
+      }
+
+      auto result = writev(_fd, vectors, static_cast<int>(batch));
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return written;
+      }
+      written += result;
+
+      if (static_cast<size_t>(result) < batchSize) {
+        // Finish the partially written buffer, then carry on with the remaining ones.
+        auto remaining = static_cast<size_t>(result);
+        while (remaining >= buffers->Size) {
+          remaining -= buffers->Size;
+          ++buffers;
+          --count;
+        }
+        auto partial = writeAll(reinterpret_cast<const char *>(buffers->Data) + remaining, buffers->Size - remaining);
+        written += partial;
+        if (partial < buffers->Size - remaining) {
+          return written;
+        }
+        ++buffers;
+        --count;
+        continue;
+      }
+
+      buffers += batch;
+      count -= batch;
+    }
+    return written;
   }
 
 private:
-  STLOutputStreamWrapper _wrapper;
-  Inner _inner;
+  int _fd;
+  bool _owned;
+
+  size_t writeAll(const char* data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+      auto result = write(_fd, data + written, size - written);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      written += result;
+    }
+    return written;
+  }
 };
 
 } // namespace anonymous
 
+size_t OutputStream::WriteVectored(const OutputBuffer* buffers, size_t count) {
+  size_t written = 0;
+  for (size_t i = 0; i < count; ++i) {
+    written += Write(buffers[i].Data, buffers[i].Size);
+  }
+  return written;
+}
+
 std::unique_ptr<InputStream> InputStream::FromSTL(std::istream &inner) {
   return std::make_unique<STLInputStreamWrapper>(inner);
 }
@@ -93,17 +279,38 @@ std::unique_ptr<InputStream> InputStream::FromBuffer(const void *buffer, size_t
   return std::make_unique<MemoryInputStream>(buffer, bufferSize);
 }
 
+std::unique_ptr<InputStream> InputStream::FromFile(const std::string& filename) {
+  std::ifstream fs { filename };
+  if (fs.fail()) {
+    return nullptr;
+  }
+
+  return std::make_unique<STLOwnedInputStream<decltype(fs)>>(std::move(fs));
+}
+
 std::unique_ptr<OutputStream> OutputStream::FromSTL(std::ostream &inner) {
   return std::make_unique<STLOutputStreamWrapper>(inner);
 }
 
 std::unique_ptr<OutputStream> OutputStream::FromFile(const std::string& filename) {
-  std::ofstream fs { filename };
-  if (fs.fail()) {
+  auto fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (fd < 0) {
     return nullptr;
   }
 
-  return std::make_unique<STLOwnedOutputStream<decltype(fs)>>(std::move(fs));
+  return CreateBuffered(FromFileDescriptor(fd, true));
+}
+
+std::unique_ptr<OutputStream> OutputStream::FromFileDescriptor(int fd, bool owned) {
+  return std::make_unique<FileDescriptorOutputStream>(fd, owned);
+}
+
+std::unique_ptr<OutputStream> OutputStream::FromString(std::string& buffer) {
+  return std::make_unique<StringOutputStream>(buffer);
+}
+
+std::unique_ptr<OutputStream> OutputStream::CreateBuffered(std::unique_ptr<OutputStream> inner, size_t capacity) {
+  return std::make_unique<BufferedOutputStream>(std::move(inner), capacity);
 }
 
 namespace {
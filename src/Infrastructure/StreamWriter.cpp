@@ -2,10 +2,20 @@
 // Created by Sirui Mu on 2019/12/19.
 //
 
+#include "Infrastructure/Statistic.h"
 #include "Infrastructure/Stream.h"
 
+#include <cstring>
+
 namespace jvc {
 
+namespace {
+
+JVC_STATISTIC(StreamWriterWrites, "Number of characters and strings written through StreamWriter objects");
+JVC_STATISTIC(StreamWriterBytes, "Number of bytes written through StreamWriter objects, excluding indents");
+
+} // namespace <anonymous>
+
 void StreamWriterIndentGuard::pop() {
   if (_writer) {
     _writer->popIndent();
@@ -22,7 +32,18 @@ StreamWriterIndentGuard StreamWriter::PushIndent() {
   return StreamWriterIndentGuard { this };
 }
 
+StreamWriter::~StreamWriter() {
+  publishStatistics();
+}
+
+void StreamWriter::Flush() {
+  publishStatistics();
+  _inner->Flush();
+}
+
 void StreamWriter::WriteChar(char ch) {
+  ++_writes;
+  ++_bytes;
   if (ch != '\n') {
     // If the character is new line character, no indent should be added no matter where the writer pointer are.
     writeIndentOnNecessary();
@@ -43,15 +64,20 @@ void StreamWriter::Write(const std::string &s) {
 }
 
 void StreamWriter::Write(std::string_view s) {
+  ++_writes;
+  _bytes += s.size();
+
   while (!s.empty()) {
     if (s.front() == '\n') {
-      WriteChar('\n');
+      // No indent is added before a new line character, see WriteChar.
+      _inner->Write("\n", 1);
+      _atLineStart = true;
       s.remove_prefix(1);
       continue;
     }
 
-    int window = 0;
-    while (s[window] && s[window] != '\n') {
+    size_t window = 0;
+    while (window < s.size() && s[window] != '\n') {
       ++window;
     }
 
@@ -68,6 +94,13 @@ void StreamWriter::popIndent() {
   }
 }
 
+void StreamWriter::publishStatistics() {
+  StreamWriterWrites += _writes;
+  StreamWriterBytes += _bytes;
+  _writes = 0;
+  _bytes = 0;
+}
+
 void StreamWriter::writeIndentOnNecessary() {
   if (_indent && _atLineStart) {
     char buffer[4];
@@ -0,0 +1,105 @@
+//
+// Created by Sirui Mu on 2020/1/3.
+//
+
+#include "Infrastructure/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+namespace jvc {
+
+ThreadPool::ThreadPool(size_t threads)
+    : _pending(0),
+      _stopping(false)
+{
+  if (threads == 0) {
+    threads = GetDefaultConcurrency();
+  }
+
+  _workers.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    _workers.emplace_back([this]() { runWorker(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock { _mutex };
+    _idle.wait(lock, [this]() { return _pending == 0; });
+    _stopping = true;
+  }
+  _taskAvailable.notify_all();
+
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::GetDefaultConcurrency() {
+  auto threads = std::thread::hardware_concurrency();
+  return threads ? threads : 1;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock { _mutex };
+    _tasks.push_back(std::move(task));
+    ++_pending;
+  }
+  _taskAvailable.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock { _mutex };
+  _idle.wait(lock, [this]() { return _pending == 0; });
+}
+
+void ThreadPool::runWorker() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock { _mutex };
+      _taskAvailable.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+      if (_tasks.empty()) {
+        return;
+      }
+      task = std::move(_tasks.front());
+      _tasks.pop_front();
+    }
+
+    task();
+
+    std::lock_guard<std::mutex> lock { _mutex };
+    if (--_pending == 0) {
+      _idle.notify_all();
+    }
+  }
+}
+
+void ParallelFor(size_t jobs, size_t count, const std::function<void(size_t)>& body) {
+  if (jobs == 0) {
+    jobs = ThreadPool::GetDefaultConcurrency();
+  }
+  jobs = std::min(jobs, count);
+
+  if (jobs <= 1) {
+    for (size_t i = 0; i < count; ++i) {
+      body(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next { 0 };
+  ThreadPool pool { jobs };
+  for (size_t i = 0; i < jobs; ++i) {
+    pool.Submit([&next, count, &body]() {
+      for (auto index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+        body(index);
+      }
+    });
+  }
+  pool.Wait();
+}
+
+} // namespace jvc
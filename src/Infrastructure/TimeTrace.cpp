@@ -0,0 +1,139 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#include "Infrastructure/Json.h"
+#include "Infrastructure/Stream.h"
+#include "Infrastructure/TimeTrace.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace jvc {
+
+namespace {
+
+const TimeTraceProfiler::Clock::time_point ProcessStartTime = TimeTraceProfiler::Clock::now();
+
+struct TimeTraceEvent {
+  const char* Name;
+  std::string Detail;
+  TimeTraceProfiler::Clock::time_point Start;
+  TimeTraceProfiler::Clock::time_point End;
+};
+
+/**
+ * @brief Events recorded by a single thread. Buffers are owned by the registry below so that they outlive the threads
+ * that recorded them.
+ */
+struct TimeTraceThreadBuffer {
+  size_t ThreadIndex;
+  std::vector<TimeTraceEvent> Events;
+  // Indexes of the events of the open scopes, innermost last.
+  std::vector<size_t> OpenScopes;
+};
+
+std::mutex threadBuffersMutex;
+std::vector<std::unique_ptr<TimeTraceThreadBuffer>> threadBuffers;
+
+TimeTraceThreadBuffer& getThreadBuffer() {
+  thread_local TimeTraceThreadBuffer* buffer = nullptr;
+  if (!buffer) {
+    std::lock_guard<std::mutex> lock { threadBuffersMutex };
+    threadBuffers.push_back(std::make_unique<TimeTraceThreadBuffer>());
+    buffer = threadBuffers.back().get();
+    buffer->ThreadIndex = threadBuffers.size() - 1;
+  }
+  return *buffer;
+}
+
+void appendMicroseconds(std::string& output, TimeTraceProfiler::Clock::duration duration) {
+  char buffer[32];
+  auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  auto length = std::snprintf(buffer, sizeof(buffer), "%.3f", static_cast<double>(nanoseconds) / 1000);
+  output.append(buffer, length);
+}
+
+} // namespace <anonymous>
+
+bool TimeTraceProfiler::Enabled = false;
+
+void TimeTraceProfiler::Initialize() {
+  Enabled = true;
+}
+
+void TimeTraceProfiler::Shutdown() {
+  Enabled = false;
+  // Threads keep pointers to their buffers, so the buffers are emptied rather than destroyed.
+  std::lock_guard<std::mutex> lock { threadBuffersMutex };
+  for (const auto& buffer : threadBuffers) {
+    buffer->Events.clear();
+    buffer->OpenScopes.clear();
+  }
+}
+
+TimeTraceProfiler::Clock::time_point TimeTraceProfiler::GetProcessStartTime() {
+  return ProcessStartTime;
+}
+
+void TimeTraceProfiler::Begin(const char* name, std::string_view detail) {
+  auto& buffer = getThreadBuffer();
+  buffer.OpenScopes.push_back(buffer.Events.size());
+  buffer.Events.push_back(TimeTraceEvent { name, std::string { detail }, Clock::now(), { } });
+}
+
+void TimeTraceProfiler::End() {
+  auto& buffer = getThreadBuffer();
+  if (buffer.OpenScopes.empty()) {
+    return;
+  }
+  buffer.Events[buffer.OpenScopes.back()].End = Clock::now();
+  buffer.OpenScopes.pop_back();
+}
+
+void TimeTraceProfiler::AddEvent(const char* name, Clock::time_point start, Clock::time_point end) {
+  getThreadBuffer().Events.push_back(TimeTraceEvent { name, std::string { }, start, end });
+}
+
+void TimeTraceProfiler::Write(OutputStream& output) {
+  std::string json { "{\"traceEvents\":[" };
+  auto first = true;
+  auto now = Clock::now();
+
+  std::lock_guard<std::mutex> lock { threadBuffersMutex };
+  for (const auto& buffer : threadBuffers) {
+    auto tid = std::to_string(buffer->ThreadIndex);
+
+    json.append(first ? "\n" : ",\n");
+    first = false;
+    json.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":").append(tid)
+        .append(",\"args\":{\"name\":\"").append(buffer->ThreadIndex ? "worker " + tid : "main").append("\"}}");
+
+    for (size_t i = 0; i < buffer->Events.size(); ++i) {
+      const auto& event = buffer->Events[i];
+      // Scopes that are still open, e.g. the one enclosing this call, end now.
+      auto end = event.End == Clock::time_point { } ? now : event.End;
+
+      json.append(",\n{\"name\":");
+      AppendJsonString(json, event.Name);
+      json.append(",\"cat\":\"jvc\",\"ph\":\"X\",\"pid\":1,\"tid\":").append(tid).append(",\"ts\":");
+      appendMicroseconds(json, event.Start - ProcessStartTime);
+      json.append(",\"dur\":");
+      appendMicroseconds(json, end - event.Start);
+      if (!event.Detail.empty()) {
+        json.append(",\"args\":{\"detail\":");
+        AppendJsonString(json, event.Detail);
+        json.push_back('}');
+      }
+      json.push_back('}');
+    }
+  }
+  json.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+
+  output.Write(json.data(), json.size());
+}
+
+} // namespace jvc
@@ -0,0 +1,144 @@
+//
+// Created by Sirui Mu on 2019/12/28.
+//
+
+#include "Infrastructure/Unicode.h"
+#include "UnicodeTables.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace jvc {
+
+bool IsASCII(const char* data, size_t size) {
+  constexpr const uint64_t HighBits = 0x8080808080808080ull;
+
+  size_t i = 0;
+  uint64_t acc = 0;
+  for (; i + 4 * sizeof(uint64_t) <= size; i += 4 * sizeof(uint64_t)) {
+    uint64_t words[4];
+    std::memcpy(words, data + i, sizeof(words));
+    acc |= words[0] | words[1] | words[2] | words[3];
+    if (acc & HighBits) {
+      return false;
+    }
+  }
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    acc |= word;
+  }
+  if (acc & HighBits) {
+    return false;
+  }
+
+  for (; i < size; ++i) {
+    if (!IsASCII(data[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t GetUTF8SequenceLength(char leader) {
+  auto b = static_cast<unsigned char>(leader);
+  if (b < 0x80u) {
+    return 1;
+  } else if (b < 0xC2u) {
+    // Continuation bytes and overlong leaders.
+    return 0;
+  } else if (b < 0xE0u) {
+    return 2;
+  } else if (b < 0xF0u) {
+    return 3;
+  } else if (b < 0xF5u) {
+    return 4;
+  } else {
+    return 0;
+  }
+}
+
+size_t DecodeUTF8(const char* data, size_t size, char32_t& cp) {
+  if (size == 0) {
+    return 0;
+  }
+
+  auto length = GetUTF8SequenceLength(data[0]);
+  if (length == 1) {
+    cp = static_cast<unsigned char>(data[0]);
+    return 1;
+  }
+  if (length == 0 || length > size) {
+    cp = ReplacementCharacter;
+    return 1;
+  }
+
+  constexpr const unsigned char LeaderMasks[] = { 0, 0, 0x1Fu, 0x0Fu, 0x07u };
+  char32_t value = static_cast<unsigned char>(data[0]) & LeaderMasks[length];
+  for (size_t i = 1; i < length; ++i) {
+    if (!IsUTF8ContinuationByte(data[i])) {
+      cp = ReplacementCharacter;
+      return i;
+    }
+    value = (value << 6u) | (static_cast<unsigned char>(data[i]) & 0x3Fu);
+  }
+
+  // Reject overlong encodings, surrogates and code points beyond the Unicode range.
+  constexpr const char32_t MinValues[] = { 0, 0, 0x80, 0x800, 0x10000 };
+  if (value < MinValues[length] || (value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF) {
+    cp = ReplacementCharacter;
+    return length;
+  }
+
+  cp = value;
+  return length;
+}
+
+size_t EncodeUTF8(char32_t cp, std::string& output) {
+  if (cp < 0x80) {
+    output.push_back(static_cast<char>(cp));
+    return 1;
+  }
+  if (cp < 0x800) {
+    output.push_back(static_cast<char>(0xC0u | (cp >> 6u)));
+    output.push_back(static_cast<char>(0x80u | (cp & 0x3Fu)));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    output.push_back(static_cast<char>(0xE0u | (cp >> 12u)));
+    output.push_back(static_cast<char>(0x80u | ((cp >> 6u) & 0x3Fu)));
+    output.push_back(static_cast<char>(0x80u | (cp & 0x3Fu)));
+    return 3;
+  }
+  if (cp <= 0x10FFFF) {
+    output.push_back(static_cast<char>(0xF0u | (cp >> 18u)));
+    output.push_back(static_cast<char>(0x80u | ((cp >> 12u) & 0x3Fu)));
+    output.push_back(static_cast<char>(0x80u | ((cp >> 6u) & 0x3Fu)));
+    output.push_back(static_cast<char>(0x80u | (cp & 0x3Fu)));
+    return 4;
+  }
+  return EncodeUTF8(ReplacementCharacter, output);
+}
+
+namespace {
+
+bool testUnicodeBlocks(const uint32_t (*blocks)[(1u << UnicodeBlockBits) / 32], char32_t cp) {
+  if (cp > 0x10FFFF) {
+    return false;
+  }
+  auto block = UnicodeBlockIndex[cp >> UnicodeBlockBits];
+  auto bit = cp & ((1u << UnicodeBlockBits) - 1);
+  return (blocks[block][bit / 32] >> (bit % 32)) & 1u;
+}
+
+} // namespace <anonymous>
+
+bool IsJavaIdentifierStart(char32_t cp) {
+  return testUnicodeBlocks(IdentifierStartBlocks, cp);
+}
+
+bool IsJavaIdentifierPart(char32_t cp) {
+  return testUnicodeBlocks(IdentifierPartBlocks, cp);
+}
+
+} // namespace jvc
@@ -2,13 +2,15 @@
 // Created by Sirui Mu on 2019/12/20.
 //
 
+#include "Infrastructure/Statistic.h"
+#include "Infrastructure/Unicode.h"
 #include "Frontend/CompilerInstance.h"
 #include "Frontend/SourceLocation.h"
 #include "Lex/Lexer.h"
+#include "Lex/LexerStatistics.h"
 #include "Lex/Token.h"
 #include "LexerStreamReader.h"
 
-#include <cctype>
 #include <cmath>
 #include <unordered_map>
 #include <type_traits>
@@ -16,15 +18,48 @@
 
 namespace jvc {
 
+namespace {
+
+JVC_STATISTIC(LexerTokens, "Number of tokens lexed");
+
+#define DEF_STATISTIC(v) JVC_STATISTIC(Lexer##v##Tokens, "Number of " #v " tokens lexed");
+JVC_TOKEN_KIND_LIST(DEF_STATISTIC)
+#undef DEF_STATISTIC
+
+Statistic* const TokenKindStatistics[] = {
+#define DEF_STATISTIC_ENTRY(v) &Lexer##v##Tokens,
+  JVC_TOKEN_KIND_LIST(DEF_STATISTIC_ENTRY)
+#undef DEF_STATISTIC_ENTRY
+};
+
+} // namespace <anonymous>
+
 Lexer::Lexer(CompilerInstance& ci, int sourceFileId, std::unique_ptr<LexerStreamReader> reader, LexerOptions options)
   : _ci(ci),
     _options(options),
     _locBuilder { sourceFileId },
     _reader(std::move(reader)),
-    _peekBuffer(nullptr)
+    _peekBuffer(nullptr),
+    _tokenCounts { }
 { }
 
-Lexer::~Lexer() = default;
+#ifdef JVC_LEX_STATS
+#define JVC_LEX_STATS_ROUTINE(routine) \
+    LexerRoutineTimer routineTimer { _stats.get(), LexerRoutine::routine }
+#else
+#define JVC_LEX_STATS_ROUTINE(routine)
+#endif
+
+Lexer::~Lexer() {
+  uint64_t tokens = 0;
+  for (size_t i = 0; i < TokenKindCount; ++i) {
+    if (_tokenCounts[i]) {
+      *TokenKindStatistics[i] += _tokenCounts[i];
+      tokens += _tokenCounts[i];
+    }
+  }
+  LexerTokens += tokens;
+}
 
 std::unique_ptr<Lexer> Lexer::Create(CompilerInstance& ci, int sourceFileId, LexerOptions options) {
   auto sourceFile = ci.GetSourceManager().GetSourceFileInfo(sourceFileId);
@@ -32,12 +67,41 @@ std::unique_ptr<Lexer> Lexer::Create(CompilerInstance& ci, int sourceFileId, Lex
     return nullptr;
   }
 
+  // Unicode escapes have to be translated before lexing (JLS §3.3). Most source files contain no `\u` at all, in which
+  // case the reader can stay on the raw byte path. The content of a streaming source file is not known in advance.
+  auto translateUnicodeEscapes = true;
+  if (!sourceFile->IsStreaming()) {
+    // Hold the content while it is scanned, so that it cannot be evicted under the scan.
+    auto buffer = sourceFile->GetBuffer();
+    if (!buffer) {
+      return nullptr;
+    }
+    translateUnicodeEscapes = buffer->GetView().find("\\u") != std::string_view::npos;
+  }
+
   auto inputStream = sourceFile->CreateInputStream();
-  auto reader = std::make_unique<LexerStreamReader>(std::move(inputStream));
+  if (!inputStream) {
+    return nullptr;
+  }
+  auto reader = std::make_unique<LexerStreamReader>(std::move(inputStream), translateUnicodeEscapes);
 
   // We cannot use std::make_unique because constructor of Lexer is private. This is not a problem since the
   // constructor of Lexer should not throw any exceptions.
-  return std::unique_ptr<Lexer> { new Lexer(ci, sourceFileId, std::move(reader), options) };
+  auto lexer = std::unique_ptr<Lexer> { new Lexer(ci, sourceFileId, std::move(reader), options) };
+#ifdef JVC_LEX_STATS
+  if (options.CollectStatistics) {
+    lexer->_stats = std::make_unique<LexerStatistics>();
+  }
+#endif
+  return lexer;
+}
+
+const LexerStatistics* Lexer::GetStatistics() const {
+#ifdef JVC_LEX_STATS
+  return _stats.get();
+#else
+  return nullptr;
+#endif
 }
 
 Token *Lexer::PeekNextToken() {
@@ -57,6 +121,22 @@ std::unique_ptr<Token> Lexer::ReadNextToken() {
   return std::move(_peekBuffer);
 }
 
+size_t Lexer::ReadAllTokens(std::vector<std::unique_ptr<Token>>& tokens) {
+  auto initialSize = tokens.size();
+
+  if (!_peekBuffer) {
+    peek();
+  }
+  while (_peekBuffer) {
+    if (shouldKeepCurrentToken()) {
+      tokens.push_back(std::move(_peekBuffer));
+    }
+    peek();
+  }
+
+  return tokens.size() - initialSize;
+}
+
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "OCSimplifyInspection"
 bool Lexer::shouldKeepCurrentToken() const {
@@ -80,18 +160,18 @@ char Lexer::ensurePeekChar() {
   char ch;
   peekCharOr(ch, [this] {
     auto loc = GetNextLocation();
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, loc, "Unexpected end-of-file.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnexpectedEOF, loc });
   });
 
   return ch;
 }
 
 bool Lexer::readChar(char &ch) {
-  if (!_reader->ReadChar(ch)) {
+  int width;
+  if (!_reader->ReadChar(ch, width)) {
     return false;
   }
-  _locBuilder.UpdateState(ch);
+  _locBuilder.UpdateState(ch, width);
   return true;
 }
 
@@ -99,15 +179,74 @@ char Lexer::ensureReadChar() {
   char ch;
   readCharOr(ch, [this] {
     auto loc = GetNextLocation();
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, loc, "Unexpected end-of-file.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnexpectedEOF, loc });
   });
 
   return ch;
 }
 
+namespace {
+
+// The following predicates only accept ASCII characters. Unlike their counterparts in <cctype>, they are not affected
+// by the current locale and are well-defined for bytes of UTF-8 sequences.
+
+bool isASCIILetter(char ch) {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+bool isASCIIDigit(char ch) {
+  return ch >= '0' && ch <= '9';
+}
+
+bool isASCIIIdentifierPart(char ch) {
+  return isASCIILetter(ch) || isASCIIDigit(ch) || ch == '_' || ch == '$';
+}
+
+bool isWhitespace(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r';
+}
+
+} // namespace <anonymous>
+
 void Lexer::peek() {
+#ifdef JVC_LEX_STATS
+  if (_stats) {
+    auto startOffset = _reader->GetOffset();
+    auto startAllocations = LexerStatistics::GetAllocationCount();
+    auto startTimestamp = LexerStatistics::ReadTimestamp();
+    lexNextToken();
+    auto ticks = LexerStatistics::ReadTimestamp() - startTimestamp;
+    if (_peekBuffer) {
+      _stats->RecordToken(*_peekBuffer, _reader->GetOffset() - startOffset,
+                          LexerStatistics::GetAllocationCount() - startAllocations, ticks);
+      ++_tokenCounts[static_cast<size_t>(_peekBuffer->kind())];
+    }
+    return;
+  }
+#endif
+
+  lexNextToken();
+  if (_peekBuffer) {
+    ++_tokenCounts[static_cast<size_t>(_peekBuffer->kind())];
+  }
+}
+
+void Lexer::lexNextToken() {
+  // Stop producing tokens once the compiler session has been cancelled, so that the consumers wind down.
+  if (_ci.GetDiagnosticsEngine().IsCancelled()) {
+    _peekBuffer = nullptr;
+    return;
+  }
+
   auto startLoc = GetNextLocation();
+  if (!startLoc.valid()) {
+    // The source code file is so large that the side table of source locations is full.
+    auto sourceFile = _ci.GetSourceManager().GetSourceFileInfo(_locBuilder.fileId());
+    _ci.GetDiagnosticsEngine().Emit(Diagnostics {
+        DiagnosticsKind::SourceLocationOutOfRange, sourceFile->path(), _locBuilder.row(), _locBuilder.col() });
+    _peekBuffer = nullptr;
+    return;
+  }
 
   char ch;
   if (!peekChar(ch)) {
@@ -115,12 +254,12 @@ void Lexer::peek() {
     return;
   }
 
-  if (std::isspace(ch)) {
+  if (isWhitespace(ch)) {
     lexWhitespace(startLoc);
     return;
   }
 
-  if (std::isalpha(ch)) {
+  if (isASCIILetter(ch)) {
     lexKeywordOrIdentifier(startLoc);
     return;
   }
@@ -130,7 +269,7 @@ void Lexer::peek() {
     return;
   }
 
-  if (std::isdigit(ch)) {
+  if (isASCIIDigit(ch)) {
     lexNumberLiteral(startLoc, std::optional<char> { });
     return;
   }
@@ -167,8 +306,16 @@ void Lexer::peek() {
     return;
   }
 
-  auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, startLoc, "Unrecognized token");
-  _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+  if (!IsASCII(ch)) {
+    char32_t cp;
+    size_t length;
+    if (_reader->PeekCodePoint(cp, length) && IsJavaIdentifierStart(cp)) {
+      lexIdentifier(startLoc);
+      return;
+    }
+  }
+
+  _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnrecognizedToken, startLoc });
 }
 
 namespace {
@@ -229,6 +376,8 @@ const std::unordered_map<std::string, KeywordKind> Keywords = {
 } // namespace anonymous
 
 void Lexer::lexKeywordOrIdentifier(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(KeywordOrIdentifier);
+
   auto mustBeIdentifier = false;
   std::string literal;
 
@@ -237,13 +386,15 @@ void Lexer::lexKeywordOrIdentifier(SourceLocation startLoc) {
   literal.push_back(ch);
 
   while (peekChar(ch)) {
-    if (std::isalpha(ch) || std::isdigit(ch) || ch == '_' || ch == '$') {
+    if (isASCIIIdentifierPart(ch)) {
       literal.push_back(ch);
-      if (std::isdigit(ch) || ch == '_') {
+      if (isASCIIDigit(ch) || ch == '_' || ch == '$') {
         mustBeIdentifier = true;
       }
       // Consume this character.
       readChar(ch);
+    } else if (!_reader->IsInASCIIBlock() && !IsASCII(ch) && lexUnicodeIdentifierPart(literal)) {
+      mustBeIdentifier = true;
     } else {
       break;
     }
@@ -267,17 +418,28 @@ void Lexer::lexKeywordOrIdentifier(SourceLocation startLoc) {
 }
 
 void Lexer::lexIdentifier(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(Identifier);
+
   std::string name;
 
-  auto ch = ensureReadChar();
-  assert((std::isalpha(ch) || ch == '_' || ch == '$') &&
-      "next character is not as expected to be the start of an identifier.");
-  name.push_back(ch);
+  auto ch = ensurePeekChar();
+  if (IsASCII(ch)) {
+    assert((isASCIILetter(ch) || ch == '_' || ch == '$') &&
+        "next character is not as expected to be the start of an identifier.");
+    name.push_back(ch);
+    consumeChar();
+  } else {
+    auto isIdentifierStart = lexUnicodeIdentifierPart(name);
+    assert(isIdentifierStart && "next character is not as expected to be the start of an identifier.");
+    (void)isIdentifierStart;
+  }
 
   while (peekChar(ch)) {
-    if (std::isalpha(ch) || std::isdigit(ch) || ch == '_') {
+    if (isASCIIIdentifierPart(ch)) {
       name.push_back(ch);
       consumeChar();
+    } else if (!_reader->IsInASCIIBlock() && !IsASCII(ch) && lexUnicodeIdentifierPart(name)) {
+      continue;
     } else {
       break;
     }
@@ -288,7 +450,24 @@ void Lexer::lexIdentifier(SourceLocation startLoc) {
   _peekBuffer = std::make_unique<IdentifierToken>(std::move(name), range);
 }
 
+bool Lexer::lexUnicodeIdentifierPart(std::string& name) {
+  char32_t cp;
+  size_t length;
+  if (!_reader->PeekCodePoint(cp, length) || !IsJavaIdentifierPart(cp)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < length; ++i) {
+    char ch;
+    readChar(ch);
+    name.push_back(ch);
+  }
+  return true;
+}
+
 void Lexer::lexStringLiteral(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(StringLiteral);
+
   std::string literal;
   std::string content;
 
@@ -312,37 +491,16 @@ void Lexer::lexStringLiteral(SourceLocation startLoc) {
   SourceRange range { startLoc, endLoc };
 
   if (!closed) {
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, range, "Unclosed string literal.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnclosedStringLiteral, range });
     return;
   }
 
   _peekBuffer = std::make_unique<StringLiteralToken>(std::move(literal), std::move(content), range);
 }
 
-namespace {
-
-class UnexpectedCharDiagnosticsMessage : public DiagnosticsMessage {
-public:
-  explicit UnexpectedCharDiagnosticsMessage(char expected, char actual, SourceLocation loc)
-    : DiagnosticsMessage { DiagnosticsLevel::Error, loc },
-      _expected(expected),
-      _actual(actual)
-  { }
-
-  void DumpMessage(StreamWriter &output) const override {
-    output << "Unexpected input character: expected `" << _expected << '`'
-           << ", but found `" << _actual << '`';
-  }
-
-private:
-  char _expected;
-  char _actual;
-};
-
-} // namespace <anonymous>
-
 void Lexer::lexCharLiteral(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(CharLiteral);
+
   std::string literal;
   std::string content;
 
@@ -356,47 +514,40 @@ void Lexer::lexCharLiteral(SourceLocation startLoc) {
   ch = ensurePeekChar();
   if (ch != '\'') {
     auto loc = GetNextLocation();
-    UnexpectedCharDiagnosticsMessage diagMsg { '\'', ch, loc };
-    _ci.GetDiagnosticsEngine().Emit(diagMsg);
+    _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnexpectedChar, loc, '\'', ch });
     return;
   }
   consumeChar();
 
+  char32_t value = 0;
+  DecodeUTF8(content.data(), content.size(), value);
+
   auto endLoc = GetNextLocation();
   SourceRange range { startLoc, endLoc };
-  _peekBuffer = std::make_unique<CharacterLiteralToken>(std::move(literal), content[0], range);
+  _peekBuffer = std::make_unique<CharacterLiteralToken>(std::move(literal), value, range);
 }
 
 void Lexer::lexStringLiteralCharacter(std::string& literal, std::string& content) {
   auto ch = ensurePeekChar();
   if (ch == '\\') {
     lexStringEscapeSequence(literal, content);
-  } else {
+  } else if (IsASCII(ch)) {
     literal.push_back(ch);
     content.push_back(ch);
     consumeChar();
+  } else {
+    // Keep multi-byte UTF-8 sequences together so that character literals see whole code points.
+    char32_t cp;
+    size_t length;
+    _reader->PeekCodePoint(cp, length);
+    for (size_t i = 0; i < length; ++i) {
+      readChar(ch);
+      literal.push_back(ch);
+      content.push_back(ch);
+    }
   }
 }
 
-namespace {
-
-class UnknownEscapeSequenceDiagnosticsMessage : public DiagnosticsMessage {
-public:
-  explicit UnknownEscapeSequenceDiagnosticsMessage(char leader, SourceLocation startLoc)
-    : DiagnosticsMessage { DiagnosticsLevel::Error, startLoc },
-      _leader(leader)
-  { }
-
-  void DumpMessage(StreamWriter &output) const override {
-    output << "Unknown escape sequence: `\\" << _leader << '`';
-  }
-
-private:
-  char _leader;
-};
-
-} // namespace anonymous
-
 void Lexer::lexStringEscapeSequence(std::string& literal, std::string& content) {
   auto ch = ensurePeekChar();
   assert(ch == '\\' && "next character is not as expected to be the start of an escape sequence.");
@@ -433,6 +584,10 @@ void Lexer::lexStringEscapeSequence(std::string& literal, std::string& content)
       content.push_back('\'');
       break;
 
+    case '"':
+      content.push_back('"');
+      break;
+
     case '\\':
       content.push_back('\\');
       break;
@@ -446,8 +601,7 @@ void Lexer::lexStringEscapeSequence(std::string& literal, std::string& content)
       break;
 
     default: {
-      UnknownEscapeSequenceDiagnosticsMessage diagMsg { ch, startLoc };
-      _ci.GetDiagnosticsEngine().Emit(diagMsg);
+      _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnknownEscapeSequence, startLoc, ch });
     }
   }
 }
@@ -518,10 +672,7 @@ void Lexer::lexUnicodeCharLiteral(std::string& literal, std::string& content) {
   }
 
   auto value = parseHex(raw.c_str());
-  content.push_back(static_cast<char>(value & 0xFFu));
-  if (value & 0xFF00u) {
-    content.push_back(static_cast<char>((value & 0xFF00u) >> 8u));
-  }
+  EncodeUTF8(value, content);
 }
 
 void Lexer::lexOctCharLiteral(char leader, std::string& literal, std::string& content) {
@@ -546,13 +697,15 @@ void Lexer::lexOctCharLiteral(char leader, std::string& literal, std::string& co
 }
 
 void Lexer::lexNumberLiteralOrOperator(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(NumberLiteralOrOperator);
+
   auto ch = ensureReadChar();
   assert((ch == '+' || ch == '-') &&
       "next character is not as expected to be the start of a number literal or an operator.");
 
   char nextChar;
   if (peekChar(nextChar)) {
-    if (std::isdigit(nextChar)) {
+    if (isASCIIDigit(nextChar)) {
       lexNumberLiteral(startLoc, ch);
       return;
     } else { // nextChar is not a digit
@@ -608,7 +761,7 @@ int getBase(NumberLiteralPrefix prefix) {
 bool isDigitUnderPrefix(char ch, NumberLiteralPrefix prefix) {
   switch (prefix) {
     case NumberLiteralPrefix::None:
-      return std::isdigit(ch);
+      return isASCIIDigit(ch);
     case NumberLiteralPrefix::Oct:
       return isOct(ch);
     case NumberLiteralPrefix::Hex:
@@ -706,6 +859,8 @@ bool tryAppendIntegralDigit(T& value, int base, int d, bool& fit) {
 } // namespace <anonymous>
 
 void Lexer::lexNumberLiteral(SourceLocation startLoc, std::optional<char> sign) {
+  JVC_LEX_STATS_ROUTINE(NumberLiteral);
+
   // Regular expression for identifying number literals:
   //  [+-]?(0|0x|0X)?[0-9a-fA-F]+((\.?[0-9a-fA-F]+)([eE][+-]?\d+)?)?[lLfF]?
 
@@ -770,7 +925,7 @@ void Lexer::lexNumberLiteral(SourceLocation startLoc, std::optional<char> sign)
       exponentSign = (ch == '-');
     }
 
-    while (peekChar(ch) && std::isdigit(ch)) {
+    while (peekChar(ch) && isASCIIDigit(ch)) {
       consumeChar();
       auto d = parseHex(ch);
       tryAppendIntegralDigit(exponent, 10, d, exponentFit);
@@ -808,29 +963,21 @@ void Lexer::lexNumberLiteral(SourceLocation startLoc, std::optional<char> sign)
   auto endLoc = GetNextLocation();
   SourceRange range { startLoc, endLoc };
 
+  auto& diag = _ci.GetDiagnosticsEngine();
   if (suffix == NumberLiteralSuffix::Long && !i64Fit) {
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, range,
-        "Number literal cannot fit into 64-bit integer type.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    diag.Emit(Diagnostics { DiagnosticsKind::IntegerLiteralOutOfRange, range });
   }
 
   if (suffix == NumberLiteralSuffix::Float && !f64Fit) {
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, range,
-        "Number literal cannot fit into double precision floating point type.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    diag.Emit(Diagnostics { DiagnosticsKind::FloatLiteralOutOfRange, range });
   }
 
   if (suffix == NumberLiteralSuffix::None && !f64Fit && !i64Fit) {
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Error, range,
-        "Number literal cannot fit into either 64-bit integer type or double precision floating point type.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    diag.Emit(Diagnostics { DiagnosticsKind::NumberLiteralOutOfRange, range });
   }
 
   if (suffix == NumberLiteralSuffix::None && !i64Fit && isInteger) {
-    auto diagMsg = DiagnosticsMessage::CreateLiteral(DiagnosticsLevel::Warning, range,
-        "Number literal is written in integer form but cannot fit in 64-bit integer type. "
-        "Fallback to interpret it as a double precision floating point value instead.");
-    _ci.GetDiagnosticsEngine().Emit(*diagMsg);
+    diag.Emit(Diagnostics { DiagnosticsKind::IntegerLiteralAsDouble, range });
   }
 
   switch (suffix) {
@@ -851,26 +998,9 @@ void Lexer::lexNumberLiteral(SourceLocation startLoc, std::optional<char> sign)
   }
 }
 
-namespace {
-
-class UnknownDelimiterDiagnosticsMessage : public DiagnosticsMessage {
-public:
-  explicit UnknownDelimiterDiagnosticsMessage(char ch, SourceLocation loc)
-    : DiagnosticsMessage { DiagnosticsLevel::Error, loc },
-      _ch(ch)
-  { }
-
-  void DumpMessage(StreamWriter &output) const override {
-    output << "Unknown delimiter: `" << _ch << '`';
-  }
-
-private:
-  char _ch;
-};
-
-} // namespace <anonymous>
-
 void Lexer::lexDelimiter(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(Delimiter);
+
   auto ch = ensureReadChar();
   auto endLoc = GetNextLocation();
   SourceRange range { startLoc, endLoc };
@@ -918,34 +1048,16 @@ void Lexer::lexDelimiter(SourceLocation startLoc) {
       break;
 
     default: {
-      UnknownDelimiterDiagnosticsMessage diagMsg { ch, startLoc };
-      _ci.GetDiagnosticsEngine().Emit(diagMsg);
+      _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnknownDelimiter, startLoc, ch });
     }
   }
 
   _peekBuffer = std::make_unique<DelimiterToken>(kind, range);
 }
 
-namespace {
-
-class UnknownOperatorDiagnosticsMessage : public DiagnosticsMessage {
-public:
-  explicit UnknownOperatorDiagnosticsMessage(char ch, SourceLocation loc)
-    : DiagnosticsMessage { DiagnosticsLevel::Error, loc },
-      _ch(ch)
-  { }
-
-  void DumpMessage(StreamWriter &output) const override {
-    output << "Unknown operator: `" << _ch << '`';
-  }
-
-private:
-  char _ch;
-};
-
-} // namespace <anonymous>
-
 void Lexer::lexOperator(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(Operator);
+
   auto ch = ensureReadChar();
 
   OperatorKind kind;
@@ -1159,8 +1271,7 @@ void Lexer::lexOperator(SourceLocation startLoc) {
       break;
 
     default: {
-      UnknownOperatorDiagnosticsMessage diagMsg { ch, startLoc };
-      _ci.GetDiagnosticsEngine().Emit(diagMsg);
+      _ci.GetDiagnosticsEngine().Emit(Diagnostics { DiagnosticsKind::UnknownOperator, startLoc, ch });
     }
   }
 
@@ -1170,6 +1281,8 @@ void Lexer::lexOperator(SourceLocation startLoc) {
 }
 
 void Lexer::lexDivideOperatorOrComment(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(DivideOperatorOrComment);
+
   auto ch = ensureReadChar();
   assert(ch == '/' && "next character is not as expected to be the start of a divide operator or a comment.");
 
@@ -1214,6 +1327,8 @@ void Lexer::lexComment(SourceLocation startLoc) {
 }
 
 void Lexer::lexBlockComment(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(BlockComment);
+
   std::string content;
 
   char ch;
@@ -1235,10 +1350,12 @@ void Lexer::lexBlockComment(SourceLocation startLoc) {
 }
 
 void Lexer::lexLineComment(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(LineComment);
+
   std::string content;
 
   char ch;
-  while (peekChar(ch) && ch != '\n') {
+  while (peekChar(ch) && ch != '\n' && ch != '\r') {
     consumeChar();
     content.push_back(ch);
   }
@@ -1249,10 +1366,12 @@ void Lexer::lexLineComment(SourceLocation startLoc) {
 }
 
 void Lexer::lexWhitespace(SourceLocation startLoc) {
+  JVC_LEX_STATS_ROUTINE(Whitespace);
+
   auto ch = ensureReadChar();
-  assert(std::isspace(ch) && "next character is not as expected to be the start of a whitespace token.");
+  assert(isWhitespace(ch) && "next character is not as expected to be the start of a whitespace token.");
 
-  while (peekChar(ch) && std::isspace(ch)) {
+  while (peekChar(ch) && isWhitespace(ch)) {
     consumeChar();
   }
 
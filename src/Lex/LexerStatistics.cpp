@@ -0,0 +1,262 @@
+//
+// Created by Sirui Mu on 2019/12/31.
+//
+
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/Stream.h"
+#include "Lex/LexerStatistics.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define JVC_HAS_RDTSC
+#endif
+
+namespace jvc {
+
+namespace {
+
+#define COUNT_VARIANT(v) + 1
+constexpr const size_t TokenKindCount = 0 JVC_TOKEN_KIND_LIST(COUNT_VARIANT);
+constexpr const size_t KeywordCount = 0 JVC_KEYWORD_LIST(COUNT_VARIANT);
+constexpr const size_t LiteralKindCount = 0 JVC_LITERAL_TYPE_LIST(COUNT_VARIANT);
+constexpr const size_t DelimiterCount = 0 JVC_DELIMITER_LIST(COUNT_VARIANT);
+constexpr const size_t OperatorCount = 0 JVC_OPERATOR_LIST(COUNT_VARIANT);
+constexpr const size_t RoutineCount = 0 JVC_LEXER_ROUTINE_LIST(COUNT_VARIANT);
+#undef COUNT_VARIANT
+
+const char* RoutineNames[] = {
+#define DEF_ROUTINE_NAME(v) "lex" #v,
+  JVC_LEXER_ROUTINE_LIST(DEF_ROUTINE_NAME)
+#undef DEF_ROUTINE_NAME
+};
+
+constexpr const size_t PreviewLength = 40;
+
+std::string makePreview(const std::string& text) {
+  std::string preview;
+  for (auto ch : text) {
+    if (preview.size() == PreviewLength) {
+      preview += "...";
+      break;
+    }
+    preview.push_back(ch == '\n' || ch == '\r' || ch == '\t' ? ' ' : ch);
+  }
+  return preview;
+}
+
+void insertLongToken(std::vector<LexerStatistics::LongToken>& tokens, LexerStatistics::LongToken token) {
+  if (tokens.size() == LexerStatistics::LongestTokensCount && tokens.back().Bytes >= token.Bytes) {
+    return;
+  }
+
+  auto pos = std::upper_bound(tokens.begin(), tokens.end(), token.Bytes,
+      [] (size_t bytes, const LexerStatistics::LongToken& t) { return bytes > t.Bytes; });
+  tokens.insert(pos, std::move(token));
+  if (tokens.size() > LexerStatistics::LongestTokensCount) {
+    tokens.pop_back();
+  }
+}
+
+double percentOf(uint64_t value, uint64_t total) {
+  return total ? 100.0 * static_cast<double>(value) / static_cast<double>(total) : 0.0;
+}
+
+template <typename NameFunc>
+void dumpCounts(StreamWriter& o, const char* title, const std::vector<uint64_t>& counts, uint64_t total,
+                NameFunc name) {
+  std::vector<size_t> order;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    if (counts[i]) {
+      order.push_back(i);
+    }
+  }
+  if (order.empty()) {
+    return;
+  }
+  std::stable_sort(order.begin(), order.end(), [&counts] (size_t lhs, size_t rhs) {
+    return counts[lhs] > counts[rhs];
+  });
+
+  o << title << ":\n";
+  auto indentGuard = o.PushIndent();
+  for (auto i : order) {
+    o << name(i) << ": " << counts[i] << " (" << percentOf(counts[i], total) << "%)\n";
+  }
+}
+
+void dumpLongTokens(StreamWriter& o, const char* title, const std::vector<LexerStatistics::LongToken>& tokens) {
+  if (tokens.empty()) {
+    return;
+  }
+
+  o << title << ":\n";
+  auto indentGuard = o.PushIndent();
+  for (const auto& token : tokens) {
+    o << token.Bytes << " bytes, " << GetTokenKindName(token.Kind) << " at ";
+    token.Location.Dump(o);
+    if (!token.Preview.empty()) {
+      o << ": `" << token.Preview << '`';
+    }
+    o << '\n';
+  }
+}
+
+} // namespace <anonymous>
+
+bool LexerStatistics::IsEnabled() {
+#ifdef JVC_LEX_STATS
+  return true;
+#else
+  return false;
+#endif
+}
+
+uint64_t LexerStatistics::GetAllocationCount() {
+#ifdef JVC_LEX_STATS
+  return MemoryUsage::GetThreadAllocationCount();
+#else
+  return 0;
+#endif
+}
+
+uint64_t LexerStatistics::ReadTimestamp() {
+#ifdef JVC_HAS_RDTSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+const char* LexerStatistics::GetTimestampUnit() {
+#ifdef JVC_HAS_RDTSC
+  return "cycles";
+#else
+  return "ns";
+#endif
+}
+
+LexerStatistics::LexerStatistics()
+    : _tokens(0),
+      _bytes(0),
+      _allocations(0),
+      _ticks(0),
+      _tokenKinds(TokenKindCount),
+      _keywords(KeywordCount),
+      _literals(LiteralKindCount),
+      _delimiters(DelimiterCount),
+      _operators(OperatorCount),
+      _routines(RoutineCount)
+{ }
+
+void LexerStatistics::RecordToken(const Token& token, size_t bytes, uint64_t allocations, uint64_t ticks) {
+  ++_tokens;
+  _bytes += bytes;
+  _allocations += allocations;
+  _ticks += ticks;
+  ++_tokenKinds[static_cast<int>(token.kind())];
+
+  std::string preview;
+  switch (token.kind()) {
+    case TokenKind::Keyword:
+      ++_keywords[static_cast<int>(static_cast<const KeywordToken &>(token).keywordKind())];
+      break;
+    case TokenKind::Identifier:
+      preview = makePreview(static_cast<const IdentifierToken &>(token).name());
+      break;
+    case TokenKind::Literal:
+      ++_literals[static_cast<int>(static_cast<const LiteralToken &>(token).literalKind())];
+      break;
+    case TokenKind::Delimiter:
+      ++_delimiters[static_cast<int>(static_cast<const DelimiterToken &>(token).delimiter())];
+      break;
+    case TokenKind::Operator:
+      ++_operators[static_cast<int>(static_cast<const OperatorToken &>(token).operatorKind())];
+      break;
+    case TokenKind::Comment:
+      insertLongToken(_longestComments, LongToken {
+          bytes, token.kind(), token.range().start(),
+          makePreview(static_cast<const CommentToken &>(token).content()) });
+      return;
+    default:
+      break;
+  }
+
+  if (!token.IsWhitespace()) {
+    insertLongToken(_longestTokens, LongToken { bytes, token.kind(), token.range().start(), std::move(preview) });
+  }
+}
+
+void LexerStatistics::Merge(const LexerStatistics& other) {
+  _tokens += other._tokens;
+  _bytes += other._bytes;
+  _allocations += other._allocations;
+  _ticks += other._ticks;
+
+  auto mergeCounts = [] (std::vector<uint64_t>& lhs, const std::vector<uint64_t>& rhs) {
+    for (size_t i = 0; i < lhs.size(); ++i) {
+      lhs[i] += rhs[i];
+    }
+  };
+  mergeCounts(_tokenKinds, other._tokenKinds);
+  mergeCounts(_keywords, other._keywords);
+  mergeCounts(_literals, other._literals);
+  mergeCounts(_delimiters, other._delimiters);
+  mergeCounts(_operators, other._operators);
+
+  for (size_t i = 0; i < _routines.size(); ++i) {
+    _routines[i].Calls += other._routines[i].Calls;
+    _routines[i].Ticks += other._routines[i].Ticks;
+  }
+
+  for (const auto& token : other._longestTokens) {
+    insertLongToken(_longestTokens, token);
+  }
+  for (const auto& comment : other._longestComments) {
+    insertLongToken(_longestComments, comment);
+  }
+}
+
+void LexerStatistics::Dump(StreamWriter& o) const {
+  o << "Lexer statistics:\n";
+  auto indentGuard = o.PushIndent();
+
+  o << "Tokens: " << _tokens << '\n';
+  o << "Bytes: " << _bytes << '\n';
+  o << "Bytes per token: " << (_tokens ? static_cast<double>(_bytes) / _tokens : 0.0) << '\n';
+  o << "Heap allocations: " << _allocations << '\n';
+  o << "Heap allocations per token: " << (_tokens ? static_cast<double>(_allocations) / _tokens : 0.0) << '\n';
+
+  dumpCounts(o, "Tokens by kind", _tokenKinds, _tokens,
+      [] (size_t i) { return GetTokenKindName(static_cast<TokenKind>(i)); });
+  dumpCounts(o, "Keywords", _keywords, _tokenKinds[static_cast<int>(TokenKind::Keyword)],
+      [] (size_t i) { return GetKeywordName(static_cast<KeywordKind>(i)); });
+  dumpCounts(o, "Literals", _literals, _tokenKinds[static_cast<int>(TokenKind::Literal)],
+      [] (size_t i) { return GetLiteralKindName(static_cast<LiteralKind>(i)); });
+  dumpCounts(o, "Delimiters", _delimiters, _tokenKinds[static_cast<int>(TokenKind::Delimiter)],
+      [] (size_t i) { return GetDelimiterName(static_cast<DelimiterKind>(i)); });
+  dumpCounts(o, "Operators", _operators, _tokenKinds[static_cast<int>(TokenKind::Operator)],
+      [] (size_t i) { return GetOperatorName(static_cast<OperatorKind>(i)); });
+
+  o << "Lexing time: " << _ticks << ' ' << GetTimestampUnit() << '\n';
+  o << "Time by routine (inclusive, " << GetTimestampUnit() << "):\n";
+  {
+    auto routineIndentGuard = o.PushIndent();
+    for (size_t i = 0; i < _routines.size(); ++i) {
+      const auto& routine = _routines[i];
+      if (!routine.Calls) {
+        continue;
+      }
+      o << RoutineNames[i] << ": " << routine.Ticks << " (" << percentOf(routine.Ticks, _ticks) << "%), "
+        << routine.Calls << " calls, " << static_cast<double>(routine.Ticks) / routine.Calls << " per call\n";
+    }
+  }
+
+  dumpLongTokens(o, "Longest tokens", _longestTokens);
+  dumpLongTokens(o, "Longest comments", _longestComments);
+}
+
+} // namespace jvc
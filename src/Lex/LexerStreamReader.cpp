@@ -2,20 +2,48 @@
 // Created by Sirui Mu on 2019/12/20.
 //
 
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/Statistic.h"
+#include "Infrastructure/Unicode.h"
 #include "LexerStreamReader.h"
 
+#include <cstring>
 #include <functional>
+#include <string>
 
 namespace jvc {
 
+namespace {
+
+JVC_STATISTIC(LexerReaderRefills, "Number of times the lexer reader buffer was refilled from its source stream");
+JVC_STATISTIC(LexerReaderBytes, "Number of bytes read by the lexer reader from its source stream");
+JVC_MEMORY_GAUGE(LexerReaderBufferBytes, "Bytes held by the read buffers of lexers");
+
+} // namespace <anonymous>
+
 class Lexer::LexerStreamReader::LexerStreamReaderBuffer {
 public:
   explicit LexerStreamReaderBuffer(std::unique_ptr<InputStream> source)
     : _source(std::move(source)),
       _buffer(std::make_unique<char[]>(BufferCapacity)),
       _readPtr(0),
-      _bufferSize(0)
-  { }
+      _bufferSize(0),
+      _bufferOffset(0),
+      _asciiBlock(true),
+      _hasBackslash(false)
+  {
+    LexerReaderBufferBytes.Add(BufferCapacity);
+  }
+
+  LexerStreamReaderBuffer(const LexerStreamReaderBuffer &) = delete;
+  LexerStreamReaderBuffer(LexerStreamReaderBuffer &&) = delete;
+
+  LexerStreamReaderBuffer& operator=(const LexerStreamReaderBuffer &) = delete;
+  LexerStreamReaderBuffer& operator=(LexerStreamReaderBuffer &&) = delete;
+
+  ~LexerStreamReaderBuffer() {
+    LexerReaderBufferBytes.Subtract(BufferCapacity);
+  }
 
   bool PeekChar(char& ch) {
     if (_readPtr == _bufferSize) {
@@ -37,6 +65,33 @@ public:
     return true;
   }
 
+  bool PeekAt(size_t offset, char& ch) {
+    if (_readPtr + offset >= _bufferSize && !ensureAvailable(offset + 1)) {
+      return false;
+    }
+    ch = _buffer[_readPtr + offset];
+    return true;
+  }
+
+  void Consume(size_t count) {
+    _readPtr += count;
+  }
+
+  [[nodiscard]]
+  const char* data() const { return _buffer.get() + _readPtr; }
+
+  [[nodiscard]]
+  size_t available() const { return _bufferSize - _readPtr; }
+
+  [[nodiscard]]
+  size_t offset() const { return _bufferOffset + _readPtr; }
+
+  [[nodiscard]]
+  bool IsASCIIBlock() const { return _asciiBlock; }
+
+  [[nodiscard]]
+  bool HasBackslash() const { return _hasBackslash; }
+
 private:
   constexpr static const int BufferCapacity = 4096;
 
@@ -44,25 +99,254 @@ private:
   std::unique_ptr<char[]> _buffer;
   size_t _readPtr;
   size_t _bufferSize;
+  // Offset of the first byte in the buffer from the start of the source stream.
+  size_t _bufferOffset;
+  bool _asciiBlock;
+  bool _hasBackslash;
 
   void loadNextBlock() {
+    _bufferOffset += _bufferSize;
     _bufferSize = _source->Read(_buffer.get(), BufferCapacity);
     _readPtr = 0;
+    ++LexerReaderRefills;
+    LexerReaderBytes += _bufferSize;
+    analyzeBlock();
+  }
+
+  bool ensureAvailable(size_t count) {
+    if (count > BufferCapacity) {
+      return false;
+    }
+
+    auto remaining = available();
+    if (remaining >= count) {
+      return true;
+    }
+
+    std::memmove(_buffer.get(), data(), remaining);
+    _bufferOffset += _readPtr;
+    _readPtr = 0;
+    _bufferSize = remaining;
+    while (_bufferSize < count) {
+      auto read = _source->Read(_buffer.get() + _bufferSize, BufferCapacity - _bufferSize);
+      if (!read) {
+        break;
+      }
+      _bufferSize += read;
+      LexerReaderBytes += read;
+    }
+    ++LexerReaderRefills;
+
+    analyzeBlock();
+    return _bufferSize >= count;
+  }
+
+  void analyzeBlock() {
+    _asciiBlock = IsASCII(_buffer.get(), _bufferSize);
+    _hasBackslash = std::memchr(_buffer.get(), '\\', _bufferSize) != nullptr;
   }
 };
 
-Lexer::LexerStreamReader::LexerStreamReader(std::unique_ptr<InputStream> inner)
-  : _buffer(std::make_unique<LexerStreamReaderBuffer>(std::move(inner)))
+Lexer::LexerStreamReader::LexerStreamReader(std::unique_ptr<InputStream> inner, bool translateUnicodeEscapes)
+  : _buffer(std::make_unique<LexerStreamReaderBuffer>(std::move(inner))),
+    _translateUnicodeEscapes(translateUnicodeEscapes),
+    _pending { },
+    _pendingWidths { },
+    _pendingHead(0),
+    _pendingSize(0),
+    _backslashRun(0)
 { }
 
 Lexer::LexerStreamReader::~LexerStreamReader() = default;
 
 bool Lexer::LexerStreamReader::PeekChar(char &ch) {
-  return _buffer->PeekChar(ch);
+  if (_pendingSize) {
+    ch = _pending[_pendingHead];
+    return true;
+  }
+
+  if (!_buffer->PeekChar(ch)) {
+    return false;
+  }
+  if (!_translateUnicodeEscapes || !_buffer->HasBackslash()) {
+    return true;
+  }
+
+  if (!translateNext()) {
+    return false;
+  }
+  ch = _pending[_pendingHead];
+  return true;
 }
 
 bool Lexer::LexerStreamReader::ReadChar(char &ch) {
-  return _buffer->ReadChar(ch);
+  int width;
+  return ReadChar(ch, width);
+}
+
+bool Lexer::LexerStreamReader::ReadChar(char &ch, int &width) {
+  if (!_pendingSize) {
+    if (!_buffer->PeekChar(ch)) {
+      return false;
+    }
+    if (!_translateUnicodeEscapes || !_buffer->HasBackslash()) {
+      // Fast path: nothing in the current block can start a unicode escape.
+      _buffer->Consume(1);
+      _backslashRun = 0;
+      width = 1;
+      return true;
+    }
+    if (!translateNext()) {
+      return false;
+    }
+  }
+
+  ch = _pending[_pendingHead];
+  width = _pendingWidths[_pendingHead];
+  ++_pendingHead;
+  --_pendingSize;
+  return true;
+}
+
+bool Lexer::LexerStreamReader::PeekCodePoint(char32_t &cp, size_t &length) {
+  char ch;
+  if (!PeekChar(ch)) {
+    return false;
+  }
+
+  if (_pendingSize) {
+    length = DecodeUTF8(_pending.data() + _pendingHead, _pendingSize, cp);
+    return true;
+  }
+
+  // Make sure that a whole UTF-8 sequence is available in the raw buffer.
+  _buffer->PeekAt(3, ch);
+  length = DecodeUTF8(_buffer->data(), _buffer->available(), cp);
+  return true;
+}
+
+size_t Lexer::LexerStreamReader::GetOffset() const {
+  // Characters in the pending queue have already been consumed from the underlying stream.
+  size_t pendingWidth = 0;
+  for (size_t i = _pendingHead; i < _pendingHead + _pendingSize; ++i) {
+    pendingWidth += _pendingWidths[i];
+  }
+  return _buffer->offset() - pendingWidth;
+}
+
+bool Lexer::LexerStreamReader::IsInASCIIBlock() const {
+  return _pendingSize == 0 && _buffer->IsASCIIBlock();
+}
+
+namespace {
+
+bool isHexDigit(char ch) {
+  return (ch >= '0' && ch <= '9') ||
+      (ch >= 'A' && ch <= 'F') ||
+      (ch >= 'a' && ch <= 'f');
+}
+
+unsigned parseHexDigit(char ch) {
+  if (ch >= '0' && ch <= '9') {
+    return ch - '0';
+  } else if (ch >= 'a' && ch <= 'f') {
+    return ch - 'a' + 10;
+  } else {
+    return ch - 'A' + 10;
+  }
+}
+
+} // namespace <anonymous>
+
+size_t Lexer::LexerStreamReader::matchUnicodeEscape(size_t offset, char32_t &unit) {
+  // UnicodeEscape:
+  //    \ UnicodeMarker HexDigit HexDigit HexDigit HexDigit
+  // UnicodeMarker:
+  //    u {u}
+  char ch;
+  if (!_buffer->PeekAt(offset, ch) || ch != '\\') {
+    return 0;
+  }
+
+  auto i = offset + 1;
+  while (_buffer->PeekAt(i, ch) && ch == 'u') {
+    ++i;
+  }
+  if (i == offset + 1) {
+    return 0;
+  }
+
+  unit = 0;
+  for (auto digit = 0; digit < 4; ++digit, ++i) {
+    if (!_buffer->PeekAt(i, ch) || !isHexDigit(ch)) {
+      return 0;
+    }
+    unit = (unit << 4u) | parseHexDigit(ch);
+  }
+
+  return i - offset;
+}
+
+bool Lexer::LexerStreamReader::translateNext() {
+  char ch;
+  if (!_buffer->PeekChar(ch)) {
+    return false;
+  }
+
+  _pendingHead = 0;
+  _pendingSize = 0;
+
+  // A backslash starts a unicode escape only if it is preceded by an even number of raw backslashes.
+  if (ch == '\\' && _backslashRun % 2 == 0) {
+    char32_t unit;
+    auto width = matchUnicodeEscape(0, unit);
+    if (width) {
+      auto cp = unit;
+      if (unit >= 0xD800 && unit <= 0xDBFF) {
+        char32_t low;
+        auto lowWidth = matchUnicodeEscape(width, low);
+        if (lowWidth && low >= 0xDC00 && low <= 0xDFFF) {
+          cp = 0x10000 + ((unit - 0xD800) << 10u) + (low - 0xDC00);
+          width += lowWidth;
+        } else {
+          cp = ReplacementCharacter;
+        }
+      } else if (unit >= 0xDC00 && unit <= 0xDFFF) {
+        cp = ReplacementCharacter;
+      }
+
+      _buffer->Consume(width);
+      _backslashRun = 0;
+
+      std::string encoded;
+      EncodeUTF8(cp, encoded);
+      for (size_t i = 0; i < encoded.size(); ++i) {
+        _pending[i] = encoded[i];
+        _pendingWidths[i] = i == 0 ? static_cast<int>(width) : 0;
+      }
+      _pendingSize = encoded.size();
+      return true;
+    }
+  }
+
+  // Move a whole UTF-8 sequence into the pending queue so that it can be decoded by PeekCodePoint.
+  auto length = GetUTF8SequenceLength(ch);
+  if (length == 0) {
+    length = 1;
+  }
+  for (size_t i = 0; i < length; ++i) {
+    char next;
+    if (!_buffer->PeekAt(i, next)) {
+      break;
+    }
+    _pending[i] = next;
+    _pendingWidths[i] = 1;
+    ++_pendingSize;
+  }
+  _buffer->Consume(_pendingSize);
+
+  _backslashRun = ch == '\\' ? _backslashRun + 1 : 0;
+  return true;
 }
 
 } // namespace jvc
@@ -8,6 +8,7 @@
 #include "Infrastructure/Stream.h"
 #include "Lex/Lexer.h"
 
+#include <array>
 #include <memory>
 #include <optional>
 
@@ -20,8 +21,11 @@ public:
   /**
    * @brief Initialize a new @see LexerStreamReader object.
    * @param inner the underlying input stream.
+   * @param translateUnicodeEscapes should the reader translate unicode escapes (JLS §3.3) in the underlying input
+   * stream? Callers should pass false if they know the input contains no `\u` sequences so that the reader can stay on
+   * the raw byte path.
    */
-  explicit LexerStreamReader(std::unique_ptr<InputStream> inner);
+  explicit LexerStreamReader(std::unique_ptr<InputStream> inner, bool translateUnicodeEscapes = false);
 
   /**
    * @brief Destroy this @see LexerStreamReader object.
@@ -44,8 +48,67 @@ public:
    */
   bool ReadChar(char& ch);
 
+  /**
+   * @brief Get next character available and consume it.
+   * @param ch output parameter, specifying the next character.
+   * @param width output parameter, specifying the number of bytes the character occupies in the underlying input
+   * stream. This is 1 for ordinary characters; a unicode escape reports its whole width on its first UTF-8 byte and 0
+   * on the remaining ones.
+   * @return whether the next character is available. This function returns false when EOS has been hit on the
+   * underlying input stream.
+   */
+  bool ReadChar(char& ch, int& width);
+
+  /**
+   * @brief Decode the UTF-8 encoded code point at the read pointer. This function does not consume any characters.
+   * @param cp output parameter, the decoded code point.
+   * @param length output parameter, number of characters the code point occupies in the output of this reader.
+   * @return whether a code point is available. This function returns false when EOS has been hit on the underlying
+   * input stream.
+   */
+  bool PeekCodePoint(char32_t& cp, size_t& length);
+
+  /**
+   * @brief Get the offset of the read pointer from the start of the underlying input stream, in bytes.
+   * @return the offset of the read pointer.
+   */
+  [[nodiscard]]
+  size_t GetOffset() const;
+
+  /**
+   * @brief Determine whether the block the read pointer is currently in consists of ASCII characters only. Lexers can
+   * skip all Unicode handling while this function returns true.
+   * @return whether the current block consists of ASCII characters only.
+   */
+  [[nodiscard]]
+  bool IsInASCIIBlock() const;
+
 private:
   std::unique_ptr<LexerStreamReaderBuffer> _buffer;
+  bool _translateUnicodeEscapes;
+
+  // Characters that have been translated from the underlying input stream but not yet consumed.
+  std::array<char, 4> _pending;
+  std::array<int, 4> _pendingWidths;
+  size_t _pendingHead;
+  size_t _pendingSize;
+
+  // Number of contiguous raw backslashes right before the raw read pointer.
+  size_t _backslashRun;
+
+  /**
+   * @brief Translate the next character or unicode escape in the underlying input stream into the pending queue.
+   * @return whether any characters were translated.
+   */
+  bool translateNext();
+
+  /**
+   * @brief Try to match a unicode escape at the given offset from the raw read pointer.
+   * @param offset offset from the raw read pointer.
+   * @param unit output parameter, the UTF-16 code unit denoted by the escape.
+   * @return width of the unicode escape, in bytes. Returns 0 if no unicode escape is present.
+   */
+  size_t matchUnicodeEscape(size_t offset, char32_t& unit);
 };
 
 // class Lexer::LexerStreamReader
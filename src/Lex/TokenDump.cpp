@@ -4,21 +4,87 @@
 
 #include "Lex/Token.h"
 #include "Infrastructure/Stream.h"
+#include "Infrastructure/Unicode.h"
 
 namespace jvc {
 
 namespace {
 
+const char* TokenKindNames[] = {
+#define DEF_TOKEN_KIND_NAME(v) #v,
+  JVC_TOKEN_KIND_LIST(DEF_TOKEN_KIND_NAME)
+#undef DEF_TOKEN_KIND_NAME
+};
+
 const char* KeywordNames[] = {
 #define DEF_KEYWORD_NAME(kw) #kw,
   JVC_KEYWORD_LIST(DEF_KEYWORD_NAME)
 #undef DEF_KEYWORD_NAME
 };
 
-} // namespace jvc
+const char* LiteralKindNames[] = {
+#define DEF_LITERAL_KIND_NAME(v) #v,
+  JVC_LITERAL_TYPE_LIST(DEF_LITERAL_KIND_NAME)
+#undef DEF_LITERAL_KIND_NAME
+};
+
+/**
+ * @brief Get the number of bytes the given string holds on the heap, which is 0 for short strings stored inline.
+ */
+size_t getHeapMemoryUsage(const std::string& s) {
+  return s.capacity() > std::string { }.capacity() ? s.capacity() + 1 : 0;
+}
+
+} // namespace <anonymous>
+
+const char* GetTokenKindName(TokenKind kind) {
+  return TokenKindNames[static_cast<int>(kind)];
+}
+
+const char* GetKeywordName(KeywordKind kind) {
+  return KeywordNames[static_cast<int>(kind)];
+}
+
+const char* GetLiteralKindName(LiteralKind kind) {
+  return LiteralKindNames[static_cast<int>(kind)];
+}
+
+size_t GetTokenMemoryUsage(const Token& token) {
+  switch (token.kind()) {
+    case TokenKind::Keyword:
+      return sizeof(KeywordToken);
+    case TokenKind::Identifier:
+      return sizeof(IdentifierToken) + getHeapMemoryUsage(static_cast<const IdentifierToken &>(token).name());
+    case TokenKind::Literal: {
+      const auto& literal = static_cast<const LiteralToken &>(token);
+      switch (literal.literalKind()) {
+        case LiteralKind::Number:
+          return sizeof(NumberLiteralToken);
+        case LiteralKind::String: {
+          const auto& string = static_cast<const StringLiteralToken &>(literal);
+          return sizeof(StringLiteralToken) + getHeapMemoryUsage(string.source()) +
+              getHeapMemoryUsage(string.content());
+        }
+        case LiteralKind::Character:
+          return sizeof(CharacterLiteralToken) +
+              getHeapMemoryUsage(static_cast<const CharacterLiteralToken &>(literal).source());
+      }
+      break;
+    }
+    case TokenKind::Delimiter:
+      return sizeof(DelimiterToken);
+    case TokenKind::Operator:
+      return sizeof(OperatorToken);
+    case TokenKind::Comment:
+      return sizeof(CommentToken) + getHeapMemoryUsage(static_cast<const CommentToken &>(token).content());
+    case TokenKind::Whitespace:
+      return sizeof(WhitespaceToken);
+  }
+  return sizeof(Token);
+}
 
 void KeywordToken::Dump(StreamWriter& o) const {
-  o << "Keyword `" << KeywordNames[static_cast<int>(_keywordKind)] << "` (";
+  o << "Keyword `" << GetKeywordName(_keywordKind) << "` (";
   range().Dump(o);
   o << ")";
 }
@@ -49,7 +115,9 @@ void StringLiteralToken::Dump(StreamWriter &o) const {
 
 
 void CharacterLiteralToken::Dump(StreamWriter &o) const {
-  o << "CharacterLiteral `" << _ch << "` (";
+  std::string encoded;
+  EncodeUTF8(_ch, encoded);
+  o << "CharacterLiteral `" << encoded << "` (";
   range().Dump(o);
   o << ")";
 }
@@ -64,8 +132,12 @@ const char* DelimiterNames[] = {
 
 } // namespace <anonymous>
 
+const char* GetDelimiterName(DelimiterKind kind) {
+  return DelimiterNames[static_cast<int>(kind)];
+}
+
 void DelimiterToken::Dump(StreamWriter &o) const {
-  o << "Delimiter <" << DelimiterNames[static_cast<int>(_kind)] << "> (";
+  o << "Delimiter <" << GetDelimiterName(_kind) << "> (";
   range().Dump(o);
   o << ")";
 }
@@ -80,8 +152,12 @@ const char* OperatorNames[] = {
 
 } // namespace <anonymous>
 
+const char* GetOperatorName(OperatorKind kind) {
+  return OperatorNames[static_cast<int>(kind)];
+}
+
 void OperatorToken::Dump(StreamWriter &o) const {
-  o << "Operator <" << OperatorNames[static_cast<int>(_kind)] << "> (";
+  o << "Operator <" << GetOperatorName(_kind) << "> (";
   range().Dump(o);
   o << ")";
 }
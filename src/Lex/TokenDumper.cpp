@@ -0,0 +1,330 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#include "Infrastructure/Json.h"
+#include "Infrastructure/Stream.h"
+#include "Infrastructure/Unicode.h"
+#include "Frontend/SourceManager.h"
+#include "Lex/Token.h"
+#include "Lex/TokenDumper.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jvc {
+
+namespace {
+
+/**
+ * @brief The format-independent description of a token.
+ */
+struct TokenFields {
+  uint8_t SubKind = 0;
+  const char* SubKindName = nullptr;
+  uint16_t Flags = 0;
+  uint64_t Value = 0;
+  bool HasPayload = false;
+  std::string_view Payload;
+};
+
+TokenFields getTokenFields(const Token& token) {
+  TokenFields fields { };
+  switch (token.kind()) {
+    case TokenKind::Keyword: {
+      auto kind = static_cast<const KeywordToken &>(token).keywordKind();
+      fields.SubKind = static_cast<uint8_t>(kind);
+      fields.SubKindName = GetKeywordName(kind);
+      break;
+    }
+    case TokenKind::Identifier:
+      fields.HasPayload = true;
+      fields.Payload = static_cast<const IdentifierToken &>(token).name();
+      break;
+    case TokenKind::Literal: {
+      const auto& literal = static_cast<const LiteralToken &>(token);
+      fields.SubKind = static_cast<uint8_t>(literal.literalKind());
+      fields.SubKindName = GetLiteralKindName(literal.literalKind());
+      if (literal.IsNumber()) {
+        const auto& number = static_cast<const NumberLiteralToken &>(token);
+        fields.Flags = static_cast<uint16_t>((number.IsInteger() ? TokenRecord::IntegerFlag : 0u) |
+            (static_cast<unsigned>(number.prefix()) << 1u) | (static_cast<unsigned>(number.suffix()) << 3u));
+        if (number.IsInteger()) {
+          auto value = number.AsInt64();
+          std::memcpy(&fields.Value, &value, sizeof(value));
+        } else {
+          auto value = number.AsDouble();
+          std::memcpy(&fields.Value, &value, sizeof(value));
+        }
+      } else if (literal.IsString()) {
+        fields.HasPayload = true;
+        fields.Payload = static_cast<const StringLiteralToken &>(token).content();
+      } else {
+        fields.Value = static_cast<const CharacterLiteralToken &>(token).value();
+      }
+      break;
+    }
+    case TokenKind::Delimiter: {
+      auto kind = static_cast<const DelimiterToken &>(token).delimiter();
+      fields.SubKind = static_cast<uint8_t>(kind);
+      fields.SubKindName = GetDelimiterName(kind);
+      break;
+    }
+    case TokenKind::Operator: {
+      auto kind = static_cast<const OperatorToken &>(token).operatorKind();
+      fields.SubKind = static_cast<uint8_t>(kind);
+      fields.SubKindName = GetOperatorName(kind);
+      break;
+    }
+    case TokenKind::Comment: {
+      const auto& comment = static_cast<const CommentToken &>(token);
+      fields.SubKind = static_cast<uint8_t>(comment.commentKind());
+      fields.SubKindName = comment.commentKind() == CommentKind::LineComment ? "LineComment" : "BlockComment";
+      fields.HasPayload = true;
+      fields.Payload = comment.content();
+      break;
+    }
+    case TokenKind::Whitespace:
+      break;
+  }
+  return fields;
+}
+
+/**
+ * @brief Map source locations of the tokens of a single source code file to byte offsets, caching the start of the
+ * most recent line since consecutive tokens are usually on the same line.
+ */
+class OffsetMapper {
+public:
+  explicit OffsetMapper(const SourceFileInfo& sourceFile)
+    : _sourceFile(sourceFile),
+      _row(0),
+      _lineStart(0)
+  { }
+
+  [[nodiscard]]
+  uint64_t GetOffset(SourceLocation loc) {
+    if (loc.row() != _row) {
+      size_t lineStart;
+      if (!_sourceFile.GetOffsetOfLoc(SourceLocation { _sourceFile.id(), loc.row(), 1 }, lineStart)) {
+        return TokenRecord::UnknownOffset;
+      }
+      _row = loc.row();
+      _lineStart = lineStart;
+    }
+    return _lineStart + loc.col() - 1;
+  }
+
+private:
+  const SourceFileInfo& _sourceFile;
+  uint64_t _row;
+  uint64_t _lineStart;
+};
+
+class TextTokenDumper : public TokenDumper {
+public:
+  explicit TextTokenDumper(const SourceFileInfo& sourceFile, StreamWriter& output)
+    : _output(output),
+      _indentGuard((output << "Tokenization of source file: " << sourceFile.path() << "\n").PushIndent())
+  { }
+
+  void Dump(const Token& token) override {
+    token.Dump(_output);
+    _output << '\n';
+  }
+
+  void Finish() override {
+    _output << '\n';
+    _indentGuard.pop();
+  }
+
+private:
+  StreamWriter& _output;
+  StreamWriterIndentGuard _indentGuard;
+};
+
+class JsonLinesTokenDumper : public TokenDumper {
+public:
+  explicit JsonLinesTokenDumper(const SourceFileInfo& sourceFile, StreamWriter& output)
+    : _sourceFile(sourceFile),
+      _output(output.stream()),
+      _offsets(sourceFile)
+  {
+    _record.append("{\"type\":\"file\",\"file\":");
+    AppendJsonNumber(_record, sourceFile.id());
+    _record.append(",\"path\":");
+    AppendJsonString(_record, sourceFile.path());
+    _record.append("}\n");
+    _output.Write(_record.data(), _record.size());
+  }
+
+  void Dump(const Token& token) override {
+    auto fields = getTokenFields(token);
+    auto range = token.range();
+    auto offset = _offsets.GetOffset(range.start());
+    auto endOffset = _offsets.GetOffset(range.end());
+
+    _record.clear();
+    _record.append("{\"type\":\"token\",\"file\":");
+    AppendJsonNumber(_record, _sourceFile.id());
+    _record.append(",\"kind\":\"").append(GetTokenKindName(token.kind())).push_back('"');
+    if (fields.SubKindName) {
+      _record.append(",\"subkind\":\"").append(fields.SubKindName).push_back('"');
+    }
+    if (offset != TokenRecord::UnknownOffset && endOffset != TokenRecord::UnknownOffset) {
+      AppendJsonField(_record, "offset", offset);
+      AppendJsonField(_record, "length", endOffset - offset);
+    }
+    AppendJsonField(_record, "line", range.start().row());
+    AppendJsonField(_record, "column", range.start().col());
+    AppendJsonField(_record, "endLine", range.end().row());
+    AppendJsonField(_record, "endColumn", range.end().col());
+    appendValue(token, fields);
+    _record.append("}\n");
+    _output.Write(_record.data(), _record.size());
+  }
+
+  void Finish() override { }
+
+private:
+  const SourceFileInfo& _sourceFile;
+  OutputStream& _output;
+  OffsetMapper _offsets;
+  std::string _record;
+
+  void appendValue(const Token& token, const TokenFields& fields) {
+    if (fields.HasPayload) {
+      _record.append(",\"value\":");
+      AppendJsonString(_record, fields.Payload);
+      return;
+    }
+    if (!token.IsLiteral()) {
+      return;
+    }
+
+    const auto& literal = static_cast<const LiteralToken &>(token);
+    _record.append(",\"value\":");
+    if (literal.IsCharacter()) {
+      std::string encoded;
+      EncodeUTF8(static_cast<const CharacterLiteralToken &>(token).value(), encoded);
+      AppendJsonString(_record, encoded);
+      return;
+    }
+
+    const auto& number = static_cast<const NumberLiteralToken &>(token);
+    if (number.IsInteger()) {
+      auto value = number.AsInt64();
+      if (value < 0) {
+        _record.push_back('-');
+        AppendJsonNumber(_record, 0 - static_cast<uint64_t>(value));
+      } else {
+        AppendJsonNumber(_record, static_cast<uint64_t>(value));
+      }
+    } else if (std::isfinite(number.AsDouble())) {
+      char buffer[32];
+      auto length = std::snprintf(buffer, sizeof(buffer), "%.17g", number.AsDouble());
+      _record.append(buffer, length);
+    } else {
+      // JSON has no representation for infinities and NaNs.
+      _record.append("null");
+    }
+  }
+};
+
+class BinaryTokenDumper : public TokenDumper {
+public:
+  explicit BinaryTokenDumper(const SourceFileInfo& sourceFile, StreamWriter& output)
+    : _sourceFile(sourceFile),
+      _output(output.stream()),
+      _offsets(sourceFile)
+  {
+    _stringOffsets.push_back(0);
+    _pathIndex = addString(sourceFile.path());
+  }
+
+  void Dump(const Token& token) override {
+    auto fields = getTokenFields(token);
+    auto range = token.range();
+    auto offset = _offsets.GetOffset(range.start());
+    auto endOffset = _offsets.GetOffset(range.end());
+
+    TokenRecord record { };
+    record.Kind = static_cast<uint8_t>(token.kind());
+    record.SubKind = fields.SubKind;
+    record.Flags = fields.Flags;
+    record.FileId = static_cast<uint32_t>(_sourceFile.id());
+    record.Offset = offset;
+    record.Length = offset != TokenRecord::UnknownOffset && endOffset != TokenRecord::UnknownOffset
+        ? endOffset - offset
+        : 0;
+    record.Payload = fields.HasPayload ? addString(fields.Payload) : TokenRecord::NoPayload;
+    record.Value = fields.Value;
+    _records.push_back(record);
+  }
+
+  void Finish() override {
+    TokenDumpSectionHeader header { };
+    header.FileId = static_cast<uint32_t>(_sourceFile.id());
+    header.PathIndex = _pathIndex;
+    header.RecordCount = _records.size();
+    header.StringCount = _stringOffsets.size() - 1;
+    header.StringBytes = _strings.size();
+
+    constexpr const char Padding[8] = { };
+    OutputBuffer buffers[] = {
+        { &header, sizeof(header) },
+        { _records.data(), _records.size() * sizeof(TokenRecord) },
+        { _stringOffsets.data(), _stringOffsets.size() * sizeof(uint64_t) },
+        { _strings.data(), _strings.size() },
+        { Padding, (8 - _strings.size() % 8) % 8 },
+    };
+    _output.WriteVectored(buffers, sizeof(buffers) / sizeof(buffers[0]));
+  }
+
+private:
+  const SourceFileInfo& _sourceFile;
+  OutputStream& _output;
+  OffsetMapper _offsets;
+  std::vector<TokenRecord> _records;
+  std::vector<uint64_t> _stringOffsets;
+  std::string _strings;
+  uint32_t _pathIndex;
+
+  uint32_t addString(std::string_view s) {
+    _strings.append(s);
+    _stringOffsets.push_back(_strings.size());
+    return static_cast<uint32_t>(_stringOffsets.size() - 2);
+  }
+};
+
+} // namespace <anonymous>
+
+std::unique_ptr<TokenDumper> TokenDumper::Create(TokenDumpFormat format, const SourceFileInfo& sourceFile,
+                                                 StreamWriter& output) {
+  switch (format) {
+    case TokenDumpFormat::JsonLines:
+      return std::make_unique<JsonLinesTokenDumper>(sourceFile, output);
+    case TokenDumpFormat::Binary:
+      return std::make_unique<BinaryTokenDumper>(sourceFile, output);
+    default:
+      return std::make_unique<TextTokenDumper>(sourceFile, output);
+  }
+}
+
+void TokenDumper::WriteHeader(TokenDumpFormat format, OutputStream& output) {
+  if (format != TokenDumpFormat::Binary) {
+    return;
+  }
+
+  TokenDumpHeader header { };
+  std::memcpy(header.Magic, TokenDumpHeader::ExpectedMagic, sizeof(header.Magic));
+  header.Version = TokenDumpHeader::CurrentVersion;
+  header.RecordSize = sizeof(TokenRecord);
+  output.Write(&header, sizeof(header));
+}
+
+} // namespace jvc
@@ -0,0 +1,48 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "CommandLine.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> extract(std::vector<std::string> args, std::vector<std::string>& fileLists) {
+  args.insert(args.begin(), "jvc");
+  std::vector<char*> argv;
+  for (auto& arg : args) {
+    argv.push_back(arg.data());
+  }
+  return jvc::ExtractInputFileLists(static_cast<int>(argv.size()), argv.data(), fileLists);
+}
+
+} // namespace <anonymous>
+
+TEST(CommandLineTests, ShortOptionValues) {
+  std::vector<std::string> fileLists;
+  const std::vector<std::string> expected { "jvc", "-j", "4", "A.java" };
+  ASSERT_EQ(extract({ "-j", "4", "A.java" }, fileLists), expected);
+  ASSERT_EQ(extract({ "-j=4", "A.java" }, fileLists), expected);
+  ASSERT_EQ(extract({ "-j4", "A.java" }, fileLists), expected) << "the value attached to -j is not split.";
+  ASSERT_EQ(extract({ "-oout.txt" }, fileLists), (std::vector<std::string> { "jvc", "-o", "out.txt" }));
+  ASSERT_EQ(extract({ "-o", "-j4" }, fileLists), (std::vector<std::string> { "jvc", "-o", "-j4" }))
+      << "the value of an option is split as an option.";
+  ASSERT_TRUE(fileLists.empty());
+}
+
+TEST(CommandLineTests, LongOptionValues) {
+  std::vector<std::string> fileLists;
+  ASSERT_EQ(extract({ "--jobs=4", "-ferror-limit=2", "--jobsx" }, fileLists),
+            (std::vector<std::string> { "jvc", "--jobs", "4", "--ferror-limit", "2", "--jobsx" }));
+  ASSERT_EQ(extract({ "@list.txt", "-o", "@out" }, fileLists), (std::vector<std::string> { "jvc", "-o", "@out" }));
+  ASSERT_EQ(fileLists, std::vector<std::string> { "list.txt" });
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,387 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Stream.h"
+#include "Frontend/CompilerInstance.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief A minimal JSON parser that only checks whether its input is a single well-formed JSON value.
+ */
+class JsonChecker {
+public:
+  explicit JsonChecker(std::string_view text)
+    : _text(text),
+      _pos(0)
+  { }
+
+  bool Check() {
+    if (!value()) {
+      return false;
+    }
+    skipWhitespace();
+    return _pos == _text.size();
+  }
+
+private:
+  std::string_view _text;
+  size_t _pos;
+
+  void skipWhitespace() {
+    while (_pos < _text.size() && std::strchr(" \t\r\n", _text[_pos])) {
+      ++_pos;
+    }
+  }
+
+  bool consume(char ch) {
+    skipWhitespace();
+    if (_pos < _text.size() && _text[_pos] == ch) {
+      ++_pos;
+      return true;
+    }
+    return false;
+  }
+
+  bool value() {
+    skipWhitespace();
+    if (_pos == _text.size()) {
+      return false;
+    }
+    switch (_text[_pos]) {
+      case '{':
+        return sequence('{', '}', true);
+      case '[':
+        return sequence('[', ']', false);
+      case '"':
+        return string();
+      default:
+        return literal();
+    }
+  }
+
+  bool sequence(char open, char close, bool members) {
+    consume(open);
+    if (consume(close)) {
+      return true;
+    }
+    do {
+      if (members && (!string() || !consume(':'))) {
+        return false;
+      }
+      if (!value()) {
+        return false;
+      }
+    } while (consume(','));
+    return consume(close);
+  }
+
+  bool string() {
+    skipWhitespace();
+    if (_pos == _text.size() || _text[_pos] != '"') {
+      return false;
+    }
+    for (++_pos; _pos < _text.size(); ++_pos) {
+      auto ch = _text[_pos];
+      if (ch == '"') {
+        ++_pos;
+        return true;
+      }
+      if (static_cast<unsigned char>(ch) < 0x20) {
+        return false;
+      }
+      if (ch == '\\' && ++_pos == _text.size()) {
+        return false;
+      }
+    }
+    return false;
+  }
+
+  bool literal() {
+    auto start = _pos;
+    while (_pos < _text.size() && (std::isalnum(static_cast<unsigned char>(_text[_pos])) ||
+                                   std::strchr("+-.", _text[_pos]))) {
+      ++_pos;
+    }
+    auto token = _text.substr(start, _pos - start);
+    return token == "true" || token == "false" || token == "null" ||
+        (!token.empty() && (std::isdigit(static_cast<unsigned char>(token[0])) || token[0] == '-'));
+  }
+};
+
+size_t countOccurrences(std::string_view text, std::string_view pattern) {
+  size_t count = 0;
+  for (auto pos = text.find(pattern); pos != std::string_view::npos; pos = text.find(pattern, pos + 1)) {
+    ++count;
+  }
+  return count;
+}
+
+} // namespace <anonymous>
+
+TEST(DiagnosticsTests, QueuedSortedAndLimited) {
+  jvc::CompilerInstance ci;
+  std::string content = "class A {\n  int x = 1;\n}\n";
+  auto fileId = ci.GetSourceManager().Load("A.java", jvc::InputStream::FromBuffer(content.data(), content.size()));
+
+  jvc::DiagnosticsOptions options { };
+  options.Queued = true;
+  options.WarningLimit = 2;
+  auto& diag = ci.GetDiagnosticsEngine();
+  diag.SetOptions(options);
+
+  testing::internal::CaptureStderr();
+  jvc::SourceRange x { jvc::SourceLocation { fileId, 2, 7 }, jvc::SourceLocation { fileId, 2, 8 } };
+  diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(jvc::DiagnosticsLevel::Warning, x, "second"));
+  diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(
+      jvc::DiagnosticsLevel::Warning, jvc::SourceLocation { fileId, 1, 7 }, "first"));
+  ASSERT_TRUE(diag.IsSuppressed(jvc::DiagnosticsLevel::Warning));
+  diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(
+      jvc::DiagnosticsLevel::Warning, jvc::SourceLocation { fileId, 1, 1 }, "dropped"));
+  ASSERT_TRUE(testing::internal::GetCapturedStderr().empty()) << "queued diagnostics are rendered before a flush.";
+
+  testing::internal::CaptureStderr();
+  diag.Flush(fileId);
+  diag.Flush();
+  auto output = testing::internal::GetCapturedStderr();
+
+  ASSERT_EQ(output,
+      "jvc: warning: first\n"
+      "  In file A.java:1:7:\n"
+      "    class A {\n"
+      "          ^\n"
+      "jvc: warning: second\n"
+      "  In file A.java:2:7:2:8:\n"
+      "      int x = 1;\n"
+      "          ^\n"
+      "jvc: info: 0 error(s) and 1 warning(s) were not reported; raise -ferror-limit or -fwarning-limit to see them.\n"
+      "\n");
+  ASSERT_EQ(diag.GetWarningCount(), 3u);
+}
+
+TEST(DiagnosticsTests, QueuedArgumentsAreCopied) {
+  jvc::CompilerInstance ci;
+  std::string content = "class A {\n  int x = 1 # 2;\n}\n";
+  auto fileId = ci.GetSourceManager().Load("A.java", jvc::InputStream::FromBuffer(content.data(), content.size()));
+
+  jvc::DiagnosticsOptions options { };
+  options.Queued = true;
+  auto& diag = ci.GetDiagnosticsEngine();
+  diag.SetOptions(options);
+  std::string output;
+  diag.SetOutput(jvc::OutputStream::FromString(output));
+
+  {
+    // String arguments refer to strings the message does not own; the queue must not.
+    std::string op { "#" };
+    std::string expected { "`" };
+    diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnexpectedChar, jvc::SourceLocation { fileId, 2, 13 },
+                                 expected, op });
+    op.assign("@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@");
+    expected.assign("$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$$");
+  }
+  diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnknownEscapeSequence, jvc::SourceLocation { fileId, 2, 3 },
+                               'q' });
+  diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::CannotReadSourcePathRoot,
+                               jvc::SourceLocation { fileId, 1, 1 },
+                               "B.java", jvc::DiagnosticsArgument::ErrorCode(ENOENT) });
+  ASSERT_TRUE(output.empty()) << "queued diagnostics are rendered before a flush.";
+  diag.Flush(fileId);
+
+  ASSERT_EQ(output,
+      "jvc: warning: cannot read source path root: B.java: " + std::string { std::strerror(ENOENT) } + "\n"
+      "  In file A.java:1:1:\n"
+      "    class A {\n"
+      "    ^\n"
+      "jvc: error: Unknown escape sequence: `\\q`\n"
+      "  In file A.java:2:3:\n"
+      "      int x = 1 # 2;\n"
+      "      ^\n"
+      "jvc: error: Unexpected input character: expected ```, but found `#`\n"
+      "  In file A.java:2:13:\n"
+      "      int x = 1 # 2;\n"
+      "                ^\n");
+}
+
+TEST(DiagnosticsTests, ShardedMerge) {
+  constexpr const int Threads = 4;
+  constexpr const int Lines = 64;
+
+  jvc::CompilerInstance ci;
+  std::string content;
+  for (auto i = 0; i < Lines; ++i) {
+    content += "line\n";
+  }
+  auto fileId = ci.GetSourceManager().Load("A.java", jvc::InputStream::FromBuffer(content.data(), content.size()));
+
+  jvc::DiagnosticsOptions options { };
+  options.Queued = true;
+  auto& diag = ci.GetDiagnosticsEngine();
+  diag.SetOptions(options);
+
+  // Every thread reports against every other line, from the bottom up; all threads report the first line.
+  std::vector<std::thread> workers;
+  for (auto t = 0; t < Threads; ++t) {
+    workers.emplace_back([&diag, fileId, t]() {
+      for (auto row = Lines - t; row > 0; row -= Threads) {
+        diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnknownOperator, jvc::SourceLocation { fileId, 1, 1 },
+                                     static_cast<char>('a' + t) });
+        diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnknownDelimiter,
+                                     jvc::SourceLocation { fileId, static_cast<uint64_t>(row), 1 } });
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  testing::internal::CaptureStderr();
+  diag.Flush(fileId);
+  auto output = testing::internal::GetCapturedStderr();
+
+  std::vector<std::string> headers;
+  std::vector<int> rows;
+  std::istringstream lines { output };
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.rfind("jvc: ", 0) == 0) {
+      headers.push_back(line);
+    } else if (line.rfind("  In file A.java:", 0) == 0) {
+      rows.push_back(std::stoi(line.substr(17)));
+    }
+  }
+  ASSERT_EQ(headers.size(), 2u * Lines);
+  ASSERT_EQ(rows.size(), 2u * Lines);
+
+  // Messages at the same location are ordered by their position in the thread reporting them, then by content,
+  // whichever thread reported them.
+  for (auto i = 0; i < Lines; ++i) {
+    ASSERT_EQ(rows[i], 1);
+    ASSERT_EQ(headers[i], std::string { "jvc: error: Unknown operator: `" } + static_cast<char>('a' + i % Threads) + '`');
+  }
+  for (auto i = Lines; i < 2 * Lines; ++i) {
+    ASSERT_EQ(rows[i], i - Lines + 1) << "messages are not sorted by location.";
+  }
+}
+
+TEST(DiagnosticsTests, FatalCancels) {
+  jvc::CompilerInstance ci;
+  auto& diag = ci.GetDiagnosticsEngine();
+  ASSERT_FALSE(diag.IsCancelled());
+
+  testing::internal::CaptureStderr();
+  diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnsupportedAction });
+  testing::internal::GetCapturedStderr();
+  ASSERT_TRUE(diag.IsCancelled()) << "fatal diagnostics do not cancel the compiler session.";
+}
+
+TEST(DiagnosticsTests, FormatArguments) {
+  auto format = [](const jvc::DiagnosticsMessage& message) {
+    std::string text;
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(text) };
+    message.DumpMessage(writer);
+    return text;
+  };
+
+  jvc::Diagnostics unexpected { jvc::DiagnosticsKind::UnexpectedChar, jvc::SourceLocation { 1, 2, 3 }, '\'', 'x' };
+  ASSERT_EQ(unexpected.level(), jvc::DiagnosticsLevel::Error);
+  ASSERT_EQ(format(unexpected), "Unexpected input character: expected `'`, but found `x`");
+
+  std::string path = "A.java";
+  jvc::Diagnostics cannotLoad {
+      jvc::DiagnosticsKind::CannotLoadSourceFile, path, jvc::DiagnosticsArgument::ErrorCode(ENOENT) };
+  ASSERT_EQ(cannotLoad.level(), jvc::DiagnosticsLevel::Fatal);
+  ASSERT_EQ(format(cannotLoad), "cannot load source file: A.java: " + std::string { std::strerror(ENOENT) });
+
+  ASSERT_STREQ(jvc::GetDiagnosticsKindName(jvc::DiagnosticsKind::UnknownOperator), "UnknownOperator");
+}
+
+TEST(DiagnosticsTests, JsonLines) {
+  jvc::CompilerInstance ci;
+  std::string content = "class A {\n  int x = 1 # 2;\n}\n";
+  auto fileId = ci.GetSourceManager().Load("A\"1.java", jvc::InputStream::FromBuffer(content.data(), content.size()));
+
+  jvc::DiagnosticsOptions options { };
+  options.Format = jvc::DiagnosticsFormat::JsonLines;
+  auto& diag = ci.GetDiagnosticsEngine();
+  diag.SetOptions(options);
+  std::string output;
+  diag.SetOutput(jvc::OutputStream::FromString(output));
+
+  jvc::SourceRange range { jvc::SourceLocation { fileId, 2, 13 }, jvc::SourceLocation { fileId, 2, 14 } };
+  diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnknownOperator, range, "#" });
+  diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(jvc::DiagnosticsLevel::Info, "a \"quoted\"\tnote"));
+  diag.Finish();
+
+  ASSERT_EQ(output,
+      "{\"level\":\"error\",\"id\":\"UnknownOperator\",\"file\":\"A\\\"1.java\",\"offset\":22,\"endOffset\":23,"
+      "\"line\":2,\"column\":13,\"endLine\":2,\"endColumn\":14,\"message\":\"Unknown operator: `#`\"}\n"
+      "{\"level\":\"info\",\"message\":\"a \\\"quoted\\\"\\tnote\"}\n");
+}
+
+TEST(DiagnosticsTests, Sarif) {
+  for (auto queued : { false, true }) {
+    jvc::CompilerInstance ci;
+    std::string content = "class A {\n  int x = 1 # 2;\n}\n";
+    auto fileId = ci.GetSourceManager().Load("A\"1.java",
+                                             jvc::InputStream::FromBuffer(content.data(), content.size()));
+
+    jvc::DiagnosticsOptions options { };
+    options.Format = jvc::DiagnosticsFormat::Sarif;
+    options.Queued = queued;
+    options.WarningLimit = 1;
+    auto& diag = ci.GetDiagnosticsEngine();
+    diag.SetOptions(options);
+    std::string output;
+    diag.SetOutput(jvc::OutputStream::FromString(output));
+
+    jvc::SourceRange range { jvc::SourceLocation { fileId, 2, 13 }, jvc::SourceLocation { fileId, 2, 14 } };
+    diag.Emit(jvc::Diagnostics { jvc::DiagnosticsKind::UnknownOperator, range, "#" });
+    diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(
+        jvc::DiagnosticsLevel::Warning, jvc::SourceLocation { fileId, 1, 7 }, "a \"quoted\"\twarning"));
+    diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(
+        jvc::DiagnosticsLevel::Warning, jvc::SourceLocation { fileId, 1, 1 }, "suppressed"));
+    diag.Emit(*jvc::DiagnosticsMessage::CreateLiteral(jvc::DiagnosticsLevel::Info, "a note"));
+    if (queued) {
+      diag.Flush(fileId);
+    }
+    diag.Finish();
+
+    ASSERT_TRUE(JsonChecker { output }.Check()) << "malformed SARIF log, queued = " << queued << ":\n" << output;
+    ASSERT_EQ(output.find("{\"$schema\":"), 0);
+    ASSERT_EQ(output.substr(output.size() - 6), "\n]}]}\n") << "the log is not closed by Finish.";
+    // The error, the reported warning, the note and the number of suppressed messages.
+    ASSERT_EQ(countOccurrences(output, "\"message\":{\"text\":"), 4) << output;
+    ASSERT_NE(output.find("{\"ruleId\":\"UnknownOperator\",\"level\":\"error\""), std::string::npos);
+    ASSERT_NE(output.find("\"uri\":\"A\\\"1.java\"},\"region\":{\"startLine\":2,\"startColumn\":13,"
+                          "\"endLine\":2,\"endColumn\":14,\"byteOffset\":22,\"byteLength\":1}"), std::string::npos);
+    ASSERT_EQ(output.find("suppressed\""), std::string::npos);
+  }
+
+  jvc::CompilerInstance ci;
+  jvc::DiagnosticsOptions options { };
+  options.Format = jvc::DiagnosticsFormat::Sarif;
+  ci.GetDiagnosticsEngine().SetOptions(options);
+  std::string output;
+  ci.GetDiagnosticsEngine().SetOutput(jvc::OutputStream::FromString(output));
+  ci.GetDiagnosticsEngine().Finish();
+  ASSERT_TRUE(JsonChecker { output }.Check()) << "malformed empty SARIF log:\n" << output;
+  ASSERT_EQ(countOccurrences(output, "\"results\":[\n]"), 1);
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,180 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Stream.h"
+#include "Frontend/CompilerInstance.h"
+#include "Frontend/SourceLocation.h"
+#include "Lex/Lexer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+TEST(LargeSourceTests, LargeLocations) {
+  constexpr const uint64_t LargeRow = 5'000'000'000ull;
+  constexpr const uint64_t LargeCol = 6'000'000'000ull;
+
+  jvc::SourceLocation small { 1, 2, 3 };
+  ASSERT_EQ(small.row(), 2);
+  ASSERT_EQ(small.col(), 3);
+
+  jvc::SourceLocation largeRow { 1, LargeRow, 3 };
+  ASSERT_EQ(largeRow.row(), LargeRow);
+  ASSERT_EQ(largeRow.col(), 3);
+
+  jvc::SourceLocation largeCol { 1, 2, LargeCol };
+  ASSERT_EQ(largeCol.row(), 2);
+  ASSERT_EQ(largeCol.col(), LargeCol);
+  ASSERT_NE(largeCol, small);
+  ASSERT_EQ(largeCol, (jvc::SourceLocation { 1, 2, LargeCol })) << "equal large locations compare unequal.";
+  ASSERT_NE(largeCol, (jvc::SourceLocation { 2, 2, LargeCol }));
+  ASSERT_EQ(UINT32_MAX, (jvc::SourceLocation { 1, 1, UINT32_MAX }).col());
+  ASSERT_NE((jvc::SourceLocation { 1, 2, LargeCol }), (jvc::SourceLocation { 1, 2, LargeCol + (1ull << 32u) }));
+
+  // Locations around the boundaries of the inline encoding and of the segments of the side table.
+  const uint64_t values[] = {
+      1, (1ull << 20u) - 1, 1ull << 20u, (1ull << 31u) - 1, 1ull << 31u, UINT32_MAX, 1ull << 32u,
+      (1ull << 48u) + 5, UINT64_MAX - 1 };
+  for (auto row : values) {
+    for (auto col : values) {
+      jvc::SourceLocation loc { 7, row, col };
+      ASSERT_TRUE(loc.valid());
+      ASSERT_EQ(loc.fileId(), 7);
+      ASSERT_EQ(loc.row(), row);
+      ASSERT_EQ(loc.col(), col);
+      ASSERT_EQ(loc, (jvc::SourceLocation { 7, row, col }));
+      ASSERT_NE(loc, (jvc::SourceLocation { 7, row, col + 1 }));
+      ASSERT_NE(loc, (jvc::SourceLocation { 7, row + 1, col }));
+    }
+  }
+
+  std::string dump;
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(dump) };
+    largeCol.Dump(writer);
+  }
+  ASSERT_EQ(dump, "2:6000000000");
+}
+
+#ifdef JVC_STRESS_TESTS
+
+TEST(LargeSourceTests, SparseFileAbove4GiB) {
+  // The file is sparse: only the head and the tail occupy disk space, and the content is memory mapped.
+  constexpr const uint64_t TailOffset = (1ull << 32u) + 100;
+  std::string head = "class Head { }\n";
+  std::string tail = "\nclass Tail { }\n";
+
+  auto path = ::testing::TempDir() + "jvc_large_source.java";
+  auto fd = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(pwrite(fd, head.data(), head.size(), 0), static_cast<ssize_t>(head.size()));
+  ASSERT_EQ(pwrite(fd, tail.data(), tail.size(), TailOffset), static_cast<ssize_t>(tail.size()));
+  close(fd);
+
+  jvc::CompilerInstance ci;
+  auto fileId = ci.GetSourceManager().Load(path);
+  auto info = ci.GetSourceManager().GetSourceFileInfo(fileId);
+  ASSERT_TRUE(info);
+  ASSERT_EQ(info->GetSize(), TailOffset + tail.size());
+
+  // Line 2 runs from the end of the head through the zeros up to the tail, so columns near its end exceed 32 bits.
+  auto loc = info->GetLocForOffset(TailOffset - 1);
+  ASSERT_EQ(loc.row(), 2);
+  ASSERT_EQ(loc.col(), TailOffset - head.size());
+  ASSERT_EQ(loc, info->GetLocForOffset(TailOffset - 1));
+
+  auto tailLoc = info->GetLocForOffset(TailOffset + 1);
+  ASSERT_EQ(tailLoc, (jvc::SourceLocation { fileId, 3, 1 }));
+  ASSERT_EQ(info->GetViewAtLoc(tailLoc), "class Tail { }\n");
+
+  auto eof = info->GetEOFLoc();
+  ASSERT_EQ(eof.row(), 4);
+  ASSERT_EQ(eof.col(), 1);
+
+  std::remove(path.c_str());
+}
+
+namespace {
+
+/**
+ * @brief An @see jvc::InputStream producing a head, the given number of spaces and a tail, without holding the spaces
+ * anywhere.
+ */
+class PaddedInputStream : public jvc::InputStream {
+public:
+  explicit PaddedInputStream(std::string head, uint64_t padding, std::string tail)
+    : _head(std::move(head)),
+      _padding(padding),
+      _tail(std::move(tail)),
+      _offset(0)
+  { }
+
+  size_t Read(void *buffer, size_t bufferSize) override {
+    auto output = reinterpret_cast<char *>(buffer);
+    size_t read = 0;
+    while (read < bufferSize && _offset < _head.size() + _padding + _tail.size()) {
+      size_t count;
+      if (_offset < _head.size()) {
+        count = std::min(bufferSize - read, _head.size() - _offset);
+        std::memcpy(output + read, _head.data() + _offset, count);
+      } else if (_offset < _head.size() + _padding) {
+        count = static_cast<size_t>(std::min<uint64_t>(bufferSize - read, _head.size() + _padding - _offset));
+        std::memset(output + read, ' ', count);
+      } else {
+        auto tailOffset = static_cast<size_t>(_offset - _head.size() - _padding);
+        count = std::min(bufferSize - read, _tail.size() - tailOffset);
+        std::memcpy(output + read, _tail.data() + tailOffset, count);
+      }
+      read += count;
+      _offset += count;
+    }
+    return read;
+  }
+
+private:
+  std::string _head;
+  uint64_t _padding;
+  std::string _tail;
+  uint64_t _offset;
+};
+
+} // namespace <anonymous>
+
+TEST(LargeSourceTests, LexAbove4GiB) {
+  // Streamed, so that neither the content nor the disk has to hold the 4 GiB line.
+  constexpr const uint64_t Padding = (1ull << 32u) + 100;
+
+  jvc::CompilerInstance ci;
+  auto fileId = ci.GetSourceManager().LoadStreaming(
+      "jvc_large_stream.java", std::make_unique<PaddedInputStream>("class Head { }\n", Padding, "class Tail { }\n"));
+  auto lexer = jvc::Lexer::Create(ci, fileId);
+  ASSERT_TRUE(lexer);
+
+  std::vector<std::unique_ptr<jvc::Token>> tokens;
+  ASSERT_EQ(lexer->ReadAllTokens(tokens), 8);
+  ASSERT_EQ(tokens[3]->range().start(), (jvc::SourceLocation { fileId, 1, 14 }));
+
+  // The second line starts with the padding, so the columns of its tokens exceed 32 bits.
+  ASSERT_TRUE(tokens[4]->IsKeyword());
+  ASSERT_EQ(tokens[4]->range().start(), (jvc::SourceLocation { fileId, 2, Padding + 1 }));
+  ASSERT_EQ(tokens[4]->range().end().col(), Padding + 6);
+  ASSERT_EQ(tokens[7]->range().end(), (jvc::SourceLocation { fileId, 2, Padding + 15 }));
+  ASSERT_EQ(ci.GetDiagnosticsEngine().GetErrorCount(), 0);
+}
+
+#endif // JVC_STRESS_TESTS
+
+#pragma clang diagnostic pop
@@ -93,3 +93,118 @@ TEST_F(SourceFileInfoTests, GetViewInRangeInvalid) {
 
   ASSERT_TRUE(view.empty()) << "SourceFileInfo gives non-empty range view when range is invaid.";
 }
+
+TEST(SourceFileInfoStreamingTests, ReadThroughWindow) {
+  std::string source;
+  for (auto i = 1; i <= 10000; ++i) {
+    source += "line " + std::to_string(i) + "\n";
+  }
+  source += "last";
+
+  auto sourceStream = jvc::InputStream::FromBuffer(source.data(), source.size());
+  auto info = jvc::SourceFileInfo::LoadStreaming(7, "<stdin>", std::move(sourceStream));
+  ASSERT_TRUE(info.IsStreaming()) << "SourceFileInfo is not in streaming mode.";
+
+  auto input = info.CreateInputStream();
+  ASSERT_NE(input, nullptr) << "SourceFileInfo gives no input stream.";
+  ASSERT_EQ(info.CreateInputStream(), nullptr) << "SourceFileInfo gives the streaming input twice.";
+
+  jvc::StreamReader reader { std::move(input) };
+  ASSERT_EQ(reader.ReadToEnd(), source) << "SourceFileInfo gives wrong streaming content.";
+
+  ASSERT_LT(info.GetContent().size(), source.size()) << "SourceFileInfo retains the whole streaming content.";
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 7, 10000, 1 }), "line 10000\n")
+      << "SourceFileInfo gives wrong location view.";
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 7, 10001, 1 }), "last")
+      << "SourceFileInfo gives wrong location view.";
+  ASSERT_TRUE(info.GetViewAtLoc(jvc::SourceLocation { 7, 1, 1 }).empty())
+      << "SourceFileInfo gives non-empty location view for a line that has been dropped.";
+
+  jvc::SourceLocation eof { 7, 10001, 5 };
+  ASSERT_EQ(info.GetEOFLoc(), eof) << "SourceFileInfo gives wrong EOF location.";
+}
+
+TEST(SourceFileInfoLineTableTests, LineTerminators) {
+  std::string source = "first\r\nsecond\rthird\n\r\nfifth";
+  auto sourceStream = jvc::InputStream::FromBuffer(source.data(), source.size());
+  auto info = jvc::SourceFileInfo::Load(3, "crlf", std::move(sourceStream));
+
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 3, 1, 1 }), "first\r\n") << "CR LF does not end a line.";
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 3, 2, 1 }), "second\r") << "a lone CR does not end a line.";
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 3, 3, 1 }), "third\n");
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 3, 4, 1 }), "\r\n");
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 3, 5, 1 }), "fifth");
+
+  jvc::SourceLocation eof { 3, 5, 6 };
+  ASSERT_EQ(info.GetEOFLoc(), eof) << "SourceFileInfo gives wrong EOF location.";
+}
+
+TEST(SourceFileInfoLineTableTests, GetLocForOffset) {
+  std::string source;
+  for (auto i = 0; i < 1000; ++i) {
+    source += std::string(i % 7, 'x') + "\n";
+  }
+
+  auto sourceStream = jvc::InputStream::FromBuffer(source.data(), source.size());
+  auto info = jvc::SourceFileInfo::Load(4, "offsets", std::move(sourceStream));
+
+  // Query forwards to exercise the last-hit cache, then backwards to exercise the binary search.
+  std::vector<jvc::SourceLocation> expected;
+  int row = 1;
+  int col = 1;
+  for (size_t offset = 0; offset < source.size(); ++offset) {
+    expected.emplace_back(4, row, col);
+    if (source[offset] == '\n') {
+      ++row;
+      col = 1;
+    } else {
+      ++col;
+    }
+  }
+  for (size_t offset = 0; offset < source.size(); ++offset) {
+    ASSERT_EQ(info.GetLocForOffset(offset), expected[offset]) << "wrong location for offset " << offset;
+  }
+  for (size_t offset = source.size(); offset-- > 0; ) {
+    ASSERT_EQ(info.GetLocForOffset(offset), expected[offset]) << "wrong location for offset " << offset;
+  }
+  ASSERT_FALSE(info.GetLocForOffset(source.size() + 1).valid()) << "out of boundary offset has a valid location.";
+}
+
+namespace {
+
+// Hands out the underlying buffer one byte at a time, so that CR LF pairs are split across reads.
+class ByteAtATimeInputStream : public jvc::InputStream {
+public:
+  explicit ByteAtATimeInputStream(std::string data)
+    : _data(std::move(data)),
+      _offset(0)
+  { }
+
+  size_t Read(void* buffer, size_t bufferSize) override {
+    if (!bufferSize || _offset == _data.size()) {
+      return 0;
+    }
+    *static_cast<char *>(buffer) = _data[_offset++];
+    return 1;
+  }
+
+private:
+  std::string _data;
+  size_t _offset;
+};
+
+} // namespace <anonymous>
+
+TEST(SourceFileInfoStreamingTests, SplitCRLF) {
+  auto info = jvc::SourceFileInfo::LoadStreaming(
+      8, "<stdin>", std::make_unique<ByteAtATimeInputStream>("a\r\nb\rc\r"));
+  jvc::StreamReader reader { info.CreateInputStream() };
+  reader.ReadToEnd();
+
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 8, 1, 1 }), "a\r\n");
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 8, 2, 1 }), "b\r");
+  ASSERT_EQ(info.GetViewAtLoc(jvc::SourceLocation { 8, 3, 1 }), "c\r");
+
+  jvc::SourceLocation eof { 8, 4, 1 };
+  ASSERT_EQ(info.GetEOFLoc(), eof) << "a CR at the end of the stream does not end a line.";
+}
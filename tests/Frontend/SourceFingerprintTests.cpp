@@ -0,0 +1,82 @@
+//
+// Created by Sirui Mu on 2020/1/9.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Stream.h"
+#include "Frontend/SourceManager.h"
+
+#include <string>
+
+namespace {
+
+jvc::SourceFileInfo load(const std::string& source) {
+  return jvc::SourceFileInfo::Load(1, "A.java", jvc::InputStream::FromBuffer(source.data(), source.size()));
+}
+
+} // namespace <anonymous>
+
+TEST(SourceFingerprintTests, Blocks) {
+  auto info = load("package p;\n"
+                   "// class A { \n"
+                   "class A {\n"
+                   "  String s = \"}\";\n"
+                   "}\n"
+                   "\n"
+                   "interface B { }\n"
+                   "// trailing\n");
+  const auto& fingerprints = info.GetLineFingerprints();
+  // The empty line after the last line terminator is counted, just as the EOF location is on it.
+  ASSERT_EQ(fingerprints.lines(), 9u);
+
+  const auto& blocks = fingerprints.GetBlocks();
+  ASSERT_EQ(blocks.size(), 3u);
+  ASSERT_EQ(blocks[0].FirstRow, 1u);
+  ASSERT_EQ(blocks[0].EndRow, 6u);
+  ASSERT_EQ(blocks[1].FirstRow, 6u);
+  ASSERT_EQ(blocks[1].EndRow, 8u);
+  ASSERT_EQ(blocks[2].FirstRow, 8u);
+  ASSERT_EQ(blocks[2].EndRow, 10u);
+  ASSERT_EQ(blocks[1].Hash, fingerprints.GetRangeHash(6, 8));
+}
+
+TEST(SourceFingerprintTests, RangeHashes) {
+  auto info = load("a\nb\nc\na\nb\nd\n");
+  const auto& fingerprints = info.GetLineFingerprints();
+
+  ASSERT_EQ(fingerprints.GetRangeHash(1, 3), fingerprints.GetRangeHash(4, 6));
+  ASSERT_NE(fingerprints.GetRangeHash(1, 4), fingerprints.GetRangeHash(4, 7));
+  ASSERT_NE(fingerprints.GetRangeHash(1, 3), fingerprints.GetRangeHash(2, 4)) << "line order is not hashed.";
+}
+
+TEST(SourceFingerprintTests, Diff) {
+  auto oldFile = load("a\nb\nc\nd\ne\nf\n");
+  auto newFile = load("a\nB\nc\nd\nf\ng\n");
+
+  ASSERT_TRUE(jvc::SourceFileInfo::Diff(oldFile, load("a\nb\nc\nd\ne\nf\n")).empty());
+  ASSERT_NE(oldFile.GetContentFingerprint(), newFile.GetContentFingerprint());
+
+  auto changes = jvc::SourceFileInfo::Diff(oldFile, newFile);
+  ASSERT_EQ(changes.size(), 3u);
+  // Line 2 is replaced.
+  ASSERT_EQ(changes[0].OldFirstRow, 2u);
+  ASSERT_EQ(changes[0].OldRowCount, 1u);
+  ASSERT_EQ(changes[0].NewFirstRow, 2u);
+  ASSERT_EQ(changes[0].NewRowCount, 1u);
+  // Line 5 is removed.
+  ASSERT_EQ(changes[1].OldFirstRow, 5u);
+  ASSERT_EQ(changes[1].OldRowCount, 1u);
+  ASSERT_EQ(changes[1].NewFirstRow, 5u);
+  ASSERT_EQ(changes[1].NewRowCount, 0u);
+  // Line 6 is inserted at the end.
+  ASSERT_EQ(changes[2].OldFirstRow, 7u);
+  ASSERT_EQ(changes[2].OldRowCount, 0u);
+  ASSERT_EQ(changes[2].NewFirstRow, 6u);
+  ASSERT_EQ(changes[2].NewRowCount, 1u);
+}
+
+#pragma clang diagnostic pop
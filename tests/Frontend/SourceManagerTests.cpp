@@ -0,0 +1,215 @@
+//
+// Created by Sirui Mu on 2020/1/2.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Hash.h"
+#include "Infrastructure/ResponseFile.h"
+#include "Infrastructure/Stream.h"
+#include "Frontend/CompilerInstance.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+TEST(SourceManagerTests, ConcurrentLoad) {
+  constexpr const int Threads = 8;
+  constexpr const int PerThread = 200;
+
+  jvc::CompilerInstance ci;
+  std::vector<std::vector<std::pair<int, std::string>>> loaded(Threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < Threads; ++t) {
+    workers.emplace_back([&ci, &loaded, t]() {
+      for (int i = 0; i < PerThread; ++i) {
+        auto name = "file_" + std::to_string(t) + "_" + std::to_string(i);
+        auto content = "class " + name + " { }\n";
+        auto stream = jvc::InputStream::FromBuffer(content.data(), content.size());
+        auto fileId = ci.GetSourceManager().Load(name, std::move(stream));
+        loaded[t].emplace_back(fileId, name);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  auto& sources = ci.GetSourceManager();
+  ASSERT_EQ(sources.size(), Threads * PerThread);
+  std::vector<bool> seen(Threads * PerThread + 1, false);
+  for (const auto& files : loaded) {
+    for (const auto& [fileId, name] : files) {
+      ASSERT_GE(fileId, 1);
+      ASSERT_LE(fileId, Threads * PerThread);
+      ASSERT_FALSE(seen[fileId]) << "file ID " << fileId << " handed out twice";
+      seen[fileId] = true;
+
+      auto info = sources.GetSourceFileInfo(fileId);
+      ASSERT_TRUE(info);
+      ASSERT_EQ(info->id(), fileId);
+      ASSERT_EQ(info->path(), name);
+      ASSERT_EQ(info->GetContent(), "class " + name + " { }\n");
+    }
+  }
+
+  ASSERT_FALSE(sources.GetSourceFileInfo(0));
+  ASSERT_FALSE(sources.GetSourceFileInfo(Threads * PerThread + 1));
+}
+
+TEST(SourceManagerTests, LoadAllAssignsIdsInOrder) {
+  constexpr const int Files = 16;
+
+  std::vector<std::string> paths;
+  for (int i = 0; i < Files; ++i) {
+    auto path = ::testing::TempDir() + "jvc_load_all_" + std::to_string(i) + ".java";
+    std::ofstream { path } << "class C" << i << " { }\n" << std::string(i * 100, ' ');
+    paths.push_back(path);
+  }
+
+  jvc::CompilerInstance ci;
+  auto fileIds = ci.GetSourceManager().LoadAll(paths, 4);
+  ASSERT_EQ(fileIds.size(), Files);
+  for (int i = 0; i < Files; ++i) {
+    ASSERT_EQ(fileIds[i], i + 1);
+    auto info = ci.GetSourceManager().GetSourceFileInfo(fileIds[i]);
+    ASSERT_TRUE(info);
+    ASSERT_EQ(info->path(), paths[i]);
+    auto content = "class C" + std::to_string(i) + " { }\n" + std::string(i * 100, ' ');
+    ASSERT_EQ(info->GetContent(), content);
+    ASSERT_EQ(info->GetContentHash(), jvc::HashBytes128(content).Low);
+  }
+
+  for (const auto& path : paths) {
+    std::remove(path.c_str());
+  }
+}
+
+TEST(SourceManagerTests, LoadAllFromList) {
+  constexpr const int Files = 600;
+
+  std::string list;
+  std::vector<std::string> paths;
+  for (int i = 0; i < Files; ++i) {
+    auto path = ::testing::TempDir() + "jvc_load_list_" + std::to_string(i) + ".java";
+    std::ofstream { path } << "class L" << i << " { }\n";
+    paths.push_back(path);
+    list += path + "\n";
+  }
+  list += "\n" + paths[0] + "\r\n";
+
+  jvc::CompilerInstance ci;
+  jvc::ResponseFileReader reader {
+    jvc::InputStream::FromBuffer(list.data(), list.size()), jvc::ResponseFileSyntax::Lines
+  };
+  auto fileIds = ci.GetSourceManager().LoadAll(reader, 4);
+  ASSERT_EQ(fileIds.size(), Files + 1);
+  for (int i = 0; i < Files; ++i) {
+    ASSERT_EQ(fileIds[i], i + 1);
+    ASSERT_EQ(ci.GetSourceManager().GetSourceFileInfo(fileIds[i])->GetContent(),
+              "class L" + std::to_string(i) + " { }\n");
+  }
+  ASSERT_EQ(fileIds[Files], 1) << "a file listed twice is loaded twice.";
+
+  for (const auto& path : paths) {
+    std::remove(path.c_str());
+  }
+}
+
+TEST(SourceManagerTests, DeduplicateFiles) {
+  auto dir = ::testing::TempDir();
+  auto path = dir + "jvc_dedup.java";
+  auto link = dir + "jvc_dedup_link.java";
+  std::ofstream { path } << "class A { }\n";
+  std::remove(link.c_str());
+  ASSERT_EQ(symlink(path.c_str(), link.c_str()), 0);
+
+  jvc::CompilerInstance ci;
+  auto& sources = ci.GetSourceManager();
+  auto fileIds = sources.LoadAll({ path, dir + "./jvc_dedup.java", link, path }, 2);
+  ASSERT_EQ(fileIds, (std::vector<int> { 1, 1, 1, 1 })) << "the same file is loaded more than once";
+  ASSERT_EQ(sources.Load(link), 1);
+  ASSERT_EQ(sources.size(), 1);
+
+  std::string content = "class B { }\n";
+  auto first = sources.Load("first", jvc::InputStream::FromBuffer(content.data(), content.size()));
+  auto second = sources.Load("second", jvc::InputStream::FromBuffer(content.data(), content.size()));
+  ASSERT_EQ(first, second) << "identical in-memory buffers are stored twice";
+  ASSERT_EQ(sources.GetSourceFileInfo(first)->path(), "first");
+
+  std::string other = "class C { }\n";
+  ASSERT_NE(sources.Load("third", jvc::InputStream::FromBuffer(other.data(), other.size())), first);
+
+  std::remove(link.c_str());
+  std::remove(path.c_str());
+}
+
+TEST(SourceManagerTests, LoadFromOverlay) {
+  auto overlay = std::make_shared<jvc::OverlayFileSystem>(jvc::FileSystem::GetRealFileSystem());
+  overlay->SetFile("Unsaved.java", "class Unsaved { }\n");
+
+  jvc::CompilerInstance ci;
+  auto& sources = ci.GetSourceManager();
+  sources.SetFileSystem(overlay->Snapshot());
+  overlay->EditFile("Unsaved.java", 15, 0, "int x; ");
+
+  auto fileIds = sources.LoadAll({ "Unsaved.java", "./Unsaved.java" }, 2);
+  ASSERT_EQ(fileIds, (std::vector<int> { 1, 1 }));
+  ASSERT_EQ(sources.GetSourceFileInfo(1)->GetContent(), "class Unsaved { }\n")
+      << "SourceManager does not load from the snapshot.";
+}
+
+TEST(SourceManagerTests, EvictAndReload) {
+  constexpr const int Files = 8;
+  constexpr const size_t FileSize = 4096;
+
+  std::vector<std::string> paths;
+  for (int i = 0; i < Files; ++i) {
+    auto path = ::testing::TempDir() + "jvc_evict_" + std::to_string(i) + ".java";
+    std::ofstream { path } << "class E" << i << " { }\n" << std::string(FileSize, ' ') << "\nint x;\n";
+    paths.push_back(path);
+  }
+
+  jvc::CompilerInstance ci;
+  auto& sources = ci.GetSourceManager();
+  sources.SetMemoryBudget(2 * FileSize);
+  auto fileIds = sources.LoadAll(paths, 4);
+  ASSERT_EQ(sources.GetMemoryUsage().EvictedBytes, 0) << "files are evicted before they are released.";
+
+  for (auto fileId : fileIds) {
+    sources.ReleaseFile(fileId);
+  }
+  auto usage = sources.GetMemoryUsage();
+  ASSERT_GT(usage.EvictedBytes, 0);
+  ASSERT_LE(usage.ResidentBytes, 2 * FileSize + 64);
+  ASSERT_FALSE(sources.GetSourceFileInfo(1)->IsResident()) << "the least recently released file is not evicted.";
+  ASSERT_TRUE(sources.GetSourceFileInfo(Files)->IsResident());
+
+  auto info = sources.GetSourceFileInfo(1);
+  auto pin = info->GetBuffer();
+  ASSERT_TRUE(pin);
+  ASSERT_EQ(info->GetViewAtLoc(jvc::SourceLocation { 1, 3, 1 }), "int x;\n") << "evicted content is not reloaded.";
+  ASSERT_EQ(sources.GetMemoryUsage().Reloads, 1);
+
+  auto evictedBytes = sources.GetMemoryUsage().EvictedBytes;
+  sources.SetMemoryBudget(1);
+  sources.ReleaseFile(1);
+  ASSERT_TRUE(info->IsResident()) << "pinned content is evicted.";
+  pin.reset();
+  sources.ReleaseFile(1);
+  ASSERT_FALSE(info->IsResident()) << "released content is not evicted once unpinned.";
+  ASSERT_GT(sources.GetMemoryUsage().EvictedBytes, evictedBytes);
+
+  for (const auto& path : paths) {
+    std::remove(path.c_str());
+  }
+}
+
+#pragma clang diagnostic pop
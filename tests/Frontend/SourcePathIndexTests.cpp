@@ -0,0 +1,76 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Frontend/CompilerInstance.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+TEST(SourcePathIndexTests, ResolveTypes) {
+  auto first = ::testing::TempDir() + "jvc_sourcepath_first";
+  auto second = ::testing::TempDir() + "jvc_sourcepath_second";
+  std::vector<std::string> directories {
+    first, first + "/a", first + "/a/b", first + "/a/empty", second, second + "/a", second + "/a/b"
+  };
+  for (const auto& directory : directories) {
+    mkdir(directory.c_str(), 0755);
+  }
+
+  std::vector<std::string> files {
+    first + "/Main.java", first + "/a/b/C.java", first + "/a/b/D.java", first + "/a/b/notes.txt",
+    second + "/a/b/C.java", second + "/a/E.java"
+  };
+  for (const auto& file : files) {
+    std::ofstream { file } << "class X { }\n";
+  }
+  auto link = first + "/a/b/Linked.java";
+  std::remove(link.c_str());
+  ASSERT_EQ(symlink((first + "/Main.java").c_str(), link.c_str()), 0);
+
+  jvc::CompilerInstance ci;
+  auto& index = ci.GetSourcePathIndex();
+  index.AddRoots({ first + ":" + second }, 4);
+
+  ASSERT_EQ(index.GetFiles(), (std::vector<std::string> {
+    first + "/Main.java", first + "/a/b/C.java", first + "/a/b/D.java", first + "/a/b/Linked.java",
+    second + "/a/E.java"
+  }));
+  ASSERT_EQ(index.GetPackageCount(), 3);
+
+  ASSERT_TRUE(index.Resolve("a.b.C"));
+  ASSERT_EQ(*index.Resolve("a.b.C"), first + "/a/b/C.java") << "the first root does not take precedence.";
+  ASSERT_EQ(*index.Resolve("a.b.D.Inner"), first + "/a/b/D.java") << "nested types are not resolved.";
+  ASSERT_EQ(*index.Resolve("a.E"), second + "/a/E.java");
+  ASSERT_EQ(*index.Resolve("Main"), first + "/Main.java");
+  ASSERT_FALSE(index.Resolve("a.b.notes"));
+  ASSERT_FALSE(index.Resolve("a.X"));
+  ASSERT_FALSE(index.Resolve("Main.b.C")) << "a qualified name resolves to a type in the unnamed package.";
+  ASSERT_FALSE(index.Resolve("Main.X"));
+  ASSERT_FALSE(index.GetPackageDirectories("a.empty"));
+  ASSERT_EQ(*index.GetPackageDirectories("a.b"), (std::vector<std::string> { first + "/a/b", second + "/a/b" }));
+
+  auto misses = ci.GetStatCache().GetMisses();
+  ASSERT_TRUE(ci.GetStatCache().Stat(link).IsRegularFile);
+  ASSERT_EQ(ci.GetStatCache().GetMisses(), misses) << "the stat result of the link is not cached.";
+
+  std::remove(link.c_str());
+  for (const auto& file : files) {
+    std::remove(file.c_str());
+  }
+  for (auto i = directories.rbegin(); i != directories.rend(); ++i) {
+    rmdir(i->c_str());
+  }
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,72 @@
+//
+// Created by Sirui Mu on 2020/1/2.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/ConcurrentTable.h"
+
+#include <thread>
+#include <vector>
+
+TEST(ConcurrentTableTests, AppendAcrossSegments) {
+  jvc::ConcurrentTable<int, 2> table;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(table.Append(std::make_unique<int>(i)), static_cast<size_t>(i));
+  }
+
+  ASSERT_EQ(table.size(), 100);
+  for (int i = 0; i < 100; ++i) {
+    auto entry = table.Get(i);
+    ASSERT_TRUE(entry) << "entry " << i << " is missing";
+    ASSERT_EQ(*entry, i);
+  }
+  ASSERT_FALSE(table.Get(100));
+}
+
+TEST(ConcurrentTableTests, ReservedSlotIsEmptyUntilPublished) {
+  jvc::ConcurrentTable<int> table;
+  auto index = table.Reserve();
+  ASSERT_EQ(table.size(), 1);
+  ASSERT_FALSE(table.Get(index));
+
+  table.Emplace(index, std::make_unique<int>(42));
+  ASSERT_TRUE(table.Get(index));
+  ASSERT_EQ(*table.Get(index), 42);
+}
+
+TEST(ConcurrentTableTests, ConcurrentAppend) {
+  constexpr const int Threads = 8;
+  constexpr const int PerThread = 2000;
+
+  jvc::ConcurrentTable<int, 4> table;
+  std::vector<std::vector<size_t>> indexes(Threads);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < Threads; ++t) {
+    workers.emplace_back([&table, &indexes, t]() {
+      for (int i = 0; i < PerThread; ++i) {
+        indexes[t].push_back(table.Append(std::make_unique<int>(t * PerThread + i)));
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  ASSERT_EQ(table.size(), Threads * PerThread);
+  std::vector<bool> seen(Threads * PerThread, false);
+  for (int t = 0; t < Threads; ++t) {
+    for (int i = 0; i < PerThread; ++i) {
+      auto index = indexes[t][i];
+      ASSERT_LT(index, seen.size());
+      ASSERT_FALSE(seen[index]) << "index " << index << " handed out twice";
+      seen[index] = true;
+      ASSERT_EQ(*table.Get(index), t * PerThread + i);
+    }
+  }
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,92 @@
+//
+// Created by Sirui Mu on 2020/1/7.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/DirectoryWalker.h"
+#include "Infrastructure/StatCache.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+bool acceptAll(std::string_view) {
+  return true;
+}
+
+} // namespace <anonymous>
+
+TEST(DirectoryWalkerTests, SymbolicLinkCycles) {
+  auto root = ::testing::TempDir() + "jvc_walker_cycle";
+  mkdir(root.c_str(), 0755);
+  mkdir((root + "/a").c_str(), 0755);
+  std::ofstream { root + "/a/X.java" } << "class X { }\n";
+  std::remove((root + "/a/parent").c_str());
+  std::remove((root + "/a/self").c_str());
+  ASSERT_EQ(symlink("..", (root + "/a/parent").c_str()), 0);
+  ASSERT_EQ(symlink(".", (root + "/a/self").c_str()), 0);
+
+  jvc::StatCache statCache;
+  int errorCode;
+  auto listings = jvc::WalkDirectoryTree(root, 4, acceptAll, statCache, errorCode);
+  ASSERT_EQ(errorCode, 0);
+  ASSERT_EQ(listings.size(), 1) << "a symbolic link to a directory is followed.";
+  ASSERT_EQ(listings[0].RelativePath, "a");
+  ASSERT_EQ(listings[0].Files, std::vector<std::string> { "X.java" });
+  ASSERT_EQ(listings[0].ErrorCode, 0);
+
+  std::remove((root + "/a/parent").c_str());
+  std::remove((root + "/a/self").c_str());
+  std::remove((root + "/a/X.java").c_str());
+  rmdir((root + "/a").c_str());
+  rmdir(root.c_str());
+}
+
+TEST(DirectoryWalkerTests, ReportsSubdirectoryErrors) {
+  auto root = ::testing::TempDir() + "jvc_walker_deep";
+  mkdir(root.c_str(), 0755);
+
+  // Nest directories until their path is too long to be opened, which fails even with elevated privileges.
+  const std::string name(NAME_MAX, 'd');
+  std::vector<int> fds { open(root.c_str(), O_RDONLY | O_DIRECTORY) };
+  ASSERT_GE(fds.back(), 0);
+  for (size_t length = root.size(); length <= PATH_MAX; length += name.size() + 1) {
+    mkdirat(fds.back(), name.c_str(), 0755);
+    fds.push_back(openat(fds.back(), name.c_str(), O_RDONLY | O_DIRECTORY));
+    ASSERT_GE(fds.back(), 0);
+  }
+
+  jvc::StatCache statCache;
+  int errorCode;
+  auto listings = jvc::WalkDirectoryTree(root, 4, acceptAll, statCache, errorCode);
+  ASSERT_EQ(errorCode, 0);
+  ASSERT_EQ(listings.size(), 1);
+  ASSERT_EQ(listings[0].ErrorCode, ENAMETOOLONG);
+  ASSERT_GT(listings[0].Path.size(), PATH_MAX);
+  ASSERT_TRUE(listings[0].Files.empty());
+
+  close(fds.back());
+  fds.pop_back();
+  while (!fds.empty()) {
+    unlinkat(fds.back(), name.c_str(), AT_REMOVEDIR);
+    close(fds.back());
+    fds.pop_back();
+  }
+  rmdir(root.c_str());
+}
+
+#pragma clang diagnostic pop
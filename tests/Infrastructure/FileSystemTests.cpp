@@ -0,0 +1,92 @@
+//
+// Created by Sirui Mu on 2020/1/5.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/FileSystem.h"
+#include "Infrastructure/Stream.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+std::string readFile(const jvc::FileSystem& fs, const std::string& path) {
+  int errorCode;
+  auto stream = fs.OpenFile(path, errorCode);
+  if (!stream) {
+    return "<error>";
+  }
+  jvc::StreamReader reader { std::move(stream) };
+  return reader.ReadToEnd();
+}
+
+} // namespace <anonymous>
+
+TEST(FileSystemTests, OverlayShadowsDisk) {
+  auto path = ::testing::TempDir() + "jvc_overlay.java";
+  std::ofstream { path } << "on disk";
+
+  jvc::OverlayFileSystem overlay { jvc::FileSystem::GetRealFileSystem() };
+  ASSERT_EQ(readFile(overlay, path), "on disk");
+
+  overlay.SetFile(path, "in memory");
+  ASSERT_TRUE(overlay.HasFile(path));
+  ASSERT_EQ(readFile(overlay, path), "in memory");
+
+  jvc::FileIdentity diskIdentity { };
+  jvc::FileIdentity overlayIdentity { };
+  ASSERT_TRUE(jvc::FileSystem::GetRealFileSystem()->GetFileIdentity(path, diskIdentity));
+  ASSERT_TRUE(overlay.GetFileIdentity(path, overlayIdentity));
+  ASSERT_FALSE(diskIdentity == overlayIdentity) << "in-memory file has the identity of the file on disk.";
+
+  ASSERT_TRUE(overlay.RemoveFile(path));
+  ASSERT_EQ(readFile(overlay, path), "on disk");
+
+  std::remove(path.c_str());
+}
+
+TEST(FileSystemTests, OverlayIdentities) {
+  jvc::OverlayFileSystem overlay { jvc::FileSystem::GetRealFileSystem() };
+  overlay.SetFile("src/A.java", "class A { }");
+  overlay.SetFile("src/B.java", "class B { }");
+
+  jvc::FileIdentity a { };
+  jvc::FileIdentity b { };
+  jvc::FileIdentity alias { };
+  ASSERT_TRUE(overlay.GetFileIdentity("src/A.java", a));
+  ASSERT_TRUE(overlay.GetFileIdentity("src/B.java", b));
+  ASSERT_TRUE(overlay.GetFileIdentity("./src/../src/A.java", alias));
+  ASSERT_FALSE(a == b) << "distinct in-memory files share an identity.";
+  ASSERT_TRUE(a == alias) << "the same in-memory file has different identities.";
+
+  overlay.SetFile("src/A.java", "class A { int x; }");
+  ASSERT_TRUE(overlay.EditFile("src/A.java", 0, 0, "// A\n"));
+  auto snapshot = overlay.Snapshot();
+  ASSERT_TRUE(snapshot->GetFileIdentity("src/A.java", alias));
+  ASSERT_TRUE(a == alias) << "replacing or editing an in-memory file changes its identity.";
+}
+
+TEST(FileSystemTests, OverlayEditsAndSnapshots) {
+  jvc::OverlayFileSystem overlay { jvc::FileSystem::GetRealFileSystem() };
+  overlay.SetFile("src/Main.java", "class Main { }");
+
+  int errorCode;
+  ASSERT_EQ(overlay.OpenFile("src/Missing.java", errorCode), nullptr);
+  ASSERT_NE(errorCode, 0);
+  ASSERT_FALSE(overlay.EditFile("src/Missing.java", 0, 0, "x"));
+
+  auto snapshot = overlay.Snapshot();
+  ASSERT_TRUE(overlay.EditFile("./src/../src/Main.java", 13, 0, "int x; "));
+  overlay.SetFile("src/Other.java", "class Other { }");
+
+  ASSERT_EQ(readFile(overlay, "src/Main.java"), "class Main { int x; }");
+  ASSERT_EQ(readFile(*snapshot, "src/Main.java"), "class Main { }") << "snapshot sees edits made after it was taken.";
+  ASSERT_EQ(readFile(*snapshot, "src/Other.java"), "<error>") << "snapshot sees files added after it was taken.";
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,40 @@
+//
+// Created by Sirui Mu on 2020/1/3.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Hash.h"
+
+#include <string>
+
+TEST(HashTests, KnownValues) {
+  ASSERT_EQ(jvc::HashBytes(""), 0xEF46DB3751D8E999ull);
+  ASSERT_EQ(jvc::HashBytes("a"), 0xD24EC4F1A98C6E5Bull);
+  ASSERT_EQ(jvc::HashBytes("abc"), 0x44BC2CF5AD770999ull);
+}
+
+TEST(HashTests, LongInputs) {
+  std::string s(1000, 'x');
+  auto h = jvc::HashBytes(s);
+  ASSERT_EQ(jvc::HashBytes(s), h) << "hash is not deterministic";
+
+  for (size_t i = 0; i < s.size(); i += 37) {
+    auto t = s;
+    t[i] = 'y';
+    ASSERT_NE(jvc::HashBytes(t), h) << "changing byte " << i << " does not change the hash";
+  }
+  ASSERT_NE(jvc::HashBytes(s, 1), h) << "seed does not change the hash";
+}
+
+TEST(HashTests, KnownValues128) {
+  ASSERT_EQ(jvc::HashBytes128(""), (jvc::Hash128 { 0, 0 }));
+  ASSERT_EQ(jvc::HashBytes128("hello"), (jvc::Hash128 { 0xCBD8A7B341BD9B02ull, 0x5B1E906A48AE1D19ull }));
+  ASSERT_EQ(jvc::HashBytes128("The quick brown fox jumps over the lazy dog"),
+            (jvc::Hash128 { 0xE34BBC7BBC071B6Cull, 0x7A433CA9C49A9347ull }));
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,73 @@
+//
+// Created by Sirui Mu on 2020/1/6.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/MemoryBuffer.h"
+#include "Infrastructure/Stream.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+TEST(MemoryBufferTests, FromFile) {
+  auto smallPath = ::testing::TempDir() + "jvc_memory_buffer_small.java";
+  auto largePath = ::testing::TempDir() + "jvc_memory_buffer_large.java";
+  std::string small = "class Small { }\n";
+  std::string large(jvc::MemoryBuffer::MemoryMapThreshold + 17, 'x');
+  std::ofstream { smallPath } << small;
+  std::ofstream { largePath } << large;
+
+  int errorCode;
+  auto smallBuffer = jvc::MemoryBuffer::FromFile(smallPath, errorCode);
+  ASSERT_TRUE(smallBuffer);
+  ASSERT_EQ(errorCode, 0);
+  ASSERT_FALSE(smallBuffer->IsMemoryMapped());
+  ASSERT_EQ(smallBuffer->GetView(), small);
+
+  auto largeBuffer = jvc::MemoryBuffer::FromFile(largePath, errorCode);
+  ASSERT_TRUE(largeBuffer);
+  ASSERT_TRUE(largeBuffer->IsMemoryMapped());
+  ASSERT_EQ(largeBuffer->GetView(), large);
+
+  std::remove(smallPath.c_str());
+  std::remove(largePath.c_str());
+
+  // The mapping stays valid after the file has been removed.
+  jvc::StreamReader reader { jvc::MemoryBuffer::CreateInputStream(std::move(largeBuffer)) };
+  ASSERT_EQ(reader.ReadToEnd(), large);
+
+  ASSERT_FALSE(jvc::MemoryBuffer::FromFile(smallPath, errorCode));
+  ASSERT_EQ(errorCode, ENOENT);
+}
+
+TEST(MemoryBufferTests, ReadFileHoldsNoSpareCapacity) {
+  auto path = ::testing::TempDir() + "jvc_memory_buffer_exact.java";
+  int errorCode;
+  for (auto size : { size_t { 4096 }, size_t { 10000 }, jvc::MemoryBuffer::MemoryMapThreshold - 1 }) {
+    std::string content(size, 'x');
+    std::ofstream { path } << content;
+
+    auto buffer = jvc::MemoryBuffer::FromFile(path, errorCode);
+    ASSERT_TRUE(buffer);
+    ASSERT_FALSE(buffer->IsMemoryMapped());
+    ASSERT_EQ(buffer->GetView(), content);
+    ASSERT_GE(buffer->GetAllocatedSize(), size);
+    ASSERT_LE(buffer->GetAllocatedSize(), size + 64) << "size = " << size;
+  }
+
+  std::remove(path.c_str());
+
+  // Files under /proc report a size of 0, so their content grows while being read.
+  auto generated = jvc::MemoryBuffer::FromFile("/proc/self/status", errorCode);
+  ASSERT_TRUE(generated);
+  ASSERT_GT(generated->size(), 0);
+  ASSERT_LE(generated->GetAllocatedSize(), generated->size() + 64);
+}
+
+#pragma clang diagnostic pop
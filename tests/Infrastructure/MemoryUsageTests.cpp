@@ -0,0 +1,97 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/MemoryUsage.h"
+#include "Infrastructure/Stream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+
+namespace {
+
+JVC_MEMORY_GAUGE(TestGauge, "A memory gauge defined by the unit tests");
+
+int newHandlerCalls = 0;
+
+void uninstallNewHandler() {
+  ++newHandlerCalls;
+  std::set_new_handler(nullptr);
+}
+
+} // namespace <anonymous>
+
+TEST(MemoryUsageTests, GaugeTracksPeak) {
+  auto gauges = jvc::MemoryGauge::GetAll();
+  ASSERT_NE(std::find(gauges.begin(), gauges.end(), &TestGauge), gauges.end());
+
+  TestGauge.Add(100);
+  TestGauge.Add(50);
+  TestGauge.Subtract(120);
+  TestGauge.Add(10);
+  ASSERT_EQ(TestGauge.current(), 40);
+  ASSERT_EQ(TestGauge.peak(), 150);
+  TestGauge.Subtract(40);
+}
+
+TEST(MemoryUsageTests, Report) {
+  std::string report;
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(report) };
+    jvc::MemoryUsage::Report(writer);
+  }
+  ASSERT_NE(report.find("peak RSS"), std::string::npos);
+  ASSERT_NE(report.find("TestGauge"), std::string::npos);
+  ASSERT_NE(report.find("StreamBufferBytes"), std::string::npos);
+}
+
+TEST(MemoryUsageTests, AllocationScopeRestoresSubsystem) {
+  {
+    jvc::AllocationScope outer { jvc::MemorySubsystem::Lexer };
+    {
+      jvc::AllocationScope inner { jvc::MemorySubsystem::Diagnostics };
+      auto value = std::make_unique<int>(42);
+      ASSERT_EQ(*value, 42);
+    }
+    if (jvc::MemoryUsage::IsAllocationTrackingEnabled()) {
+      ASSERT_EQ(jvc::MemoryUsage::EnterSubsystem(jvc::MemorySubsystem::Other), jvc::MemorySubsystem::Lexer);
+      jvc::MemoryUsage::LeaveSubsystem(jvc::MemorySubsystem::Lexer);
+    }
+  }
+}
+
+TEST(MemoryUsageTests, OperatorNewCallsNewHandler) {
+  newHandlerCalls = 0;
+  std::set_new_handler(uninstallNewHandler);
+  ASSERT_THROW(::operator delete(::operator new(std::numeric_limits<size_t>::max() / 2)), std::bad_alloc);
+  ASSERT_EQ(newHandlerCalls, 1) << "operator new throws without calling the new handler.";
+  ASSERT_EQ(std::get_new_handler(), nullptr);
+}
+
+TEST(MemoryUsageTests, CountsOverAlignedAllocations) {
+  struct alignas(128) Aligned {
+    char Bytes[128];
+  };
+
+  auto before = jvc::MemoryUsage::GetThreadAllocationCount();
+  auto plain = std::make_unique<int>(42);
+  auto hooked = jvc::MemoryUsage::GetThreadAllocationCount() != before;
+
+  before = jvc::MemoryUsage::GetThreadAllocationCount();
+  auto aligned = std::make_unique<Aligned>();
+  ASSERT_EQ(reinterpret_cast<uintptr_t>(aligned.get()) % alignof(Aligned), 0u);
+  if (hooked) {
+    ASSERT_EQ(jvc::MemoryUsage::GetThreadAllocationCount(), before + 1) << "over-aligned allocations are not counted.";
+  }
+}
+
+#pragma clang diagnostic pop
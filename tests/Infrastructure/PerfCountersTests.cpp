@@ -0,0 +1,60 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/PerfCounters.h"
+#include "Infrastructure/Stream.h"
+
+#include <string>
+#include <vector>
+
+class PerfCountersTests : public ::testing::Test {
+protected:
+  void TearDown() override {
+    jvc::PerfCounters::Shutdown();
+  }
+};
+
+TEST_F(PerfCountersTests, ReportsPhasesInEveryCounterSource) {
+  jvc::PerfCounters::Initialize();
+  {
+    jvc::PerfCounterScope scope { jvc::PerfPhase::Lex };
+    std::vector<uint64_t> data(1u << 20u);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = i * i;
+    }
+    ASSERT_EQ(data[3], 9);
+  }
+
+  std::string report;
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(report) };
+    jvc::PerfCounters::Report(writer, 1000, 100);
+  }
+  ASSERT_EQ(report.find("Performance counters ("), 0);
+  ASSERT_NE(report.find("  Lex:\n"), std::string::npos);
+  ASSERT_NE(report.find("  Total:\n"), std::string::npos);
+  // Page faults and the CPU time are available even without perf_event_open.
+  ASSERT_NE(report.find("    page faults"), std::string::npos);
+  ASSERT_NE(report.find("    CPU time (ns)"), std::string::npos);
+  ASSERT_NE(report.find("/byte"), std::string::npos);
+
+  jvc::PerfCounters::Shutdown();
+  ASSERT_FALSE(jvc::PerfCounters::IsEnabled());
+  report.clear();
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(report) };
+    jvc::PerfCounters::Report(writer, 0, 0);
+  }
+  // The CPU time collected so far has been discarded.
+  auto cpuTime = report.find("    CPU time (ns)");
+  ASSERT_NE(cpuTime, std::string::npos);
+  ASSERT_LT(std::stoull(report.substr(cpuTime + 24)), 10000000u) << report;
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,62 @@
+//
+// Created by Sirui Mu on 2020/1/5.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/PieceTable.h"
+#include "Infrastructure/Stream.h"
+
+#include <random>
+#include <string>
+
+TEST(PieceTableTests, RandomEdits) {
+  std::string expected = "public class Main {\n  int x;\n}\n";
+  jvc::PieceTable table { expected };
+
+  std::mt19937 rng { 42 };
+  for (auto i = 0; i < 2000; ++i) {
+    auto offset = std::uniform_int_distribution<size_t> { 0, expected.size() }(rng);
+    auto length = std::uniform_int_distribution<size_t> { 0, 4 }(rng);
+    auto text = std::string(std::uniform_int_distribution<size_t> { 0, 3 }(rng), static_cast<char>('a' + i % 26));
+
+    table.Replace(offset, length, text);
+    expected.replace(offset, std::min(length, expected.size() - offset), text);
+    ASSERT_EQ(table.size(), expected.size()) << "wrong size after edit " << i;
+  }
+  ASSERT_EQ(table.ToString(), expected);
+
+  jvc::StreamReader reader { table.CreateInputStream() };
+  ASSERT_EQ(reader.ReadToEnd(), expected) << "PieceTable gives wrong content through its input stream.";
+}
+
+TEST(PieceTableTests, TypingExtendsPiece) {
+  jvc::PieceTable table { "class A { }" };
+  std::string typed = "int x; ";
+  for (size_t i = 0; i < typed.size(); ++i) {
+    table.Insert(10 + i, std::string_view { &typed[i], 1 });
+    ASSERT_LE(table.GetPieceCount(), 3) << "typing does not extend the previous insertion.";
+  }
+  ASSERT_EQ(table.ToString(), "class A { int x; }");
+}
+
+TEST(PieceTableTests, SnapshotIsolation) {
+  jvc::PieceTable table { "abc" };
+  table.Insert(3, "def");
+
+  auto snapshot = table;
+  auto stream = table.CreateInputStream();
+  table.Insert(6, "ghi");
+  table.Erase(0, 2);
+  snapshot.Insert(0, "xyz");
+
+  ASSERT_EQ(table.ToString(), "cdefghi");
+  ASSERT_EQ(snapshot.ToString(), "xyzabcdef") << "snapshot is affected by edits to the original.";
+  jvc::StreamReader reader { std::move(stream) };
+  ASSERT_EQ(reader.ReadToEnd(), "abcdef") << "input stream is affected by later edits.";
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,44 @@
+//
+// Created by Sirui Mu on 2020/1/8.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/ResponseFile.h"
+#include "Infrastructure/Stream.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<std::string> readAll(const std::string& content, jvc::ResponseFileSyntax syntax) {
+  jvc::ResponseFileReader reader { jvc::InputStream::FromBuffer(content.data(), content.size()), syntax };
+  std::vector<std::string> arguments;
+  std::vector<std::string> batch;
+  while (reader.ReadBatch(batch, 2)) {
+    arguments.insert(arguments.end(), batch.begin(), batch.end());
+  }
+  return arguments;
+}
+
+} // namespace <anonymous>
+
+TEST(ResponseFileTests, Arguments) {
+  auto arguments = readAll("  A.java\tb/B.java\n\"with space/C.java\" 'single \"quoted\"' escaped\\ D.java\r\nlast",
+                           jvc::ResponseFileSyntax::Arguments);
+  ASSERT_EQ(arguments, (std::vector<std::string> {
+    "A.java", "b/B.java", "with space/C.java", "single \"quoted\"", "escaped D.java", "last"
+  }));
+  ASSERT_TRUE(readAll(" \n\t ", jvc::ResponseFileSyntax::Arguments).empty());
+}
+
+TEST(ResponseFileTests, Lines) {
+  auto arguments = readAll("A.java\n\nwith space/B.java\r\n'quoted'.java\nlast", jvc::ResponseFileSyntax::Lines);
+  ASSERT_EQ(arguments, (std::vector<std::string> { "A.java", "with space/B.java", "'quoted'.java", "last" }));
+}
+
+#pragma clang diagnostic pop
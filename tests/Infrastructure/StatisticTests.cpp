@@ -0,0 +1,64 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Statistic.h"
+#include "Infrastructure/Stream.h"
+
+#include <algorithm>
+#include <string>
+
+namespace {
+
+JVC_STATISTIC(TestStatistic, "A statistic defined by the unit tests");
+
+} // namespace <anonymous>
+
+TEST(StatisticTests, RegisterAndPrint) {
+  auto statistics = jvc::Statistic::GetAll();
+  ASSERT_NE(std::find(statistics.begin(), statistics.end(), &TestStatistic), statistics.end());
+  ASSERT_TRUE(std::is_sorted(statistics.begin(), statistics.end(), [](const auto* lhs, const auto* rhs) {
+    return std::string { lhs->name() } < rhs->name();
+  }));
+
+  auto initial = TestStatistic.value();
+  ++TestStatistic;
+  TestStatistic += 41;
+  ASSERT_EQ(TestStatistic.value(), initial + 42);
+
+  std::string json;
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(json) };
+    jvc::Statistic::PrintJson(writer);
+  }
+  ASSERT_EQ(json.find("{\"stats\":{"), 0);
+  ASSERT_NE(json.find("\"TestStatistic\":" + std::to_string(initial + 42)), std::string::npos);
+}
+
+TEST(StatisticTests, StreamWriterCountsWrites) {
+  auto statistics = jvc::Statistic::GetAll();
+  auto find = [&statistics](const char* name) {
+    return *std::find_if(statistics.begin(), statistics.end(), [name](const auto* statistic) {
+      return std::string { statistic->name() } == name;
+    });
+  };
+  const auto* writeCount = find("StreamWriterWrites");
+  const auto* byteCount = find("StreamWriterBytes");
+  auto initialWrites = writeCount->value();
+  auto initialBytes = byteCount->value();
+
+  std::string output;
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(output) };
+    writer << "hello" << '\n';
+  }
+  ASSERT_EQ(writeCount->value(), initialWrites + 2);
+  ASSERT_EQ(byteCount->value(), initialBytes + 6);
+}
+
+#pragma clang diagnostic pop
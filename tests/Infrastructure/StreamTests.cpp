@@ -86,6 +86,15 @@ TEST(OutputStream, CreateFromSTL) {
   ASSERT_EQ(str, "hello");
 }
 
+TEST(OutputStream, CreateFromString) {
+  std::string output = "say ";
+  auto stream = jvc::OutputStream::FromString(output);
+  ASSERT_TRUE(stream) << "FromString function returns nullptr.";
+
+  ASSERT_EQ(stream->Write("hello", 5), 5) << "Write function does not return the size of the input buffer.";
+  ASSERT_EQ(output, "say hello") << "Write function does not append contents to the string.";
+}
+
 TEST(OutputStream, Write) {
   std::stringstream output { };
   auto stream = jvc::OutputStream::FromSTL(output);
@@ -0,0 +1,37 @@
+//
+// Created by Sirui Mu on 2020/1/3.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/ThreadPool.h"
+
+#include <atomic>
+#include <vector>
+
+TEST(ThreadPoolTests, SubmitAndWait) {
+  std::atomic<int> sum { 0 };
+  jvc::ThreadPool pool { 4 };
+  ASSERT_EQ(pool.size(), 4);
+
+  for (int i = 1; i <= 100; ++i) {
+    pool.Submit([&sum, i]() { sum += i; });
+  }
+  pool.Wait();
+  ASSERT_EQ(sum.load(), 5050);
+}
+
+TEST(ThreadPoolTests, ParallelForVisitsEachIndexOnce) {
+  for (size_t jobs : { 1, 3, 8 }) {
+    std::vector<std::atomic<int>> visits(1000);
+    jvc::ParallelFor(jobs, visits.size(), [&visits](size_t i) { ++visits[i]; });
+    for (size_t i = 0; i < visits.size(); ++i) {
+      ASSERT_EQ(visits[i].load(), 1) << "index " << i << " with " << jobs << " jobs";
+    }
+  }
+}
+
+#pragma clang diagnostic pop
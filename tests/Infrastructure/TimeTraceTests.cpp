@@ -0,0 +1,71 @@
+//
+// Created by Sirui Mu on 2020/1/11.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Stream.h"
+#include "Infrastructure/TimeTrace.h"
+
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string writeTimeTrace() {
+  std::string json;
+  {
+    auto output = jvc::OutputStream::FromString(json);
+    jvc::TimeTraceProfiler::Write(*output);
+  }
+  return json;
+}
+
+} // namespace <anonymous>
+
+class TimeTraceTests : public ::testing::Test {
+protected:
+  void TearDown() override {
+    jvc::TimeTraceProfiler::Shutdown();
+  }
+};
+
+TEST_F(TimeTraceTests, WritesNestedScopesPerThread) {
+  jvc::TimeTraceProfiler::Initialize();
+  {
+    jvc::TimeTraceScope outer { "TestOuter", "a \"quoted\" detail" };
+    jvc::TimeTraceScope inner { "TestInner" };
+  }
+  std::thread worker { []() { jvc::TimeTraceScope scope { "TestWorker" }; } };
+  worker.join();
+
+  auto json = writeTimeTrace();
+  ASSERT_EQ(json.find("{\"traceEvents\":["), 0);
+  ASSERT_NE(json.find("\"name\":\"TestOuter\",\"cat\":\"jvc\",\"ph\":\"X\""), std::string::npos);
+  ASSERT_NE(json.find("\"args\":{\"detail\":\"a \\\"quoted\\\" detail\"}"), std::string::npos);
+  ASSERT_LT(json.find("\"TestOuter\""), json.find("\"TestInner\""));
+  ASSERT_NE(json.find("\"name\":\"TestWorker\""), std::string::npos);
+  ASSERT_NE(json.find("\"args\":{\"name\":\"main\"}"), std::string::npos);
+  ASSERT_NE(json.find("\"args\":{\"name\":\"worker "), std::string::npos);
+}
+
+TEST_F(TimeTraceTests, ShutdownDiscardsEvents) {
+  jvc::TimeTraceProfiler::Initialize();
+  {
+    jvc::TimeTraceScope scope { "TestDiscarded" };
+  }
+  jvc::TimeTraceProfiler::Shutdown();
+  ASSERT_FALSE(jvc::TimeTraceProfiler::IsEnabled());
+  {
+    jvc::TimeTraceScope scope { "TestNotRecorded" };
+  }
+
+  auto json = writeTimeTrace();
+  ASSERT_EQ(json.find("\"TestDiscarded\""), std::string::npos);
+  ASSERT_EQ(json.find("\"TestNotRecorded\""), std::string::npos);
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,88 @@
+//
+// Created by Sirui Mu on 2019/12/28.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Unicode.h"
+
+#include <string>
+
+TEST(Unicode, IsASCII) {
+  std::string ascii(100, 'a');
+  ASSERT_TRUE(jvc::IsASCII(ascii.data(), ascii.size())) << "IsASCII rejects an ASCII buffer.";
+
+  for (auto position : { 0, 7, 31, 32, 63, 99 }) {
+    auto text = ascii;
+    text[position] = '\xC3';
+    ASSERT_FALSE(jvc::IsASCII(text.data(), text.size()))
+        << "IsASCII misses a non-ASCII byte at position " << position << ".";
+  }
+}
+
+TEST(Unicode, DecodeUTF8) {
+  char32_t cp;
+
+  ASSERT_EQ(jvc::DecodeUTF8("a", 1, cp), 1);
+  ASSERT_EQ(cp, U'a');
+
+  ASSERT_EQ(jvc::DecodeUTF8("\xCE\xB1", 2, cp), 2);
+  ASSERT_EQ(cp, U'α');
+
+  ASSERT_EQ(jvc::DecodeUTF8("\xE5\x90\x8D", 3, cp), 3);
+  ASSERT_EQ(cp, U'名');
+
+  ASSERT_EQ(jvc::DecodeUTF8("\xF0\x9F\x98\x80", 4, cp), 4);
+  ASSERT_EQ(cp, U'\U0001F600');
+}
+
+TEST(Unicode, DecodeMalformedUTF8) {
+  char32_t cp;
+
+  ASSERT_EQ(jvc::DecodeUTF8("\x80", 1, cp), 1) << "continuation byte is not skipped.";
+  ASSERT_EQ(cp, jvc::ReplacementCharacter);
+
+  ASSERT_EQ(jvc::DecodeUTF8("\xE5\x90", 2, cp), 1) << "truncated sequence is not rejected.";
+  ASSERT_EQ(cp, jvc::ReplacementCharacter);
+
+  ASSERT_EQ(jvc::DecodeUTF8("\xC0\xAF", 2, cp), 1) << "overlong sequence is not rejected.";
+  ASSERT_EQ(cp, jvc::ReplacementCharacter);
+
+  ASSERT_EQ(jvc::DecodeUTF8("\xED\xA0\x80", 3, cp), 3) << "surrogate is not rejected.";
+  ASSERT_EQ(cp, jvc::ReplacementCharacter);
+}
+
+TEST(Unicode, EncodeUTF8) {
+  for (char32_t cp : { U'a', U'α', U'名', U'\U0001F600' }) {
+    std::string encoded;
+    auto length = jvc::EncodeUTF8(cp, encoded);
+    ASSERT_EQ(length, encoded.size());
+
+    char32_t decoded;
+    ASSERT_EQ(jvc::DecodeUTF8(encoded.data(), encoded.size(), decoded), length);
+    ASSERT_EQ(decoded, cp) << "EncodeUTF8 and DecodeUTF8 do not round-trip.";
+  }
+}
+
+TEST(Unicode, JavaIdentifierCharacters) {
+  ASSERT_TRUE(jvc::IsJavaIdentifierStart(U'a'));
+  ASSERT_TRUE(jvc::IsJavaIdentifierStart(U'$'));
+  ASSERT_TRUE(jvc::IsJavaIdentifierStart(U'_'));
+  ASSERT_TRUE(jvc::IsJavaIdentifierStart(U'α'));
+  ASSERT_TRUE(jvc::IsJavaIdentifierStart(U'名'));
+  ASSERT_FALSE(jvc::IsJavaIdentifierStart(U'1'));
+  ASSERT_FALSE(jvc::IsJavaIdentifierStart(U' '));
+  ASSERT_FALSE(jvc::IsJavaIdentifierStart(U'\U0001F600'));
+
+  ASSERT_TRUE(jvc::IsJavaIdentifierPart(U'1'));
+  ASSERT_TRUE(jvc::IsJavaIdentifierPart(U'٣'));
+  ASSERT_TRUE(jvc::IsJavaIdentifierPart(U'́'));
+  ASSERT_FALSE(jvc::IsJavaIdentifierPart(U'+'));
+  ASSERT_FALSE(jvc::IsJavaIdentifierPart(U'　'));
+  ASSERT_FALSE(jvc::IsJavaIdentifierPart(0x110000));
+}
+
+#pragma clang diagnostic pop
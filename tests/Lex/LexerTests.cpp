@@ -11,6 +11,7 @@
 #include "Frontend/CompilerInstance.h"
 #include "Lex/Token.h"
 #include "Lex/Lexer.h"
+#include "Lex/LexerStatistics.h"
 
 class LexerTest : public ::testing::Test {
 protected:
@@ -80,7 +81,7 @@ TEST_F(LexerTest, LexStringLiteral) {
   auto lexer = CreateLexer("name", "\"literal\\n\\t\\uac12\\123value\" interface", options);
 
   auto token = lexer->ReadNextToken();
-  ASSERT_IS_STRING_LITERAL(token.get(), "literal\n\t\x12\xAC\x53value");
+  ASSERT_IS_STRING_LITERAL(token.get(), "literal\n\t\xEA\xB0\x92\x53value");
 
   token = lexer->ReadNextToken();
   ASSERT_IS_KEYWORD(token.get(), jvc::KeywordKind::Interface);
@@ -115,6 +116,13 @@ TEST_F(LexerTest, LexStringLiteral) {
     ASSERT_EQ(dynamic_cast<jvc::NumberLiteralToken *>(token)->suffix(), (literalSuffix)) \
         << "number literal suffix is not correct"
 
+TEST_F(LexerTest, LexStringLiteralQuoteEscape) {
+  auto lexer = CreateLexer("name", "\"say \\\"hi\\\"\"");
+
+  auto token = lexer->ReadNextToken();
+  ASSERT_IS_STRING_LITERAL(token.get(), "say \"hi\"");
+}
+
 TEST_F(LexerTest, LexNumberLiteral) {
   jvc::LexerOptions options { };
   options.KeepWhitespace = false;
@@ -249,4 +257,122 @@ TEST_F(LexerTest, LexComment) {
   ASSERT_FALSE(token) << "Lexer does not return nullptr at EOF.";
 }
 
+TEST_F(LexerTest, LexUnicodeIdentifier) {
+  jvc::LexerOptions options { };
+  options.KeepWhitespace = false;
+  auto lexer = CreateLexer("name", "int \xCE\xB1\xCE\xB2 = \xE5\x90\x8D\xE5\xAD\x97_1;", options);
+
+  auto token = lexer->ReadNextToken();
+  ASSERT_IS_KEYWORD(token.get(), jvc::KeywordKind::Int);
+
+  token = lexer->ReadNextToken();
+  ASSERT_IS_IDENTIFIER(token.get(), "\xCE\xB1\xCE\xB2");
+
+  token = lexer->ReadNextToken();
+  ASSERT_IS_OPERATOR(token.get(), jvc::OperatorKind::Assignment);
+
+  token = lexer->ReadNextToken();
+  ASSERT_IS_IDENTIFIER(token.get(), "\xE5\x90\x8D\xE5\xAD\x97_1");
+
+  token = lexer->ReadNextToken();
+  ASSERT_IS_DELIMITER(token.get(), jvc::DelimiterKind::Semicolon);
+}
+
+TEST_F(LexerTest, LineTerminators) {
+  jvc::LexerOptions options { };
+  options.KeepWhitespace = false;
+  auto lexer = CreateLexer("name", "a\r\nb\rc // d\re", options);
+
+  for (auto [name, row] : { std::make_pair("a", 1), std::make_pair("b", 2), std::make_pair("c", 3) }) {
+    auto token = lexer->ReadNextToken();
+    ASSERT_IS_IDENTIFIER(token.get(), name);
+    ASSERT_EQ(token->range().start(), (jvc::SourceLocation { 1, static_cast<uint64_t>(row), 1 })) << "wrong location of " << name;
+  }
+
+  // The line comment must stop at the lone CR.
+  auto token = lexer->ReadNextToken();
+  ASSERT_IS_IDENTIFIER(token.get(), "e");
+  ASSERT_EQ(token->range().start(), (jvc::SourceLocation { 1, 4, 1 }));
+}
+
+TEST_F(LexerTest, TranslateUnicodeEscapes) {
+  jvc::LexerOptions options { };
+  options.KeepWhitespace = false;
+  auto lexer = CreateLexer("name", "\\u0070ublic a\\uu0062c \"\\\\u0041\"", options);
+
+  auto token = lexer->ReadNextToken();
+  ASSERT_IS_KEYWORD(token.get(), jvc::KeywordKind::Public);
+
+  token = lexer->ReadNextToken();
+  ASSERT_IS_IDENTIFIER(token.get(), "abc");
+  jvc::SourceRange expectedRange {
+    jvc::SourceLocation { 1, 1, 13 },
+    jvc::SourceLocation { 1, 1, 22 }
+  };
+  ASSERT_EQ(token->range(), expectedRange) << "unicode escapes are not counted by their width in the source.";
+
+  // The backslash before `u0041` is preceded by another backslash and thus does not start a unicode escape.
+  token = lexer->ReadNextToken();
+  ASSERT_IS_STRING_LITERAL(token.get(), "\\u0041");
+
+  token = lexer->ReadNextToken();
+  ASSERT_FALSE(token) << "Lexer does not return nullptr at EOF.";
+}
+
+TEST_F(LexerTest, LexUnicodeCharLiteral) {
+  jvc::LexerOptions options { };
+  options.KeepWhitespace = false;
+  auto lexer = CreateLexer("name", "'\xC3\xA9' '\\uD83D\\uDE00'", options);
+
+  auto token = lexer->ReadNextToken();
+  ASSERT_TRUE(token && token->IsLiteral()) << "token is not a literal token";
+  ASSERT_EQ(dynamic_cast<jvc::CharacterLiteralToken *>(token.get())->value(), U'\u00E9')
+      << "value of character literal is not correct";
+
+  token = lexer->ReadNextToken();
+  ASSERT_TRUE(token && token->IsLiteral()) << "token is not a literal token";
+  ASSERT_EQ(dynamic_cast<jvc::CharacterLiteralToken *>(token.get())->value(), U'\U0001F600')
+      << "surrogate pairs in unicode escapes are not combined";
+}
+
+TEST_F(LexerTest, ReadAllTokens) {
+  jvc::LexerOptions options { };
+  options.KeepWhitespace = false;
+  options.KeepComment = false;
+  auto lexer = CreateLexer("name", "public /* comment */ identifier;", options);
+
+  auto token = lexer->PeekNextToken();
+  ASSERT_IS_KEYWORD(token, jvc::KeywordKind::Public);
+
+  std::vector<std::unique_ptr<jvc::Token>> tokens;
+  ASSERT_EQ(lexer->ReadAllTokens(tokens), 3) << "Lexer reads wrong number of tokens.";
+  ASSERT_IS_KEYWORD(tokens[0].get(), jvc::KeywordKind::Public);
+  ASSERT_IS_IDENTIFIER(tokens[1].get(), "identifier");
+  ASSERT_IS_DELIMITER(tokens[2].get(), jvc::DelimiterKind::Semicolon);
+
+  token = lexer->PeekNextToken();
+  ASSERT_FALSE(token) << "Lexer does not return nullptr at EOF.";
+}
+
+TEST_F(LexerTest, CollectStatistics) {
+  jvc::LexerOptions options { };
+  options.CollectStatistics = true;
+  auto lexer = CreateLexer("name", "public  /* comment */ identifier", options);
+
+  while (lexer->ReadNextToken()) { }
+
+  auto stats = lexer->GetStatistics();
+  if (!jvc::LexerStatistics::IsEnabled()) {
+    ASSERT_EQ(stats, nullptr) << "Lexer collects statistics when they are not compiled in.";
+    return;
+  }
+
+  ASSERT_NE(stats, nullptr) << "Lexer does not collect statistics.";
+  ASSERT_EQ(stats->tokens(), 5) << "Lexer statistics count wrong number of tokens.";
+  ASSERT_EQ(stats->bytes(), 32) << "Lexer statistics count wrong number of bytes.";
+  ASSERT_EQ(stats->GetTokenCount(jvc::TokenKind::Whitespace), 2) << "Lexer statistics count wrong token kinds.";
+  ASSERT_EQ(stats->longestTokens().front().Bytes, 10) << "Lexer statistics give wrong longest token.";
+  ASSERT_EQ(stats->longestComments().front().Bytes, 13) << "Lexer statistics give wrong longest comment.";
+}
+
 #pragma clang diagnostic pop
\ No newline at end of file
@@ -0,0 +1,78 @@
+//
+// Created by Sirui Mu on 2020/1/10.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "Infrastructure/Stream.h"
+#include "Frontend/CompilerInstance.h"
+#include "Lex/Lexer.h"
+#include "Lex/Token.h"
+#include "Lex/TokenDumper.h"
+
+#include <cstring>
+#include <string>
+
+TEST(TokenDumperTests, BinaryLayout) {
+  jvc::CompilerInstance ci;
+  std::string content = "int x\n  = \"hi\";\n";
+  auto fileId = ci.GetSourceManager().Load("A.java", jvc::InputStream::FromBuffer(content.data(), content.size()));
+  auto sourceFile = ci.GetSourceManager().GetSourceFileInfo(fileId);
+
+  std::string output;
+  {
+    jvc::StreamWriter writer { jvc::OutputStream::FromString(output) };
+    jvc::TokenDumper::WriteHeader(jvc::TokenDumpFormat::Binary, writer.stream());
+    auto dumper = jvc::TokenDumper::Create(jvc::TokenDumpFormat::Binary, *sourceFile, writer);
+    auto lexer = jvc::Lexer::Create(ci, fileId, jvc::LexerOptions { });
+    while (auto token = lexer->ReadNextToken()) {
+      dumper->Dump(*token);
+    }
+    dumper->Finish();
+  }
+
+  jvc::TokenDumpHeader header { };
+  ASSERT_GE(output.size(), sizeof(header));
+  std::memcpy(&header, output.data(), sizeof(header));
+  ASSERT_EQ(std::memcmp(header.Magic, jvc::TokenDumpHeader::ExpectedMagic, sizeof(header.Magic)), 0);
+  ASSERT_EQ(header.Version, jvc::TokenDumpHeader::CurrentVersion);
+  ASSERT_EQ(header.RecordSize, sizeof(jvc::TokenRecord));
+
+  jvc::TokenDumpSectionHeader section { };
+  auto p = output.data() + sizeof(header);
+  std::memcpy(&section, p, sizeof(section));
+  p += sizeof(section);
+  ASSERT_EQ(section.FileId, static_cast<uint32_t>(fileId));
+  ASSERT_EQ(section.RecordCount, 5u);
+  ASSERT_EQ(section.StringCount, 3u);
+
+  jvc::TokenRecord records[5];
+  std::memcpy(records, p, sizeof(records));
+  p += sizeof(records);
+  uint64_t stringOffsets[4];
+  std::memcpy(stringOffsets, p, sizeof(stringOffsets));
+  p += sizeof(stringOffsets);
+  auto getString = [p, &stringOffsets](uint32_t index) {
+    return std::string { p + stringOffsets[index], p + stringOffsets[index + 1] };
+  };
+  ASSERT_EQ(getString(section.PathIndex), "A.java");
+
+  // `x` is an identifier at offset 4; the string literal starts on the second line, at offset 10.
+  ASSERT_EQ(records[1].Kind, static_cast<uint8_t>(jvc::TokenKind::Identifier));
+  ASSERT_EQ(records[1].Offset, 4u);
+  ASSERT_EQ(records[1].Length, 1u);
+  ASSERT_EQ(getString(records[1].Payload), "x");
+  ASSERT_EQ(records[3].Kind, static_cast<uint8_t>(jvc::TokenKind::Literal));
+  ASSERT_EQ(records[3].Offset, 10u);
+  ASSERT_EQ(records[3].Length, 4u);
+  ASSERT_EQ(getString(records[3].Payload), "hi");
+  ASSERT_EQ(records[4].Payload, jvc::TokenRecord::NoPayload);
+
+  auto stringBytes = static_cast<size_t>(section.StringBytes);
+  ASSERT_EQ(p + stringBytes + (8 - stringBytes % 8) % 8, output.data() + output.size());
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,46 @@
+//
+// Created by Sirui Mu on 2019/12/30.
+//
+
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+#include "gtest/gtest.h"
+
+#include "CorpusGenerator.h"
+
+#include <algorithm>
+
+TEST(CorpusGenerator, Deterministic) {
+  jvc::CorpusOptions options { };
+  options.Seed = 42;
+  options.Files = 4;
+  options.LinesPerFile = 200;
+
+  jvc::CorpusGenerator first { options };
+  jvc::CorpusGenerator second { options };
+  ASSERT_EQ(first.GenerateFile(3), second.GenerateFile(3)) << "CorpusGenerator is not deterministic.";
+  ASSERT_NE(first.GenerateFile(2), first.GenerateFile(3)) << "CorpusGenerator generates identical files.";
+
+  options.Seed = 43;
+  jvc::CorpusGenerator third { options };
+  ASSERT_NE(first.GenerateFile(3), third.GenerateFile(3)) << "CorpusGenerator ignores the seed.";
+}
+
+TEST(CorpusGenerator, LinesPerFile) {
+  for (auto mix : { jvc::CorpusMix::Balanced, jvc::CorpusMix::CommentHeavy, jvc::CorpusMix::LiteralHeavy,
+                    jvc::CorpusMix::LongIdentifier, jvc::CorpusMix::DeeplyNested }) {
+    for (auto lines : { 1, 5, 6, 9, 1000 }) {
+      jvc::CorpusOptions options { };
+      options.LinesPerFile = lines;
+      options.Mix = mix;
+
+      auto content = jvc::CorpusGenerator { options }.GenerateFile(0);
+      auto expectedLines = std::max<size_t>(lines, jvc::CorpusGenerator::MinimumLinesPerFile);
+      ASSERT_EQ(std::count(content.begin(), content.end(), '\n'), expectedLines)
+          << "CorpusGenerator generates wrong number of lines for mix " << jvc::GetCorpusMixName(mix) << ".";
+    }
+  }
+}
+
+#pragma clang diagnostic pop
@@ -0,0 +1,440 @@
+//
+// Created by Sirui Mu on 2019/12/30.
+//
+
+#include "Infrastructure/Stream.h"
+#include "CorpusGenerator.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace jvc {
+
+const char* GetCorpusMixName(CorpusMix mix) {
+  switch (mix) {
+#define DECLARE_CASE(item, name) case CorpusMix::item: return name;
+    JVC_CORPUS_MIX_LIST(DECLARE_CASE)
+#undef DECLARE_CASE
+    default:
+      return "unknown";
+  }
+}
+
+bool ParseCorpusMix(const std::string& name, CorpusMix& mix) {
+#define DECLARE_COMPARISON(item, itemName) \
+  if (name == itemName) { \
+    mix = CorpusMix::item; \
+    return true; \
+  }
+  JVC_CORPUS_MIX_LIST(DECLARE_COMPARISON)
+#undef DECLARE_COMPARISON
+  return false;
+}
+
+namespace {
+
+/**
+ * @brief SplitMix64 pseudo random number generator. It is tiny, fast and, unlike the distributions in <random>, gives
+ * the same output on every standard library implementation.
+ */
+class CorpusRandom {
+public:
+  explicit CorpusRandom(uint64_t seed)
+      : _state(seed)
+  { }
+
+  uint64_t Next() {
+    uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27u)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31u);
+  }
+
+  /**
+   * @brief Get a random number in [min, max].
+   */
+  size_t Range(size_t min, size_t max) {
+    return min + static_cast<size_t>(Next() % (max - min + 1));
+  }
+
+  bool Chance(unsigned percent) {
+    return Next() % 100 < percent;
+  }
+
+  template <typename T, size_t N>
+  const T& Pick(const T (&items)[N]) {
+    return items[Next() % N];
+  }
+
+private:
+  uint64_t _state;
+};
+
+enum class ElementKind {
+  Comment,
+  Literal,
+  Identifier,
+  Expression,
+  Nested,
+};
+
+struct MixProfile {
+  // Weights of the element kinds, in the order of ElementKind.
+  unsigned Weights[5];
+  size_t MaxDepth;
+  size_t MaxMethodLines;
+  size_t MinIdentifierLength;
+  size_t MaxIdentifierLength;
+};
+
+const MixProfile& getMixProfile(CorpusMix mix) {
+  static const MixProfile Balanced { { 15, 20, 15, 35, 15 }, 8, 40, 3, 12 };
+  static const MixProfile CommentHeavy { { 60, 10, 5, 20, 5 }, 8, 40, 3, 12 };
+  static const MixProfile LiteralHeavy { { 5, 65, 5, 20, 5 }, 8, 40, 3, 12 };
+  static const MixProfile LongIdentifier { { 5, 10, 60, 20, 5 }, 8, 40, 30, 120 };
+  static const MixProfile DeeplyNested { { 5, 10, 5, 20, 60 }, 256, 1000, 3, 12 };
+
+  switch (mix) {
+    case CorpusMix::CommentHeavy: return CommentHeavy;
+    case CorpusMix::LiteralHeavy: return LiteralHeavy;
+    case CorpusMix::LongIdentifier: return LongIdentifier;
+    case CorpusMix::DeeplyNested: return DeeplyNested;
+    default: return Balanced;
+  }
+}
+
+const char* const Words[] = {
+  "value", "count", "index", "buffer", "result", "total", "node", "item", "offset", "limit", "cache", "state", "token",
+  "source", "target", "length", "scale", "factor", "entry", "record",
+};
+
+const char* const Syllables[] = {
+  "ka", "lo", "mi", "ne", "ru", "sa", "to", "vi", "ze", "qu", "bar", "dor", "fen", "gil", "hum", "jas",
+};
+
+/**
+ * @brief Generate a single file. Lines are buffered and flushed to the output stream in chunks.
+ */
+class FileGenerator {
+public:
+  explicit FileGenerator(const CorpusOptions& options, size_t index, OutputStream& output)
+      : _options(options),
+        _profile(getMixProfile(options.Mix)),
+        _random(options.Seed ^ (0xD1B54A32D192ED03ull * (index + 1))),
+        _index(index),
+        _output(output),
+        _depth(0),
+        _nextName(0)
+  { }
+
+  void Generate() {
+    auto lines = std::max(_options.LinesPerFile, CorpusGenerator::MinimumLinesPerFile);
+
+    char header[128];
+    std::snprintf(header, sizeof(header), "// Generated by JVCCorpusGen: seed=%llu mix=%s file=%zu",
+                  static_cast<unsigned long long>(_options.Seed), GetCorpusMixName(_options.Mix), _index);
+    line() << header;
+    endLine();
+    line() << "package corpus.p" << std::to_string(_index / 1000) << ';';
+    endLine();
+    endLine();
+    line() << "public class C" << std::to_string(_index) << " {";
+    endLine();
+
+    ++_depth;
+    auto budget = lines - CorpusGenerator::MinimumLinesPerFile;
+    while (budget > 0) {
+      if (budget >= 4) {
+        auto bodyLines = std::min(budget - 3, _random.Range(4, _profile.MaxMethodLines));
+        emitMethod(bodyLines);
+        budget -= bodyLines + 3;
+      } else {
+        emitField();
+        --budget;
+      }
+    }
+    --_depth;
+
+    line() << '}';
+    endLine();
+    flush();
+  }
+
+private:
+  constexpr static const size_t FlushThreshold = 64 * 1024;
+
+  const CorpusOptions& _options;
+  const MixProfile& _profile;
+  CorpusRandom _random;
+  size_t _index;
+  OutputStream& _output;
+  std::string _buffer;
+  size_t _depth;
+  size_t _nextName;
+
+  /**
+   * @brief Start a new line at the current indentation.
+   */
+  FileGenerator& line() {
+    _buffer.append(std::min<size_t>(_depth, 64) * 4, ' ');
+    return *this;
+  }
+
+  FileGenerator& operator<<(const std::string& s) {
+    _buffer += s;
+    return *this;
+  }
+
+  FileGenerator& operator<<(const char* s) {
+    _buffer += s;
+    return *this;
+  }
+
+  FileGenerator& operator<<(char ch) {
+    _buffer.push_back(ch);
+    return *this;
+  }
+
+  void endLine() {
+    _buffer.push_back('\n');
+    if (_buffer.size() >= FlushThreshold) {
+      flush();
+    }
+  }
+
+  void flush() {
+    _output.Write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+  }
+
+  std::string identifier() {
+    std::string name;
+    auto length = _random.Range(_profile.MinIdentifierLength, _profile.MaxIdentifierLength);
+    while (name.size() < length) {
+      std::string syllable { _random.Pick(Syllables) };
+      if (!name.empty() && _random.Chance(40)) {
+        syllable[0] = static_cast<char>(syllable[0] - 'a' + 'A');
+      }
+      name += syllable;
+    }
+    if (_random.Chance(30)) {
+      name += std::to_string(_nextName++);
+    }
+    return name;
+  }
+
+  std::string words(size_t min, size_t max) {
+    std::string text;
+    auto count = _random.Range(min, max);
+    for (size_t i = 0; i < count; ++i) {
+      if (i) {
+        text.push_back(' ');
+      }
+      text += _random.Pick(Words);
+    }
+    return text;
+  }
+
+  std::string numberLiteral() {
+    switch (_random.Range(0, 4)) {
+      case 0: return std::to_string(_random.Range(0, 1000000));
+      case 1: return std::to_string(_random.Range(0, 1000000000)) + "L";
+      case 2: {
+        char hex[32];
+        std::snprintf(hex, sizeof(hex), "0x%llX", static_cast<unsigned long long>(_random.Range(1, 0xFFFFFF)));
+        return hex;
+      }
+      case 3: return std::to_string(_random.Range(1, 999)) + "." + std::to_string(_random.Range(1, 99)) + "f";
+      default:
+        return std::to_string(_random.Range(1, 99)) + "." + std::to_string(_random.Range(1, 999)) + "e"
+            + (_random.Chance(50) ? "-" : "") + std::to_string(_random.Range(1, 30));
+    }
+  }
+
+  std::string stringLiteral() {
+    const char* const Escapes[] = { "\\t", "\\n", "\\\"", "\\\\", "\\u00e9", "\\101" };
+
+    std::string literal { "\"" };
+    auto count = _random.Range(1, 8);
+    for (size_t i = 0; i < count; ++i) {
+      literal += _random.Pick(Words);
+      literal += _random.Chance(30) ? _random.Pick(Escapes) : " ";
+    }
+    literal.push_back('"');
+    return literal;
+  }
+
+  std::string charLiteral() {
+    const char* const Chars[] = { "'a'", "'Z'", "'0'", "' '", "'\\n'", "'\\t'", "'\\''", "'\\\\'", "'\\u0041'" };
+    return _random.Pick(Chars);
+  }
+
+  std::string expression() {
+    const char* const Operators[] = { " + ", " - ", " * ", " / ", " % ", " & ", " | ", " ^ ", " << ", " >> ", " >>> " };
+
+    std::string expr = identifier();
+    auto terms = _random.Range(1, 4);
+    for (size_t i = 0; i < terms; ++i) {
+      expr += _random.Pick(Operators);
+      expr += _random.Chance(50) ? identifier() : std::to_string(_random.Range(1, 1000));
+    }
+    return _random.Chance(30) ? "(" + expr + ")" : expr;
+  }
+
+  std::string condition() {
+    const char* const Comparisons[] = { " < ", " <= ", " > ", " >= ", " == ", " != " };
+    auto cond = identifier() + _random.Pick(Comparisons) + std::to_string(_random.Range(0, 100));
+    if (_random.Chance(30)) {
+      cond += _random.Chance(50) ? " && " : " || ";
+      cond += "!" + identifier();
+    }
+    return cond;
+  }
+
+  ElementKind pickElement() {
+    unsigned total = 0;
+    for (auto weight : _profile.Weights) {
+      total += weight;
+    }
+
+    auto r = static_cast<unsigned>(_random.Next() % total);
+    for (size_t i = 0; i < 5; ++i) {
+      if (r < _profile.Weights[i]) {
+        return static_cast<ElementKind>(i);
+      }
+      r -= _profile.Weights[i];
+    }
+    return ElementKind::Expression;
+  }
+
+  void emitField() {
+    const char* const Modifiers[] = { "private ", "protected ", "public ", "private static final " };
+    line() << _random.Pick(Modifiers) << "int " << identifier() << " = " << std::to_string(_random.Range(0, 100))
+           << ';';
+    endLine();
+  }
+
+  void emitMethod(size_t bodyLines) {
+    line() << "public long " << identifier() << "(long " << identifier() << ", int " << identifier() << ") {";
+    endLine();
+    ++_depth;
+    emitBlock(bodyLines);
+    line() << "return " << identifier() << ';';
+    endLine();
+    --_depth;
+    line() << '}';
+    endLine();
+  }
+
+  /**
+   * @brief Emit statements filling exactly the given number of lines at the current depth.
+   */
+  void emitBlock(size_t budget) {
+    while (budget > 0) {
+      auto kind = pickElement();
+      if (kind == ElementKind::Nested && budget >= 3 && _depth < _profile.MaxDepth) {
+        // Deeply nested corpora spend almost all of their budget on the innermost block, producing long chains.
+        auto inner = _options.Mix == CorpusMix::DeeplyNested ? budget - 2 : _random.Range(1, budget - 2);
+        emitNested(inner);
+        budget -= inner + 2;
+      } else if (kind == ElementKind::Comment && budget >= 3 && _random.Chance(40)) {
+        auto lines = _random.Range(3, std::min<size_t>(budget, 8));
+        emitBlockComment(lines);
+        budget -= lines;
+      } else {
+        emitStatement(kind);
+        --budget;
+      }
+    }
+  }
+
+  void emitNested(size_t inner) {
+    switch (_random.Range(0, 2)) {
+      case 0:
+        line() << "if (" << condition() << ") {";
+        break;
+      case 1:
+        line() << "while (" << condition() << ") {";
+        break;
+      default: {
+        auto i = identifier();
+        line() << "for (int " << i << " = 0; " << i << " < " << std::to_string(_random.Range(1, 100)) << "; ++"
+               << i << ") {";
+        break;
+      }
+    }
+    endLine();
+
+    ++_depth;
+    emitBlock(inner);
+    --_depth;
+
+    line() << '}';
+    endLine();
+  }
+
+  void emitBlockComment(size_t lines) {
+    line() << (_random.Chance(50) ? "/**" : "/*");
+    endLine();
+    for (size_t i = 2; i < lines; ++i) {
+      line() << " * " << words(2, 12);
+      endLine();
+    }
+    line() << " */";
+    endLine();
+  }
+
+  void emitStatement(ElementKind kind) {
+    switch (kind) {
+      case ElementKind::Comment:
+        line() << "// " << words(2, 12);
+        break;
+      case ElementKind::Literal:
+        switch (_random.Range(0, 2)) {
+          case 0:
+            line() << "String " << identifier() << " = " << stringLiteral() << ';';
+            break;
+          case 1:
+            line() << "char " << identifier() << " = " << charLiteral() << ';';
+            break;
+          default:
+            line() << "double " << identifier() << " = " << numberLiteral() << " + " << numberLiteral() << ';';
+            break;
+        }
+        break;
+      case ElementKind::Identifier:
+        line() << identifier() << '.' << identifier() << '(' << identifier() << ", " << identifier() << ");";
+        break;
+      default: {
+        const char* const Assignments[] = { " = ", " += ", " -= ", " *= ", " |= " };
+        line() << identifier() << _random.Pick(Assignments) << expression() << ';';
+        break;
+      }
+    }
+    endLine();
+  }
+};
+
+} // namespace <anonymous>
+
+CorpusGenerator::CorpusGenerator(CorpusOptions options)
+    : _options(options)
+{ }
+
+std::string CorpusGenerator::GetFilePath(size_t index) const {
+  return "p" + std::to_string(index / 1000) + "/C" + std::to_string(index) + ".java";
+}
+
+void CorpusGenerator::GenerateFile(size_t index, OutputStream& output) const {
+  FileGenerator generator { _options, index, output };
+  generator.Generate();
+}
+
+std::string CorpusGenerator::GenerateFile(size_t index) const {
+  std::string content;
+  auto output = OutputStream::FromString(content);
+  GenerateFile(index, *output);
+  return content;
+}
+
+} // namespace jvc
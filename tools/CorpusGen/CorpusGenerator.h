@@ -0,0 +1,129 @@
+//
+// Created by Sirui Mu on 2019/12/30.
+//
+
+#ifndef JVC_CORPUSGENERATOR_H
+#define JVC_CORPUSGENERATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace jvc {
+
+class OutputStream;
+
+#define JVC_CORPUS_MIX_LIST(h) \
+    h(Balanced, "balanced") \
+    h(CommentHeavy, "comment") \
+    h(LiteralHeavy, "literal") \
+    h(LongIdentifier, "identifier") \
+    h(DeeplyNested, "nested")
+
+/**
+ * @brief Kinds of content mixes of generated java source code.
+ */
+enum class CorpusMix {
+#define DECLARE_ENUM_ITEM(item, name) item,
+  JVC_CORPUS_MIX_LIST(DECLARE_ENUM_ITEM)
+#undef DECLARE_ENUM_ITEM
+};
+
+/**
+ * @brief Get the name of the given content mix.
+ * @param mix the content mix.
+ * @return the name of the content mix.
+ */
+const char* GetCorpusMixName(CorpusMix mix);
+
+/**
+ * @brief Parse the name of a content mix.
+ * @param name the name of the content mix.
+ * @param mix output parameter, the content mix.
+ * @return whether the name denotes a content mix.
+ */
+bool ParseCorpusMix(const std::string& name, CorpusMix& mix);
+
+/**
+ * @brief Options controlling the shape and content of a generated corpus.
+ */
+struct CorpusOptions {
+  /**
+   * @brief Seed of the pseudo random number generator. The same seed always produces the same corpus.
+   */
+  uint64_t Seed = 1;
+
+  /**
+   * @brief Number of files in the corpus.
+   */
+  size_t Files = 1;
+
+  /**
+   * @brief Number of lines in each file. Files have at least @see CorpusGenerator::MinimumLinesPerFile lines.
+   */
+  size_t LinesPerFile = 1000;
+
+  /**
+   * @brief The content mix.
+   */
+  CorpusMix Mix = CorpusMix::Balanced;
+};
+
+/**
+ * @brief Generate synthetic java source code deterministically.
+ *
+ * Every file is generated from its own random stream derived from the seed and the file index, so files can be
+ * generated independently, in any order, and each file is always the same for the same options.
+ */
+class CorpusGenerator {
+public:
+  /**
+   * @brief Minimum number of lines in a generated file.
+   */
+  constexpr static const size_t MinimumLinesPerFile = 5;
+
+  /**
+   * @brief Initialize a new @see CorpusGenerator object.
+   * @param options the corpus options.
+   */
+  explicit CorpusGenerator(CorpusOptions options);
+
+  /**
+   * @brief Get the corpus options.
+   * @return the corpus options.
+   */
+  [[nodiscard]]
+  const CorpusOptions& options() const { return _options; }
+
+  /**
+   * @brief Get the path of the specified file, relative to the root of the corpus. Files are grouped into package
+   * directories of at most 1000 files each.
+   * @param index index of the file.
+   * @return the relative path of the file.
+   */
+  [[nodiscard]]
+  std::string GetFilePath(size_t index) const;
+
+  /**
+   * @brief Generate the specified file into the given output stream. The file is written in chunks so that arbitrarily
+   * large files can be generated in constant memory.
+   * @param index index of the file.
+   * @param output the output stream.
+   */
+  void GenerateFile(size_t index, OutputStream& output) const;
+
+  /**
+   * @brief Generate the specified file.
+   * @param index index of the file.
+   * @return the content of the file.
+   */
+  [[nodiscard]]
+  std::string GenerateFile(size_t index) const;
+
+private:
+  CorpusOptions _options;
+};
+
+} // namespace jvc
+
+#endif // JVC_CORPUSGENERATOR_H
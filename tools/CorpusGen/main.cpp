@@ -0,0 +1,117 @@
+//
+// Created by Sirui Mu on 2019/12/30.
+//
+
+#include "Infrastructure/Stream.h"
+#include "CorpusGenerator.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace {
+
+struct CorpusGenArgs {
+  jvc::CorpusOptions Options;
+  std::string OutputDirectory;
+};
+
+[[noreturn]] void PrintUsageAndExit(const char* program) {
+  std::cerr << "usage: " << program << " --output DIR [--seed N] [--files N] [--lines N] [--mix NAME]" << std::endl
+            << "       " << program << " --output DIR --preset giant-single|many-tiny --total-lines N [--seed N]"
+            << " [--mix NAME]" << std::endl
+            << "Mixes: balanced, comment, literal, identifier, nested. Use '-' as DIR to write all files to stdout."
+            << std::endl;
+  std::exit(1);
+}
+
+CorpusGenArgs ParseCommandLine(int argc, char* argv[]) {
+  CorpusGenArgs args { };
+  std::string preset;
+  size_t totalLines = 0;
+
+  for (auto i = 1; i < argc; ++i) {
+    if (i + 1 >= argc) {
+      PrintUsageAndExit(argv[0]);
+    }
+
+    std::string name { argv[i] };
+    std::string value { argv[++i] };
+    if (name == "--output") {
+      args.OutputDirectory = value;
+    } else if (name == "--seed") {
+      args.Options.Seed = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "--files") {
+      args.Options.Files = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "--lines") {
+      args.Options.LinesPerFile = std::strtoull(value.c_str(), nullptr, 10);
+    } else if (name == "--mix") {
+      if (!jvc::ParseCorpusMix(value, args.Options.Mix)) {
+        PrintUsageAndExit(argv[0]);
+      }
+    } else if (name == "--preset") {
+      preset = value;
+    } else if (name == "--total-lines") {
+      totalLines = std::strtoull(value.c_str(), nullptr, 10);
+    } else {
+      PrintUsageAndExit(argv[0]);
+    }
+  }
+
+  if (!preset.empty()) {
+    constexpr const size_t TinyFileLines = 10;
+    if (totalLines == 0) {
+      PrintUsageAndExit(argv[0]);
+    }
+    if (preset == "giant-single") {
+      args.Options.Files = 1;
+      args.Options.LinesPerFile = totalLines;
+    } else if (preset == "many-tiny") {
+      args.Options.Files = (totalLines + TinyFileLines - 1) / TinyFileLines;
+      args.Options.LinesPerFile = TinyFileLines;
+    } else {
+      PrintUsageAndExit(argv[0]);
+    }
+  }
+
+  if (args.OutputDirectory.empty() || args.Options.Files == 0) {
+    PrintUsageAndExit(argv[0]);
+  }
+  return args;
+}
+
+} // namespace <anonymous>
+
+int main(int argc, char* argv[]) {
+  auto args = ParseCommandLine(argc, argv);
+  jvc::CorpusGenerator generator { args.Options };
+
+  if (args.OutputDirectory == "-") {
+    for (size_t i = 0; i < args.Options.Files; ++i) {
+      generator.GenerateFile(i, jvc::outs().stream());
+    }
+    return 0;
+  }
+
+  std::filesystem::path root { args.OutputDirectory };
+  for (size_t i = 0; i < args.Options.Files; ++i) {
+    auto path = root / generator.GetFilePath(i);
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto output = jvc::OutputStream::FromFile(path.string());
+    if (ec || !output) {
+      std::cerr << "fatal error: cannot create file: " << path.string() << std::endl;
+      return 1;
+    }
+
+    generator.GenerateFile(i, *output);
+  }
+
+  std::cerr << "Generated " << args.Options.Files << " files of " << args.Options.LinesPerFile << " lines ("
+            << jvc::GetCorpusMixName(args.Options.Mix) << ", seed " << args.Options.Seed << ") in "
+            << args.OutputDirectory << std::endl;
+  return 0;
+}
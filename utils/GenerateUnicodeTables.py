@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+#
+# Generate src/Infrastructure/UnicodeTables.h, the two-level lookup tables behind IsJavaIdentifierStart and
+# IsJavaIdentifierPart.
+#
+# Usage: python3 utils/GenerateUnicodeTables.py > src/Infrastructure/UnicodeTables.h
+#
+
+import unicodedata
+
+BLOCK_BITS = 8
+BLOCK_SIZE = 1 << BLOCK_BITS
+MAX_CODE_POINT = 0x110000
+
+# Character.isJavaIdentifierStart: letters, letter numbers, currency symbols and connector punctuations.
+START_CATEGORIES = {'Lu', 'Ll', 'Lt', 'Lm', 'Lo', 'Nl', 'Sc', 'Pc'}
+# Character.isJavaIdentifierPart additionally accepts digits, combining marks and ignorable characters.
+PART_CATEGORIES = START_CATEGORIES | {'Nd', 'Mn', 'Mc', 'Cf'}
+
+
+def is_start(cp):
+    return unicodedata.category(chr(cp)) in START_CATEGORIES
+
+
+def is_part(cp):
+    if cp <= 0x08 or 0x0E <= cp <= 0x1B or 0x7F <= cp <= 0x9F:
+        return True
+    return unicodedata.category(chr(cp)) in PART_CATEGORIES
+
+
+def bitmap(pred, block):
+    words = []
+    for w in range(BLOCK_SIZE // 32):
+        value = 0
+        for bit in range(32):
+            if pred((block << BLOCK_BITS) + w * 32 + bit):
+                value |= 1 << bit
+        words.append(value)
+    return tuple(words)
+
+
+def main():
+    blocks = {}
+    stage1 = []
+    for block in range(MAX_CODE_POINT >> BLOCK_BITS):
+        key = (bitmap(is_start, block), bitmap(is_part, block))
+        stage1.append(blocks.setdefault(key, len(blocks)))
+    assert len(blocks) <= 256
+
+    ordered = sorted(blocks.items(), key=lambda item: item[1])
+
+    print('//')
+    print('// Generated by utils/GenerateUnicodeTables.py from Unicode %s. Do not edit.' % unicodedata.unidata_version)
+    print('//')
+    print()
+    print('#ifndef JVC_UNICODETABLES_H')
+    print('#define JVC_UNICODETABLES_H')
+    print()
+    print('#include <cstdint>')
+    print()
+    print('namespace jvc {')
+    print()
+    print('namespace {')
+    print()
+    print('constexpr const unsigned UnicodeBlockBits = %d;' % BLOCK_BITS)
+    print()
+    print('const uint8_t UnicodeBlockIndex[%d] = {' % len(stage1))
+    for i in range(0, len(stage1), 24):
+        print('    ' + ', '.join(str(v) for v in stage1[i:i + 24]) + ',')
+    print('};')
+    for name, part in (('IdentifierStartBlocks', 0), ('IdentifierPartBlocks', 1)):
+        print()
+        print('const uint32_t %s[%d][%d] = {' % (name, len(ordered), BLOCK_SIZE // 32))
+        for key, _ in ordered:
+            print('    { ' + ', '.join('0x%08X' % w for w in key[part]) + ' },')
+        print('};')
+    print()
+    print('} // namespace <anonymous>')
+    print()
+    print('} // namespace jvc')
+    print()
+    print('#endif // JVC_UNICODETABLES_H')
+
+
+if __name__ == '__main__':
+    main()